@@ -0,0 +1,172 @@
+/* components/common/include/json_writer.h */
+
+#ifndef TOPOROBO_JSON_WRITER_H
+#define TOPOROBO_JSON_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Streaming JSON writer into a caller-provided buffer. Nothing is allocated:
+ * values are formatted straight into the buffer, so a payload can live on the
+ * stack. Only the C standard library is used, host tools and benchmarks build
+ * it as is, and the enums are plain C enums. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Macros *********************************************************************/
+
+#define JSON_WRITER_MAX_DECIMALS (9) /* Most fractional digits written for a number */
+
+/* Schema field of a member of `type`, see json_field_t */
+#define JSON_FIELD_FLOAT(type, member, key, decimals) \
+  { (key), (uint16_t)offsetof(type, member), k_json_field_float, (decimals) }
+#define JSON_FIELD_UINT8(type, member, key) \
+  { (key), (uint16_t)offsetof(type, member), k_json_field_uint8, 0 }
+#define JSON_FIELD_UINT16(type, member, key) \
+  { (key), (uint16_t)offsetof(type, member), k_json_field_uint16, 0 }
+#define JSON_FIELD_UINT32(type, member, key) \
+  { (key), (uint16_t)offsetof(type, member), k_json_field_uint32, 0 }
+#define JSON_FIELD_STRING(type, member, key) \
+  { (key), (uint16_t)offsetof(type, member), k_json_field_string, (uint8_t)sizeof(((type *)0)->member) }
+
+/* Schema over a static field table */
+#define JSON_SCHEMA(object_type, fields) \
+  { (object_type), (fields), (uint8_t)(sizeof(fields) / sizeof((fields)[0])) }
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief C type of a struct member written by a schema
+ */
+typedef enum {
+  k_json_field_float,  /* float, written with a fixed number of decimals */
+  k_json_field_uint8,  /* uint8_t */
+  k_json_field_uint16, /* uint16_t */
+  k_json_field_uint32, /* uint32_t */
+  k_json_field_string, /* char array, written up to its NUL or its size */
+} json_field_type_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief One member of a struct written as a JSON key and value
+ */
+typedef struct {
+  const char        *key;    /* JSON key, written unescaped */
+  uint16_t           offset; /* offsetof the member */
+  json_field_type_t  type;   /* C type of the member */
+  uint8_t            arg;    /* Decimals of a float, size of a char array */
+} json_field_t;
+
+/**
+ * @brief A struct written as a flat JSON object
+ *
+ * The object starts with `"sensor_type":"<object_type>"`, followed by the
+ * fields in table order.
+ */
+typedef struct {
+  const char         *object_type; /* Value of the leading "sensor_type" key */
+  const json_field_t *fields;      /* Members to write */
+  uint8_t             field_count; /* Entries in fields */
+} json_schema_t;
+
+/**
+ * @brief Writer state over one output buffer
+ *
+ * Like snprintf, `length` keeps counting after the buffer is full, so the
+ * size a payload needs is known after one pass.
+ */
+typedef struct {
+  char   *buffer;     /* Output, may be NULL when size is 0 */
+  size_t  size;       /* Bytes of buffer, including the terminating NUL */
+  size_t  length;     /* Characters produced so far, written or not */
+  bool    need_comma; /* Whether the next key or value follows a sibling */
+} json_writer_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Starts writing into a buffer
+ *
+ * @param writer Writer to set up
+ * @param buffer Output buffer, may be NULL if size is 0
+ * @param size   Bytes of buffer
+ */
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size);
+
+/**
+ * @brief Opens an object, as a value of the current key if there is one
+ */
+void json_writer_begin_object(json_writer_t *writer);
+
+/**
+ * @brief Closes the innermost open object
+ */
+void json_writer_end_object(json_writer_t *writer);
+
+/**
+ * @brief Writes a key, the next call writes its value
+ *
+ * @param writer Writer
+ * @param key    Key, must not need escaping
+ */
+void json_writer_key(json_writer_t *writer, const char *key);
+
+/**
+ * @brief Writes a string value, escaped
+ *
+ * @param writer     Writer
+ * @param value      String to write
+ * @param max_length Most characters read from value if it has no NUL
+ */
+void json_writer_string(json_writer_t *writer, const char *value, size_t max_length);
+
+/**
+ * @brief Writes a number with a fixed number of decimals
+ *
+ * Trailing zeros of the fraction are dropped. NaN, infinities and values too
+ * large for the decimals are written as null, as JSON has no other way to
+ * say so.
+ *
+ * @param writer   Writer
+ * @param value    Number to write
+ * @param decimals Fractional digits, at most JSON_WRITER_MAX_DECIMALS
+ */
+void json_writer_number(json_writer_t *writer, double value, uint8_t decimals);
+
+/**
+ * @brief Writes an unsigned integer value
+ */
+void json_writer_uint(json_writer_t *writer, uint32_t value);
+
+/**
+ * @brief Terminates the output
+ *
+ * @param writer Writer
+ * @return Characters the complete output needs without the NUL; the output
+ *         was cut short if this is not less than the buffer size
+ */
+size_t json_writer_finish(json_writer_t *writer);
+
+/**
+ * @brief Writes a struct as a flat JSON object described by a schema
+ *
+ * @param schema Object type and fields
+ * @param data   Struct the field offsets refer to
+ * @param buffer Output buffer, may be NULL if size is 0
+ * @param size   Bytes of buffer
+ * @return Characters the object needs without the NUL, as json_writer_finish
+ */
+size_t json_writer_write_schema(const json_schema_t *schema,
+                                const void          *data,
+                                char                *buffer,
+                                size_t               size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_JSON_WRITER_H */
@@ -25,6 +25,55 @@ extern const char *log_tag; /* Tag for logging */
 #define LOG_MAX_TAG_LENGTH     (32)    /* Maximum length of log tags */
 #define LOG_SEPARATOR          (" - ") /* Separator between log components */
 #define LOG_TASK_NAME_LENGTH   (16)    /* Maximum length of task name to display */
+#define LOG_MAX_TAG_OVERRIDES  (16)    /* Maximum number of tags with a runtime level */
+#define LOG_TIMESTAMP_LENGTH   (20)    /* "YYYY-MM-DD HH:MM:SS" plus terminator */
+
+/**
+ * Records queued for the drain task, a power of two of about 200 bytes each.
+ * Sized for the boot burst, when every component logs its init while the
+ * drain task competes with the init tasks. Override with `-DLOG_RING_SIZE=n`.
+ */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE          (128)
+#endif
+
+#if (LOG_RING_SIZE & (LOG_RING_SIZE - 1)) != 0 || LOG_RING_SIZE < 4
+#error "LOG_RING_SIZE must be a power of two of at least 4"
+#endif
+
+/**
+ * Compile-time level gate. Log calls above the threshold compile away
+ * completely, arguments included, so they cost nothing in hot paths.
+ *
+ * `LOG_COMPILE_LEVEL` sets the threshold for the whole build (e.g.
+ * `-DLOG_COMPILE_LEVEL=ESP_LOG_DEBUG`). A module can give its tag its own
+ * threshold by defining `LOG_LOCAL_COMPILE_LEVEL` before its first include.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL ESP_LOG_INFO
+#endif
+
+#ifndef LOG_LOCAL_COMPILE_LEVEL
+#define LOG_LOCAL_COMPILE_LEVEL LOG_COMPILE_LEVEL
+#endif
+
+#define LOG_AT_LEVEL(level, tag, short_msg, ...)                      \
+  do {                                                                \
+    if ((level) <= LOG_LOCAL_COMPILE_LEVEL &&                         \
+        log_level_enabled((tag), (level))) {                          \
+      log_write((level), (tag), (short_msg), __VA_ARGS__);            \
+    }                                                                 \
+  } while (0)
+
+/**
+ * Level wrappers. Arguments are `(tag, short_msg, detailed_msg, ...)`, with
+ * printf-style checking of `detailed_msg` through `log_write`.
+ */
+#define log_error(tag, short_msg, ...)   LOG_AT_LEVEL(ESP_LOG_ERROR,   tag, short_msg, __VA_ARGS__)
+#define log_warn(tag, short_msg, ...)    LOG_AT_LEVEL(ESP_LOG_WARN,    tag, short_msg, __VA_ARGS__)
+#define log_info(tag, short_msg, ...)    LOG_AT_LEVEL(ESP_LOG_INFO,    tag, short_msg, __VA_ARGS__)
+#define log_debug(tag, short_msg, ...)   LOG_AT_LEVEL(ESP_LOG_DEBUG,   tag, short_msg, __VA_ARGS__)
+#define log_verbose(tag, short_msg, ...) LOG_AT_LEVEL(ESP_LOG_VERBOSE, tag, short_msg, __VA_ARGS__)
 
 /* Global Variables **********************************************************/
 
@@ -36,6 +85,9 @@ extern _Atomic uint64_t g_log_sequence_number; /* Atomic counter for log sequenc
  * @brief Initializes the log handler
  * 
  * Sets up the log handler and optionally initializes SD card logging.
+ * Starts the low-priority drain task, from then on log calls only queue
+ * their arguments and the drain task formats and writes them. Until then
+ * messages are written synchronously by the caller.
  * 
  * @param[in] log_to_sd Whether to enable logging to SD card
  * @return ESP_OK if successful, ESP_FAIL otherwise
@@ -52,6 +104,8 @@ void log_set_sd_logging(bool enabled);
 /**
  * @brief Flushes any buffered logs to the SD card
  * 
+ * Drains queued records first, so everything logged before the call is stored.
+ * 
  * @return ESP_OK if successful, ESP_FAIL otherwise
  */
 esp_err_t log_flush(void);
@@ -59,9 +113,15 @@ esp_err_t log_flush(void);
 /**
  * @brief Log a message with the specified level and tag
  * 
- * This is the core logging function. The inline wrappers below provide
+ * This is the core logging function. The level macros above provide
  * a more convenient interface with compile-time format checking.
  * 
+ * Does not block and is safe from ISRs once the drain task runs: the
+ * arguments are copied into a lock-free ring and formatted later. `tag`,
+ * `short_msg` and `detailed_msg` are kept by pointer and must be string
+ * literals or otherwise outlive the call; `%s` arguments are copied.
+ * When the ring is full the message is dropped and counted.
+ * 
  * @param[in] level        Log level (ESP_LOG_xxx)
  * @param[in] tag          Component or module identifier
  * @param[in] short_msg    Short description of the log
@@ -84,116 +144,47 @@ void log_write(esp_log_level_t level,
                ...)
                __attribute__((format(printf, 4, 5)));
 
-/* Inline Function Wrappers *************************************************/
-
 /**
- * @brief Log an error message
- * 
- * @param[in] tag          Component or module identifier
- * @param[in] short_msg    Short description of the log
- * @param[in] detailed_msg Detailed message with optional format specifiers
- * @param[in] args         va_list of arguments for format string
+ * @brief Checks the runtime level for a tag
  * 
- * The inline keyword suggests to the compiler to insert the function code
- * directly at the call site instead of generating a function call.
+ * Called by the level wrappers before any argument is evaluated, so filtered
+ * messages skip formatting, task lookup, timestamps and storage.
  * 
- * The format attribute tells the compiler:
- * - This function uses printf-style formatting
- * - The format string is the 3rd parameter
- * - The variable arguments start at the 4th parameter
- * This enables compile-time format string checking.
+ * @param[in] tag   Component or module identifier
+ * @param[in] level Log level (ESP_LOG_xxx) of the message
+ * @return true if the message should be written
  */
-static inline __attribute__((format(printf, 3, 4))) 
-void log_error(const char *tag, 
-               const char *short_msg, 
-               const char *detailed_msg, 
-               ...) 
-{
-  va_list args;
-  va_start(args, detailed_msg);
-  log_write_va(ESP_LOG_ERROR, tag, short_msg, detailed_msg, args);
-  va_end(args);
-}
+bool log_level_enabled(const char *tag, esp_log_level_t level);
 
 /**
- * @brief Log a warning message
+ * @brief Sets the runtime level for one tag
  * 
- * @param[in] tag          Component or module identifier
- * @param[in] short_msg    Short description of the log
- * @param[in] detailed_msg Detailed message with optional format specifiers
- * @param[in] args         va_list of arguments for format string
- */
-static inline __attribute__((format(printf, 3, 4))) 
-void log_warn(const char *tag, 
-              const char *short_msg, 
-              const char *detailed_msg, 
-              ...) 
-{
-  va_list args;
-  va_start(args, detailed_msg);
-  log_write_va(ESP_LOG_WARN, tag, short_msg, detailed_msg, args);
-  va_end(args);
-}
-
-/**
- * @brief Log an info message
+ * Overrides the default level for field debugging. Messages above the
+ * compile-time threshold are already compiled out and cannot be re-enabled.
+ * Also applied to the ESP-IDF console filter for the tag.
  * 
- * @param[in] tag          Component or module identifier
- * @param[in] short_msg    Short description of the log
- * @param[in] detailed_msg Detailed message with optional format specifiers
- * @param[in] args         va_list of arguments for format string
+ * @param[in] tag   Component or module identifier
+ * @param[in] level Most verbose level to write for this tag
+ * @return 
+ * - ESP_OK              if the level was set
+ * - ESP_ERR_INVALID_ARG if tag is NULL or too long
+ * - ESP_ERR_NO_MEM      if LOG_MAX_TAG_OVERRIDES tags already have a level
  */
-static inline __attribute__((format(printf, 3, 4))) 
-void log_info(const char *tag, 
-              const char *short_msg,
-              const char *detailed_msg, 
-              ...) 
-{
-  va_list args;
-  va_start(args, detailed_msg);
-  log_write_va(ESP_LOG_INFO, tag, short_msg, detailed_msg, args);
-  va_end(args);
-}
+esp_err_t log_set_level(const char *tag, esp_log_level_t level);
 
 /**
- * @brief Log a debug message
+ * @brief Sets the runtime level for tags without an override
  * 
- * @param[in] tag          Component or module identifier
- * @param[in] short_msg    Short description of the log
- * @param[in] detailed_msg Detailed message with optional format specifiers
- * @param[in] args         va_list of arguments for format string
+ * @param[in] level Most verbose level to write
  */
-static inline __attribute__((format(printf, 3, 4))) 
-void log_debug(const char *tag, 
-               const char *short_msg,
-               const char *detailed_msg, 
-               ...) 
-{
-  va_list args;
-  va_start(args, detailed_msg);
-  log_write_va(ESP_LOG_DEBUG, tag, short_msg, detailed_msg, args);
-  va_end(args);
-}
+void log_set_default_level(esp_log_level_t level);
 
 /**
- * @brief Log a verbose message
+ * @brief Gets the number of messages dropped because the ring was full
  * 
- * @param[in] tag          Component or module identifier
- * @param[in] short_msg    Short description of the log
- * @param[in] detailed_msg Detailed message with optional format specifiers
- * @param[in] args         va_list of arguments for format string
+ * @return Messages dropped since boot
  */
-static inline __attribute__((format(printf, 3, 4))) 
-void log_verbose(const char *tag, 
-                 const char *short_msg,
-                 const char *detailed_msg, 
-                 ...) 
-{
-  va_list args;
-  va_start(args, detailed_msg);
-  log_write_va(ESP_LOG_VERBOSE, tag, short_msg, detailed_msg, args);
-  va_end(args);
-}
+uint32_t log_get_dropped_count(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,196 @@
+/* components/common/include/log_record.h */
+
+#ifndef TOPOROBO_LOG_RECORD_H
+#define TOPOROBO_LOG_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shared with host tools (tools/log_decoder), so only the C standard library
+ * is used here and the enums are plain C enums. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Macros *********************************************************************/
+
+#define LOG_RECORD_MAX_ARGS         (8)    /* Format arguments kept per record, extras print unformatted */
+#define LOG_RECORD_STRING_BYTES     (64)   /* Bytes kept per record for copies of %s arguments */
+#define LOG_RECORD_SPEC_LENGTH      (16)   /* Longest single printf conversion rendered */
+#define LOG_RECORD_TASK_NAME_LENGTH (16)   /* Task name bytes kept per record */
+#define LOG_RECORD_MAX_STRINGS      (255)  /* Interned strings per log file, later ones are written inline */
+#define LOG_RECORD_MAX_TASKS        (16)   /* Interned task names per log file, later ones are written inline */
+#define LOG_RECORD_MAX_STRING_DEF   (200)  /* Longest tag, short message or format stored, longer ones are cut */
+#define LOG_RECORD_MAX_ENCODED_SIZE (1024) /* Worst case bytes for one record with its string definitions */
+#define LOG_RECORD_FILE_MAGIC       ("TLOG")
+#define LOG_RECORD_FILE_VERSION     (1)
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief How a captured printf argument was passed
+ */
+typedef enum {
+  k_log_arg_none,    /* Conversion without an argument (e.g. %%) */
+  k_log_arg_int,     /* int and narrower, after promotion */
+  k_log_arg_long,    /* long */
+  k_log_arg_llong,   /* long long and intmax_t */
+  k_log_arg_size,    /* size_t and ptrdiff_t */
+  k_log_arg_double,  /* double, and float after promotion */
+  k_log_arg_string,  /* char *, copied into the record */
+  k_log_arg_pointer, /* void * */
+} log_arg_kind_t;
+
+/**
+ * @brief Block types of the binary log file format
+ *
+ * A file starts with `LOG_RECORD_FILE_MAGIC` and `LOG_RECORD_FILE_VERSION`,
+ * followed by blocks that each start with one of these bytes. Integers are
+ * LEB128 varints, signed ones zigzag encoded, doubles are 8 bytes little endian.
+ */
+typedef enum {
+  k_log_block_string    = 0x01, /* varint id, varint length, bytes: defines an interned string */
+  k_log_block_task      = 0x02, /* varint id, varint length, bytes: defines an interned task name */
+  k_log_block_time_sync = 0x03, /* signed varint: Unix time minus esp_timer time, in microseconds */
+  k_log_block_entry     = 0x10, /* 0x10 + level, then the entry fields, see log_record_encode */
+} log_block_type_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief One printf conversion parsed from a format string
+ */
+typedef struct {
+  uint8_t        length; /* Characters from '%' to the conversion, inclusive */
+  uint8_t        stars;  /* '*' width/precision arguments taken before the value */
+  log_arg_kind_t kind;   /* How the value argument is passed */
+} log_spec_t;
+
+/**
+ * @brief Raw printf argument stored in a log record
+ */
+typedef union {
+  long long   i; /* Integer kinds and string offsets */
+  double      d; /* Floating point */
+  const void *p; /* Pointers */
+} log_arg_t;
+
+/**
+ * @brief Unformatted log message
+ *
+ * Tag, short message and format are stored as pointers, so they must be
+ * static strings; `%s` arguments are copied into `strings`.
+ */
+typedef struct {
+  uint64_t    sequence;                               /* Log sequence number */
+  int64_t     timestamp_us;                           /* esp_timer time of the call */
+  const char *tag;                                    /* Component or module identifier */
+  const char *short_msg;                              /* Short description of the log */
+  const char *format;                                 /* printf format of the detailed message */
+  const void *task;                                   /* Calling task handle, NULL from an ISR */
+  char        task_name[LOG_RECORD_TASK_NAME_LENGTH]; /* Calling task name */
+  uint8_t     level;                                  /* Log level, esp_log_level_t values */
+  uint8_t     arg_count;                              /* Entries used in args */
+  uint8_t     string_bytes;                           /* Bytes used in strings */
+  log_arg_t   args[LOG_RECORD_MAX_ARGS];              /* Captured arguments, in format order */
+  char        strings[LOG_RECORD_STRING_BYTES];       /* Copies of %s arguments, NUL separated */
+} log_record_t;
+
+/**
+ * @brief Per-file state of the binary encoder
+ *
+ * Strings are interned by address, which is why records must point at
+ * static strings. Task names are interned by content.
+ */
+typedef struct {
+  const char *strings[LOG_RECORD_MAX_STRINGS];                          /* Interned strings, id is index + 1 */
+  char        tasks[LOG_RECORD_MAX_TASKS][LOG_RECORD_TASK_NAME_LENGTH]; /* Interned task names, id is index + 1 */
+  uint16_t    string_count;                                             /* Entries used in strings */
+  uint8_t     task_count;                                               /* Entries used in tasks */
+  uint64_t    last_sequence;                                            /* Sequence of the previous entry */
+  int64_t     last_timestamp_us;                                        /* Timestamp of the previous entry */
+} log_record_encoder_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Parses one printf conversion
+ *
+ * @param[in]  spec_start Format text starting at the '%'
+ * @param[out] spec       Filled with the conversion's length and argument kind
+ */
+void log_record_parse_spec(const char *spec_start, log_spec_t *spec);
+
+/**
+ * @brief Formats a record's detailed message from its captured arguments
+ *
+ * Arguments that were not captured leave the rest of the format unformatted.
+ *
+ * @param[in]  record Record to format
+ * @param[out] buffer Output buffer
+ * @param[in]  size   Size of the output buffer
+ */
+void log_record_render(const log_record_t *record, char *buffer, size_t size);
+
+/**
+ * @brief Writes an unsigned LEB128 varint
+ *
+ * @param[out] out   Destination, needs up to 10 bytes
+ * @param[in]  value Value to write
+ * @return Bytes written
+ */
+size_t log_record_put_varint(uint8_t *out, uint64_t value);
+
+/**
+ * @brief Reads an unsigned LEB128 varint
+ *
+ * @param[in]  in    Source bytes
+ * @param[in]  len   Bytes available
+ * @param[out] value Value read
+ * @return Bytes read, 0 if the varint is truncated or too long
+ */
+size_t log_record_get_varint(const uint8_t *in, size_t len, uint64_t *value);
+
+/**
+ * @brief Starts a new file: clears the intern tables and writes the file header
+ *
+ * @param[out] encoder Encoder to reset
+ * @param[out] out     Destination, needs `sizeof(LOG_RECORD_FILE_MAGIC)` bytes
+ * @return Bytes written
+ */
+size_t log_record_encoder_reset(log_record_encoder_t *encoder, uint8_t *out);
+
+/**
+ * @brief Writes a time sync block mapping esp_timer time to Unix time
+ *
+ * @param[out] out       Destination, needs up to 11 bytes
+ * @param[in]  offset_us Unix time minus esp_timer time, in microseconds
+ * @return Bytes written
+ */
+size_t log_record_encode_time_sync(uint8_t *out, int64_t offset_us);
+
+/**
+ * @brief Encodes one record, preceded by definitions of strings new to the file
+ *
+ * The entry holds the level in its block type, then the zigzag varint deltas
+ * of the sequence number and timestamp, varint ids of the tag, short message,
+ * format and task, the argument count and the arguments in format order.
+ * An id of 0 means the string follows inline as a varint length and bytes,
+ * used once the intern tables are full and for records without a task.
+ *
+ * @param[in,out] encoder Encoder of the file the record goes to
+ * @param[in]     record  Record to encode
+ * @param[out]    out     Destination, needs `LOG_RECORD_MAX_ENCODED_SIZE` bytes
+ * @return Bytes written
+ */
+size_t log_record_encode(log_record_encoder_t *encoder,
+                         const log_record_t   *record,
+                         uint8_t              *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_LOG_RECORD_H */
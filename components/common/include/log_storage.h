@@ -10,6 +10,7 @@ extern "C" {
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "sd_card_hal.h"
+#include "log_record.h"
 
 /* Constants ******************************************************************/
 
@@ -20,38 +21,55 @@ extern const int   log_max_files;            /* Maximum number of log files to k
 extern const int   log_compression_enabled;  /* Enable/disable compression (1=enabled, 0=disabled) */
 extern const int   log_compression_level;    /* Compression level (0-9, or Z_DEFAULT_COMPRESSION) */
 extern const int   log_compression_buffer;   /* Size of compression buffer */
-extern const char *log_compressed_extension; /* Extension for compressed log files */
-extern const int   zlib_window_bits;         /* Window size with gzip header */
-extern const int   zlib_mem_level;           /* Memory level for zlib compression */
+extern const char *log_binary_extension;     /* Extension for binary log files */
+extern const char *log_compressed_extension; /* Extension added to compressed log files */
+extern const int   log_time_sync_tolerance;  /* Wall clock drift in microseconds before a new time sync block */
+extern const int   log_zlib_window_bits;     /* Window size with gzip header */
+extern const int   log_zlib_mem_level;       /* Memory level for zlib compression */
+extern const int   log_buffer_budget;        /* Bytes of internal RAM for buffered records */
+extern const int   log_buffer_psram_budget;  /* Bytes of PSRAM for buffered records, when present */
 
 /* Macros *********************************************************************/
 
-#define LOG_BUFFER_SIZE                        (10)                                     /* Size of the log buffer for temporary storage */
-#define LOG_STORAGE_MAX_MESSAGE_LENGTH         (256)                                    /* Maximum length of log messages */
-#define TIMESTAMP_BUFFER_SIZE                  (64)                                     /* Buffer size for formatted timestamp strings */
-#define DATE_STRING_BUFFER_SIZE                (32)                                     /* Buffer size for date strings */
-#define LOG_STORAGE_MAX_FORMATTED_ENTRY_LENGTH (LOG_STORAGE_MAX_MESSAGE_LENGTH * 2)     /* Formatted log entry buffer size */
+#define LOG_BUFFER_SIZE             (10)   /* Records collected before a flush while the SD card is available */
+#define DATE_STRING_BUFFER_SIZE     (32)   /* Buffer size for date strings */
+#define LOG_COMPRESSION_BUFFER_SIZE (4096) /* Bytes collected per file write, at most FILE_WRITE_LARGE_BUFFER_SIZE */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief What happens to a new record when the log buffer is full
+ */
+typedef enum : uint8_t {
+  k_log_overflow_drop_oldest,         /* Evict the oldest buffered records */
+  k_log_overflow_drop_lower_severity, /* Evict the oldest of the least severe records, drop the new one if all are more severe */
+  k_log_overflow_block,               /* Wait for a flush to make room, drop the new record on timeout */
+} log_overflow_policy_t;
 
 /* Structs ********************************************************************/
 
 /**
- * @brief Structure for storing a log entry
- *      
- * This structure contains all the information needed for a single log entry,
- * including the message text, log level, and timestamp when the log was created.
+ * @brief Log buffer counters, kept since `log_storage_init`
  */
 typedef struct {
-  char            buffer[LOG_STORAGE_MAX_MESSAGE_LENGTH]; /**< Buffer for the log message text */
-  esp_log_level_t level;                                  /**< Log level (error, warning, info, etc.) */
-  uint64_t        timestamp;                              /**< Timestamp when the log was created */
-} log_entry_t;
+  uint32_t dropped;        /* New records discarded because no room could be made */
+  uint32_t overwritten;    /* Buffered records evicted to make room for newer ones */
+  uint32_t flushed;        /* Records written to the SD card */
+  uint32_t buffered;       /* Records currently waiting in the buffer */
+  uint32_t buffered_bytes; /* Bytes used by the waiting records */
+  uint32_t capacity_bytes; /* Size of the buffer */
+} log_storage_stats_t;
 
 /* Public Functions ***********************************************************/
 
 /**
  * @brief Initializes the log storage system
  * 
- * @return ESP_OK if successful, ESP_FAIL otherwise
+ * Allocates the log buffer, `log_buffer_psram_budget` bytes in PSRAM when
+ * present, `log_buffer_budget` bytes of internal RAM otherwise.
+ * 
+ * @return ESP_OK if successful, ESP_ERR_NO_MEM if the buffer cannot be
+ *         allocated, ESP_FAIL otherwise
  */
 esp_err_t log_storage_init(void);
 
@@ -66,21 +84,46 @@ esp_err_t log_storage_init(void);
 void log_storage_set_sd_available(bool available);
 
 /**
- * @brief Writes a log message to storage
+ * @brief Writes a log record to storage
  * 
- * @param[in] level   Log level
- * @param[in] message Log message
- * @return ESP_OK if successful, ESP_FAIL otherwise
+ * Records are stored unformatted in the binary format of `log_record.h`:
+ * tags, short messages and formats are written once per file and referred to
+ * by id, arguments are packed. `tools/log_decoder` turns the files back into
+ * text or JSON.
+ * 
+ * Records wait in a byte-budgeted buffer, packed to the arguments and strings
+ * they use, until `LOG_BUFFER_SIZE` of them are collected and the SD card is
+ * available. While the card is missing the buffer keeps filling; once full,
+ * the overflow policy decides which records are lost.
+ * 
+ * @param[in] record Log record, its strings must be static
+ * @return ESP_OK if the record was buffered, ESP_FAIL otherwise
  */
-esp_err_t log_storage_write(esp_log_level_t level, const char *message);
+esp_err_t log_storage_write(const log_record_t *record);
 
 /**
  * @brief Flushes the log buffer to disk
  * 
+ * With compression enabled, every log file holds one gzip stream that stays
+ * open across flushes. Each flush ends with a zlib sync flush, so everything
+ * written so far can be decompressed even before the file is rotated and the
+ * stream finished.
+ * 
  * @return ESP_OK if successful, ESP_FAIL otherwise
  */
 esp_err_t log_storage_flush(void);
 
+/**
+ * @brief Flushes the log buffer and closes the current log file
+ * 
+ * Finishes the gzip stream, so the file ends in a complete gzip member and
+ * the next flush starts a new file. Later records stay in the buffer until
+ * `log_storage_set_sd_available(true)`. Used before power is lost.
+ * 
+ * @return ESP_OK if successful, ESP_FAIL if records could not be written
+ */
+esp_err_t log_storage_close(void);
+
 /**
  * @brief Sets whether log compression is enabled
  * 
@@ -96,6 +139,29 @@ esp_err_t log_storage_set_compression(bool enabled);
  */
 bool log_storage_is_compression_enabled(void);
 
+/**
+ * @brief Selects what happens to new records when the log buffer is full
+ * 
+ * With `k_log_overflow_block`, `log_storage_write` waits up to
+ * `block_timeout_ms` for a flush to make room. It runs on the log drain task,
+ * so records queued meanwhile may be dropped by the log handler instead.
+ * While the SD card is unavailable nothing can flush, so blocking falls back
+ * to `k_log_overflow_drop_lower_severity` until the card returns.
+ * 
+ * @param[in] policy           Overflow policy
+ * @param[in] block_timeout_ms Longest wait for `k_log_overflow_block`
+ * @return ESP_OK if successful, ESP_ERR_INVALID_ARG for an unknown policy
+ */
+esp_err_t log_storage_set_overflow_policy(log_overflow_policy_t policy,
+                                          uint32_t              block_timeout_ms);
+
+/**
+ * @brief Copies the log buffer counters
+ * 
+ * @param[out] stats Destination for the counters
+ */
+void log_storage_get_stats(log_storage_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
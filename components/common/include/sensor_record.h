@@ -0,0 +1,251 @@
+/* components/common/include/sensor_record.h */
+
+#ifndef TOPOROBO_SENSOR_RECORD_H
+#define TOPOROBO_SENSOR_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shared with host tools (tools/sensor_decoder), so only the C standard
+ * library is used here and the enums are plain C enums. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Macros *********************************************************************/
+
+#define SENSOR_RECORD_MAX_COLUMNS       (8)          /* Value columns per sensor, the timestamp not counted */
+#define SENSOR_RECORD_MAX_ROWS          (255)        /* Records per block, bounds the encoder's staging arrays */
+#define SENSOR_RECORD_MIN_BLOCK_SIZE    (256)        /* Smallest block, the file header must fit in one */
+#define SENSOR_RECORD_MAX_BLOCK_SIZE    (4096)       /* Largest block, one large file writer buffer */
+#define SENSOR_RECORD_BLOCK_HEADER_SIZE (40)         /* Bytes before a data block's payload */
+#define SENSOR_RECORD_FILE_MAGIC        (0x534E5354) /* "TSNS" little endian, starts a file header block */
+#define SENSOR_RECORD_BLOCK_MAGIC       (0x4B4C4253) /* "SBLK" little endian, starts a data block */
+#define SENSOR_RECORD_FILE_VERSION      (1)
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief Sensors with a record schema, stored in every block
+ *
+ * Values are only ever appended, files keep their meaning across versions.
+ */
+typedef enum {
+  k_sensor_record_bh1750,     /* Light intensity */
+  k_sensor_record_dht22,      /* Temperature and humidity */
+  k_sensor_record_mpu6050,    /* Accelerometer, gyroscope and die temperature */
+  k_sensor_record_qmc5883l,   /* Magnetometer and heading */
+  k_sensor_record_gy_neo6mv2, /* GPS position */
+  k_sensor_record_ccs811,     /* eCO2 and TVOC */
+  k_sensor_record_mq135,      /* Gas sensor */
+  k_sensor_record_type_count,
+} sensor_record_type_t;
+
+/**
+ * @brief How a data block's columns are stored
+ */
+typedef enum {
+  k_sensor_encoding_raw,   /* Timestamps as 32-bit offsets, values as 32-bit integers */
+  k_sensor_encoding_delta, /* Zigzag varint deltas to the previous row, small for slow-changing signals */
+} sensor_encoding_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief One value column of a sensor record
+ *
+ * Values are stored as `round(value * scale)` in 32-bit integers, so the
+ * scale sets the resolution kept and deltas between rows stay integers.
+ */
+typedef struct {
+  const char *name;  /* Column name, also the CSV header */
+  const char *unit;  /* Unit of the unscaled value */
+  uint32_t    scale; /* Stored steps per unit */
+} sensor_column_t;
+
+/**
+ * @brief Columns of one sensor's records
+ */
+typedef struct {
+  const char     *name;                               /* Sensor name */
+  uint8_t         column_count;                       /* Entries used in columns */
+  sensor_column_t columns[SENSOR_RECORD_MAX_COLUMNS]; /* Value columns, in record order */
+} sensor_schema_t;
+
+/**
+ * @brief Header of a data block
+ *
+ * Every block of a file has the same size, so the headers form a time index
+ * that is read without decoding payloads. Stored little endian: magic (4),
+ * type (1), encoding (1), record count (2), payload bytes (2), reserved (2),
+ * sequence (4), first timestamp (8), span (4), payload CRC-32 (4) and
+ * Unix offset (8).
+ */
+typedef struct {
+  uint8_t  type;           /* sensor_record_type_t of the records */
+  uint8_t  encoding;       /* sensor_encoding_t of the payload */
+  uint16_t record_count;   /* Rows in the block */
+  uint16_t payload_bytes;  /* Bytes after the header, the rest is padding */
+  uint32_t sequence;       /* Block number since boot, gaps mean lost blocks */
+  int64_t  first_us;       /* esp_timer time of the first row */
+  uint32_t span_us;        /* Last row's time minus first_us */
+  uint32_t crc;            /* CRC-32 of the payload */
+  int64_t  unix_offset_us; /* Unix time minus esp_timer time, 0 if wall time was unknown */
+} sensor_block_header_t;
+
+/**
+ * @brief Builds one data block from rows appended one at a time
+ *
+ * Rows are staged in caller-provided arrays and transposed into columns
+ * when the block is finished. The encoded size is tracked on every append,
+ * so a row is refused exactly when it would not fit the block.
+ */
+typedef struct {
+  uint8_t   type;                            /* sensor_record_type_t of the block */
+  uint8_t   encoding;                        /* sensor_encoding_t of the block */
+  uint8_t   column_count;                    /* Value columns of the sensor */
+  uint16_t  block_size;                      /* Bytes of a finished block */
+  uint16_t  max_rows;                        /* Rows the staging arrays hold */
+  uint16_t  row_count;                       /* Rows staged */
+  size_t    payload_bytes;                   /* Encoded size of the staged rows */
+  int64_t   first_us;                        /* Timestamp of the first staged row */
+  uint32_t  last_offset_us;                  /* Offset of the last staged row from first_us */
+  int32_t   last[SENSOR_RECORD_MAX_COLUMNS]; /* Last staged row, the delta base of the next */
+  uint32_t *offsets;                         /* Staged timestamps, offsets from first_us */
+  int32_t  *values;                          /* Staged values, row-major */
+} sensor_block_encoder_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Returns the columns of a sensor's records
+ *
+ * @param[in] type Sensor
+ * @return Schema, NULL for an unknown type
+ */
+const sensor_schema_t *sensor_record_schema(sensor_record_type_t type);
+
+/**
+ * @brief Staging bytes an encoder needs for `max_rows` rows of a sensor
+ *
+ * @param[in] type     Sensor
+ * @param[in] max_rows Rows per block, at most `SENSOR_RECORD_MAX_ROWS`
+ * @return Bytes for the `offsets` array followed by the `values` array
+ */
+size_t sensor_record_staging_size(sensor_record_type_t type, uint16_t max_rows);
+
+/**
+ * @brief Prepares an encoder for a sensor's blocks
+ *
+ * @param[out] encoder    Encoder to set up
+ * @param[in]  type       Sensor
+ * @param[in]  encoding   Payload encoding
+ * @param[in]  block_size Bytes per block, between the min and max block size
+ * @param[in]  max_rows   Rows per block, at most `SENSOR_RECORD_MAX_ROWS`
+ * @param[in]  staging    `sensor_record_staging_size` bytes, 4-byte aligned
+ * @return true if successful, false if an argument is out of range
+ */
+bool sensor_record_encoder_init(sensor_block_encoder_t *encoder,
+                                sensor_record_type_t    type,
+                                sensor_encoding_t       encoding,
+                                uint16_t                block_size,
+                                uint16_t                max_rows,
+                                void                   *staging);
+
+/**
+ * @brief Stages one row
+ *
+ * Values are in schema column order and unscaled units, out of range
+ * values are clamped to the 32-bit range.
+ *
+ * @param[in,out] encoder      Encoder
+ * @param[in]     timestamp_us esp_timer time of the sample
+ * @param[in]     values       One value per column
+ * @return true if staged, false if the block is full and must be finished first
+ */
+bool sensor_record_append(sensor_block_encoder_t *encoder,
+                          int64_t                 timestamp_us,
+                          const float            *values);
+
+/**
+ * @brief Encodes the staged rows as a block and starts an empty one
+ *
+ * @param[in,out] encoder        Encoder
+ * @param[in]     sequence       Block number written to the header
+ * @param[in]     unix_offset_us Unix time minus esp_timer time, 0 if unknown
+ * @param[out]    out            Destination, `block_size` bytes, padded with zeros
+ * @return Bytes written, always `block_size`, or 0 if no rows were staged
+ */
+size_t sensor_record_finish_block(sensor_block_encoder_t *encoder,
+                                  uint32_t                sequence,
+                                  int64_t                 unix_offset_us,
+                                  uint8_t                *out);
+
+/**
+ * @brief Writes the file header block holding the sensor's schema
+ *
+ * Written at the start of every boot's data, so a file appended to across
+ * boots is still read block by block.
+ *
+ * @param[in]  type       Sensor
+ * @param[in]  block_size Bytes per block
+ * @param[out] out        Destination, `block_size` bytes, padded with zeros
+ * @return Bytes written, always `block_size`, or 0 if the schema does not fit
+ */
+size_t sensor_record_encode_file_header(sensor_record_type_t type,
+                                        uint16_t             block_size,
+                                        uint8_t             *out);
+
+/**
+ * @brief Reads a file header block
+ *
+ * Column names and units point into `in`, which must outlive the schema.
+ *
+ * @param[in]  in         Start of the block
+ * @param[in]  len        Bytes available
+ * @param[out] type       Sensor of the file
+ * @param[out] block_size Bytes per block of the file
+ * @param[out] schema     Columns as stored in the file
+ * @return true if the block is a valid file header
+ */
+bool sensor_record_read_file_header(const uint8_t   *in,
+                                    size_t           len,
+                                    uint8_t         *type,
+                                    uint16_t        *block_size,
+                                    sensor_schema_t *schema);
+
+/**
+ * @brief Reads and checks a data block header without decoding the payload
+ *
+ * @param[in]  in     Start of the block
+ * @param[in]  len    Bytes available, the whole block for the CRC check
+ * @param[out] header Parsed header
+ * @return true if the magic matches and the payload CRC is correct
+ */
+bool sensor_record_read_block_header(const uint8_t         *in,
+                                     size_t                 len,
+                                     sensor_block_header_t *header);
+
+/**
+ * @brief Decodes a data block's columns
+ *
+ * @param[in]  in            Start of the block, checked with `sensor_record_read_block_header`
+ * @param[in]  header        Its header
+ * @param[in]  column_count  Value columns of the sensor
+ * @param[out] timestamps_us `record_count` esp_timer times
+ * @param[out] values        `record_count * column_count` scaled values, row-major
+ * @return true if the payload decoded to exactly `record_count` rows
+ */
+bool sensor_record_decode_block(const uint8_t               *in,
+                                const sensor_block_header_t *header,
+                                uint8_t                      column_count,
+                                int64_t                     *timestamps_us,
+                                int32_t                     *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SENSOR_RECORD_H */
@@ -0,0 +1,242 @@
+/* components/common/json_writer.c */
+
+#include "json_writer.h"
+#include <string.h>
+
+/* Constants ******************************************************************/
+
+static const uint32_t s_powers_of_ten[JSON_WRITER_MAX_DECIMALS + 1] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+static const char s_hex_digits[] = "0123456789abcdef";
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Appends bytes, counting the ones that no longer fit
+ */
+static void priv_put(json_writer_t *writer, const char *bytes, size_t count)
+{
+  if (writer->length + 1 < writer->size) {
+    size_t room = writer->size - 1 - writer->length;
+    memcpy(&writer->buffer[writer->length], bytes, count < room ? count : room);
+  }
+  writer->length += count;
+}
+
+/**
+ * @brief Appends one character
+ */
+static void priv_put_char(json_writer_t *writer, char c)
+{
+  priv_put(writer, &c, 1);
+}
+
+/**
+ * @brief Writes the separator before a value that follows a sibling
+ */
+static void priv_begin_value(json_writer_t *writer)
+{
+  if (writer->need_comma) {
+    priv_put_char(writer, ',');
+  }
+}
+
+/**
+ * @brief Formats an unsigned integer into the end of a scratch buffer
+ *
+ * @param value      Number to format
+ * @param end        One past the last byte of the scratch buffer
+ * @param min_digits Digits written at least, zero padded
+ * @return First character written
+ */
+static char *priv_format_digits(uint64_t value, char *end, uint8_t min_digits)
+{
+  char   *pos    = end;
+  uint8_t digits = 0;
+  do {
+    *--pos  = (char)('0' + value % 10);
+    value  /= 10;
+    digits++;
+  } while (value != 0 || digits < min_digits);
+  return pos;
+}
+
+/* Public Functions ***********************************************************/
+
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size)
+{
+  writer->buffer     = buffer;
+  writer->size       = buffer != NULL ? size : 0;
+  writer->length     = 0;
+  writer->need_comma = false;
+}
+
+void json_writer_begin_object(json_writer_t *writer)
+{
+  priv_begin_value(writer);
+  priv_put_char(writer, '{');
+  writer->need_comma = false;
+}
+
+void json_writer_end_object(json_writer_t *writer)
+{
+  priv_put_char(writer, '}');
+  writer->need_comma = true;
+}
+
+void json_writer_key(json_writer_t *writer, const char *key)
+{
+  priv_begin_value(writer);
+  priv_put_char(writer, '"');
+  priv_put(writer, key, strlen(key));
+  priv_put(writer, "\":", 2);
+  writer->need_comma = false;
+}
+
+void json_writer_string(json_writer_t *writer, const char *value, size_t max_length)
+{
+  priv_begin_value(writer);
+  priv_put_char(writer, '"');
+
+  /* Runs that need no escaping are copied in one go */
+  size_t run_start = 0;
+  size_t i         = 0;
+  for (; i < max_length && value[i] != '\0'; i++) {
+    unsigned char c = (unsigned char)value[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    priv_put(writer, &value[run_start], i - run_start);
+    run_start = i + 1;
+
+    char   escape[6] = { '\\', (char)c };
+    size_t len       = 2;
+    if (c == '\n') {
+      escape[1] = 'n';
+    } else if (c == '\r') {
+      escape[1] = 'r';
+    } else if (c == '\t') {
+      escape[1] = 't';
+    } else if (c < 0x20) {
+      escape[1] = 'u';
+      escape[2] = '0';
+      escape[3] = '0';
+      escape[4] = s_hex_digits[c >> 4];
+      escape[5] = s_hex_digits[c & 0x0F];
+      len       = 6;
+    }
+    priv_put(writer, escape, len);
+  }
+  priv_put(writer, &value[run_start], i - run_start);
+
+  priv_put_char(writer, '"');
+  writer->need_comma = true;
+}
+
+void json_writer_number(json_writer_t *writer, double value, uint8_t decimals)
+{
+  priv_begin_value(writer);
+  writer->need_comma = true;
+  if (decimals > JSON_WRITER_MAX_DECIMALS) {
+    decimals = JSON_WRITER_MAX_DECIMALS;
+  }
+
+  /* Fixed point keeps this away from printf's float path, which may allocate */
+  double scaled = value * s_powers_of_ten[decimals];
+  if (!(scaled < 9.0e18 && scaled > -9.0e18)) { /* Also false for NaN */
+    priv_put(writer, "null", 4);
+    return;
+  }
+  int64_t  rounded   = (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  uint64_t magnitude = rounded < 0 ? (uint64_t)0 - (uint64_t)rounded : (uint64_t)rounded;
+  uint64_t whole     = magnitude / s_powers_of_ten[decimals];
+  uint64_t fraction  = magnitude % s_powers_of_ten[decimals];
+  while (decimals > 0 && fraction % 10 == 0) {
+    fraction /= 10;
+    decimals--;
+  }
+
+  char  scratch[32];
+  char *end   = &scratch[sizeof(scratch)];
+  char *start = end;
+  if (decimals > 0) {
+    start    = priv_format_digits(fraction, end, decimals);
+    *--start = '.';
+  }
+  start = priv_format_digits(whole, start, 1);
+  if (rounded < 0) {
+    *--start = '-';
+  }
+  priv_put(writer, start, (size_t)(end - start));
+}
+
+void json_writer_uint(json_writer_t *writer, uint32_t value)
+{
+  priv_begin_value(writer);
+  char  scratch[10];
+  char *end   = &scratch[sizeof(scratch)];
+  char *start = priv_format_digits(value, end, 1);
+  priv_put(writer, start, (size_t)(end - start));
+  writer->need_comma = true;
+}
+
+size_t json_writer_finish(json_writer_t *writer)
+{
+  if (writer->size > 0) {
+    size_t end          = writer->length < writer->size ? writer->length : writer->size - 1;
+    writer->buffer[end] = '\0';
+  }
+  return writer->length;
+}
+
+size_t json_writer_write_schema(const json_schema_t *schema,
+                                const void          *data,
+                                char                *buffer,
+                                size_t               size)
+{
+  json_writer_t writer;
+  json_writer_init(&writer, buffer, size);
+  json_writer_begin_object(&writer);
+  json_writer_key(&writer, "sensor_type");
+  json_writer_string(&writer, schema->object_type, SIZE_MAX);
+
+  const uint8_t *base = (const uint8_t *)data;
+  for (uint8_t i = 0; i < schema->field_count; i++) {
+    const json_field_t *field  = &schema->fields[i];
+    const void         *member = &base[field->offset];
+    json_writer_key(&writer, field->key);
+
+    /* Members are read with memcpy, a packed struct may leave them unaligned */
+    switch (field->type) {
+      case k_json_field_float: {
+        float value;
+        memcpy(&value, member, sizeof(value));
+        json_writer_number(&writer, value, field->arg);
+        break;
+      }
+      case k_json_field_uint8:
+        json_writer_uint(&writer, *(const uint8_t *)member);
+        break;
+      case k_json_field_uint16: {
+        uint16_t value;
+        memcpy(&value, member, sizeof(value));
+        json_writer_uint(&writer, value);
+        break;
+      }
+      case k_json_field_uint32: {
+        uint32_t value;
+        memcpy(&value, member, sizeof(value));
+        json_writer_uint(&writer, value);
+        break;
+      }
+      case k_json_field_string:
+        json_writer_string(&writer, (const char *)member, field->arg);
+        break;
+    }
+  }
+
+  json_writer_end_object(&writer);
+  return json_writer_finish(&writer);
+}
@@ -2,8 +2,11 @@
 
 #include "log_handler.h"
 #include "log_storage.h"
+#include "log_record.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
@@ -12,99 +15,161 @@
 
 /* Constants ******************************************************************/
 
-const char *log_tag = "LOG_HANDLER";
+const char    *log_tag                = "LOG_HANDLER";
+const uint32_t log_drain_period_ms    = 20;                /* Drain task wake-up period when idle */
+const uint32_t log_drain_wake_records = LOG_RING_SIZE / 4; /* Records between early wake-ups, power of two */
+const uint32_t log_drain_stack_size   = 4096;
+const uint8_t  log_drain_priority     = 3;                 /* Above app_main and idle-adjacent tasks, below sensors, motion and I/O */
 
 /* Global Variables *********************************************************/
 
 _Atomic uint64_t g_log_sequence_number = 0; /* Initialize sequence counter */
 
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief Ring slot, the sequence says whose turn it is
+ * 
+ * A slot at ring position `pos` is free for a producer when its sequence 
+ * equals `pos` and ready for the drain task when it equals `pos + 1`.
+ */
+typedef struct {
+  _Atomic uint32_t sequence; /* Turn counter for this slot */
+  log_record_t     record;   /* The log record */
+} log_ring_slot_t;
+
+/**
+ * @brief Runtime level override for one tag
+ */
+typedef struct {
+  char            tag[LOG_MAX_TAG_LENGTH]; /* Tag the override applies to */
+  esp_log_level_t level;                   /* Most verbose level written for the tag */
+} log_tag_level_t;
+
 /* Globals (Static) ***********************************************************/
 
-static bool s_log_to_sd_enabled = false;
+static bool              s_log_to_sd_enabled                 = false;
+static esp_log_level_t   s_default_level                     = ESP_LOG_VERBOSE; /* Runtime level for tags without an override */
+static log_tag_level_t   s_tag_levels[LOG_MAX_TAG_OVERRIDES] = {0};
+static _Atomic uint8_t   s_tag_level_count                   = 0;               /* Published after the entry is filled */
+static portMUX_TYPE      s_tag_level_lock                    = portMUX_INITIALIZER_UNLOCKED;
+static log_ring_slot_t   s_ring[LOG_RING_SIZE]               = {0};
+static _Atomic uint32_t  s_ring_head                         = 0;               /* Next position a producer claims */
+static uint32_t          s_ring_tail                         = 0;               /* Next position drained, drain side only */
+static _Atomic bool      s_ring_running                      = false;           /* Records are queued once the drain task runs */
+static _Atomic uint32_t  s_dropped_records                   = 0;               /* Records lost to a full ring */
+static uint32_t          s_reported_drops                    = 0;               /* Drops already reported, drain side only */
+static SemaphoreHandle_t s_drain_mutex                       = NULL;            /* Serializes the drain task and log_flush */
+static TaskHandle_t      s_drain_task                        = NULL;
 
 /* Private Functions *******************************************************/
 
 /**
- * @brief Get the current task information formatted as a string
+ * @brief Copies printf arguments into a record without formatting them
  * 
- * @param buffer Buffer to store the task info string
- * @param size Size of the buffer
+ * @param record Record holding the format, filled with the arguments
+ * @param args   Arguments matching the record's format
  */
-static void priv_get_task_info(char *buffer, size_t size) 
+static void priv_capture_args(log_record_t *record, va_list args)
 {
-  if (!buffer || size == 0) {
-    return;
-  }
+  record->arg_count    = 0;
+  record->string_bytes = 0;
 
-  TaskHandle_t current_task = xTaskGetCurrentTaskHandle();
-  if (current_task) {
-    char task_name[LOG_TASK_NAME_LENGTH];
-    /* Get task name, truncate if too long */
-    strlcpy(task_name, pcTaskGetName(current_task), sizeof(task_name));
-    snprintf(buffer, size, "[%s:%p]", task_name, (void*)current_task);
-  } else {
-    /* If no task context (e.g. running from ISR), indicate that */
-    snprintf(buffer, size, "[ISR]");
-  }
-}
+  for (const char *p = strchr(record->format, '%'); p != NULL; p = strchr(p, '%')) {
+    log_spec_t spec;
+    log_record_parse_spec(p, &spec);
+    p += spec.length;
 
-/* Public Functions ********************************************************/
+    if (spec.kind == k_log_arg_none) {
+      continue;
+    }
+    if (record->arg_count + spec.stars + 1 > LOG_RECORD_MAX_ARGS) {
+      return; /* The drain task prints the rest of the format as is */
+    }
+    for (uint8_t i = 0; i < spec.stars; i++) {
+      record->args[record->arg_count++].i = va_arg(args, int);
+    }
 
-void log_write_va(esp_log_level_t level, 
-                  const char     *tag,
-                  const char     *short_msg, 
-                  const char     *detailed_msg,
-                  va_list         args) 
-{
-  if (!tag || !short_msg || !detailed_msg) {
-    ESP_LOGE(tag, "Invalid arguments: tag, short_msg, or detailed_msg is NULL");
-    return;
+    log_arg_t *arg = &record->args[record->arg_count++];
+    switch (spec.kind) {
+      case k_log_arg_long:    arg->i = va_arg(args, long);      break;
+      case k_log_arg_llong:   arg->i = va_arg(args, long long); break;
+      case k_log_arg_size:    arg->i = va_arg(args, size_t);    break;
+      case k_log_arg_double:  arg->d = va_arg(args, double);    break;
+      case k_log_arg_pointer: arg->p = va_arg(args, void *);    break;
+      case k_log_arg_string: {
+        const char *str   = va_arg(args, const char *);
+        size_t      avail = sizeof(record->strings) - record->string_bytes;
+        if (avail == 0) {
+          arg->i = sizeof(record->strings) - 1; /* Pool full, the last byte is a terminator */
+          break;
+        }
+        arg->i     = record->string_bytes;
+        size_t len = strlcpy(&record->strings[record->string_bytes], 
+                             str ? str : "(null)", 
+                             avail);
+        record->string_bytes += (len < avail) ? len + 1 : avail;
+        break;
+      }
+      default:                arg->i = va_arg(args, int);       break;
+    }
   }
+}
 
-  /* Format the detailed message with provided va_list */
-  char formatted_msg[LOG_MAX_MESSAGE_LENGTH];
-  vsnprintf(formatted_msg, sizeof(formatted_msg), detailed_msg, args);
-
-  /* Get task information */
+/**
+ * @brief Writes a finished log line to the console and storage
+ * 
+ * @param record        Record the line belongs to, formats are not used
+ * @param formatted_msg Detailed message, already formatted
+ */
+static void priv_emit(const log_record_t *record, const char *formatted_msg)
+{
   char task_info[LOG_MAX_MESSAGE_LENGTH / 4];
-  priv_get_task_info(task_info, sizeof(task_info));
+  if (record->task != NULL) {
+    snprintf(task_info, sizeof(task_info), "[%s:%p]", record->task_name, record->task);
+  } else {
+    /* If no task context (e.g. running from ISR), indicate that */
+    snprintf(task_info, sizeof(task_info), "[ISR]");
+  }
 
   /* Create the complete log message with the required format */
   char complete_msg[LOG_MAX_MESSAGE_LENGTH * 2];
-  char *timestamp = NULL;
-  uint64_t seq_num = atomic_fetch_add(&g_log_sequence_number, 1);
 
-  /* Only try to get timestamp if time manager is initialized */
+  /* Only render a timestamp once the time manager has a wall clock */
   if (time_manager_is_initialized()) {
-    timestamp = time_manager_get_timestamp();
-  }
+    /* Wall time of the call, not of the drain */
+    int64_t   age_s = (esp_timer_get_time() - record->timestamp_us) / 1000000;
+    time_t    then  = time(NULL) - (time_t)age_s;
+    struct tm timeinfo;
+    char      timestamp[LOG_TIMESTAMP_LENGTH];
+    localtime_r(&then, &timeinfo);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
-  if (timestamp != NULL) {
     /* Include timestamp, sequence number, and task info */
     snprintf(complete_msg, 
              sizeof(complete_msg), 
              "[%s][%llu]%s %s%s%s",
              timestamp,
-             seq_num,
+             record->sequence,
              task_info,
-             short_msg,
+             record->short_msg,
              LOG_SEPARATOR,
              formatted_msg);
-    free(timestamp);
   } else {
     /* Skip timestamp but include sequence number and task info */
     snprintf(complete_msg, 
              sizeof(complete_msg), 
              "[%llu]%s %s%s%s",
-             seq_num,
+             record->sequence,
              task_info,
-             short_msg,
+             record->short_msg,
              LOG_SEPARATOR,
              formatted_msg);
   }
 
   /* Log using ESP's logging system */
-  switch (level) {
+  const char *tag = record->tag;
+  switch (record->level) {
     case ESP_LOG_ERROR:
       ESP_LOGE(tag, "%s", complete_msg);
       break;
@@ -125,9 +190,240 @@ void log_write_va(esp_log_level_t level,
       break;
   }
   
-  /* If SD card logging is enabled, also write to storage */
+  /* If SD card logging is enabled, also write to storage, it keeps the record unformatted */
   if (s_log_to_sd_enabled) {
-    log_storage_write(level, complete_msg);
+    log_storage_write(record);
+  }
+}
+
+/**
+ * @brief Fills the fields every record carries
+ * 
+ * @param record    Record to fill
+ * @param level     Log level
+ * @param tag       Component or module identifier
+ * @param short_msg Short description of the log
+ * @param format    printf format of the detailed message
+ */
+static inline void priv_fill_record(log_record_t   *record,
+                                    esp_log_level_t level,
+                                    const char     *tag,
+                                    const char     *short_msg,
+                                    const char     *format)
+{
+  record->sequence     = atomic_fetch_add(&g_log_sequence_number, 1);
+  record->timestamp_us = esp_timer_get_time();
+  record->level        = level;
+  record->tag          = tag;
+  record->short_msg    = short_msg;
+  record->format       = format;
+  record->task         = NULL;
+  record->task_name[0] = '\0';
+
+  if (!xPortInIsrContext()) {
+    TaskHandle_t current_task = xTaskGetCurrentTaskHandle();
+    if (current_task != NULL) {
+      /* Get task name, truncate if too long */
+      record->task = current_task;
+      strlcpy(record->task_name, pcTaskGetName(current_task), sizeof(record->task_name));
+    }
+  }
+}
+
+/**
+ * @brief Claims a free ring slot
+ * 
+ * Lock-free and safe from ISRs, producers only contend on one compare-and-swap.
+ * 
+ * @param position Set to the claimed ring position
+ * @return The slot, or NULL if the ring is full
+ */
+static log_ring_slot_t *priv_ring_claim(uint32_t *position)
+{
+  uint32_t pos = atomic_load_explicit(&s_ring_head, memory_order_relaxed);
+  while (true) {
+    log_ring_slot_t *slot = &s_ring[pos & (LOG_RING_SIZE - 1)];
+    uint32_t         seq  = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    int32_t          diff = (int32_t)(seq - pos);
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&s_ring_head, 
+                                                &pos, 
+                                                pos + 1, 
+                                                memory_order_relaxed, 
+                                                memory_order_relaxed)) {
+        *position = pos;
+        return slot;
+      }
+    } else if (diff < 0) {
+      return NULL; /* The drain task has not freed this slot yet */
+    } else {
+      pos = atomic_load_explicit(&s_ring_head, memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * @brief Formats and writes every record published so far
+ * 
+ * Must hold `s_drain_mutex`, the ring has a single consumer.
+ */
+static void priv_drain_ring(void)
+{
+  char formatted_msg[LOG_MAX_MESSAGE_LENGTH];
+
+  while (true) {
+    log_ring_slot_t *slot = &s_ring[s_ring_tail & (LOG_RING_SIZE - 1)];
+    uint32_t         seq  = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (seq != s_ring_tail + 1) {
+      break; /* Empty, or the next producer has not finished its record */
+    }
+
+    log_record_render(&slot->record, formatted_msg, sizeof(formatted_msg));
+    priv_emit(&slot->record, formatted_msg);
+
+    atomic_store_explicit(&slot->sequence, s_ring_tail + LOG_RING_SIZE, memory_order_release);
+    s_ring_tail++;
+  }
+
+  /* Reported straight from here, queuing the warning could drop it too */
+  uint32_t dropped = atomic_load(&s_dropped_records);
+  if (dropped != s_reported_drops) {
+    log_record_t record;
+    priv_fill_record(&record, ESP_LOG_WARN, log_tag, "Ring Full", "%lu log records dropped");
+    record.args[0].i    = dropped - s_reported_drops;
+    record.arg_count    = 1;
+    record.string_bytes = 0;
+    log_record_render(&record, formatted_msg, sizeof(formatted_msg));
+    priv_emit(&record, formatted_msg);
+    s_reported_drops = dropped;
+  }
+}
+
+/**
+ * @brief Task that formats and stores queued records
+ * 
+ * Runs every `log_drain_period_ms`, or sooner when producers notify it
+ * after every `log_drain_wake_records` records.
+ * 
+ * @param arg Unused
+ */
+static void priv_log_drain_task(void *arg)
+{
+  while (1) {
+    if (xSemaphoreTake(s_drain_mutex, portMAX_DELAY) == pdTRUE) {
+      priv_drain_ring();
+      xSemaphoreGive(s_drain_mutex);
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(log_drain_period_ms));
+  }
+}
+
+/**
+ * @brief Finds the runtime override for a tag
+ * 
+ * @param tag Tag to look up
+ * @return The override, or NULL if the tag uses the default level
+ */
+static log_tag_level_t *priv_find_tag_level(const char *tag)
+{
+  uint8_t count = atomic_load(&s_tag_level_count);
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(s_tag_levels[i].tag, tag) == 0) {
+      return &s_tag_levels[i];
+    }
+  }
+  return NULL;
+}
+
+/* Public Functions ********************************************************/
+
+bool log_level_enabled(const char *tag, esp_log_level_t level)
+{
+  /* No overrides is the common case, skip the tag comparison entirely */
+  if (atomic_load(&s_tag_level_count) == 0 || tag == NULL) {
+    return level <= s_default_level;
+  }
+
+  const log_tag_level_t *override = priv_find_tag_level(tag);
+  return level <= (override ? override->level : s_default_level);
+}
+
+esp_err_t log_set_level(const char *tag, esp_log_level_t level)
+{
+  if (tag == NULL || strlen(tag) >= LOG_MAX_TAG_LENGTH) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t ret = ESP_OK;
+  taskENTER_CRITICAL(&s_tag_level_lock);
+  log_tag_level_t *override = priv_find_tag_level(tag);
+  if (override != NULL) {
+    override->level = level;
+  } else if (s_tag_level_count < LOG_MAX_TAG_OVERRIDES) {
+    /* Fill the entry before publishing it through the count */
+    override = &s_tag_levels[s_tag_level_count];
+    strlcpy(override->tag, tag, sizeof(override->tag));
+    override->level = level;
+    atomic_fetch_add(&s_tag_level_count, 1);
+  } else {
+    ret = ESP_ERR_NO_MEM;
+  }
+  taskEXIT_CRITICAL(&s_tag_level_lock);
+
+  if (ret == ESP_OK) {
+    esp_log_level_set(tag, level);
+  }
+  return ret;
+}
+
+void log_set_default_level(esp_log_level_t level)
+{
+  s_default_level = level;
+}
+
+
+void log_write_va(esp_log_level_t level, 
+                  const char     *tag,
+                  const char     *short_msg, 
+                  const char     *detailed_msg,
+                  va_list         args) 
+{
+  if (!tag || !short_msg || !detailed_msg) {
+    ESP_LOGE(tag, "Invalid arguments: tag, short_msg, or detailed_msg is NULL");
+    return;
+  }
+
+  if (!atomic_load_explicit(&s_ring_running, memory_order_acquire)) {
+    /* No drain task yet, format and write in the caller */
+    log_record_t record;
+    char         formatted_msg[LOG_MAX_MESSAGE_LENGTH];
+    priv_fill_record(&record, level, tag, short_msg, detailed_msg);
+    priv_capture_args(&record, args);
+    log_record_render(&record, formatted_msg, sizeof(formatted_msg));
+    priv_emit(&record, formatted_msg);
+    return;
+  }
+
+  /* Hot path, capture the raw arguments and leave formatting to the drain task */
+  uint32_t         position;
+  log_ring_slot_t *slot = priv_ring_claim(&position);
+  if (slot == NULL) {
+    atomic_fetch_add(&s_dropped_records, 1);
+    return;
+  }
+
+  priv_fill_record(&slot->record, level, tag, short_msg, detailed_msg);
+  priv_capture_args(&slot->record, args);
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+
+  /* Wake the drain task early during bursts instead of waiting for its period */
+  if (((position + 1) & (log_drain_wake_records - 1)) == 0) {
+    if (xPortInIsrContext()) {
+      vTaskNotifyGiveFromISR(s_drain_task, NULL);
+    } else {
+      xTaskNotifyGive(s_drain_task);
+    }
   }
 }
 
@@ -162,6 +458,31 @@ esp_err_t log_init(bool log_to_sd)
     log_info(log_tag, "Storage Ready", "Log storage initialized successfully");
   }
   
+  if (s_drain_task == NULL) {
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+      atomic_init(&s_ring[i].sequence, i);
+    }
+
+    s_drain_mutex = xSemaphoreCreateMutex();
+    if (s_drain_mutex == NULL) {
+      log_error(log_tag, "Mutex Error", "Failed to create log drain mutex");
+      return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t task_created = xTaskCreate(priv_log_drain_task,
+                                          "log_drain_task",
+                                          log_drain_stack_size,
+                                          NULL,
+                                          log_drain_priority,
+                                          &s_drain_task);
+    if (task_created != pdPASS) {
+      log_error(log_tag, "Task Error", "Failed to create log drain task");
+      s_drain_task = NULL;
+      return ESP_FAIL;
+    }
+    atomic_store_explicit(&s_ring_running, true, memory_order_release);
+  }
+  
   log_info(log_tag, "Init Complete", "Log handler initialized successfully");
   return ESP_OK;
 }
@@ -177,6 +498,12 @@ void log_set_sd_logging(bool enabled)
 
 esp_err_t log_flush(void)
 {
+  /* Hand queued records to storage before flushing it */
+  if (s_drain_mutex != NULL && xSemaphoreTake(s_drain_mutex, portMAX_DELAY) == pdTRUE) {
+    priv_drain_ring();
+    xSemaphoreGive(s_drain_mutex);
+  }
+
   if (!s_log_to_sd_enabled) {
     log_info(log_tag, "Flush Skip", "SD card logging is disabled, skipping flush");
     return ESP_OK;
@@ -191,4 +518,9 @@ esp_err_t log_flush(void)
   }
   
   return ret;
-}
\ No newline at end of file
+}
+
+uint32_t log_get_dropped_count(void)
+{
+  return atomic_load(&s_dropped_records);
+}
@@ -0,0 +1,349 @@
+/* components/common/log_record.c */
+
+#include "log_record.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Maps a signed value onto an unsigned one, small magnitudes stay small
+ * 
+ * @param value Signed value
+ * @return Zigzag encoded value
+ */
+static inline uint64_t priv_zigzag(int64_t value)
+{
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**
+ * @brief Writes a length-prefixed string
+ * 
+ * @param out     Destination
+ * @param str     String to write
+ * @param max_len Longest length written, the rest is cut
+ * @return Bytes written
+ */
+static size_t priv_put_string(uint8_t *out, const char *str, size_t max_len)
+{
+  size_t len = strnlen(str, max_len);
+  size_t pos = log_record_put_varint(out, len);
+  memcpy(&out[pos], str, len);
+  return pos + len;
+}
+
+/**
+ * @brief Finds a static string's id, defining it first if it is new to the file
+ * 
+ * @param encoder Encoder of the file
+ * @param str     String, interned by address
+ * @param out     Destination for a definition block
+ * @param pos     Advanced by the bytes written to out
+ * @return The string's id, 0 if the table is full and it must go inline
+ */
+static uint16_t priv_intern_string(log_record_encoder_t *encoder, 
+                                   const char           *str, 
+                                   uint8_t              *out, 
+                                   size_t               *pos)
+{
+  for (uint16_t i = 0; i < encoder->string_count; i++) {
+    if (encoder->strings[i] == str) {
+      return i + 1;
+    }
+  }
+  if (encoder->string_count >= LOG_RECORD_MAX_STRINGS) {
+    return 0;
+  }
+
+  uint16_t id              = ++encoder->string_count;
+  encoder->strings[id - 1] = str;
+  out[(*pos)++]            = k_log_block_string;
+  *pos                    += log_record_put_varint(&out[*pos], id);
+  *pos                    += priv_put_string(&out[*pos], str, LOG_RECORD_MAX_STRING_DEF);
+  return id;
+}
+
+/**
+ * @brief Finds a task name's id, defining it first if it is new to the file
+ * 
+ * @param encoder Encoder of the file
+ * @param name    Task name, interned by content
+ * @param out     Destination for a definition block
+ * @param pos     Advanced by the bytes written to out
+ * @return The name's id, 0 if it is empty or the table is full and it must go inline
+ */
+static uint8_t priv_intern_task(log_record_encoder_t *encoder, 
+                                const char           *name, 
+                                uint8_t              *out, 
+                                size_t               *pos)
+{
+  if (name[0] == '\0') {
+    return 0;
+  }
+  for (uint8_t i = 0; i < encoder->task_count; i++) {
+    if (strncmp(encoder->tasks[i], name, LOG_RECORD_TASK_NAME_LENGTH) == 0) {
+      return i + 1;
+    }
+  }
+  if (encoder->task_count >= LOG_RECORD_MAX_TASKS) {
+    return 0;
+  }
+
+  uint8_t id = ++encoder->task_count;
+  strncpy(encoder->tasks[id - 1], name, LOG_RECORD_TASK_NAME_LENGTH);
+  out[(*pos)++]  = k_log_block_task;
+  *pos          += log_record_put_varint(&out[*pos], id);
+  *pos          += priv_put_string(&out[*pos], name, LOG_RECORD_TASK_NAME_LENGTH);
+  return id;
+}
+
+/**
+ * @brief Writes a string id, followed by the string itself for id 0
+ * 
+ * @param out     Destination
+ * @param id      Interned id, 0 for inline
+ * @param str     String the id stands for
+ * @param max_len Longest length written inline
+ * @return Bytes written
+ */
+static size_t priv_put_ref(uint8_t *out, uint16_t id, const char *str, size_t max_len)
+{
+  size_t pos = log_record_put_varint(out, id);
+  if (id == 0) {
+    pos += priv_put_string(&out[pos], str, max_len);
+  }
+  return pos;
+}
+
+/* Public Functions ***********************************************************/
+
+void log_record_parse_spec(const char *spec_start, log_spec_t *spec)
+{
+  const char *p = spec_start + 1;
+  spec->stars   = 0;
+  spec->kind    = k_log_arg_int;
+
+  while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+    p++;
+  }
+  for (uint8_t field = 0; field < 2; field++) { /* Width, then precision */
+    if (field == 1) {
+      if (*p != '.') {
+        break;
+      }
+      p++;
+    }
+    if (*p == '*') {
+      spec->stars++;
+      p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+      p++;
+    }
+  }
+
+  if (p[0] == 'l' && p[1] == 'l') {
+    spec->kind  = k_log_arg_llong;
+    p          += 2;
+  } else if (*p == 'l') {
+    spec->kind = k_log_arg_long;
+    p++;
+  } else if (*p == 'j' || *p == 'L' || *p == 'q') {
+    spec->kind = k_log_arg_llong;
+    p++;
+  } else if (*p == 'z' || *p == 't') {
+    spec->kind = k_log_arg_size;
+    p++;
+  } else {
+    while (*p == 'h') {
+      p++;
+    }
+  }
+
+  switch (*p) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+      break; /* Integer kind from the length modifier */
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      spec->kind = k_log_arg_double;
+      break;
+    case 's':
+      spec->kind = k_log_arg_string;
+      break;
+    case 'p':
+      spec->kind = k_log_arg_pointer;
+      break;
+    default: /* %% or unsupported, prints as is without an argument */
+      spec->kind  = k_log_arg_none;
+      spec->stars = 0;
+      break;
+  }
+  spec->length = (uint8_t)(p - spec_start + (*p != '\0' ? 1 : 0));
+}
+
+void log_record_render(const log_record_t *record, char *buffer, size_t size)
+{
+  const char *p        = record->format;
+  size_t      pos      = 0;
+  uint8_t     next_arg = 0;
+
+  buffer[0] = '\0';
+  while (*p != '\0' && pos + 1 < size) {
+    if (*p != '%') {
+      buffer[pos++] = *p++;
+      buffer[pos]   = '\0';
+      continue;
+    }
+
+    log_spec_t spec;
+    log_record_parse_spec(p, &spec);
+    if (spec.kind != k_log_arg_none && next_arg + spec.stars + 1 > record->arg_count) {
+      snprintf(&buffer[pos], size - pos, "%s", p); /* Arguments that did not fit */
+      return;
+    }
+
+    char spec_text[LOG_RECORD_SPEC_LENGTH];
+    if (spec.length >= sizeof(spec_text)) {
+      snprintf(&buffer[pos], size - pos, "%s", p);
+      return;
+    }
+    memcpy(spec_text, p, spec.length);
+    spec_text[spec.length] = '\0';
+    p += spec.length;
+
+    int stars[2] = { 0, 0 };
+    for (uint8_t i = 0; i < spec.stars; i++) {
+      stars[i] = (int)record->args[next_arg++].i;
+    }
+
+    /* Each conversion is formatted on its own, passing the value back as its original type */
+    const log_arg_t *arg     = (spec.kind != k_log_arg_none) ? &record->args[next_arg++] : NULL;
+    int              written = 0;
+    char            *out     = &buffer[pos];
+    size_t           avail   = size - pos;
+    switch (spec.kind) {
+      case k_log_arg_none:
+        written = snprintf(out, avail, "%s", (spec_text[1] == '%') ? "%" : spec_text);
+        break;
+#define LOG_RENDER(value)                                                     \
+        (spec.stars == 2) ? snprintf(out, avail, spec_text, stars[0], stars[1], value) : \
+        (spec.stars == 1) ? snprintf(out, avail, spec_text, stars[0], value) :           \
+                            snprintf(out, avail, spec_text, value)
+      case k_log_arg_long:    written = LOG_RENDER((long)arg->i);                                   break;
+      case k_log_arg_llong:   written = LOG_RENDER((long long)arg->i);                              break;
+      case k_log_arg_size:    written = LOG_RENDER((size_t)arg->i);                                 break;
+      case k_log_arg_double:  written = LOG_RENDER(arg->d);                                         break;
+      case k_log_arg_pointer: written = LOG_RENDER(arg->p);                                         break;
+      case k_log_arg_string:  written = LOG_RENDER(&record->strings[arg->i]);                       break;
+      default:                written = LOG_RENDER((int)arg->i);                                    break;
+#undef LOG_RENDER
+    }
+    if (written > 0) {
+      pos += ((size_t)written < avail) ? (size_t)written : avail - 1;
+    }
+  }
+}
+
+size_t log_record_put_varint(uint8_t *out, uint64_t value)
+{
+  size_t pos = 0;
+  while (value >= 0x80) {
+    out[pos++]   = (uint8_t)(value | 0x80);
+    value      >>= 7;
+  }
+  out[pos++] = (uint8_t)value;
+  return pos;
+}
+
+size_t log_record_get_varint(const uint8_t *in, size_t len, uint64_t *value)
+{
+  uint64_t result = 0;
+  for (size_t pos = 0; pos < len && pos < 10; pos++) {
+    result |= (uint64_t)(in[pos] & 0x7F) << (7 * pos);
+    if ((in[pos] & 0x80) == 0) {
+      *value = result;
+      return pos + 1;
+    }
+  }
+  return 0;
+}
+
+size_t log_record_encoder_reset(log_record_encoder_t *encoder, uint8_t *out)
+{
+  memset(encoder, 0, sizeof(*encoder));
+  memcpy(out, LOG_RECORD_FILE_MAGIC, sizeof(LOG_RECORD_FILE_MAGIC) - 1);
+  out[sizeof(LOG_RECORD_FILE_MAGIC) - 1] = LOG_RECORD_FILE_VERSION;
+  return sizeof(LOG_RECORD_FILE_MAGIC);
+}
+
+size_t log_record_encode_time_sync(uint8_t *out, int64_t offset_us)
+{
+  out[0] = k_log_block_time_sync;
+  return 1 + log_record_put_varint(&out[1], priv_zigzag(offset_us));
+}
+
+size_t log_record_encode(log_record_encoder_t *encoder,
+                         const log_record_t   *record,
+                         uint8_t              *out)
+{
+  /* Definitions of new strings go first, the entry refers to them by id */
+  size_t   pos       = 0;
+  uint16_t tag_id    = priv_intern_string(encoder, record->tag, out, &pos);
+  uint16_t short_id  = priv_intern_string(encoder, record->short_msg, out, &pos);
+  uint16_t format_id = priv_intern_string(encoder, record->format, out, &pos);
+  uint8_t  task_id   = priv_intern_task(encoder, record->task_name, out, &pos);
+
+  out[pos++]  = k_log_block_entry + record->level;
+  pos        += log_record_put_varint(&out[pos], priv_zigzag((int64_t)(record->sequence - encoder->last_sequence)));
+  pos        += log_record_put_varint(&out[pos], priv_zigzag(record->timestamp_us - encoder->last_timestamp_us));
+  pos        += priv_put_ref(&out[pos], tag_id, record->tag, LOG_RECORD_MAX_STRING_DEF);
+  pos        += priv_put_ref(&out[pos], short_id, record->short_msg, LOG_RECORD_MAX_STRING_DEF);
+  pos        += priv_put_ref(&out[pos], format_id, record->format, LOG_RECORD_MAX_STRING_DEF);
+  pos        += priv_put_ref(&out[pos], task_id, record->task_name, LOG_RECORD_TASK_NAME_LENGTH);
+  pos        += log_record_put_varint(&out[pos], record->arg_count);
+
+  /* Arguments follow the format, so the decoder recovers their kinds by parsing it */
+  uint8_t next_arg = 0;
+  for (const char *p = strchr(record->format, '%'); 
+       p != NULL && next_arg < record->arg_count; 
+       p = strchr(p, '%')) {
+    log_spec_t spec;
+    log_record_parse_spec(p, &spec);
+    p += spec.length;
+
+    if (spec.kind == k_log_arg_none) {
+      continue;
+    }
+    for (uint8_t i = 0; i < spec.stars && next_arg < record->arg_count; i++) {
+      pos += log_record_put_varint(&out[pos], priv_zigzag(record->args[next_arg++].i));
+    }
+    if (next_arg >= record->arg_count) {
+      break;
+    }
+
+    const log_arg_t *arg = &record->args[next_arg++];
+    switch (spec.kind) {
+      case k_log_arg_double: {
+        uint64_t bits;
+        memcpy(&bits, &arg->d, sizeof(bits));
+        for (uint8_t i = 0; i < sizeof(bits); i++) {
+          out[pos++] = (uint8_t)(bits >> (8 * i));
+        }
+        break;
+      }
+      case k_log_arg_string:
+        pos += priv_put_string(&out[pos], &record->strings[arg->i], LOG_RECORD_STRING_BYTES);
+        break;
+      case k_log_arg_pointer:
+        pos += log_record_put_varint(&out[pos], (uintptr_t)arg->p);
+        break;
+      default:
+        pos += log_record_put_varint(&out[pos], priv_zigzag(arg->i));
+        break;
+    }
+  }
+
+  encoder->last_sequence     = record->sequence;
+  encoder->last_timestamp_us = record->timestamp_us;
+  return pos;
+}
@@ -3,10 +3,15 @@
 #include "log_storage.h"
 #include "log_handler.h"
 #include "file_write_manager.h"
+#include "time_manager.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -24,45 +29,53 @@ const int   log_max_file_size        = 1024 * 1024;           /* Maximum log fil
 const int   log_max_files            = 10;                    /* Maximum number of log files to keep */
 const int   log_compression_enabled  = 1;                     /* Enable/disable compression (1=enabled, 0=disabled) */
 const int   log_compression_level    = Z_DEFAULT_COMPRESSION; /* Compression level (0-9, or Z_DEFAULT_COMPRESSION) */
-const int   log_compression_buffer   = 4096;                  /* Size of compression buffer */
-const char *log_compressed_extension = ".gz";                 /* Extension for compressed log files */
-const int   log_zlib_window_bits     = 15 + 16;               /* Window size with gzip header */
-const int   log_zlib_mem_level       = 8;                     /* Memory level for zlib compression */
+const int   log_compression_buffer   = LOG_COMPRESSION_BUFFER_SIZE; /* Size of compression buffer */
+const char *log_binary_extension     = ".tlog";               /* Extension for binary log files */
+const char *log_compressed_extension = ".gz";                 /* Extension added to compressed log files */
+const int   log_time_sync_tolerance  = 1000000;               /* Wall clock drift in microseconds before a new time sync block */
+const int   log_zlib_window_bits     = 12 + 16;               /* 4 KB window with gzip header, kept for the whole file */
+const int   log_zlib_mem_level       = 4;                     /* Memory level for zlib compression, ~24 KB of state with the window */
+const int   log_buffer_budget        = 16 * 1024;             /* Bytes of internal RAM for buffered records, ~200 typical records */
+const int   log_buffer_psram_budget  = 256 * 1024;            /* Bytes of PSRAM for buffered records, minutes of history while the SD card is out */
 
 /* Globals (Static) ***********************************************************/
 
-static log_entry_t       s_log_buffer[LOG_BUFFER_SIZE]            = {0};   /* Buffer to store logs when SD card is not available */
-static uint32_t          s_log_buffer_index                       = 0;     /* Current index in the buffer */
-static bool              s_log_storage_initialized                = false; /* Flag to track initialization status */
-static char              s_current_log_file[MAX_FILE_PATH_LENGTH] = {0};   /* Current log file path */
-static SemaphoreHandle_t s_log_mutex                              = NULL;  /* Mutex for thread-safe access */
-static bool              s_compression_enabled                    = true;  /* Compression state */
-static bool              s_sd_card_available                      = false; /* Flag indicating if SD card is available */
+static uint8_t              *s_log_buffer                                  = NULL;  /* Packed records waiting for the SD card, a byte ring */
+static size_t                s_log_buffer_capacity                         = 0;     /* Size of s_log_buffer */
+static size_t                s_log_buffer_head                             = 0;     /* Offset where the next record is written */
+static size_t                s_log_buffer_tail                             = 0;     /* Offset of the oldest record */
+static size_t                s_log_buffer_used                             = 0;     /* Bytes used in s_log_buffer */
+static uint32_t              s_log_buffer_count                            = 0;     /* Records in s_log_buffer */
+static uint32_t              s_level_counts[ESP_LOG_VERBOSE + 1]           = {0};   /* Records in s_log_buffer per level */
+static log_overflow_policy_t s_overflow_policy                             = k_log_overflow_drop_lower_severity; /* What to evict when full */
+static uint32_t              s_block_timeout_ms                            = 100;   /* Longest wait with k_log_overflow_block */
+static SemaphoreHandle_t     s_space_available                             = NULL;  /* Given when a flush empties the buffer */
+static bool                  s_overflow_reported                           = false; /* Whether this outage's first loss was reported */
+static uint32_t              s_dropped_records                             = 0;     /* New records discarded */
+static uint32_t              s_overwritten_records                         = 0;     /* Buffered records evicted */
+static uint32_t              s_flushed_records                             = 0;     /* Records written to the SD card */
+static log_record_t          s_flush_record                                = {0};   /* Record being unpacked for encoding */
+static bool                  s_log_storage_initialized                     = false; /* Flag to track initialization status */
+static char                  s_current_log_file[MAX_FILE_PATH_LENGTH]      = {0};   /* Current log file path */
+static SemaphoreHandle_t     s_log_mutex                                   = NULL;  /* Mutex for thread-safe access */
+static bool                  s_compression_enabled                         = true;  /* Compression state */
+static bool                  s_sd_card_available                           = false; /* Flag indicating if SD card is available */
+static uint32_t              s_current_file_bytes                          = 0;     /* Bytes handed to the writer for the current file */
+static bool                  s_file_started                                = false; /* Whether the current file has its header */
+static int64_t               s_time_offset_us                              = 0;     /* Unix time minus esp_timer time last written to the file */
+static log_record_encoder_t  s_encoder                                     = {0};   /* Interned strings of the current file */
+static uint8_t               s_encode_buffer[LOG_RECORD_MAX_ENCODED_SIZE]  = {0};   /* One encoded record */
+static z_stream              s_deflate_stream                              = {0};   /* Compression state of the current file */
+static bool                  s_deflate_open                                = false; /* Whether s_deflate_stream holds an open gzip stream */
+static file_write_buffer_t  *s_write_buffer                                = NULL;  /* Pooled buffer being filled, handed to the writer when full */
+static size_t                s_write_length                                = 0;     /* Bytes used in s_write_buffer without compression */
+static file_write_id_t       s_file_id                                     = FILE_WRITE_INVALID_ID; /* Interned s_current_log_file */
+static bool                  s_write_critical                              = false; /* Whether bytes not yet handed to the writer hold an error */
+static time_t                s_log_file_time                               = 0;     /* Second the current file was named in */
+static uint32_t              s_log_file_sequence                           = 0;     /* Files already named in that second */
 
 /* Private Helper Functions ***************************************************/
 
-/**
- * @brief Converts microseconds timestamp to seconds
- * 
- * @param[in] timestamp_us Timestamp in microseconds
- * @return Timestamp in seconds
- */
-static inline time_t priv_timestamp_us_to_seconds(uint64_t timestamp_us)
-{
-  return timestamp_us / 1000000;
-}
-
-/**
- * @brief Extracts milliseconds from microseconds timestamp
- * 
- * @param[in] timestamp_us Timestamp in microseconds
- * @return Milliseconds component (0-999)
- */
-static inline uint64_t priv_timestamp_us_to_milliseconds(uint64_t timestamp_us)
-{
-  return (timestamp_us % 1000000) / 1000;
-}
-
 /**
  * @brief Formats a date string in YYYY-MM-DD format
  * 
@@ -83,38 +96,6 @@ static inline int priv_format_date_string(char                  *buffer,
                   timeinfo->tm_mday);
 }
 
-/**
- * @brief Formats a log entry with timestamp, level, and message
- * 
- * @param[out] buffer       Output buffer to store formatted string
- * @param[in]  buffer_size  Size of output buffer
- * @param[in]  timeinfo     Time information structure
- * @param[in]  milliseconds Millisecond component of timestamp
- * @param[in]  level_str    String representation of log level
- * @param[in]  message      The log message
- * @return Number of characters written (excluding null terminator)
- */
-static inline int priv_format_log_entry(char                  *buffer,
-                                        size_t                 buffer_size,
-                                        const struct tm *const timeinfo,
-                                        uint64_t               milliseconds,
-                                        const char *const      level_str,
-                                        const char *const      message)
-{
-  return snprintf(buffer, 
-                  buffer_size,
-                  "%04d-%02d-%02d %02d:%02d:%02d.%03llu [%s] %s",
-                  timeinfo->tm_year + 1900,
-                  timeinfo->tm_mon + 1,
-                  timeinfo->tm_mday,
-                  timeinfo->tm_hour,
-                  timeinfo->tm_min,
-                  timeinfo->tm_sec,
-                  milliseconds,
-                  level_str,
-                  message);
-}
-
 /**
  * @brief Formats a log filepath based on date and time
  * 
@@ -148,24 +129,6 @@ static inline int priv_format_log_filepath(char                  *buffer,
 
 /* Private Functions **********************************************************/
 
-/**
- * @brief Converts a log level to its string representation
- * 
- * @param[in] level The log level
- * @return Const string representing the log level
- */
-static const char *priv_log_level_to_string(esp_log_level_t level)
-{
-  switch (level) {
-    case ESP_LOG_ERROR:   return "ERROR";
-    case ESP_LOG_WARN:    return "WARN";
-    case ESP_LOG_INFO:    return "INFO";
-    case ESP_LOG_DEBUG:   return "DEBUG";
-    case ESP_LOG_VERBOSE: return "VERBOSE";
-    default:              return "UNKNOWN";
-  }
-}
-
 /**
  * @brief Generates a log file path based on the current date and time
  * 
@@ -178,7 +141,22 @@ static void priv_generate_log_file_path(char *file_path, size_t file_path_len)
   time_t    now = time(NULL);
   localtime_r(&now, &timeinfo);
   
-  const char *extension = s_compression_enabled ? log_compressed_extension : ".txt";
+  /* A second file in the same second must not append to an abandoned stream */
+  s_log_file_sequence = (now == s_log_file_time) ? s_log_file_sequence + 1 : 0;
+  s_log_file_time     = now;
+  
+  char sequence[12] = "";
+  if (s_log_file_sequence > 0) {
+    snprintf(sequence, sizeof(sequence), "_%lu", (unsigned long)s_log_file_sequence);
+  }
+  
+  char extension[32];
+  snprintf(extension, 
+           sizeof(extension), 
+           "%s%s%s", 
+           sequence,
+           log_binary_extension, 
+           s_compression_enabled ? log_compressed_extension : "");
   priv_format_log_filepath(file_path, file_path_len, &timeinfo, extension);
 }
 
@@ -194,15 +172,8 @@ static bool priv_check_log_rotation(void)
     return false;
   }
   
-  /* Check file size */
-  struct stat st;
-  if (stat(s_current_log_file, &st) != 0) {
-    /* File doesn't exist, no need to rotate */
-    return false;
-  }
-  
-  /* Check if file size exceeds the maximum */
-  if (st.st_size >= log_max_file_size) {
+  /* Check file size, counted as written since the writer appends asynchronously */
+  if (s_current_file_bytes >= (uint32_t)log_max_file_size) {
     return true;
   }
   
@@ -229,49 +200,77 @@ static bool priv_check_log_rotation(void)
 }
 
 /**
- * @brief Rotates the log file if needed
+ * @brief Takes a pooled buffer to collect output in, if none is held
  * 
- * @return ESP_OK if successful, ESP_FAIL otherwise
+ * @return ESP_OK if successful, ESP_FAIL if no buffer became free
  */
-static esp_err_t priv_rotate_log_file(void)
+static esp_err_t priv_write_reserve(void)
 {
-  if (!priv_check_log_rotation()) {
-    return ESP_OK; /* No rotation needed */
+  if (s_write_buffer != NULL) {
+    return ESP_OK;
   }
-  
-  /* Generate new log file path */
-  priv_generate_log_file_path(s_current_log_file, sizeof(s_current_log_file));
-  log_info(log_storage_tag, 
-           "Log Rotation", 
-           "Rotating to new log file: %s", 
-           s_current_log_file);
-  
+
+  s_write_buffer = file_write_buffer_alloc(LOG_COMPRESSION_BUFFER_SIZE, pdMS_TO_TICKS(100));
+  if (s_write_buffer == NULL) {
+    log_error(log_storage_tag, 
+              "Buffer Failed", 
+              "No free write buffer for %s", 
+              s_current_log_file);
+    return ESP_FAIL;
+  }
+  s_deflate_stream.next_out  = s_write_buffer->data;
+  s_deflate_stream.avail_out = s_write_buffer->capacity;
+  s_write_length             = 0;
   return ESP_OK;
 }
 
 /**
- * @brief Compresses data using zlib
+ * @brief Hands the collected buffer to the file writer without copying it
  * 
- * @param[in]     input      Input data to compress
- * @param[in]     input_len  Length of input data
- * @param[out]    output     Buffer to store compressed data
- * @param[in,out] output_len Size of output buffer on input, size of compressed data on output
  * @return ESP_OK if successful, ESP_FAIL otherwise
  */
-static esp_err_t priv_compress_data(const char *input, 
-                                    size_t      input_len, 
-                                    char       *output, 
-                                    size_t     *output_len)
+static esp_err_t priv_write_emit(void)
 {
-  if (input == NULL || output == NULL || output_len == NULL) {
+  if (s_write_buffer == NULL) {
+    return ESP_OK;
+  }
+  size_t pending = s_deflate_open ? s_write_buffer->capacity - s_deflate_stream.avail_out : s_write_length;
+  if (pending == 0) {
+    return ESP_OK;
+  }
+
+  s_write_buffer->length = pending;
+  esp_err_t ret = file_write_buffer_enqueue(s_file_id, 
+                                            s_write_buffer, 
+                                            k_file_write_lane_critical,
+                                            k_file_write_binary | (s_write_critical ? k_file_write_critical : 0));
+
+  /* The writer owns the buffer now, the next output goes to a new one */
+  s_write_buffer             = NULL;
+  s_write_critical           = false;
+  s_write_length             = 0;
+  s_deflate_stream.next_out  = NULL;
+  s_deflate_stream.avail_out = 0;
+  if (ret != ESP_OK) {
     return ESP_FAIL;
   }
-  
-  z_stream stream;
-  memset(&stream, 0, sizeof(stream));
-  
-  /* Initialize zlib for gzip compression */
-  int ret = deflateInit2(&stream, 
+  s_current_file_bytes += pending;
+  return ESP_OK;
+}
+
+/**
+ * @brief Opens the gzip stream for the current log file if it is not open yet
+ * 
+ * @return ESP_OK if successful, ESP_FAIL otherwise
+ */
+static esp_err_t priv_deflate_begin(void)
+{
+  if (s_deflate_open) {
+    return ESP_OK;
+  }
+
+  memset(&s_deflate_stream, 0, sizeof(s_deflate_stream));
+  int ret = deflateInit2(&s_deflate_stream, 
                          log_compression_level, 
                          Z_DEFLATED,
                          log_zlib_window_bits,
@@ -284,77 +283,396 @@ static esp_err_t priv_compress_data(const char *input,
               ret);
     return ESP_FAIL;
   }
-  
-  /* Set up input and output buffers */
-  stream.next_in   = (Bytef *)input;
-  stream.avail_in  = input_len;
-  stream.next_out  = (Bytef *)output;
-  stream.avail_out = *output_len;
-  
-  /* Compress data */
-  ret = deflate(&stream, Z_FINISH);
-  
-  /* Clean up */
-  deflateEnd(&stream);
-  
-  if (ret != Z_STREAM_END) {
-    log_error(log_storage_tag, 
-              "Compression Failed", 
-              "Failed to compress data: %d", 
-              ret);
-    return ESP_FAIL;
+
+  s_deflate_open = true;
+  return priv_write_reserve();
+}
+
+/**
+ * @brief Drops the gzip stream without finishing it
+ * 
+ * Used when earlier output may not have reached the file, so the stream
+ * cannot continue there. The next flush starts a new file.
+ */
+static void priv_deflate_abandon(void)
+{
+  if (s_deflate_open) {
+    deflateEnd(&s_deflate_stream);
+    s_deflate_open = false;
+  }
+  file_write_buffer_release(s_write_buffer);
+  s_write_buffer        = NULL;
+  s_write_length        = 0;
+  s_write_critical      = false;
+  s_current_log_file[0] = '\0';
+}
+
+/**
+ * @brief Feeds data through the current file's gzip stream
+ * 
+ * @param[in] data  Data to compress, may be NULL if `len` is 0
+ * @param[in] len   Length of data
+ * @param[in] flush zlib flush mode, `Z_NO_FLUSH`, `Z_SYNC_FLUSH` or `Z_FINISH`
+ * @return ESP_OK if successful, ESP_FAIL otherwise
+ */
+static esp_err_t priv_deflate_write(const void *data, size_t len, int flush)
+{
+  s_deflate_stream.next_in  = (Bytef *)data;
+  s_deflate_stream.avail_in = len;
+
+  /* Each pass stops when the input is consumed or the output buffer is full */
+  do {
+    if (priv_write_reserve() != ESP_OK) {
+      return ESP_FAIL;
+    }
+    int ret = deflate(&s_deflate_stream, flush);
+    if (ret == Z_STREAM_ERROR) {
+      log_error(log_storage_tag, 
+                "Compression Failed", 
+                "Failed to compress data: %d", 
+                ret);
+      return ESP_FAIL;
+    }
+    if (s_deflate_stream.avail_out == 0 && priv_write_emit() != ESP_OK) {
+      return ESP_FAIL;
+    }
+  } while (s_deflate_stream.avail_in > 0 || s_deflate_stream.avail_out == 0);
+
+  return ESP_OK;
+}
+
+/**
+ * @brief Writes the gzip trailer for the current file and releases the stream
+ * 
+ * @return ESP_OK if successful, ESP_FAIL otherwise
+ */
+static esp_err_t priv_deflate_finish(void)
+{
+  if (!s_deflate_open) {
+    return ESP_OK;
+  }
+
+  esp_err_t ret = priv_deflate_write(NULL, 0, Z_FINISH);
+  if (ret == ESP_OK) {
+    ret = priv_write_emit();
+  }
+
+  deflateEnd(&s_deflate_stream);
+  s_deflate_open = false;
+  return ret;
+}
+
+/**
+ * @brief Appends encoded log data to the current file
+ * 
+ * Goes through the gzip stream when compression is enabled, otherwise it is
+ * collected in pooled buffers of `LOG_COMPRESSION_BUFFER_SIZE` bytes.
+ * 
+ * @param[in] data Data to write
+ * @param[in] len  Length of data
+ * @return ESP_OK if successful, ESP_FAIL otherwise
+ */
+static esp_err_t priv_write_bytes(const uint8_t *data, size_t len)
+{
+  if (s_deflate_open) {
+    return priv_deflate_write(data, len, Z_NO_FLUSH);
+  }
+
+  while (len > 0) {
+    if (priv_write_reserve() != ESP_OK) {
+      return ESP_FAIL;
+    }
+    size_t chunk = s_write_buffer->capacity - s_write_length;
+    if (chunk > len) {
+      chunk = len;
+    }
+    memcpy(&s_write_buffer->data[s_write_length], data, chunk);
+    s_write_length += chunk;
+    data           += chunk;
+    len            -= chunk;
+    if (s_write_length == s_write_buffer->capacity && priv_write_emit() != ESP_OK) {
+      return ESP_FAIL;
+    }
   }
-  
-  /* Update output length */
-  *output_len = stream.total_out;
-  
   return ESP_OK;
 }
 
 /**
- * @brief Writes log data to a file
+ * @brief Rotates the log file if needed
+ * 
+ * Finishes the gzip stream of the old file first, so each file is a
+ * complete gzip member.
  * 
- * @param[in] file_path Path to the log file
- * @param[in] data      Data to write
  * @return ESP_OK if successful, ESP_FAIL otherwise
  */
-static esp_err_t priv_write_log_data(const char *file_path, const char *data)
+static esp_err_t priv_rotate_log_file(void)
 {
-  if (file_path == NULL || data == NULL) {
+  if (s_current_log_file[0] != '\0' && !priv_check_log_rotation()) {
+    return ESP_OK; /* No rotation needed */
+  }
+
+  if (priv_deflate_finish() != ESP_OK) {
+    log_warn(log_storage_tag, 
+             "Finalize Failed", 
+             "Failed to finish log file: %s", 
+             s_current_log_file);
+  }
+  
+  /* Generate new log file path, interned so each write only carries its ID */
+  priv_generate_log_file_path(s_current_log_file, sizeof(s_current_log_file));
+  file_write_release_path(s_file_id);
+  if (file_write_register_path(s_current_log_file, &s_file_id) != ESP_OK) {
+    s_file_id             = FILE_WRITE_INVALID_ID;
+    s_current_log_file[0] = '\0';
     return ESP_FAIL;
   }
+  s_current_file_bytes = 0;
+  s_file_started       = false;
+  log_info(log_storage_tag, 
+           "Log Rotation", 
+           "Rotating to new log file: %s", 
+           s_current_log_file);
   
-  /* Check if compression is enabled */
-  if (s_compression_enabled) {
-    /* Compress data before writing */
-    char *compress_buffer = malloc(log_compression_buffer);
-    if (compress_buffer == NULL) {
-      log_error(log_storage_tag, 
-                "Memory Error", 
-                "Failed to allocate compression buffer");
-      return ESP_FAIL;
+  return ESP_OK;
+}
+
+/**
+ * @brief Bytes a record takes in the log buffer
+ * 
+ * Records are packed as a 16-bit length, the record fields before `args`,
+ * the used arguments and the used string bytes.
+ * 
+ * @param[in] record Record to measure
+ * @return Packed size in bytes
+ */
+static inline size_t priv_buffer_entry_size(const log_record_t *record)
+{
+  return sizeof(uint16_t) + 
+         offsetof(log_record_t, args) + 
+         record->arg_count * sizeof(log_arg_t) + 
+         record->string_bytes;
+}
+
+/**
+ * @brief Copies bytes into the log buffer, wrapping at its end
+ * 
+ * @param[in] offset Buffer offset to write at
+ * @param[in] data   Bytes to copy
+ * @param[in] len    Number of bytes
+ * @return Buffer offset after the copied bytes
+ */
+static size_t priv_buffer_copy_in(size_t offset, const void *data, size_t len)
+{
+  size_t first = s_log_buffer_capacity - offset;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(&s_log_buffer[offset], data, first);
+  memcpy(s_log_buffer, (const uint8_t *)data + first, len - first);
+  return (offset + len) % s_log_buffer_capacity;
+}
+
+/**
+ * @brief Copies bytes out of the log buffer, wrapping at its end
+ * 
+ * @param[in]  offset Buffer offset to read at
+ * @param[out] data   Destination
+ * @param[in]  len    Number of bytes
+ * @return Buffer offset after the copied bytes
+ */
+static size_t priv_buffer_copy_out(size_t offset, void *data, size_t len)
+{
+  size_t first = s_log_buffer_capacity - offset;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(data, &s_log_buffer[offset], first);
+  memcpy((uint8_t *)data + first, s_log_buffer, len - first);
+  return (offset + len) % s_log_buffer_capacity;
+}
+
+/**
+ * @brief Reads the length and level of the buffered record at an offset
+ * 
+ * @param[in]  offset Buffer offset of the record
+ * @param[out] level  Level of the record
+ * @return Packed size of the record
+ */
+static size_t priv_buffer_peek(size_t offset, uint8_t *level)
+{
+  uint16_t length;
+  offset = priv_buffer_copy_out(offset, &length, sizeof(length));
+  offset = (offset + offsetof(log_record_t, level)) % s_log_buffer_capacity;
+  priv_buffer_copy_out(offset, level, sizeof(*level));
+  return length;
+}
+
+/**
+ * @brief Unpacks the buffered record at an offset
+ * 
+ * @param[in]  offset Buffer offset of the record
+ * @param[out] record Unpacked record
+ * @return Buffer offset of the next record
+ */
+static size_t priv_buffer_read(size_t offset, log_record_t *record)
+{
+  uint16_t length;
+  offset = priv_buffer_copy_out(offset, &length, sizeof(length));
+  offset = priv_buffer_copy_out(offset, record, offsetof(log_record_t, args));
+  offset = priv_buffer_copy_out(offset, record->args, record->arg_count * sizeof(log_arg_t));
+  return priv_buffer_copy_out(offset, record->strings, record->string_bytes);
+}
+
+/**
+ * @brief Packs a record at the head of the log buffer, which must have room
+ * 
+ * @param[in] record Record to store
+ */
+static void priv_buffer_push(const log_record_t *record)
+{
+  uint16_t length = priv_buffer_entry_size(record);
+  size_t   offset = s_log_buffer_head;
+
+  offset = priv_buffer_copy_in(offset, &length, sizeof(length));
+  offset = priv_buffer_copy_in(offset, record, offsetof(log_record_t, args));
+  offset = priv_buffer_copy_in(offset, record->args, record->arg_count * sizeof(log_arg_t));
+  offset = priv_buffer_copy_in(offset, record->strings, record->string_bytes);
+
+  s_log_buffer_head  = offset;
+  s_log_buffer_used += length;
+  s_log_buffer_count++;
+  s_level_counts[record->level]++;
+}
+
+/**
+ * @brief Removes a buffered record, closing the gap from the old side
+ * 
+ * Records older than the removed one move forward by its size, so removing
+ * the oldest record moves nothing.
+ * 
+ * @param[in] offset Buffer offset of the record
+ */
+static void priv_buffer_remove(size_t offset)
+{
+  uint8_t level;
+  size_t  length = priv_buffer_peek(offset, &level);
+  size_t  before = (offset + s_log_buffer_capacity - s_log_buffer_tail) % s_log_buffer_capacity;
+
+  /* Move the older bytes in contiguous runs, from the newest end back */
+  size_t src_end = offset;
+  size_t dst_end = (offset + length) % s_log_buffer_capacity;
+  while (before > 0) {
+    size_t src_run = (src_end == 0) ? s_log_buffer_capacity : src_end;
+    size_t dst_run = (dst_end == 0) ? s_log_buffer_capacity : dst_end;
+    size_t chunk   = before;
+    if (chunk > src_run) {
+      chunk = src_run;
     }
-    
-    size_t data_len   = strlen(data);
-    size_t output_len = log_compression_buffer;
-    
-    esp_err_t ret = priv_compress_data(data, 
-                                       data_len, 
-                                       compress_buffer, 
-                                       &output_len);
-    if (ret != ESP_OK) {
-      free(compress_buffer);
-      return ret;
+    if (chunk > dst_run) {
+      chunk = dst_run;
     }
-    
-    /* Write compressed data to file */
-    ret = file_write_binary_enqueue(file_path, compress_buffer, output_len);
-    free(compress_buffer);
-    return ret;
-  } else {
-    /* Write uncompressed data to file */
-    return file_write_enqueue(file_path, data);
+    memmove(&s_log_buffer[dst_run - chunk], &s_log_buffer[src_run - chunk], chunk);
+    src_end  = src_run - chunk;
+    dst_end  = dst_run - chunk;
+    before  -= chunk;
+  }
+
+  s_log_buffer_tail  = (s_log_buffer_tail + length) % s_log_buffer_capacity;
+  s_log_buffer_used -= length;
+  s_log_buffer_count--;
+  s_level_counts[level]--;
+}
+
+/**
+ * @brief Overflow policy in effect right now
+ * 
+ * Without an SD card no flush can make room, so `k_log_overflow_block` 
+ * would only stall the drain task; it evicts by severity until the card is back.
+ * 
+ * @return The policy to apply to the next record
+ */
+static inline log_overflow_policy_t priv_overflow_policy(void)
+{
+  if (s_overflow_policy == k_log_overflow_block && !s_sd_card_available) {
+    return k_log_overflow_drop_lower_severity;
   }
+  return s_overflow_policy;
+}
+
+/**
+ * @brief Finds the oldest buffered record to evict for a new one
+ * 
+ * @param[in]  level  Level of the new record
+ * @param[out] offset Buffer offset of the record to evict
+ * @return true if a record may be evicted, false if the new one should be dropped
+ */
+static bool priv_buffer_find_victim(uint8_t level, size_t *offset)
+{
+  if (s_log_buffer_count == 0) {
+    return false;
+  }
+  if (s_overflow_policy == k_log_overflow_drop_oldest) {
+    *offset = s_log_buffer_tail;
+    return true;
+  }
+
+  /* Least severe level first, never one more severe than the new record */
+  for (uint8_t victim = ESP_LOG_VERBOSE; victim >= level && victim > ESP_LOG_NONE; victim--) {
+    if (s_level_counts[victim] == 0) {
+      continue;
+    }
+    size_t candidate = s_log_buffer_tail;
+    for (uint32_t i = 0; i < s_log_buffer_count; i++) {
+      uint8_t candidate_level;
+      size_t  length = priv_buffer_peek(candidate, &candidate_level);
+      if (candidate_level == victim) {
+        *offset = candidate;
+        return true;
+      }
+      candidate = (candidate + length) % s_log_buffer_capacity;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Evicts buffered records until a new one fits, following the overflow policy
+ * 
+ * @param[in] record Record that needs room
+ * @return true if the record fits now, false if it should be dropped
+ */
+static bool priv_buffer_make_room(const log_record_t *record)
+{
+  size_t needed = priv_buffer_entry_size(record);
+  if (needed > s_log_buffer_capacity) {
+    return false;
+  }
+
+  while (s_log_buffer_capacity - s_log_buffer_used < needed) {
+    size_t victim;
+    if (priv_overflow_policy() == k_log_overflow_block || 
+        !priv_buffer_find_victim(record->level, &victim)) {
+      return false;
+    }
+    priv_buffer_remove(victim);
+    s_overwritten_records++;
+  }
+  return true;
+}
+
+/**
+ * @brief Empties the log buffer after its records were written
+ */
+static void priv_buffer_clear(void)
+{
+  s_flushed_records  += s_log_buffer_count;
+  s_log_buffer_head   = 0;
+  s_log_buffer_tail   = 0;
+  s_log_buffer_used   = 0;
+  s_log_buffer_count  = 0;
+  memset(s_level_counts, 0, sizeof(s_level_counts));
+  s_overflow_reported = false;
+  xSemaphoreGive(s_space_available);
 }
 
 /**
@@ -364,7 +682,7 @@ static esp_err_t priv_write_log_data(const char *file_path, const char *data)
  */
 static esp_err_t priv_flush_log_buffer(void)
 {
-  if (s_log_buffer_index == 0) {
+  if (s_log_buffer_count == 0) {
     return ESP_OK; /* Nothing to flush */
   }
   
@@ -372,7 +690,7 @@ static esp_err_t priv_flush_log_buffer(void)
     log_warn(log_storage_tag, 
              "Flush Skip", 
              "SD card not available, keeping %lu logs in buffer", 
-             s_log_buffer_index);
+             s_log_buffer_count);
     return ESP_FAIL;
   }
   
@@ -381,130 +699,67 @@ static esp_err_t priv_flush_log_buffer(void)
     return ESP_FAIL;
   }
   
-  /* If compression is enabled, we'll collect all logs into a single buffer first */
-  char  *all_logs   = NULL;
-  size_t total_size = 0;
-  
-  if (s_compression_enabled) {
-    /* Calculate total size needed */
-    for (uint32_t i = 0; i < s_log_buffer_index; i++) {
-      const char *level_str = priv_log_level_to_string(s_log_buffer[i].level);
-      
-      /* Convert timestamp to time components */
-      time_t    log_time = priv_timestamp_us_to_seconds(s_log_buffer[i].timestamp);
-      struct tm timeinfo;
-      localtime_r(&log_time, &timeinfo);
-      
-      uint64_t milliseconds = priv_timestamp_us_to_milliseconds(s_log_buffer[i].timestamp);
-      
-      /* Calculate the size of this log entry */
-      char timestamp[TIMESTAMP_BUFFER_SIZE];
-      priv_format_log_entry(timestamp, 
-                            sizeof(timestamp), 
-                            &timeinfo,
-                            milliseconds,
-                            "",  /* Empty level string for size calculation */
-                            ""); /* Empty message for size calculation */
-      
-      total_size += strlen(timestamp) + 
-                    strlen(level_str) + 
-                    strlen(s_log_buffer[i].buffer);
-    }
-    
-    /* Allocate buffer for all logs */
-    all_logs = malloc(total_size + 1); /* +1 for null terminator */
-    if (!all_logs) {
-      log_error(log_storage_tag, 
-                "Memory Error", 
-                "Failed to allocate buffer for log compression");
-      return ESP_FAIL;
-    }
-    
-    /* Reset buffer position */
-    size_t pos = 0;
-    
-    /* Collect all logs into the buffer */
-    for (uint32_t i = 0; i < s_log_buffer_index; i++) {
-      const char *level_str = priv_log_level_to_string(s_log_buffer[i].level);
-      
-      /* Convert timestamp to time components */
-      time_t    log_time = priv_timestamp_us_to_seconds(s_log_buffer[i].timestamp);
-      struct tm timeinfo;
-      localtime_r(&log_time, &timeinfo);
-      
-      uint64_t milliseconds = priv_timestamp_us_to_milliseconds(s_log_buffer[i].timestamp);
-      
-      /* Format the timestamp and log entry */
-      int written = priv_format_log_entry(all_logs + pos, 
-                                          total_size - pos, 
-                                          &timeinfo,
-                                          milliseconds,
-                                          level_str,
-                                          s_log_buffer[i].buffer);
-      
-      if (written > 0) {
-        pos += written;
-        
-        /* Add newline if there's space */
-        if (pos < total_size) {
-          all_logs[pos++] = '\n';
-        }
-      }
-    }
-    
-    /* Ensure null termination */
-    all_logs[pos] = '\0';
-    
-    /* Write all logs at once */
-    esp_err_t ret = priv_write_log_data(s_current_log_file, all_logs);
-    free(all_logs);
-    
-    if (ret != ESP_OK) {
-      log_error(log_storage_tag, 
-                "Write Failed", 
-                "Failed to write compressed logs: %s", 
-                esp_err_to_name(ret));
-      return ESP_FAIL;
-    }
-  } else {
-    /* No compression, write each log entry individually */
-    for (uint32_t i = 0; i < s_log_buffer_index; i++) {
-      const char *level_str = priv_log_level_to_string(s_log_buffer[i].level);
-      
-      /* Convert timestamp to time components */
-      time_t    log_time = priv_timestamp_us_to_seconds(s_log_buffer[i].timestamp);
-      struct tm timeinfo;
-      localtime_r(&log_time, &timeinfo);
-      
-      uint64_t milliseconds = priv_timestamp_us_to_milliseconds(s_log_buffer[i].timestamp);
-      
-      /* Format the timestamp and log entry */
-      char formatted_log[LOG_STORAGE_MAX_FORMATTED_ENTRY_LENGTH];
-      priv_format_log_entry(formatted_log, 
-                            sizeof(formatted_log), 
-                            &timeinfo,
-                            milliseconds,
-                            level_str,
-                            s_log_buffer[i].buffer);
-      
-      /* Enqueue the log for writing */
-      esp_err_t ret = file_write_enqueue(s_current_log_file, formatted_log);
-      if (ret != ESP_OK) {
-        log_error(log_storage_tag, 
-                  "Write Failed", 
-                  "Failed to enqueue log for writing: %s", 
-                  esp_err_to_name(ret));
-        return ESP_FAIL;
-      }
+  if (s_compression_enabled && priv_deflate_begin() != ESP_OK) {
+    return ESP_FAIL;
+  }
+  /* Nothing was written yet, so the records can wait for a buffer in the ring */
+  if (priv_write_reserve() != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  esp_err_t ret = ESP_OK;
+  if (!s_file_started) {
+    /* Every file starts its own string table, so it decodes on its own */
+    size_t len       = log_record_encoder_reset(&s_encoder, s_encode_buffer);
+    ret              = priv_write_bytes(s_encode_buffer, len);
+    s_time_offset_us = 0;
+    s_file_started   = true;
+  }
+
+  /* Record timestamps are esp_timer time, a sync block maps them to wall time */
+  if (ret == ESP_OK && time_manager_is_initialized()) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t offset_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec - esp_timer_get_time();
+    if (llabs(offset_us - s_time_offset_us) > log_time_sync_tolerance) {
+      size_t len       = log_record_encode_time_sync(s_encode_buffer, offset_us);
+      ret              = priv_write_bytes(s_encode_buffer, len);
+      s_time_offset_us = offset_us;
     }
   }
+
+  size_t offset = s_log_buffer_tail;
+  for (uint32_t i = 0; i < s_log_buffer_count && ret == ESP_OK; i++) {
+    offset            = priv_buffer_read(offset, &s_flush_record);
+    size_t len        = log_record_encode(&s_encoder, &s_flush_record, s_encode_buffer);
+    ret               = priv_write_bytes(s_encode_buffer, len);
+    s_write_critical |= (s_flush_record.level == ESP_LOG_ERROR);
+  }
+
+  /* Byte-align and hand over everything so far, the stream stays open for the next flush */
+  if (ret == ESP_OK && s_deflate_open) {
+    ret = priv_deflate_write(NULL, 0, Z_SYNC_FLUSH);
+  }
+  if (ret == ESP_OK) {
+    ret = priv_write_emit();
+  }
+
+  if (ret != ESP_OK) {
+    log_error(log_storage_tag, 
+              "Write Failed", 
+              "Failed to write logs to %s", 
+              s_current_log_file);
+    /* The file may be missing data now, continue in a new one */
+    priv_deflate_abandon();
+    return ESP_FAIL;
+  }
   
-  /* Reset buffer index */
-  s_log_buffer_index = 0;
+  priv_buffer_clear();
   
-  log_info(log_storage_tag, 
-           "Buffer Flushed", 
-           "Successfully flushed log buffer to SD card");
+  /* Debug only, an info record would refill the buffer every flush */
+  log_debug(log_storage_tag, 
+            "Buffer Flushed", 
+            "Successfully flushed log buffer to SD card");
   return ESP_OK;
 }
 
@@ -526,6 +781,39 @@ esp_err_t log_storage_init(void)
     return ESP_FAIL;
   }
   
+  s_space_available = xSemaphoreCreateBinary();
+  if (s_space_available == NULL) {
+    log_error(log_storage_tag, "Semaphore Failed", "Failed to create buffer semaphore");
+    vSemaphoreDelete(s_log_mutex);
+    s_log_mutex = NULL;
+    return ESP_FAIL;
+  }
+  
+  /* PSRAM holds a much longer history for SD card outages, internal RAM is the fallback */
+  s_log_buffer_capacity = log_buffer_psram_budget;
+  s_log_buffer          = heap_caps_malloc(s_log_buffer_capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (s_log_buffer == NULL) {
+    s_log_buffer_capacity = log_buffer_budget;
+    s_log_buffer          = heap_caps_malloc(s_log_buffer_capacity, MALLOC_CAP_8BIT);
+  }
+  if (s_log_buffer == NULL) {
+    log_error(log_storage_tag, 
+              "Buffer Failed", 
+              "Failed to allocate %d bytes for the log buffer", 
+              log_buffer_budget);
+    vSemaphoreDelete(s_space_available);
+    vSemaphoreDelete(s_log_mutex);
+    s_space_available     = NULL;
+    s_log_mutex           = NULL;
+    s_log_buffer_capacity = 0;
+    return ESP_ERR_NO_MEM;
+  }
+  log_info(log_storage_tag, 
+           "Buffer Ready", 
+           "Log buffer of %u bytes in %s", 
+           (unsigned)s_log_buffer_capacity,
+           (s_log_buffer_capacity == (size_t)log_buffer_psram_budget) ? "PSRAM" : "internal RAM");
+  
   /* Initialize SD card availability status */
   s_sd_card_available = false;
   
@@ -559,6 +847,10 @@ void log_storage_set_sd_available(bool available)
     return;
   }
   
+  if (!available && !s_sd_card_available) {
+    xSemaphoreGive(s_log_mutex); /* Already closed or abandoned */
+    return;
+  }
   s_sd_card_available = available;
   
   if (available) {
@@ -568,6 +860,8 @@ void log_storage_set_sd_available(bool available)
              "SD card became available, flushing buffered logs");
     priv_flush_log_buffer();
   } else {
+    /* Queued writes to the current file may be lost, so its stream cannot continue */
+    priv_deflate_abandon();
     log_warn(log_storage_tag, 
              "SD Unavailable", 
              "SD card became unavailable, logs will be buffered");
@@ -576,11 +870,14 @@ void log_storage_set_sd_available(bool available)
   xSemaphoreGive(s_log_mutex);
 }
 
-esp_err_t log_storage_write(esp_log_level_t level, const char *message)
+esp_err_t log_storage_write(const log_record_t *record)
 {
   if (!s_log_storage_initialized) {
     return ESP_FAIL;
   }
+  if (record == NULL || record->level > ESP_LOG_VERBOSE) {
+    return ESP_ERR_INVALID_ARG;
+  }
   
   if (xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
     log_error(log_storage_tag, 
@@ -589,39 +886,56 @@ esp_err_t log_storage_write(esp_log_level_t level, const char *message)
     return ESP_FAIL;
   }
   
-  /* Store log in buffer */
-  if (s_log_buffer_index < LOG_BUFFER_SIZE) {
-    s_log_buffer[s_log_buffer_index].level     = level;
-    s_log_buffer[s_log_buffer_index].timestamp = esp_timer_get_time();
-
-    strncpy(s_log_buffer[s_log_buffer_index].buffer, 
-            message, 
-            LOG_STORAGE_MAX_MESSAGE_LENGTH - 1);
-    s_log_buffer[s_log_buffer_index].buffer[LOG_STORAGE_MAX_MESSAGE_LENGTH - 1] = '\0';
-    s_log_buffer_index++;
-  } else {
+  size_t   needed      = priv_buffer_entry_size(record);
+  uint32_t lost_before = s_overwritten_records + s_dropped_records;
+  if (s_log_buffer_capacity - s_log_buffer_used < needed && s_sd_card_available) {
     /* Buffer is full, need to flush */
     log_warn(log_storage_tag, "Buffer Full", "Log buffer full, forcing flush");
     priv_flush_log_buffer();
-    
-    /* Store the current log */
-    s_log_buffer[0].level     = level;
-    s_log_buffer[0].timestamp = esp_timer_get_time();
-
-    strncpy(s_log_buffer[0].buffer, 
-            message, 
-            LOG_STORAGE_MAX_MESSAGE_LENGTH - 1);
-    s_log_buffer[0].buffer[LOG_STORAGE_MAX_MESSAGE_LENGTH - 1] = '\0';
-    s_log_buffer_index = 1;
   }
   
-  /* If buffer is full or SD card is available, try to flush */
-  if (s_log_buffer_index >= LOG_BUFFER_SIZE && s_sd_card_available) {
+  bool       fits     = priv_buffer_make_room(record);
+  TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(s_block_timeout_ms);
+  while (!fits && priv_overflow_policy() == k_log_overflow_block && needed <= s_log_buffer_capacity) {
+    /* Let a flush from another task make room, it gives s_space_available */
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(deadline - now) <= 0) {
+      break;
+    }
+    xSemaphoreGive(s_log_mutex);
+    xSemaphoreTake(s_space_available, deadline - now);
+    if (xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+      s_dropped_records++;
+      return ESP_FAIL;
+    }
+    fits = priv_buffer_make_room(record); /* Evicts instead if the SD card went away meanwhile */
+  }
+  
+  esp_err_t ret = ESP_OK;
+  if (fits) {
+    priv_buffer_push(record);
+  } else {
+    s_dropped_records++;
+    ret = ESP_FAIL;
+  }
+  
+  if (s_overwritten_records + s_dropped_records != lost_before && !s_overflow_reported) {
+    /* Once per outage, each loss is counted in log_storage_get_stats */
+    s_overflow_reported = true;
+    log_warn(log_storage_tag, 
+             "Buffer Overflow", 
+             "Log buffer full, %lu logs overwritten and %lu dropped so far", 
+             s_overwritten_records, 
+             s_dropped_records);
+  }
+  
+  /* Write out once enough records are collected and the SD card is there */
+  if (s_log_buffer_count >= LOG_BUFFER_SIZE && s_sd_card_available) {
     priv_flush_log_buffer();
   }
   
   xSemaphoreGive(s_log_mutex);
-  return ESP_OK;
+  return ret;
 }
 
 esp_err_t log_storage_flush(void)
@@ -641,7 +955,44 @@ esp_err_t log_storage_flush(void)
   esp_err_t ret = priv_flush_log_buffer();
   
   xSemaphoreGive(s_log_mutex);
-  log_info(log_storage_tag, "Flush Complete", "Log flush completed successfully");
+  log_debug(log_storage_tag, "Flush Complete", "Log flush completed successfully");
+  return ret;
+}
+
+esp_err_t log_storage_close(void)
+{
+  if (!s_log_storage_initialized) {
+    log_error(log_storage_tag, "Close Error", "Log storage not initialized");
+    return ESP_FAIL;
+  }
+  
+  if (xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    log_error(log_storage_tag, 
+              "Mutex Error", 
+              "Failed to acquire mutex for log close");
+    return ESP_FAIL;
+  }
+  
+  esp_err_t ret = ESP_OK;
+  if (s_sd_card_available) {
+    ret = priv_flush_log_buffer();
+    if (priv_deflate_finish() != ESP_OK) {
+      ret = ESP_FAIL;
+    }
+  }
+  
+  /* Nothing more goes to the writer, the next flush starts a new file */
+  priv_deflate_abandon();
+  file_write_release_path(s_file_id);
+  s_file_id           = FILE_WRITE_INVALID_ID;
+  s_sd_card_available = false;
+  uint32_t kept       = s_log_buffer_count;
+  
+  xSemaphoreGive(s_log_mutex);
+  log_info(log_storage_tag, 
+           "Storage Closed", 
+           "Log file closed, %lu logs kept in buffer", 
+           kept);
   return ret;
 }
 
@@ -661,17 +1012,18 @@ esp_err_t log_storage_set_compression(bool enabled)
   
   /* Only update if the setting has changed */
   if (s_compression_enabled != enabled) {
+    /* Flush current logs in the old format before changing compression setting */
+    priv_flush_log_buffer();
+    
+    /* Finish the current file and force log rotation on next write to use new extension */
+    priv_deflate_finish();
+    s_current_log_file[0] = '\0';
+    
     s_compression_enabled = enabled;
     log_info(log_storage_tag, 
              "Compression Config", 
              "Log compression %s", 
              enabled ? "enabled" : "disabled");
-    
-    /* Flush current logs before changing compression setting */
-    priv_flush_log_buffer();
-    
-    /* Force log rotation on next write to use new extension */
-    s_current_log_file[0] = '\0';
   }
   
   xSemaphoreGive(s_log_mutex);
@@ -682,3 +1034,36 @@ bool log_storage_is_compression_enabled(void)
 {
   return s_compression_enabled;
 }
+
+esp_err_t log_storage_set_overflow_policy(log_overflow_policy_t policy,
+                                          uint32_t              block_timeout_ms)
+{
+  if (policy > k_log_overflow_block) {
+    log_error(log_storage_tag, "Config Error", "Unknown overflow policy %u", (unsigned)policy);
+    return ESP_ERR_INVALID_ARG;
+  }
+  
+  s_overflow_policy  = policy;
+  s_block_timeout_ms = block_timeout_ms;
+  return ESP_OK;
+}
+
+void log_storage_get_stats(log_storage_stats_t *stats)
+{
+  if (stats == NULL) {
+    return;
+  }
+  
+  if (s_log_mutex != NULL) {
+    xSemaphoreTake(s_log_mutex, portMAX_DELAY);
+  }
+  stats->dropped        = s_dropped_records;
+  stats->overwritten    = s_overwritten_records;
+  stats->flushed        = s_flushed_records;
+  stats->buffered       = s_log_buffer_count;
+  stats->buffered_bytes = s_log_buffer_used;
+  stats->capacity_bytes = s_log_buffer_capacity;
+  if (s_log_mutex != NULL) {
+    xSemaphoreGive(s_log_mutex);
+  }
+}
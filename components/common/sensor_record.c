@@ -0,0 +1,486 @@
+/* components/common/sensor_record.c */
+
+#include "sensor_record.h"
+#include "log_record.h"
+#include <math.h>
+#include <string.h>
+
+/* Globals (Static) ***********************************************************/
+
+/* Indexed by sensor_record_type_t. Scales keep a little more than each
+ * sensor's resolution, columns are only ever appended. */
+static const sensor_schema_t s_schemas[k_sensor_record_type_count] = {
+  [k_sensor_record_bh1750] = { "bh1750", 1, {
+    { "lux", "lx", 100 },
+  } },
+  [k_sensor_record_dht22] = { "dht22", 2, {
+    { "temperature", "C", 100 },
+    { "humidity",    "%", 100 },
+  } },
+  [k_sensor_record_mpu6050] = { "mpu6050", 7, {
+    { "accel_x",     "g",     10000 },
+    { "accel_y",     "g",     10000 },
+    { "accel_z",     "g",     10000 },
+    { "gyro_x",      "deg/s", 1000  },
+    { "gyro_y",      "deg/s", 1000  },
+    { "gyro_z",      "deg/s", 1000  },
+    { "temperature", "C",     100   },
+  } },
+  [k_sensor_record_qmc5883l] = { "qmc5883l", 4, {
+    { "mag_x",   "uT",  1000 },
+    { "mag_y",   "uT",  1000 },
+    { "mag_z",   "uT",  1000 },
+    { "heading", "deg", 100  },
+  } },
+  [k_sensor_record_gy_neo6mv2] = { "gy_neo6mv2", 6, {
+    { "latitude",        "deg", 10000000 },
+    { "longitude",       "deg", 10000000 },
+    { "speed",           "m/s", 100      },
+    { "hdop",            "",    100      },
+    { "fix_status",      "",    1        },
+    { "satellite_count", "",    1        },
+  } },
+  [k_sensor_record_ccs811] = { "ccs811", 2, {
+    { "eco2", "ppm", 1 },
+    { "tvoc", "ppb", 1 },
+  } },
+  [k_sensor_record_mq135] = { "mq135", 2, {
+    { "raw_adc",           "",    1   },
+    { "gas_concentration", "ppm", 100 },
+  } },
+};
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Maps a signed value onto an unsigned one, small magnitudes stay small
+ * 
+ * @param value Signed value
+ * @return Zigzag encoded value
+ */
+static inline uint64_t priv_zigzag(int64_t value)
+{
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**
+ * @brief Reverses `priv_zigzag`
+ * 
+ * @param value Zigzag encoded value
+ * @return Signed value
+ */
+static inline int64_t priv_unzigzag(uint64_t value)
+{
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief Bytes the varint of a value takes
+ *
+ * @param value Value to measure
+ * @return 1 to 10
+ */
+static inline size_t priv_varint_size(uint64_t value)
+{
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/* Fields are little endian whatever the host's byte order */
+
+static inline void priv_put_u16(uint8_t *out, uint16_t value)
+{
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+}
+
+static inline void priv_put_u32(uint8_t *out, uint32_t value)
+{
+  priv_put_u16(out, (uint16_t)value);
+  priv_put_u16(&out[2], (uint16_t)(value >> 16));
+}
+
+static inline void priv_put_u64(uint8_t *out, uint64_t value)
+{
+  priv_put_u32(out, (uint32_t)value);
+  priv_put_u32(&out[4], (uint32_t)(value >> 32));
+}
+
+static inline uint16_t priv_get_u16(const uint8_t *in)
+{
+  return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static inline uint32_t priv_get_u32(const uint8_t *in)
+{
+  return priv_get_u16(in) | ((uint32_t)priv_get_u16(&in[2]) << 16);
+}
+
+static inline uint64_t priv_get_u64(const uint8_t *in)
+{
+  return priv_get_u32(in) | ((uint64_t)priv_get_u32(&in[4]) << 32);
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3), a nibble at a time to keep the table small
+ *
+ * @param data Bytes to check
+ * @param len  Number of bytes
+ * @return CRC of the bytes
+ */
+static uint32_t priv_crc32(const uint8_t *data, size_t len)
+{
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc  = (crc >> 4) ^ table[crc & 0x0F];
+    crc  = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+/**
+ * @brief Scales a value to its stored integer, clamped to 32 bits
+ *
+ * @param value Unscaled value
+ * @param scale Stored steps per unit
+ * @return Stored integer, 0 for NaN
+ */
+static int32_t priv_quantize(float value, uint32_t scale)
+{
+  double scaled = round((double)value * scale);
+  if (scaled != scaled) {
+    return 0;
+  }
+  if (scaled > INT32_MAX) {
+    return INT32_MAX;
+  }
+  if (scaled < INT32_MIN) {
+    return INT32_MIN;
+  }
+  return (int32_t)scaled;
+}
+
+/**
+ * @brief Writes a NUL terminated string
+ *
+ * @param out Destination, NULL after an earlier string did not fit
+ * @param end End of the destination
+ * @param str String to write
+ * @return Position after the terminator, NULL if it does not fit
+ */
+static uint8_t *priv_put_string(uint8_t *out, const uint8_t *end, const char *str)
+{
+  size_t size = strlen(str) + 1;
+  if (out == NULL || out + size > end) {
+    return NULL;
+  }
+  memcpy(out, str, size);
+  return out + size;
+}
+
+/**
+ * @brief Points at a NUL terminated string
+ *
+ * @param in  Source, NULL after an earlier string was truncated
+ * @param end End of the source
+ * @param str Set to the string
+ * @return Position after the terminator, NULL if there is none before `end`
+ */
+static const uint8_t *priv_get_string(const uint8_t *in, const uint8_t *end, const char **str)
+{
+  const uint8_t *nul = (in != NULL) ? memchr(in, '\0', end - in) : NULL;
+  if (nul == NULL) {
+    return NULL;
+  }
+  *str = (const char *)in;
+  return nul + 1;
+}
+
+/* Public Functions ***********************************************************/
+
+const sensor_schema_t *sensor_record_schema(sensor_record_type_t type)
+{
+  if ((unsigned)type >= k_sensor_record_type_count) {
+    return NULL;
+  }
+  return &s_schemas[type];
+}
+
+size_t sensor_record_staging_size(sensor_record_type_t type, uint16_t max_rows)
+{
+  const sensor_schema_t *schema = sensor_record_schema(type);
+  if (schema == NULL) {
+    return 0;
+  }
+  return (size_t)max_rows * (sizeof(uint32_t) + schema->column_count * sizeof(int32_t));
+}
+
+bool sensor_record_encoder_init(sensor_block_encoder_t *encoder,
+                                sensor_record_type_t    type,
+                                sensor_encoding_t       encoding,
+                                uint16_t                block_size,
+                                uint16_t                max_rows,
+                                void                   *staging)
+{
+  const sensor_schema_t *schema = sensor_record_schema(type);
+  if (schema == NULL || staging == NULL || max_rows == 0 || max_rows > SENSOR_RECORD_MAX_ROWS ||
+      block_size < SENSOR_RECORD_MIN_BLOCK_SIZE || block_size > SENSOR_RECORD_MAX_BLOCK_SIZE) {
+    return false;
+  }
+
+  memset(encoder, 0, sizeof(*encoder));
+  encoder->type         = type;
+  encoder->encoding     = encoding;
+  encoder->column_count = schema->column_count;
+  encoder->block_size   = block_size;
+  encoder->max_rows     = max_rows;
+  encoder->offsets      = (uint32_t *)staging;
+  encoder->values       = (int32_t *)&encoder->offsets[max_rows];
+  return true;
+}
+
+bool sensor_record_append(sensor_block_encoder_t *encoder,
+                          int64_t                 timestamp_us,
+                          const float            *values)
+{
+  if (encoder->row_count >= encoder->max_rows) {
+    return false;
+  }
+
+  /* Offsets are 32 bits from the block's first row, later or earlier samples start a new block */
+  int64_t offset = (encoder->row_count == 0) ? 0 : timestamp_us - encoder->first_us;
+  if (offset < 0 || offset > UINT32_MAX) {
+    return false;
+  }
+
+  const sensor_schema_t *schema = &s_schemas[encoder->type];
+  int32_t                row[SENSOR_RECORD_MAX_COLUMNS];
+  size_t                 row_bytes;
+  if (encoder->encoding == k_sensor_encoding_delta) {
+    row_bytes = priv_varint_size(priv_zigzag(offset - (int64_t)encoder->last_offset_us));
+  } else {
+    row_bytes = sizeof(uint32_t) + encoder->column_count * sizeof(int32_t);
+  }
+  for (uint8_t c = 0; c < encoder->column_count; c++) {
+    row[c] = priv_quantize(values[c], schema->columns[c].scale);
+    if (encoder->encoding == k_sensor_encoding_delta) {
+      row_bytes += priv_varint_size(priv_zigzag((int64_t)row[c] - encoder->last[c]));
+    }
+  }
+  if (SENSOR_RECORD_BLOCK_HEADER_SIZE + encoder->payload_bytes + row_bytes > encoder->block_size) {
+    return false;
+  }
+
+  if (encoder->row_count == 0) {
+    encoder->first_us = timestamp_us;
+  }
+  encoder->offsets[encoder->row_count] = (uint32_t)offset;
+  memcpy(&encoder->values[encoder->row_count * encoder->column_count],
+         row,
+         encoder->column_count * sizeof(int32_t));
+  memcpy(encoder->last, row, sizeof(encoder->last));
+  encoder->last_offset_us  = (uint32_t)offset;
+  encoder->payload_bytes  += row_bytes;
+  encoder->row_count++;
+  return true;
+}
+
+size_t sensor_record_finish_block(sensor_block_encoder_t *encoder,
+                                  uint32_t                sequence,
+                                  int64_t                 unix_offset_us,
+                                  uint8_t                *out)
+{
+  if (encoder->row_count == 0) {
+    return 0;
+  }
+
+  /* Columns one after another, each delta column starting from zero */
+  uint8_t *pos   = &out[SENSOR_RECORD_BLOCK_HEADER_SIZE];
+  uint16_t rows  = encoder->row_count;
+  uint8_t  cols  = encoder->column_count;
+  bool     delta = (encoder->encoding == k_sensor_encoding_delta);
+  int64_t  prev  = 0;
+  for (uint16_t r = 0; r < rows; r++) {
+    if (delta) {
+      pos  += log_record_put_varint(pos, priv_zigzag((int64_t)encoder->offsets[r] - prev));
+      prev  = encoder->offsets[r];
+    } else {
+      priv_put_u32(pos, encoder->offsets[r]);
+      pos += sizeof(uint32_t);
+    }
+  }
+  for (uint8_t c = 0; c < cols; c++) {
+    prev = 0;
+    for (uint16_t r = 0; r < rows; r++) {
+      int32_t value = encoder->values[r * cols + c];
+      if (delta) {
+        pos  += log_record_put_varint(pos, priv_zigzag((int64_t)value - prev));
+        prev  = value;
+      } else {
+        priv_put_u32(pos, (uint32_t)value);
+        pos += sizeof(uint32_t);
+      }
+    }
+  }
+
+  size_t payload_bytes = pos - &out[SENSOR_RECORD_BLOCK_HEADER_SIZE];
+  memset(pos, 0, encoder->block_size - (pos - out));
+
+  priv_put_u32(&out[0], SENSOR_RECORD_BLOCK_MAGIC);
+  out[4] = encoder->type;
+  out[5] = encoder->encoding;
+  priv_put_u16(&out[6], rows);
+  priv_put_u16(&out[8], (uint16_t)payload_bytes);
+  priv_put_u16(&out[10], 0);
+  priv_put_u32(&out[12], sequence);
+  priv_put_u64(&out[16], (uint64_t)encoder->first_us);
+  priv_put_u32(&out[24], encoder->last_offset_us);
+  priv_put_u32(&out[28], priv_crc32(&out[SENSOR_RECORD_BLOCK_HEADER_SIZE], payload_bytes));
+  priv_put_u64(&out[32], (uint64_t)unix_offset_us);
+
+  encoder->row_count      = 0;
+  encoder->payload_bytes  = 0;
+  encoder->last_offset_us = 0;
+  memset(encoder->last, 0, sizeof(encoder->last));
+  return encoder->block_size;
+}
+
+size_t sensor_record_encode_file_header(sensor_record_type_t type,
+                                        uint16_t             block_size,
+                                        uint8_t             *out)
+{
+  const sensor_schema_t *schema = sensor_record_schema(type);
+  if (schema == NULL || block_size < SENSOR_RECORD_MIN_BLOCK_SIZE) {
+    return 0;
+  }
+
+  /* Magic, version, type, column count, reserved, block size, then the schema */
+  memset(out, 0, block_size);
+  priv_put_u32(&out[0], SENSOR_RECORD_FILE_MAGIC);
+  out[4] = SENSOR_RECORD_FILE_VERSION;
+  out[5] = (uint8_t)type;
+  out[6] = schema->column_count;
+  priv_put_u16(&out[8], block_size);
+
+  const uint8_t *end = out + block_size;
+  uint8_t       *pos = priv_put_string(&out[10], end, schema->name);
+  for (uint8_t c = 0; c < schema->column_count; c++) {
+    pos = priv_put_string(pos, end, schema->columns[c].name);
+    pos = priv_put_string(pos, end, schema->columns[c].unit);
+    if (pos == NULL || pos + sizeof(uint32_t) > end) {
+      return 0;
+    }
+    priv_put_u32(pos, schema->columns[c].scale);
+    pos += sizeof(uint32_t);
+  }
+  return (pos != NULL) ? block_size : 0;
+}
+
+bool sensor_record_read_file_header(const uint8_t   *in,
+                                    size_t           len,
+                                    uint8_t         *type,
+                                    uint16_t        *block_size,
+                                    sensor_schema_t *schema)
+{
+  if (len < SENSOR_RECORD_MIN_BLOCK_SIZE || priv_get_u32(in) != SENSOR_RECORD_FILE_MAGIC ||
+      in[4] != SENSOR_RECORD_FILE_VERSION || in[6] > SENSOR_RECORD_MAX_COLUMNS) {
+    return false;
+  }
+  *type                = in[5];
+  *block_size          = priv_get_u16(&in[8]);
+  schema->column_count = in[6];
+  if (*block_size < SENSOR_RECORD_MIN_BLOCK_SIZE || *block_size > len) {
+    return false;
+  }
+
+  const uint8_t *end = in + *block_size;
+  const uint8_t *pos = priv_get_string(&in[10], end, &schema->name);
+  for (uint8_t c = 0; c < schema->column_count; c++) {
+    pos = priv_get_string(pos, end, &schema->columns[c].name);
+    pos = priv_get_string(pos, end, &schema->columns[c].unit);
+    if (pos == NULL || pos + sizeof(uint32_t) > end) {
+      return false;
+    }
+    schema->columns[c].scale  = priv_get_u32(pos);
+    pos                      += sizeof(uint32_t);
+  }
+  return pos != NULL;
+}
+
+bool sensor_record_read_block_header(const uint8_t         *in,
+                                     size_t                 len,
+                                     sensor_block_header_t *header)
+{
+  if (len < SENSOR_RECORD_BLOCK_HEADER_SIZE || priv_get_u32(in) != SENSOR_RECORD_BLOCK_MAGIC) {
+    return false;
+  }
+  header->type           = in[4];
+  header->encoding       = in[5];
+  header->record_count   = priv_get_u16(&in[6]);
+  header->payload_bytes  = priv_get_u16(&in[8]);
+  header->sequence       = priv_get_u32(&in[12]);
+  header->first_us       = (int64_t)priv_get_u64(&in[16]);
+  header->span_us        = priv_get_u32(&in[24]);
+  header->crc            = priv_get_u32(&in[28]);
+  header->unix_offset_us = (int64_t)priv_get_u64(&in[32]);
+
+  if (SENSOR_RECORD_BLOCK_HEADER_SIZE + (size_t)header->payload_bytes > len ||
+      header->record_count > SENSOR_RECORD_MAX_ROWS) {
+    return false;
+  }
+  return priv_crc32(&in[SENSOR_RECORD_BLOCK_HEADER_SIZE], header->payload_bytes) == header->crc;
+}
+
+bool sensor_record_decode_block(const uint8_t               *in,
+                                const sensor_block_header_t *header,
+                                uint8_t                      column_count,
+                                int64_t                     *timestamps_us,
+                                int32_t                     *values)
+{
+  const uint8_t *pos   = &in[SENSOR_RECORD_BLOCK_HEADER_SIZE];
+  const uint8_t *end   = pos + header->payload_bytes;
+  uint16_t       rows  = header->record_count;
+  bool           delta = (header->encoding == k_sensor_encoding_delta);
+
+  for (uint8_t c = 0; c <= column_count; c++) {
+    int64_t prev = 0;
+    for (uint16_t r = 0; r < rows; r++) {
+      int64_t value;
+      if (delta) {
+        uint64_t raw;
+        size_t   used = log_record_get_varint(pos, end - pos, &raw);
+        if (used == 0) {
+          return false;
+        }
+        pos   += used;
+        value  = prev + priv_unzigzag(raw);
+        prev   = value;
+      } else {
+        if (end - pos < (ptrdiff_t)sizeof(uint32_t)) {
+          return false;
+        }
+        /* Timestamp offsets are unsigned, values signed */
+        value  = (c == 0) ? (int64_t)priv_get_u32(pos) : (int64_t)(int32_t)priv_get_u32(pos);
+        pos   += sizeof(uint32_t);
+      }
+
+      /* The timestamp column comes first, then the value columns */
+      if (c == 0) {
+        timestamps_us[r] = header->first_us + value;
+      } else {
+        values[r * column_count + c - 1] = (int32_t)value;
+      }
+    }
+  }
+  return pos == end;
+}
@@ -7,14 +7,20 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "hexapod_geometry.h"
 
 /* Macros *********************************************************************/
 
-#define PCA9685_MOTORS_PER_BOARD (16) /**< Number of motors per PCA9685 board */
+#define PCA9685_MOTORS_PER_BOARD (16)   /**< Number of motors per PCA9685 board */
+#define PCA9685_LED_REG_SIZE     (4)    /**< ON_L, ON_H, OFF_L and OFF_H registers per channel */
+#define PCA9685_ANGLE_LUT_SIZE   (1801) /**< 0.0° to 180.0° in 0.1° steps */
+#define PCA9685_CAL_VERSION      (1)    /**< Layout of the calibration stored in NVS, bump when `pca9685_servo_cal_t` changes */
 
 /* Constants ******************************************************************/
 
@@ -32,6 +38,9 @@ extern const char      *pca9685_tag;              /**< Tag for logs */
 extern const uint8_t    pca9685_step_size_deg;    /**< Step size in degrees for gradual movement */
 extern const uint32_t   pca9685_step_delay_ms;    /**< Delay in milliseconds between steps */
 extern const float      pca9685_default_angle;    /**< Default angle for motors */
+extern const uint16_t   pca9685_min_pulse_ticks;  /**< OFF tick count for a 0° servo pulse (1 ms at 54 Hz) */
+extern const uint16_t   pca9685_max_pulse_ticks;  /**< OFF tick count for a 180° servo pulse (2 ms at 54 Hz) */
+extern const char      *pca9685_nvs_namespace;    /**< NVS namespace holding per-servo calibration */
 
 /* Enums **********************************************************************/
 
@@ -69,6 +78,7 @@ typedef enum : uint8_t {
   k_pca9685_channel0_on_h_cmd      = 0x07, /**< Channel 0 output on time (high byte). */
   k_pca9685_channel0_off_l_cmd     = 0x08, /**< Channel 0 output off time (low byte). */
   k_pca9685_channel0_off_h_cmd     = 0x09, /**< Channel 0 output off time (high byte). */
+  k_pca9685_all_led_on_l_cmd       = 0xFA, /**< All channels output on time (low byte), followed by ON_H, OFF_L and OFF_H. */
   k_pca9685_auto_increment_cmd     = 0x20, /**< Auto-increment for MODE1 register. */
   k_pca9685_restart_cmd            = 0x80, /**< Restart command to enable PWM after frequency changes. */
   k_pca9685_sleep_cmd              = 0x10, /**< Sleep command to put the PCA9685 into low-power mode. */
@@ -80,23 +90,53 @@ typedef enum : uint8_t {
 
 /* Structs ********************************************************************/
 
+/**
+ * @brief Calibration of a single servo channel.
+ *
+ * A commanded angle is first mirrored when `inverted` is set, then offset by 
+ * `trim_decideg`, and finally mapped linearly from 0°-180° onto 
+ * `min_pulse_ticks`-`max_pulse_ticks`.
+ */
+typedef struct {
+  uint16_t min_pulse_ticks; /**< Pulse width in ticks at 0°. */
+  uint16_t max_pulse_ticks; /**< Pulse width in ticks at 180°. */
+  int16_t  trim_decideg;    /**< Mechanical offset in 0.1° steps, within ±45°. */
+  bool     inverted;        /**< Servo is mounted mirrored, so angles run 180° to 0°. */
+} pca9685_servo_cal_t;
+
 /**
  * @brief Represents a PCA9685 board in the system.
  *
  * Contains information about a single PCA9685 board, including its I2C address,
  * communication bus, operational state, unique ID, and motors it controls.
- * It also supports a singly linked list structure for managing multiple boards.
+ * Multiple boards are held in one contiguous array indexed by `board_id`.
  */
 typedef struct pca9685_board_t {
-  uint8_t                 i2c_address;                      /**< Base I2C address of the PCA9685 board. */
-  uint8_t                 i2c_bus;                          /**< I2C bus number used for communication. */
-  uint8_t                 state;                            /**< Current state of the PCA9685 (see pca9685_states_t). */
-  uint8_t                 board_id;                         /**< Unique ID for this board in multi-board setups. */
-  uint8_t                 num_boards;                       /**< Total number of PCA9685 boards in the system. */
-  motor_t                 motors[PCA9685_MOTORS_PER_BOARD]; /**< Array representing the motors controlled by this board. */
-  struct pca9685_board_t *next;                             /**< Pointer to the next board in the singly linked list. */
+  uint8_t                 i2c_address;                           /**< Base I2C address of the PCA9685 board. */
+  uint8_t                 i2c_bus;                               /**< I2C bus number used for communication. */
+  uint8_t                 state;                                 /**< Current state of the PCA9685 (see pca9685_states_t). */
+  uint8_t                 board_id;                              /**< Unique ID for this board in multi-board setups. */
+  uint8_t                 num_boards;                            /**< Total number of PCA9685 boards in the system. */
+  motor_t                 motors[PCA9685_MOTORS_PER_BOARD];      /**< Array representing the motors controlled by this board. */
+  uint16_t                pwm_on[PCA9685_MOTORS_PER_BOARD];      /**< Shadow of each channel's ON tick, including staged values. */
+  uint16_t                pwm_off[PCA9685_MOTORS_PER_BOARD];     /**< Shadow of each channel's OFF tick, including staged values. */
+  uint16_t                dirty_mask;                            /**< Channels staged but not yet written to the chip. */
+  pca9685_servo_cal_t     calibration[PCA9685_MOTORS_PER_BOARD]; /**< Per-channel servo calibration. */
+  const uint16_t         *angle_lut[PCA9685_MOTORS_PER_BOARD];   /**< Per-channel 0.1° angle-to-tick table, built from `calibration`. */
+  SemaphoreHandle_t       mutex;                                 /**< Guards the shadow, `motors` and the calibration, tasks may stage and flush concurrently. */
 } pca9685_board_t;
 
+/**
+ * @brief I2C traffic generated by the PCA9685 driver.
+ *
+ * Counts every write transaction and the bytes it put on the bus, including 
+ * the address byte, so batching gains can be measured.
+ */
+typedef struct {
+  uint32_t transactions; /**< I2C write transactions issued. */
+  uint32_t bytes;        /**< Bytes on the wire, address byte included. */
+} pca9685_bus_stats_t;
+
 /* Private Inline Functions ***************************************************/
 
 /**
@@ -132,7 +172,7 @@ static inline esp_err_t pca9685_read_register(uint8_t  i2c_addr,
  * Sets the PWM frequency for controlling servos or other PWM-controlled devices.
  * Logs errors and returns a failure code if any board initialization fails.
  *
- * @param[in,out] controller_data Pointer to the head of the linked list of PCA9685 boards.
+ * @param[out]    controller_data Set to the array of `num_boards` boards, indexed by board ID.
  * @param[in]     num_boards      Number of PCA9685 boards to initialize.
  *
  * @return 
@@ -151,7 +191,7 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards);
  * Updates servo positions using a motor bitmask and desired angle. Converts the angle 
  * (in degrees) to the corresponding PWM pulse width and applies it to the selected motors.
  *
- * @param[in] controller_data Pointer to the linked list of PCA9685 boards.
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
  * @param[in] motor_mask      Bitmask indicating motors to control (e.g., 0x01 for channel 0).
  * @param[in] board_id        ID of the PCA9685 board to control.
  * @param[in] angle           Servo angle in degrees (0-180).
@@ -171,6 +211,183 @@ esp_err_t pca9685_set_angle(pca9685_board_t *controller_data,
                             uint8_t          board_id, 
                             float            target_angle);
 
+/**
+ * @brief Writes a precomputed OFF tick count to one or more servo motors.
+ *
+ * Same as `pca9685_set_angle` but writes a raw pulse width, bypassing the 
+ * channel calibration. The stored motor position is derived back from the 
+ * tick count using the nominal pulse range.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in] motor_mask      Bitmask indicating motors to control (e.g., 0x01 for channel 0).
+ * @param[in] board_id        ID of the PCA9685 board to control.
+ * @param[in] ticks           OFF tick count, within 
+ *                            `pca9685_min_pulse_ticks`..`pca9685_max_pulse_ticks`.
+ *
+ * @return 
+ * - `ESP_OK`              if the ticks are successfully applied.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL or `ticks` is out of range.
+ * - `ESP_FAIL`            if the board ID is not found or not initialized.
+ */
+esp_err_t pca9685_set_ticks(pca9685_board_t *controller_data, 
+                            uint16_t         motor_mask,
+                            uint8_t          board_id, 
+                            uint16_t         ticks);
+
+/**
+ * @brief Writes a servo pulse that starts at a chosen point in the PWM period.
+ *
+ * The pulse rises at `on_ticks` and falls `width_ticks` later, wrapping 
+ * around the 4096-tick period. Staggering `on_ticks` across channels keeps 
+ * servo pulses, and the current they draw, from all starting together.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the PCA9685 board to control.
+ * @param[in] channel         Channel on the board (0-15).
+ * @param[in] on_ticks        Tick at which the pulse starts (0-4095).
+ * @param[in] width_ticks     Pulse width, within 
+ *                            `pca9685_min_pulse_ticks`..`pca9685_max_pulse_ticks`.
+ *
+ * @return 
+ * - `ESP_OK`              if the pulse is successfully applied.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL or an argument is out of range.
+ * - `ESP_FAIL`            if the board ID is not found or not initialized.
+ *
+ * @note This is called from the control loop and only logs on failure.
+ */
+esp_err_t pca9685_set_pulse(pca9685_board_t *controller_data, 
+                            uint8_t          board_id, 
+                            uint8_t          channel, 
+                            uint16_t         on_ticks, 
+                            uint16_t         width_ticks);
+
+/**
+ * @brief Stages a servo pulse without touching the bus.
+ *
+ * Same arguments as `pca9685_set_pulse`. The value is only written by the 
+ * next `pca9685_flush`, and is dropped there if it matches what the chip 
+ * already holds.
+ *
+ * @return 
+ * - `ESP_OK`              if the pulse is staged.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL or an argument is out of range.
+ * - `ESP_FAIL`            if the board ID is not found or not initialized.
+ */
+esp_err_t pca9685_stage_pulse(pca9685_board_t *controller_data, 
+                              uint8_t          board_id, 
+                              uint8_t          channel, 
+                              uint16_t         on_ticks, 
+                              uint16_t         width_ticks);
+
+/**
+ * @brief Writes every staged channel on every board.
+ *
+ * Each board takes at most one I2C transaction. When all 16 channels end up 
+ * with the same value the ALL_LED registers are used. Otherwise the range 
+ * from the first to the last changed channel is written in one 
+ * auto-increment burst. Each board's mutex is held while it is written, so 
+ * another task staging or setting channels never loses an update; a value it 
+ * staged before the flush may go out with it.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ *
+ * @return 
+ * - `ESP_OK`              if every board was flushed.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL.
+ * - Relevant `esp_err_t` codes if a write fails; unwritten channels stay staged.
+ */
+esp_err_t pca9685_flush(pca9685_board_t *controller_data);
+
+/**
+ * @brief Stages a servo position through the channel's calibration table.
+ *
+ * Like `pca9685_stage_pulse`, but the pulse width comes from a single 
+ * lookup in the channel's angle-to-tick table.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the PCA9685 board to control.
+ * @param[in] channel         Channel on the board (0-15).
+ * @param[in] on_ticks        Tick at which the pulse starts (0-4095).
+ * @param[in] angle_decideg   Servo position in 0.1° steps (0-1800), clamped.
+ *
+ * @return 
+ * - `ESP_OK`              if the position is staged.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL or an argument is out of range.
+ * - `ESP_FAIL`            if the board ID is not found or not initialized.
+ */
+esp_err_t pca9685_stage_angle(pca9685_board_t *controller_data, 
+                              uint8_t          board_id, 
+                              uint8_t          channel, 
+                              uint16_t         on_ticks, 
+                              uint16_t         angle_decideg);
+
+/**
+ * @brief Replaces a channel's calibration and rebuilds its lookup table.
+ *
+ * The new calibration takes effect immediately but is only persisted by 
+ * `pca9685_save_calibration`.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the PCA9685 board.
+ * @param[in] channel         Channel on the board (0-15).
+ * @param[in] calibration     New calibration for the channel.
+ *
+ * @return 
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if an argument is NULL, out of range, or the 
+ *                         calibration is inconsistent.
+ * - `ESP_ERR_NO_MEM`      if the lookup table cannot be allocated.
+ * - `ESP_FAIL`            if the board ID is not found.
+ */
+esp_err_t pca9685_set_calibration(pca9685_board_t           *controller_data, 
+                                  uint8_t                    board_id, 
+                                  uint8_t                    channel, 
+                                  const pca9685_servo_cal_t *calibration);
+
+/**
+ * @brief Reads a channel's current calibration.
+ *
+ * @param[in]  controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in]  board_id        ID of the PCA9685 board.
+ * @param[in]  channel         Channel on the board (0-15).
+ * @param[out] calibration     Destination for the calibration.
+ *
+ * @return 
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if an argument is NULL or out of range.
+ * - `ESP_FAIL`            if the board ID is not found.
+ */
+esp_err_t pca9685_get_calibration(pca9685_board_t     *controller_data, 
+                                  uint8_t              board_id, 
+                                  uint8_t              channel, 
+                                  pca9685_servo_cal_t *calibration);
+
+/**
+ * @brief Persists a board's calibration table to NVS.
+ *
+ * Stored with `PCA9685_CAL_VERSION` and its size; `pca9685_init` loads it back
+ * on the next boot and ignores tables stored with another layout.
+ *
+ * @param[in] controller_data Any board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the PCA9685 board.
+ *
+ * @return 
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if `controller_data` is NULL.
+ * - `ESP_FAIL`            if the board ID is not found.
+ * - Relevant NVS `esp_err_t` codes on storage failure.
+ */
+esp_err_t pca9685_save_calibration(pca9685_board_t *controller_data, 
+                                   uint8_t          board_id);
+
+/**
+ * @brief Copies the I2C traffic counters.
+ *
+ * @param[out] stats Destination for the counters.
+ * @param[in]  reset Clears the counters after copying when true.
+ */
+void pca9685_get_bus_stats(pca9685_bus_stats_t *stats, bool reset);
+
 #ifdef __cplusplus
 }
 #endif
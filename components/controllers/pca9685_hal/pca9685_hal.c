@@ -2,8 +2,10 @@
 
 #include "pca9685_hal.h"
 #include "common/i2c.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "nvs.h"
 #include "log_handler.h"
 
 /* Constants ******************************************************************/
@@ -22,19 +24,60 @@ const char      *pca9685_tag              = "PCA9685";
 const uint8_t    pca9685_step_size_deg    = 5;
 const uint32_t   pca9685_step_delay_ms    = 20;
 const float      pca9685_default_angle    = 90.0f;
+const uint16_t   pca9685_min_pulse_ticks  = 221;      /**< (4096 * 1ms) / 18.519ms */
+const uint16_t   pca9685_max_pulse_ticks  = 442;      /**< (4096 * 2ms) / 18.519ms */
+const char      *pca9685_nvs_namespace    = "pca9685";
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief A board's calibration as stored in NVS.
+ *
+ * The header lets a load reject blobs written with another layout instead
+ * of misreading them.
+ */
+typedef struct {
+  uint16_t            version;                               /**< `PCA9685_CAL_VERSION` when written. */
+  uint16_t            size;                                  /**< Bytes of `calibration`. */
+  pca9685_servo_cal_t calibration[PCA9685_MOTORS_PER_BOARD]; /**< Per-channel calibration. */
+} pca9685_cal_blob_t;
+
+/* Globals (Static) ***********************************************************/
+
+static pca9685_bus_stats_t s_bus_stats                               = {0};
+static uint16_t            s_default_lut[PCA9685_ANGLE_LUT_SIZE]     = {0}; /* Shared by every uncalibrated channel */
+static bool                s_default_lut_ready                       = false;
 
 /* Private Function Implementations *******************************************/
 
+/**
+ * @brief Issues one I2C write transaction and counts it.
+ *
+ * @param[in] i2c_addr I2C address of the PCA9685 device.
+ * @param[in] buf      Register address followed by the data bytes.
+ * @param[in] len      Number of bytes in `buf`.
+ *
+ * @return ESP_OK if successful, otherwise an error code.
+ */
+static esp_err_t priv_write_burst(uint8_t        i2c_addr, 
+                                  const uint8_t *buf, 
+                                  size_t         len)
+{
+  s_bus_stats.transactions++;
+  s_bus_stats.bytes += len + 1; /* Address byte */
+  return i2c_master_write_to_device(pca9685_i2c_bus, 
+                                    i2c_addr, 
+                                    buf, 
+                                    len, 
+                                    pdMS_TO_TICKS(100));
+}
+
 static esp_err_t pca9685_write_register(uint8_t i2c_addr, 
                                         uint8_t reg, 
                                         uint8_t value) 
 {
-  uint8_t write_buf[2] = {reg, value};
-  esp_err_t ret = i2c_master_write_to_device(pca9685_i2c_bus, 
-                                             i2c_addr, 
-                                             write_buf, 
-                                             sizeof(write_buf), 
-                                             pdMS_TO_TICKS(100));
+  uint8_t   write_buf[2] = {reg, value};
+  esp_err_t ret          = priv_write_burst(i2c_addr, write_buf, sizeof(write_buf));
   if (ret != ESP_OK) {
     log_error(pca9685_tag, 
               "Write Error", 
@@ -95,90 +138,346 @@ static esp_err_t pca9685_set_pwm_freq(uint8_t i2c_addr, uint16_t freq)
   return ESP_OK;
 }
 
-static esp_err_t pca9685_set_pwm(uint8_t  i2c_addr, 
-                                 uint8_t  channel, 
-                                 uint16_t on, 
-                                 uint16_t off) 
+/**
+ * @brief Records a channel's ON/OFF ticks in the board shadow.
+ *
+ * The channel is only marked dirty when the value actually changes.
+ *
+ * @param[in,out] board   Board owning the channel.
+ * @param[in]     channel Channel on the board (0-15).
+ * @param[in]     on      ON tick count.
+ * @param[in]     off     OFF tick count.
+ */
+static inline void priv_stage_pwm(pca9685_board_t *board, 
+                                  uint8_t          channel, 
+                                  uint16_t         on, 
+                                  uint16_t         off)
 {
-  uint8_t   reg = k_pca9685_channel0_on_l_cmd + (channel * 4);
-  esp_err_t ret;
+  if (board->pwm_on[channel] != on || board->pwm_off[channel] != off) {
+    board->pwm_on[channel]   = on;
+    board->pwm_off[channel]  = off;
+    board->dirty_mask       |= (1 << channel);
+  }
+}
 
-  log_info(pca9685_tag, 
-           "PWM Update", 
-           "Setting channel %u: ON=%u, OFF=%u", 
-           channel, 
-           on, 
-           off);
+/**
+ * @brief Writes a board's staged channels in a single I2C transaction.
+ *
+ * Uses the ALL_LED registers when every channel holds the same value, 
+ * otherwise one auto-increment burst covering the first to the last dirty 
+ * channel. Clean channels inside that range are rewritten with their 
+ * unchanged shadow values, which is cheaper than splitting the burst.
+ *
+ * @param[in,out] board Board to flush.
+ *
+ * @return ESP_OK if successful, otherwise an error code.
+ */
+static esp_err_t priv_flush_board(pca9685_board_t *board)
+{
+  if (board->dirty_mask == 0) {
+    return ESP_OK;
+  }
 
-  /* Write ON time */
-  ret = pca9685_write_register(i2c_addr, reg, on & 0xFF);
-  if (ret != ESP_OK) {
-    log_error(pca9685_tag, 
-              "Write Error", 
-              "Failed to write ON low byte for channel %u", 
-              channel);
-    return ret;
+  bool uniform = true;
+  for (uint8_t channel = 1; channel < PCA9685_MOTORS_PER_BOARD; channel++) {
+    if (board->pwm_on[channel] != board->pwm_on[0] || 
+        board->pwm_off[channel] != board->pwm_off[0]) {
+      uniform = false;
+      break;
+    }
   }
-  ret = pca9685_write_register(i2c_addr, reg + 1, (on >> 8) & 0xFF);
-  if (ret != ESP_OK) {
-    log_error(pca9685_tag, 
-              "Write Error", 
-              "Failed to write ON high byte for channel %u", 
-              channel);
-    return ret;
+
+  uint8_t buf[1 + (PCA9685_MOTORS_PER_BOARD * PCA9685_LED_REG_SIZE)];
+  uint8_t first = 0;
+  uint8_t count = 1;
+  if (uniform && (board->dirty_mask & (board->dirty_mask - 1)) != 0) {
+    buf[0] = k_pca9685_all_led_on_l_cmd;
+  } else {
+    first  = __builtin_ctz(board->dirty_mask);
+    count  = (31 - __builtin_clz(board->dirty_mask)) - first + 1;
+    buf[0] = k_pca9685_channel0_on_l_cmd + (first * PCA9685_LED_REG_SIZE);
   }
 
-  /* Write OFF time */
-  ret = pca9685_write_register(i2c_addr, reg + 2, off & 0xFF);
-  if (ret != ESP_OK) {
-    log_error(pca9685_tag, 
-              "Write Error", 
-              "Failed to write OFF low byte for channel %u", 
-              channel);
-    return ret;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t *regs = &buf[1 + (i * PCA9685_LED_REG_SIZE)];
+    regs[0]       = board->pwm_on[first + i] & 0xFF;
+    regs[1]       = (board->pwm_on[first + i] >> 8) & 0x0F;
+    regs[2]       = board->pwm_off[first + i] & 0xFF;
+    regs[3]       = (board->pwm_off[first + i] >> 8) & 0x0F;
   }
-  ret = pca9685_write_register(i2c_addr, reg + 3, (off >> 8) & 0xFF);
+
+  esp_err_t ret = priv_write_burst(board->i2c_address, 
+                                   buf, 
+                                   1 + (count * PCA9685_LED_REG_SIZE));
   if (ret != ESP_OK) {
     log_error(pca9685_tag, 
               "Write Error", 
-              "Failed to write OFF high byte for channel %u", 
-              channel);
+              "Failed to write %u channels starting at %u on board %u", 
+              count, 
+              first, 
+              board->board_id);
     return ret;
   }
 
+  board->dirty_mask = 0;
+  return ESP_OK;
+}
+
+/**
+ * @brief Derives a motor position in degrees from a pulse width.
+ *
+ * @param[in] width_ticks Pulse width in ticks.
+ *
+ * @return The matching servo angle (0-180).
+ */
+static inline float priv_ticks_to_deg(uint16_t width_ticks)
+{
+  return (float)(width_ticks - pca9685_min_pulse_ticks) * 180.0f / 
+         (float)(pca9685_max_pulse_ticks - pca9685_min_pulse_ticks);
+}
+
+/**
+ * @brief Fills an angle-to-tick table from a servo calibration.
+ *
+ * @param[in]  cal Calibration to apply.
+ * @param[out] lut Table of `PCA9685_ANGLE_LUT_SIZE` entries, one per 0.1°.
+ */
+static void priv_build_angle_lut(const pca9685_servo_cal_t *cal, uint16_t *lut)
+{
+  const int32_t last = PCA9685_ANGLE_LUT_SIZE - 1;
+  const int32_t span = cal->max_pulse_ticks - cal->min_pulse_ticks;
+
+  for (int32_t i = 0; i <= last; i++) {
+    int32_t angle = (cal->inverted ? last - i : i) + cal->trim_decideg;
+    if (angle < 0) {
+      angle = 0;
+    } else if (angle > last) {
+      angle = last;
+    }
+    lut[i] = cal->min_pulse_ticks + (uint16_t)((span * angle + (last / 2)) / last);
+  }
+}
+
+/**
+ * @brief Returns the calibration every channel starts with.
+ */
+static inline pca9685_servo_cal_t priv_default_calibration(void)
+{
+  return (pca9685_servo_cal_t){
+    .min_pulse_ticks = pca9685_min_pulse_ticks,
+    .max_pulse_ticks = pca9685_max_pulse_ticks,
+    .trim_decideg    = 0,
+    .inverted        = false,
+  };
+}
+
+/**
+ * @brief Checks that a calibration describes a usable servo.
+ *
+ * @param[in] cal Calibration to check.
+ *
+ * @return true if the pulse range and trim are sane.
+ */
+static bool priv_calibration_is_valid(const pca9685_servo_cal_t *cal)
+{
+  return cal->min_pulse_ticks > 0 && 
+         cal->min_pulse_ticks < cal->max_pulse_ticks && 
+         cal->max_pulse_ticks <= pca9685_max_pwm_value && 
+         cal->trim_decideg >= -450 && 
+         cal->trim_decideg <= 450;
+}
+
+/**
+ * @brief Stores a channel's calibration and points it at a matching table.
+ *
+ * Uncalibrated channels share `s_default_lut`; calibrated ones get their 
+ * own table, replacing any previous one.
+ *
+ * @param[in,out] board   Board owning the channel.
+ * @param[in]     channel Channel on the board (0-15).
+ * @param[in]     cal     Validated calibration to apply.
+ *
+ * @return 
+ * - `ESP_OK`         on success.
+ * - `ESP_ERR_NO_MEM` if the table cannot be allocated; the channel is unchanged.
+ */
+static esp_err_t priv_apply_calibration(pca9685_board_t           *board, 
+                                        uint8_t                    channel, 
+                                        const pca9685_servo_cal_t *cal)
+{
+  const pca9685_servo_cal_t defaults = priv_default_calibration();
+  uint16_t                 *lut      = s_default_lut;
+
+  if (memcmp(cal, &defaults, sizeof(defaults)) != 0) {
+    lut = malloc(PCA9685_ANGLE_LUT_SIZE * sizeof(uint16_t));
+    if (lut == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+    priv_build_angle_lut(cal, lut);
+  }
+
+  if (board->angle_lut[channel] != NULL && board->angle_lut[channel] != s_default_lut) {
+    free((void *)board->angle_lut[channel]);
+  }
+  board->calibration[channel] = *cal;
+  board->angle_lut[channel]   = lut;
   return ESP_OK;
 }
 
-static uint16_t angle_to_pwm(float angle) 
+/**
+ * @brief Releases every calibrated lookup table owned by a board.
+ *
+ * Used when a board fails to initialize. It is never driven, so the tables 
+ * loaded for it would only hold heap.
+ *
+ * @param[in,out] board Board to clean up.
+ */
+static void priv_free_angle_luts(pca9685_board_t *board)
+{
+  for (uint8_t channel = 0; channel < PCA9685_MOTORS_PER_BOARD; channel++) {
+    if (board->angle_lut[channel] != NULL && board->angle_lut[channel] != s_default_lut) {
+      free((void *)board->angle_lut[channel]);
+    }
+    board->angle_lut[channel] = NULL;
+  }
+}
+
+/**
+ * @brief Converts a servo position to ticks with the channel's table.
+ *
+ * @param[in] board         Board owning the channel.
+ * @param[in] channel       Channel on the board (0-15).
+ * @param[in] angle_decideg Servo position in 0.1° steps, clamped to 1800.
+ *
+ * @return The calibrated pulse width in ticks.
+ */
+static inline uint16_t priv_angle_to_ticks(const pca9685_board_t *board, 
+                                           uint8_t                channel, 
+                                           uint16_t               angle_decideg)
+{
+  if (angle_decideg >= PCA9685_ANGLE_LUT_SIZE) {
+    angle_decideg = PCA9685_ANGLE_LUT_SIZE - 1;
+  }
+  return board->angle_lut[channel][angle_decideg];
+}
+
+/**
+ * @brief Builds the NVS key holding a board's calibration.
+ *
+ * @param[in]  board_id ID of the board.
+ * @param[out] key      Destination, at least 8 bytes.
+ */
+static inline void priv_calibration_key(uint8_t board_id, char key[8])
+{
+  snprintf(key, 8, "cal%u", board_id);
+}
+
+/**
+ * @brief Loads a board's calibration from NVS, falling back to defaults.
+ *
+ * Missing or invalid entries, and blobs of another version or size, leave 
+ * the affected channels on the default calibration.
+ *
+ * @param[in,out] board Board to calibrate.
+ */
+static void priv_load_calibration(pca9685_board_t *board)
 {
-  /* At 54Hz:
-   * 1ms pulse = (4096 * 1ms) / 18.519ms ≈ 221 counts
-   * 2ms pulse = (4096 * 2ms) / 18.519ms ≈ 442 counts */
-  const uint16_t min_pulse = 221; /* 1ms at 54Hz */
-  const uint16_t max_pulse = 442; /* 2ms at 54Hz */
-  
-  /* Constrain angle to 0-180 degrees */
-  if (angle < 0.0f) {
-    angle = 0.0f;
-  }
-  if (angle > 180.0f) {
-    angle = 180.0f;
-  }
-  
-  /* Linear interpolation */
-  uint16_t pwm = min_pulse + (uint16_t)((max_pulse - min_pulse) * angle / 180.0f);
-  
-  /* Calculate actual pulse width in microseconds for debugging */
-  float pulse_us = (float)pwm * (18519.0f / pca9685_pwm_resolution);
-  
+  pca9685_cal_blob_t blob;
+  size_t             length = sizeof(blob);
+  bool               loaded = false;
+  nvs_handle_t       handle;
+  char               key[8];
+
+  priv_calibration_key(board->board_id, key);
+  if (nvs_open(pca9685_nvs_namespace, NVS_READONLY, &handle) == ESP_OK) {
+    esp_err_t ret = nvs_get_blob(handle, key, &blob, &length);
+    nvs_close(handle);
+
+    if (ret == ESP_OK && length == sizeof(blob) && 
+        blob.version == PCA9685_CAL_VERSION && blob.size == sizeof(blob.calibration)) {
+      loaded = true;
+    } else if (ret == ESP_OK || ret == ESP_ERR_NVS_INVALID_LENGTH) {
+      log_warn(pca9685_tag, 
+               "Calibration", 
+               "Ignoring stored calibration for board %u, written with another layout", 
+               board->board_id);
+    }
+  }
+  const pca9685_servo_cal_t *stored = blob.calibration;
+
+  const pca9685_servo_cal_t defaults = priv_default_calibration();
+  for (uint8_t channel = 0; channel < PCA9685_MOTORS_PER_BOARD; channel++) {
+    const pca9685_servo_cal_t *cal = &defaults;
+    if (loaded) {
+      if (priv_calibration_is_valid(&stored[channel])) {
+        cal = &stored[channel];
+      } else {
+        log_warn(pca9685_tag, 
+                 "Calibration", 
+                 "Ignoring invalid calibration for channel %u on board %u", 
+                 channel, 
+                 board->board_id);
+      }
+    }
+    if (priv_apply_calibration(board, channel, cal) != ESP_OK) {
+      log_warn(pca9685_tag, 
+               "Calibration", 
+               "No memory for channel %u table on board %u, using defaults", 
+               channel, 
+               board->board_id);
+      priv_apply_calibration(board, channel, &defaults);
+    }
+  }
+
   log_info(pca9685_tag, 
-           "Angle Convert", 
-           "Angle %.1f° converted to PWM %u (%.2f ms pulse)", 
-           angle, 
-           pwm, 
-           pulse_us / 1000.0f); /* Convert to milliseconds */
-           
-  return pwm;
+           "Calibration", 
+           "Board %u using %s servo calibration", 
+           board->board_id, 
+           loaded ? "stored" : "default");
+}
+
+/**
+ * @brief Finds a board by ID.
+ *
+ * Boards live in one array indexed by ID, so this is a bounds check and an
+ * offset. Any board of the array may be passed in, not just the first.
+ *
+ * @param[in] controller_data A board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the board to find.
+ *
+ * @return The board, or NULL if there is none with that ID or it has no mutex.
+ */
+static inline pca9685_board_t *priv_find_board(pca9685_board_t *controller_data, 
+                                               uint8_t          board_id)
+{
+  if (board_id >= controller_data->num_boards) {
+    return NULL;
+  }
+  pca9685_board_t *board = controller_data - controller_data->board_id + board_id;
+  return board->mutex != NULL ? board : NULL;
+}
+
+/**
+ * @brief Finds a board by ID and checks that it is ready.
+ *
+ * @param[in] controller_data A board of the array returned by `pca9685_init`.
+ * @param[in] board_id        ID of the board to find.
+ *
+ * @return The board, or NULL (after logging) if it is missing or not ready.
+ */
+static pca9685_board_t *priv_find_ready_board(pca9685_board_t *controller_data, 
+                                              uint8_t          board_id)
+{
+  pca9685_board_t *board = priv_find_board(controller_data, board_id);
+  if (board == NULL || board->state != k_pca9685_ready) {
+    log_error(pca9685_tag, 
+              "Board Error", 
+              "Board %u not found or not ready (state=%u)", 
+              board_id, 
+              board ? board->state : -1);
+    return NULL;
+  }
+  return board;
 }
 
 /* Public Function Implementations *******************************************/
@@ -216,25 +515,25 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
     return ret;
   }
 
-  /* Create and initialize the board list */
-  pca9685_board_t *head    = NULL;
-  pca9685_board_t *current = NULL;
+  /* Table shared by every channel still on the default calibration */
+  if (!s_default_lut_ready) {
+    const pca9685_servo_cal_t defaults = priv_default_calibration();
+    priv_build_angle_lut(&defaults, s_default_lut);
+    s_default_lut_ready = true;
+  }
+
+  /* Boards are allocated as one array indexed by board ID */
+  pca9685_board_t *boards = calloc(num_boards, sizeof(pca9685_board_t));
+  if (boards == NULL) {
+    log_error(pca9685_tag, 
+              "Memory Error", 
+              "Failed to allocate memory for %u boards", 
+              num_boards);
+    return ESP_ERR_NO_MEM;
+  }
 
   for (uint8_t i = 0; i < num_boards; i++) {
-    pca9685_board_t *board = calloc(1, sizeof(pca9685_board_t));
-    if (board == NULL) {
-      log_error(pca9685_tag, 
-                "Memory Error", 
-                "Failed to allocate memory for board %u", 
-                i);
-      /* Clean up on allocation failure */
-      while (head != NULL) {
-        current = head;
-        head    = head->next;
-        free(current);
-      }
-      return ESP_ERR_NO_MEM;
-    }
+    pca9685_board_t *board = &boards[i];
 
     /* Initialize board structure */
     board->i2c_address = pca9685_i2c_address + i;
@@ -242,7 +541,11 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
     board->board_id    = i;
     board->num_boards  = num_boards;
     board->state       = k_pca9685_uninitialized;
-    board->next        = NULL;
+    board->mutex       = xSemaphoreCreateMutex();
+    if (board->mutex == NULL) {
+      log_error(pca9685_tag, "Init Error", "Failed to create mutex for board %u", i);
+      continue;
+    }
 
     /* Initialize motors array */
     for (int j = 0; j < PCA9685_MOTORS_PER_BOARD; j++) {
@@ -251,14 +554,8 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
       board->motors[j].motor_id = j;
     }
 
-    /* Add to linked list */
-    if (head == NULL) {
-      head    = board;
-      current = board;
-    } else {
-      current->next = board;
-      current       = board;
-    }
+    /* Per-servo pulse range, trim and direction, before anything is driven */
+    priv_load_calibration(board);
 
     /* Initialize PCA9685 hardware */
     /* Reset the device */
@@ -267,6 +564,7 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
                                  k_pca9685_restart_cmd);
     if (ret != ESP_OK) {
       log_error(pca9685_tag, "Reset Error", "Failed to reset board %u", i);
+      priv_free_angle_luts(board);
       continue;
     }
 
@@ -277,6 +575,7 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
                 "Freq Error", 
                 "Failed to set PWM frequency for board %u", 
                 i);
+      priv_free_angle_luts(board);
       continue;
     }
 
@@ -289,6 +588,24 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
                 "Config Error", 
                 "Failed to configure output mode for board %u", 
                 i);
+      priv_free_angle_luts(board);
+      continue;
+    }
+
+    /* Enable register auto-increment so channel updates can be written in one burst */
+    uint8_t mode1;
+    ret = pca9685_read_register(board->i2c_address, k_pca9685_mode1_cmd, &mode1);
+    if (ret == ESP_OK) {
+      ret = pca9685_write_register(board->i2c_address, 
+                                   k_pca9685_mode1_cmd, 
+                                   (mode1 & ~k_pca9685_restart_cmd) | k_pca9685_auto_increment_cmd);
+    }
+    if (ret != ESP_OK) {
+      log_error(pca9685_tag, 
+                "Config Error", 
+                "Failed to enable auto-increment for board %u", 
+                i);
+      priv_free_angle_luts(board);
       continue;
     }
 
@@ -299,22 +616,21 @@ esp_err_t pca9685_init(pca9685_board_t **controller_data, uint8_t num_boards)
              i, 
              board->i2c_address);
 
-    /* Set all motors to their default angle */
-    uint16_t default_pwm = angle_to_pwm(pca9685_default_angle);
-    for (int j = 0; j < PCA9685_MOTORS_PER_BOARD; j++) {
-      ret = pca9685_set_pwm(board->i2c_address, j, 0, default_pwm);
-      if (ret != ESP_OK) {
-        log_warn(pca9685_tag, 
-                 "Motor Init", 
-                 "Failed to set default angle for motor %u on board %u", 
-                 j, 
-                 i);
-        continue;
-      }
+    /* Set all motors to their default angle, a single ALL_LED write when uncalibrated */
+    uint16_t default_decideg = (uint16_t)(pca9685_default_angle * 10.0f + 0.5f);
+    for (uint8_t j = 0; j < PCA9685_MOTORS_PER_BOARD; j++) {
+      priv_stage_pwm(board, j, 0, priv_angle_to_ticks(board, j, default_decideg));
+    }
+    ret = priv_flush_board(board);
+    if (ret != ESP_OK) {
+      log_warn(pca9685_tag, 
+               "Motor Init", 
+               "Failed to set default angle for motors on board %u", 
+               i);
     }
   }
 
-  *controller_data = head;
+  *controller_data = boards;
   return ESP_OK;
 }
 
@@ -333,60 +649,334 @@ esp_err_t pca9685_set_angle(pca9685_board_t *controller_data,
   }
 
   /* Find the target board */
-  pca9685_board_t *board = controller_data;
-  while (board != NULL && board->board_id != board_id) {
-    board = board->next;
-  }
-
-  if (board == NULL || board->state != k_pca9685_ready) {
-    log_error(pca9685_tag, 
-              "Board Error", 
-              "Board %u not found or not ready (state=%u)", 
-              board_id, 
-              board ? board->state : -1);
+  pca9685_board_t *board = priv_find_ready_board(controller_data, board_id);
+  if (board == NULL) {
     return ESP_FAIL;
   }
 
-  /* Convert angle to PWM value */
-  uint16_t pwm_value = angle_to_pwm(target_angle);
-  log_info(pca9685_tag, 
-           "Angle Set", 
-           "Setting board %u to angle %.2f° (PWM: %u)", 
-           board_id, 
-           target_angle, 
-           pwm_value);
+  /* Angle in 0.1° steps indexes each channel's calibration table */
+  uint16_t angle_decideg = (uint16_t)(target_angle * 10.0f + 0.5f);
+  log_debug(pca9685_tag, 
+            "Angle Set", 
+            "Setting board %u to angle %.2f°", 
+            board_id, 
+            target_angle);
 
   /* Update each motor specified in the mask */
-  esp_err_t ret = ESP_OK;
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
   for (uint8_t channel = 0; channel < PCA9685_MOTORS_PER_BOARD; channel++) {
     if (motor_mask & (1 << channel)) {
-      log_info(pca9685_tag, 
-               "Motor Update", 
-               "Setting channel %u on board %u", 
-               channel, 
-               board_id);
-      
-      /* Set PWM values (ON time = 0, OFF time = calculated value) */
-      ret = pca9685_set_pwm(board->i2c_address, channel, 0, pwm_value);
-      if (ret != ESP_OK) {
-        log_error(pca9685_tag, 
-                  "PWM Error", 
-                  "Failed to set PWM for channel %u on board %u", 
-                  channel, 
-                  board_id);
-        return ret;
-      }
+      uint16_t pwm_value = priv_angle_to_ticks(board, channel, angle_decideg);
+      log_debug(pca9685_tag, 
+                "Motor Update", 
+                "Setting channel %u on board %u (PWM: %u)", 
+                channel, 
+                board_id, 
+                pwm_value);
       
+      /* Stage PWM values (ON time = 0, OFF time = calculated value) */
+      priv_stage_pwm(board, channel, 0, pwm_value);
+
       /* Update motor state */
       board->motors[channel].pos_deg = target_angle;
-      log_info(pca9685_tag, 
-               "Motor Set", 
-               "Channel %u on board %u set to %.2f°", 
-               channel, 
-               board_id, 
-               target_angle);
+      log_debug(pca9685_tag, 
+                "Motor Set", 
+                "Channel %u on board %u set to %.2f°", 
+                channel, 
+                board_id, 
+                target_angle);
     }
   }
 
+  /* Write all selected channels in one transaction */
+  esp_err_t ret = priv_flush_board(board);
+  xSemaphoreGive(board->mutex);
+  if (ret != ESP_OK) {
+    log_error(pca9685_tag, 
+              "PWM Error", 
+              "Failed to set PWM for mask 0x%04X on board %u", 
+              motor_mask, 
+              board_id);
+  }
+  return ret;
+}
+
+esp_err_t pca9685_set_ticks(pca9685_board_t *controller_data, 
+                            uint16_t         motor_mask,
+                            uint8_t          board_id, 
+                            uint16_t         ticks) 
+{
+  if (controller_data == NULL || 
+      ticks < pca9685_min_pulse_ticks || 
+      ticks > pca9685_max_pulse_ticks) {
+    log_error(pca9685_tag, 
+              "Param Error", 
+              "Invalid arguments: controller=%p, ticks=%u", 
+              (void*)controller_data, 
+              ticks);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_ready_board(controller_data, board_id);
+  if (board == NULL) {
+    return ESP_FAIL;
+  }
+
+  const float pos_deg = priv_ticks_to_deg(ticks);
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  for (uint8_t channel = 0; channel < PCA9685_MOTORS_PER_BOARD; channel++) {
+    if (motor_mask & (1 << channel)) {
+      priv_stage_pwm(board, channel, 0, ticks);
+      board->motors[channel].pos_deg = pos_deg;
+    }
+  }
+
+  esp_err_t ret = priv_flush_board(board);
+  xSemaphoreGive(board->mutex);
+  if (ret != ESP_OK) {
+    log_error(pca9685_tag, 
+              "PWM Error", 
+              "Failed to set PWM for mask 0x%04X on board %u", 
+              motor_mask, 
+              board_id);
+  }
+  return ret;
+}
+
+esp_err_t pca9685_stage_pulse(pca9685_board_t *controller_data, 
+                              uint8_t          board_id, 
+                              uint8_t          channel, 
+                              uint16_t         on_ticks, 
+                              uint16_t         width_ticks) 
+{
+  if (controller_data == NULL || 
+      channel >= PCA9685_MOTORS_PER_BOARD || 
+      on_ticks > pca9685_max_pwm_value || 
+      width_ticks < pca9685_min_pulse_ticks || 
+      width_ticks > pca9685_max_pulse_ticks) {
+    log_error(pca9685_tag, 
+              "Param Error", 
+              "Invalid arguments: controller=%p, channel=%u, on=%u, width=%u", 
+              (void*)controller_data, 
+              channel, 
+              on_ticks, 
+              width_ticks);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_ready_board(controller_data, board_id);
+  if (board == NULL) {
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  priv_stage_pwm(board, 
+                 channel, 
+                 on_ticks, 
+                 (on_ticks + width_ticks) % pca9685_pwm_resolution);
+  board->motors[channel].pos_deg = priv_ticks_to_deg(width_ticks);
+  xSemaphoreGive(board->mutex);
+  return ESP_OK;
+}
+
+esp_err_t pca9685_stage_angle(pca9685_board_t *controller_data, 
+                              uint8_t          board_id, 
+                              uint8_t          channel, 
+                              uint16_t         on_ticks, 
+                              uint16_t         angle_decideg) 
+{
+  if (controller_data == NULL || 
+      channel >= PCA9685_MOTORS_PER_BOARD || 
+      on_ticks > pca9685_max_pwm_value) {
+    log_error(pca9685_tag, 
+              "Param Error", 
+              "Invalid arguments: controller=%p, channel=%u, on=%u", 
+              (void*)controller_data, 
+              channel, 
+              on_ticks);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_ready_board(controller_data, board_id);
+  if (board == NULL) {
+    return ESP_FAIL;
+  }
+
+  if (angle_decideg >= PCA9685_ANGLE_LUT_SIZE) {
+    angle_decideg = PCA9685_ANGLE_LUT_SIZE - 1;
+  }
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  uint16_t width_ticks = priv_angle_to_ticks(board, channel, angle_decideg);
+  priv_stage_pwm(board, 
+                 channel, 
+                 on_ticks, 
+                 (on_ticks + width_ticks) % pca9685_pwm_resolution);
+  board->motors[channel].pos_deg = (float)angle_decideg * 0.1f;
+  xSemaphoreGive(board->mutex);
   return ESP_OK;
 }
+
+esp_err_t pca9685_set_pulse(pca9685_board_t *controller_data, 
+                            uint8_t          board_id, 
+                            uint8_t          channel, 
+                            uint16_t         on_ticks, 
+                            uint16_t         width_ticks) 
+{
+  esp_err_t ret = pca9685_stage_pulse(controller_data, 
+                                      board_id, 
+                                      channel, 
+                                      on_ticks, 
+                                      width_ticks);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  return pca9685_flush(controller_data);
+}
+
+esp_err_t pca9685_flush(pca9685_board_t *controller_data)
+{
+  if (controller_data == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t        result = ESP_OK;
+  pca9685_board_t *boards = controller_data - controller_data->board_id;
+  for (uint8_t i = 0; i < controller_data->num_boards; i++) {
+    pca9685_board_t *board = &boards[i];
+    if (board->state != k_pca9685_ready) {
+      continue;
+    }
+    xSemaphoreTake(board->mutex, portMAX_DELAY);
+    esp_err_t ret = priv_flush_board(board);
+    xSemaphoreGive(board->mutex);
+    if (ret != ESP_OK) {
+      result = ret; /* Keep going so other boards still get their update */
+    }
+  }
+  return result;
+}
+
+esp_err_t pca9685_set_calibration(pca9685_board_t           *controller_data, 
+                                  uint8_t                    board_id, 
+                                  uint8_t                    channel, 
+                                  const pca9685_servo_cal_t *calibration)
+{
+  if (controller_data == NULL || 
+      calibration == NULL || 
+      channel >= PCA9685_MOTORS_PER_BOARD || 
+      !priv_calibration_is_valid(calibration)) {
+    log_error(pca9685_tag, 
+              "Param Error", 
+              "Invalid calibration for channel %u on board %u", 
+              channel, 
+              board_id);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_board(controller_data, board_id);
+  if (board == NULL) {
+    log_error(pca9685_tag, "Board Error", "Board %u not found", board_id);
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  esp_err_t ret = priv_apply_calibration(board, channel, calibration);
+  xSemaphoreGive(board->mutex);
+  if (ret != ESP_OK) {
+    log_error(pca9685_tag, 
+              "Memory Error", 
+              "Failed to allocate lookup table for channel %u on board %u", 
+              channel, 
+              board_id);
+    return ret;
+  }
+
+  log_info(pca9685_tag, 
+           "Calibration", 
+           "Channel %u on board %u: pulse %u-%u, trim %d, %s", 
+           channel, 
+           board_id, 
+           calibration->min_pulse_ticks, 
+           calibration->max_pulse_ticks, 
+           calibration->trim_decideg, 
+           calibration->inverted ? "inverted" : "normal");
+  return ESP_OK;
+}
+
+esp_err_t pca9685_get_calibration(pca9685_board_t     *controller_data, 
+                                  uint8_t              board_id, 
+                                  uint8_t              channel, 
+                                  pca9685_servo_cal_t *calibration)
+{
+  if (controller_data == NULL || calibration == NULL || channel >= PCA9685_MOTORS_PER_BOARD) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_board(controller_data, board_id);
+  if (board == NULL) {
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  *calibration = board->calibration[channel];
+  xSemaphoreGive(board->mutex);
+  return ESP_OK;
+}
+
+esp_err_t pca9685_save_calibration(pca9685_board_t *controller_data, 
+                                   uint8_t          board_id)
+{
+  if (controller_data == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pca9685_board_t *board = priv_find_board(controller_data, board_id);
+  if (board == NULL) {
+    log_error(pca9685_tag, "Board Error", "Board %u not found", board_id);
+    return ESP_FAIL;
+  }
+
+  nvs_handle_t handle;
+  char         key[8];
+  priv_calibration_key(board_id, key);
+
+  pca9685_cal_blob_t blob = {
+    .version = PCA9685_CAL_VERSION,
+    .size    = sizeof(blob.calibration),
+  };
+  xSemaphoreTake(board->mutex, portMAX_DELAY);
+  memcpy(blob.calibration, board->calibration, sizeof(blob.calibration));
+  xSemaphoreGive(board->mutex);
+
+  esp_err_t ret = nvs_open(pca9685_nvs_namespace, NVS_READWRITE, &handle);
+  if (ret == ESP_OK) {
+    ret = nvs_set_blob(handle, key, &blob, sizeof(blob));
+    if (ret == ESP_OK) {
+      ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+
+  if (ret != ESP_OK) {
+    log_error(pca9685_tag, 
+              "NVS Error", 
+              "Failed to save calibration for board %u: %s", 
+              board_id, 
+              esp_err_to_name(ret));
+    return ret;
+  }
+
+  log_info(pca9685_tag, "Calibration", "Saved calibration for board %u", board_id);
+  return ESP_OK;
+}
+
+void pca9685_get_bus_stats(pca9685_bus_stats_t *stats, bool reset)
+{
+  if (stats == NULL) {
+    return;
+  }
+  *stats = s_bus_stats;
+  if (reset) {
+    s_bus_stats = (pca9685_bus_stats_t){0};
+  }
+}
@@ -0,0 +1,141 @@
+/* components/sensors/ahrs.c */
+
+#include "ahrs.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "sensor_bus.h"
+#include "log_handler.h"
+
+/* Constants ******************************************************************/
+
+const char *ahrs_tag = "AHRS";
+
+/* Globals (Static) ***********************************************************/
+
+static ahrs_filter_t s_ahrs_filter; /* Only touched by the MPU6050 task */
+
+/* Latest magnetometer reading, from the QMC5883L task to the MPU6050 task */
+static portMUX_TYPE s_ahrs_mag_lock    = portMUX_INITIALIZER_UNLOCKED;
+static float        s_ahrs_mag[3]      = { 0.0f, 0.0f, 0.0f };
+static int64_t      s_ahrs_mag_time_us = 0;
+static bool         s_ahrs_mag_valid   = false;
+static uint32_t     s_ahrs_mag_samples = 0;
+
+/* Latest estimate, published once per batch. The counters share its slot */
+static sensor_seqlock_t   s_ahrs_seqlock      = SENSOR_SEQLOCK_INITIALIZER;
+static ahrs_orientation_t s_ahrs_orientation  = { 0 };
+static ahrs_stats_t       s_ahrs_stats        = { 0 };
+static _Atomic uint32_t   s_ahrs_read_retries = 0;
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Publishes the filter's estimate and counters
+ */
+static void priv_ahrs_publish(void)
+{
+  ahrs_orientation_t orientation;
+  ahrs_filter_get_orientation(&s_ahrs_filter, &orientation);
+
+  sensor_seqlock_write_begin(&s_ahrs_seqlock);
+  s_ahrs_orientation          = orientation;
+  s_ahrs_stats.updates        = s_ahrs_filter.updates;
+  s_ahrs_stats.mag_fused      = s_ahrs_filter.mag_fused;
+  s_ahrs_stats.accel_rejected = s_ahrs_filter.accel_rejected;
+  s_ahrs_stats.gaps           = s_ahrs_filter.gaps;
+  sensor_seqlock_write_end(&s_ahrs_seqlock);
+}
+
+/**
+ * @brief MPU6050 batch callback, fuses every sample and publishes once
+ */
+static void priv_ahrs_on_batch(const mpu6050_batch_t *batch, void *context)
+{
+  (void)context;
+
+  float   mag[3];
+  int64_t mag_time_us;
+  bool    mag_valid;
+  portENTER_CRITICAL(&s_ahrs_mag_lock);
+  memcpy(mag, s_ahrs_mag, sizeof(mag));
+  mag_time_us = s_ahrs_mag_time_us;
+  mag_valid   = s_ahrs_mag_valid;
+  portEXIT_CRITICAL(&s_ahrs_mag_lock);
+
+  for (uint16_t i = 0; i < batch->count; i++) {
+    const mpu6050_sample_t *sample  = &batch->samples[i];
+    float                   gyro[]  = { sample->gyro_x, sample->gyro_y, sample->gyro_z };
+    float                   accel[] = { sample->accel_x, sample->accel_y, sample->accel_z };
+    ahrs_filter_update(&s_ahrs_filter,
+                       sample->timestamp_us,
+                       gyro,
+                       accel,
+                       mag_valid ? mag : NULL,
+                       mag_time_us);
+  }
+
+  if (s_ahrs_filter.aligned) {
+    priv_ahrs_publish();
+  }
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t ahrs_init(mpu6050_data_t *imu)
+{
+  if (imu == NULL) {
+    log_error(ahrs_tag, "Invalid Parameter", "MPU6050 data pointer is NULL");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  ahrs_filter_init(&s_ahrs_filter, &ahrs_filter_default_config);
+  mpu6050_register_batch_callback(imu, priv_ahrs_on_batch, NULL);
+  log_info(ahrs_tag,
+           "Init Complete",
+           "Fusing MPU6050 and magnetometer samples, kp %.2f, ki %.2f",
+           ahrs_filter_default_config.kp,
+           ahrs_filter_default_config.ki);
+  return ESP_OK;
+}
+
+void ahrs_update_mag(int64_t timestamp_us, float mag_x, float mag_y, float mag_z)
+{
+  portENTER_CRITICAL(&s_ahrs_mag_lock);
+  s_ahrs_mag[0]      = mag_x;
+  s_ahrs_mag[1]      = mag_y;
+  s_ahrs_mag[2]      = mag_z;
+  s_ahrs_mag_time_us = timestamp_us;
+  s_ahrs_mag_valid   = true;
+  s_ahrs_mag_samples++;
+  portEXIT_CRITICAL(&s_ahrs_mag_lock);
+}
+
+esp_err_t ahrs_get_orientation(ahrs_orientation_t *orientation)
+{
+  if (orientation == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  if (!sensor_seqlock_read(&s_ahrs_seqlock,
+                           &s_ahrs_orientation,
+                           orientation,
+                           sizeof(*orientation),
+                           &s_ahrs_read_retries)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return ESP_OK;
+}
+
+void ahrs_get_stats(ahrs_stats_t *stats)
+{
+  if (!sensor_seqlock_read(&s_ahrs_seqlock, &s_ahrs_stats, stats, sizeof(*stats), NULL)) {
+    memset(stats, 0, sizeof(*stats));
+  }
+
+  portENTER_CRITICAL(&s_ahrs_mag_lock);
+  stats->mag_samples = s_ahrs_mag_samples;
+  portEXIT_CRITICAL(&s_ahrs_mag_lock);
+  stats->read_retries = atomic_load_explicit(&s_ahrs_read_retries, memory_order_relaxed);
+}
@@ -0,0 +1,224 @@
+/* components/sensors/ahrs_filter.c */
+
+#include "ahrs_filter.h"
+#include <math.h>
+#include <string.h>
+
+/* Constants ******************************************************************/
+
+static const float k_deg_to_rad = 0.017453292519943f;
+static const float k_rad_to_deg = 57.29577951308232f;
+
+const ahrs_filter_config_t ahrs_filter_default_config = {
+  .kp             = 1.0f,
+  .ki             = 0.2f,
+  .accel_reject_g = 0.15f,
+  .bias_limit_dps = 5.0f,
+  .max_gap_us     = 100 * 1000,
+  .mag_max_age_us = 100 * 1000,
+};
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Direction of earth z (up) in the body frame, the third row of the rotation
+ */
+static void priv_up_in_body(const float *q, float *up)
+{
+  up[0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+  up[1] = 2.0f * (q[2] * q[3] + q[0] * q[1]);
+  up[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+/**
+ * @brief Normalizes a vector in place, returns its former length
+ */
+static float priv_normalize3(float *v)
+{
+  float norm = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (norm > 0.0f) {
+    v[0] /= norm;
+    v[1] /= norm;
+    v[2] /= norm;
+  }
+  return norm;
+}
+
+/**
+ * @brief Sets the orientation from the references alone
+ *
+ * Roll and pitch come from gravity, the heading from the magnetometer
+ * de-rotated into the horizontal plane, or 0 without one.
+ *
+ * @param accel Unit gravity direction in the body frame
+ * @param mag   Magnetic field in the body frame, NULL if unknown
+ */
+static void priv_align(ahrs_filter_t *filter, const float *accel, const float *mag)
+{
+  float roll  = atan2f(accel[1], accel[2]);
+  float pitch = atan2f(-accel[0], sqrtf(accel[1] * accel[1] + accel[2] * accel[2]));
+  float yaw   = 0.0f;
+  if (mag != NULL) {
+    float sr = sinf(roll), cr = cosf(roll);
+    float sp = sinf(pitch), cp = cosf(pitch);
+    float hx = mag[0] * cp + (mag[1] * sr + mag[2] * cr) * sp;
+    float hy = mag[1] * cr - mag[2] * sr;
+    yaw      = -atan2f(hy, hx);
+  }
+
+  float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+  float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+  float cy = cosf(yaw * 0.5f), sy = sinf(yaw * 0.5f);
+  filter->q[0]        = cr * cp * cy + sr * sp * sy;
+  filter->q[1]        = sr * cp * cy - cr * sp * sy;
+  filter->q[2]        = cr * sp * cy + sr * cp * sy;
+  filter->q[3]        = cr * cp * sy - sr * sp * cy;
+  filter->aligned     = true;
+  filter->heading_set = mag != NULL;
+}
+
+/* Public Functions ***********************************************************/
+
+void ahrs_filter_init(ahrs_filter_t *filter, const ahrs_filter_config_t *config)
+{
+  memset(filter, 0, sizeof(*filter));
+  filter->config = *config;
+  filter->q[0]   = 1.0f;
+}
+
+void ahrs_filter_update(ahrs_filter_t *filter,
+                        int64_t        timestamp_us,
+                        const float   *gyro,
+                        const float   *accel,
+                        const float   *mag,
+                        int64_t        mag_timestamp_us)
+{
+  int64_t step_us = timestamp_us - filter->last_us;
+  bool    timed   = filter->aligned && step_us > 0 && step_us <= filter->config.max_gap_us;
+  if (filter->aligned && !timed) {
+    filter->gaps++;
+  }
+  filter->last_us = timestamp_us;
+  if (mag != NULL && timestamp_us - mag_timestamp_us > filter->config.mag_max_age_us) {
+    mag = NULL;
+  }
+
+  float a[3] = { accel[0], accel[1], accel[2] };
+  float m[3] = { 0.0f, 0.0f, 0.0f };
+  bool  accel_ok = fabsf(priv_normalize3(a) - 1.0f) <= filter->config.accel_reject_g;
+  bool  mag_ok   = false;
+  if (mag != NULL) {
+    m[0]   = mag[0];
+    m[1]   = mag[1];
+    m[2]   = mag[2];
+    mag_ok = priv_normalize3(m) > 0.0f;
+  }
+
+  /* Start from the references, and take the heading from the first magnetometer reading */
+  if (!filter->aligned || (mag_ok && !filter->heading_set)) {
+    if (!accel_ok) {
+      filter->accel_rejected++;
+      return;
+    }
+    priv_align(filter, a, mag_ok ? m : NULL);
+    filter->updates++;
+    return;
+  }
+  if (!timed) {
+    return;
+  }
+  float dt_s = step_us * 1e-6f;
+
+  float *q = filter->q;
+  float  v[3];
+  float  e[3] = { 0.0f, 0.0f, 0.0f };
+  priv_up_in_body(q, v);
+
+  if (accel_ok) {
+    e[0] = a[1] * v[2] - a[2] * v[1];
+    e[1] = a[2] * v[0] - a[0] * v[2];
+    e[2] = a[0] * v[1] - a[1] * v[0];
+  } else {
+    filter->accel_rejected++;
+  }
+
+  if (mag_ok) {
+    /* Field in the earth frame, its reference keeps the measured dip but points north */
+    float q0q1 = q[0] * q[1], q0q2 = q[0] * q[2], q0q3 = q[0] * q[3];
+    float q1q1 = q[1] * q[1], q1q2 = q[1] * q[2], q1q3 = q[1] * q[3];
+    float q2q2 = q[2] * q[2], q2q3 = q[2] * q[3], q3q3 = q[3] * q[3];
+    float hx = 2.0f * (m[0] * (0.5f - q2q2 - q3q3) + m[1] * (q1q2 - q0q3) + m[2] * (q1q3 + q0q2));
+    float hy = 2.0f * (m[0] * (q1q2 + q0q3) + m[1] * (0.5f - q1q1 - q3q3) + m[2] * (q2q3 - q0q1));
+    float bz = 2.0f * (m[0] * (q1q3 - q0q2) + m[1] * (q2q3 + q0q1) + m[2] * (0.5f - q1q1 - q2q2));
+    float bx = sqrtf(hx * hx + hy * hy);
+    float w[3] = {
+      2.0f * (bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2)),
+      2.0f * (bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3)),
+      2.0f * (bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2)),
+    };
+
+    /* Only the part about the vertical is kept, so magnetic disturbances can't tilt the estimate */
+    float em[3] = {
+      m[1] * w[2] - m[2] * w[1],
+      m[2] * w[0] - m[0] * w[2],
+      m[0] * w[1] - m[1] * w[0],
+    };
+    float along = em[0] * v[0] + em[1] * v[1] + em[2] * v[2];
+    e[0] += along * v[0];
+    e[1] += along * v[1];
+    e[2] += along * v[2];
+    filter->mag_fused++;
+  }
+
+  float g[3] = { gyro[0] * k_deg_to_rad, gyro[1] * k_deg_to_rad, gyro[2] * k_deg_to_rad };
+  if (accel_ok || mag_ok) {
+    float limit = filter->config.bias_limit_dps * k_deg_to_rad;
+    for (int i = 0; i < 3; i++) {
+      float integral = filter->integral[i] + filter->config.ki * e[i] * dt_s;
+      filter->integral[i] = fminf(fmaxf(integral, -limit), limit);
+      g[i] += filter->config.kp * e[i];
+    }
+  }
+  g[0] += filter->integral[0];
+  g[1] += filter->integral[1];
+  g[2] += filter->integral[2];
+
+  /* q' = q + dt/2 * q ⊗ (0, g) */
+  float h  = 0.5f * dt_s;
+  float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  q[0] += h * (-q1 * g[0] - q2 * g[1] - q3 * g[2]);
+  q[1] += h * (q0 * g[0] + q2 * g[2] - q3 * g[1]);
+  q[2] += h * (q0 * g[1] - q1 * g[2] + q3 * g[0]);
+  q[3] += h * (q0 * g[2] + q1 * g[1] - q2 * g[0]);
+  float norm = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  q[0] /= norm;
+  q[1] /= norm;
+  q[2] /= norm;
+  q[3] /= norm;
+  filter->updates++;
+}
+
+void ahrs_filter_get_orientation(const ahrs_filter_t *filter, ahrs_orientation_t *orientation)
+{
+  const float *q = filter->q;
+  float sin_pitch = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+  float yaw       = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3]));
+  float heading   = 0.0f - yaw * k_rad_to_deg; /* Not -0 when level */
+  if (heading < 0.0f) {
+    heading += 360.0f;
+  }
+  if (heading >= 360.0f) {
+    heading = 0.0f; /* -0.0001 + 360 rounds to 360 */
+  }
+
+  orientation->timestamp_us = filter->last_us;
+  memcpy(orientation->q, q, sizeof(orientation->q));
+  orientation->roll         = atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]),
+                                     1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) * k_rad_to_deg;
+  orientation->pitch        = asinf(fminf(fmaxf(sin_pitch, -1.0f), 1.0f)) * k_rad_to_deg;
+  orientation->heading      = heading;
+  orientation->gyro_bias[0] = -filter->integral[0] * k_rad_to_deg;
+  orientation->gyro_bias[1] = -filter->integral[1] * k_rad_to_deg;
+  orientation->gyro_bias[2] = -filter->integral[2] * k_rad_to_deg;
+  orientation->magnetic     = filter->heading_set;
+}
@@ -1,9 +1,12 @@
 /* components/sensors/bh1750_hal/bh1750_hal.c */
 
 #include "bh1750_hal.h"
-#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "common/i2c.h"
 #include "error_handler.h"
 #include "log_handler.h"
@@ -24,6 +27,14 @@ const uint8_t    bh1750_measurement_bytes      = 2;
 const float      bh1750_raw_to_lux_factor      = 1.2f;
 const uint8_t    bh1750_high_byte_shift        = 8;
 
+/* Globals (Static) ***********************************************************/
+
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_bh1750_json_fields[] = {
+  JSON_FIELD_FLOAT(bh1750_data_t, lux, "lux", 2),
+};
+static const json_schema_t s_bh1750_json_schema   = JSON_SCHEMA("light", s_bh1750_json_fields);
+
 /* Static Functions **********************************************************/
 
 /**
@@ -84,43 +95,14 @@ static esp_err_t priv_bh1750_reset(void *context)
 
 /* Public Functions ***********************************************************/
 
-char *bh1750_data_to_json(const bh1750_data_t *data)
+esp_err_t bh1750_data_to_json_buf(const bh1750_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(bh1750_tag, 
-              "JSON Error", 
-              "Failed to allocate memory for JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "light")) {
-    log_error(bh1750_tag, 
-              "JSON Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "lux", data->lux)) {
-    log_error(bh1750_tag, 
-              "JSON Error", 
-              "Failed to add lux field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(bh1750_tag, 
-              "JSON Error", 
-              "Failed to serialize JSON object to string");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_bh1750_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *bh1750_data_to_json(const bh1750_data_t *data)
+{
+  return sensor_json_to_string(&s_bh1750_json_schema, data);
 }
 
 esp_err_t bh1750_init(void *sensor_data)
@@ -186,10 +168,10 @@ esp_err_t bh1750_read(bh1750_data_t *sensor_data)
   /* Combine high byte and low byte to form 16-bit measurement value */
   uint16_t raw_light_intensity = (data[0] << bh1750_high_byte_shift) | data[1];
   sensor_data->lux             = raw_light_intensity / bh1750_raw_to_lux_factor;
-  log_info(bh1750_tag, 
-           "Data Update", 
-           "New reading - Light intensity: %.2f lux", 
-           sensor_data->lux);
+  log_debug(bh1750_tag, 
+            "Data Update", 
+            "New reading - Light intensity: %.2f lux", 
+            sensor_data->lux);
 
   sensor_data->state = k_bh1750_data_updated;
   return ESP_OK;
@@ -207,11 +189,14 @@ void bh1750_tasks(void *sensor_data)
   while (1) {
     esp_err_t ret = bh1750_read(bh1750_data);
     if (ret == ESP_OK) {
-      char *json = bh1750_data_to_json(bh1750_data);
-      if (json) {
+      float values[] = { bh1750_data->lux };
+      int64_t now_us = esp_timer_get_time();
+      sensor_log_write(k_sensor_record_bh1750, now_us, values);
+      sensor_history_insert(k_sensor_record_bh1750, now_us, values);
+      sensor_bus_publish(k_sensor_record_bh1750, now_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (bh1750_data_to_json_buf(bh1750_data, json, sizeof(json), NULL) == ESP_OK) {
         send_sensor_data_to_webserver(json);
-        file_write_enqueue("bh1750.txt", json);
-        free(json);
       } else {
         log_error(bh1750_tag, 
                   "JSON Error", 
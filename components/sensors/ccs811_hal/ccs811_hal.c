@@ -1,9 +1,12 @@
 /* components/sensors/ccs811_hal/ccs811_hal.c */
 
 #include "ccs811_hal.h"
-#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "common/i2c.h"
 #include "error_handler.h"
 #include "log_handler.h"
@@ -24,6 +27,15 @@ const uint8_t    ccs811_max_retries            = 4;
 const uint32_t   ccs811_initial_retry_interval = pdMS_TO_TICKS(15 * 1000);
 const uint32_t   ccs811_max_backoff_interval   = pdMS_TO_TICKS(8 * 60 * 1000);
 
+/* Globals (Static) ***********************************************************/
+
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_ccs811_json_fields[] = {
+  JSON_FIELD_UINT16(ccs811_data_t, eco2, "eCO2"),
+  JSON_FIELD_UINT16(ccs811_data_t, tvoc, "TVOC"),
+};
+static const json_schema_t s_ccs811_json_schema   = JSON_SCHEMA("air_quality", s_ccs811_json_fields);
+
 /* Static Functions **********************************************************/
 
 /**
@@ -69,51 +81,14 @@ static esp_err_t priv_ccs811_reset(void *context)
 
 /* Public Functions ***********************************************************/
 
-char *ccs811_data_to_json(const ccs811_data_t *data)
+esp_err_t ccs811_data_to_json_buf(const ccs811_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(ccs811_tag, 
-              "JSON Error", 
-              "Failed to allocate memory for JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "air_quality")) {
-    log_error(ccs811_tag, 
-              "JSON Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "eCO2", data->eco2)) {
-    log_error(ccs811_tag, 
-              "JSON Error", 
-              "Failed to add eCO2 field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "TVOC", data->tvoc)) {
-    log_error(ccs811_tag, 
-              "JSON Error", 
-              "Failed to add TVOC field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(ccs811_tag, 
-              "JSON Error", 
-              "Failed to serialize JSON object to string");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_ccs811_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *ccs811_data_to_json(const ccs811_data_t *data)
+{
+  return sensor_json_to_string(&s_ccs811_json_schema, data);
 }
 
 esp_err_t ccs811_init(void *sensor_data)
@@ -178,9 +153,9 @@ esp_err_t ccs811_read(ccs811_data_t *sensor_data)
 
   sensor_data->eco2 = (data[0] << 8) | data[1];
   sensor_data->tvoc = (data[2] << 8) | data[3];
-  log_info(ccs811_tag, "Data Update", 
-           "New readings - eCO2: %u ppm, TVOC: %u ppb", 
-           sensor_data->eco2, sensor_data->tvoc);
+  log_debug(ccs811_tag, "Data Update", 
+            "New readings - eCO2: %u ppm, TVOC: %u ppb", 
+            sensor_data->eco2, sensor_data->tvoc);
 
   sensor_data->state = k_ccs811_data_updated;
   return ESP_OK;
@@ -198,11 +173,14 @@ void ccs811_tasks(void *sensor_data)
   while (1) {
     esp_err_t ret = ccs811_read(ccs811_data);
     if (ret == ESP_OK) {
-      char *json = ccs811_data_to_json(ccs811_data);
-      if (json) {
+      float values[] = { ccs811_data->eco2, ccs811_data->tvoc };
+      int64_t now_us = esp_timer_get_time();
+      sensor_log_write(k_sensor_record_ccs811, now_us, values);
+      sensor_history_insert(k_sensor_record_ccs811, now_us, values);
+      sensor_bus_publish(k_sensor_record_ccs811, now_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (ccs811_data_to_json_buf(ccs811_data, json, sizeof(json), NULL) == ESP_OK) {
         send_sensor_data_to_webserver(json);
-        file_write_enqueue("ccs811.txt", json);
-        free(json);
       } else {
         log_error(ccs811_tag, "JSON Error", "Failed to convert sensor data to JSON format");
       }
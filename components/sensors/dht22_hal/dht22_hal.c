@@ -3,9 +3,11 @@
 #include "dht22_hal.h"
 #include <stdio.h>
 #include <string.h>
-#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "driver/gpio.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -31,6 +33,14 @@ const uint8_t  dht22_allowed_fail_attempts  = 3;
 
 static error_handler_t s_dht22_error_handler = { 0 };
 
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_dht22_json_fields[] = {
+  JSON_FIELD_FLOAT(dht22_data_t, temperature_c, "temperature_c", 2),
+  JSON_FIELD_FLOAT(dht22_data_t, temperature_f, "temperature_f", 2),
+  JSON_FIELD_FLOAT(dht22_data_t, humidity,      "humidity", 2),
+};
+static const json_schema_t s_dht22_json_schema   = JSON_SCHEMA("temperature_humidity", s_dht22_json_fields);
+
 /* Static (Private) Functions **************************************************/
 
 /**
@@ -253,59 +263,14 @@ static esp_err_t priv_dht22_verify_checksum(uint8_t *data_buffer)
 
 /* Public Functions ************************************************************/
 
-char *dht22_data_to_json(const dht22_data_t *data)
+esp_err_t dht22_data_to_json_buf(const dht22_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(dht22_tag, 
-              "JSON Creation Failed", 
-              "Unable to allocate memory for JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "temperature_humidity")) {
-    log_error(dht22_tag, 
-              "JSON Field Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "temperature_c", data->temperature_c)) {
-    log_error(dht22_tag, 
-              "JSON Field Error", 
-              "Failed to add temperature_c field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "temperature_f", data->temperature_f)) {
-    log_error(dht22_tag, 
-              "JSON Field Error", 
-              "Failed to add temperature_f field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "humidity", data->humidity)) {
-    log_error(dht22_tag, 
-              "JSON Field Error", 
-              "Failed to add humidity field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(dht22_tag, 
-              "JSON Serialization Failed", 
-              "Unable to convert JSON object to string format");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_dht22_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *dht22_data_to_json(const dht22_data_t *data)
+{
+  return sensor_json_to_string(&s_dht22_json_schema, data);
 }
 
 esp_err_t dht22_init(void *sensor_data)
@@ -405,11 +370,11 @@ esp_err_t dht22_read(dht22_data_t *sensor_data)
 
   sensor_data->state = k_dht22_data_updated;
 
-  log_info(dht22_tag, 
-           "Read Success", 
-           "Temperature: %.1f°C, Humidity: %.1f%%", 
-           sensor_data->temperature_c, 
-           sensor_data->humidity);
+  log_debug(dht22_tag, 
+            "Read Success", 
+            "Temperature: %.1f°C, Humidity: %.1f%%", 
+            sensor_data->temperature_c, 
+            sensor_data->humidity);
   return ESP_OK;
 }
 
@@ -425,10 +390,17 @@ void dht22_tasks(void *sensor_data)
   dht22_data_t *dht22_data = (dht22_data_t *)sensor_data;
   while (1) {
     if (dht22_read(dht22_data) == ESP_OK) {
-      char *json = dht22_data_to_json(dht22_data);
-      send_sensor_data_to_webserver(json);
-      file_write_enqueue("dht22.txt", json);
-      free(json);
+      float values[] = { dht22_data->temperature_c, dht22_data->humidity };
+      int64_t now_us = esp_timer_get_time();
+      sensor_log_write(k_sensor_record_dht22, now_us, values);
+      sensor_history_insert(k_sensor_record_dht22, now_us, values);
+      sensor_bus_publish(k_sensor_record_dht22, now_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (dht22_data_to_json_buf(dht22_data, json, sizeof(json), NULL) == ESP_OK) {
+        send_sensor_data_to_webserver(json);
+      } else {
+        log_error(dht22_tag, "JSON Error", "Failed to convert sensor data to JSON format");
+      }
     } else {
       dht22_reset_on_error(dht22_data);
     }
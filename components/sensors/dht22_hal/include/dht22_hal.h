@@ -78,6 +78,23 @@ typedef struct {
  */
 char *dht22_data_to_json(const dht22_data_t *data);
 
+/**
+ * @brief Writes DHT22 data as its JSON payload into a caller-provided buffer.
+ *
+ * Allocation-free counterpart of `dht22_data_to_json`, used by the sensor task.
+ *
+ * @param[in]  data   Pointer to the `dht22_data_t` structure with valid sensor data.
+ * @param[out] buffer Output, NUL-terminated.
+ * @param[in]  size   Bytes of `buffer`, `SENSOR_JSON_PAYLOAD_SIZE` always fits.
+ * @param[out] length Characters written without the NUL, may be NULL.
+ *
+ * @return
+ * - ESP_OK               on success.
+ * - ESP_ERR_INVALID_ARG  if an argument is NULL.
+ * - ESP_ERR_INVALID_SIZE if the payload does not fit `size`.
+ */
+esp_err_t dht22_data_to_json_buf(const dht22_data_t *data, char *buffer, size_t size, size_t *length);
+
 /**
  * @brief Initializes the DHT22 sensor for temperature and humidity measurements.
  *
@@ -4,9 +4,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include "esp_err.h"
-#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "common/uart.h"
 #include "driver/gpio.h"
 #include "error_handler.h"
@@ -40,6 +43,20 @@ static uint32_t        s_gy_neo6mv2_sentence_index  = 0;
 static uint8_t         s_gy_neo6mv2_satellite_count = 0;                              /**< Counter for the number of satellites currently stored in the buffer. */
 static error_handler_t s_gy_neo6mv2_error_handler   = { 0 };
 
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_gy_neo6mv2_json_fields[] = {
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  latitude,        "latitude", 7),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  longitude,       "longitude", 7),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  speed,           "speed", 2),
+  JSON_FIELD_STRING(gy_neo6mv2_data_t, time,            "time"),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  fix_status,      "fix_status"),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  satellite_count, "satellite_count"),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  hdop,            "hdop", 2),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  retry_count,     "retry_count"),
+  JSON_FIELD_UINT32(gy_neo6mv2_data_t, retry_interval,  "retry_interval"),
+};
+static const json_schema_t s_gy_neo6mv2_json_schema   = JSON_SCHEMA("gps", s_gy_neo6mv2_json_fields);
+
 /* Static (Private) Functions *************************************************/
 
 /**
@@ -154,13 +171,13 @@ static void priv_gy_neo6mv2_add_satellite(uint8_t  prn,
     sat->snr         = snr;
     s_gy_neo6mv2_satellite_count++;
 
-    log_info(gy_neo6mv2_tag, 
-             "Satellite Added", 
-             "PRN=%u, Elevation=%u°, Azimuth=%u°, SNR=%u",
-             prn, 
-             elevation, 
-             azimuth, 
-             snr);
+    log_verbose(gy_neo6mv2_tag, 
+                "Satellite Added", 
+                "PRN=%u, Elevation=%u°, Azimuth=%u°, SNR=%u",
+                prn, 
+                elevation, 
+                azimuth, 
+                snr);
   } else {
     log_warn(gy_neo6mv2_tag, 
              "Buffer Full", 
@@ -200,116 +217,23 @@ static uint8_t priv_gy_neo6mv2_get_satellites(satellite_t *satellites,
                    s_gy_neo6mv2_satellite_count : max_count;
 
   memcpy(satellites, s_gy_neo6mv2_satellites, count * sizeof(satellite_t));
-  log_info(gy_neo6mv2_tag, 
-           "Data Retrieved", 
-           "Copied %u satellites from buffer", 
-           count);
+  log_verbose(gy_neo6mv2_tag, 
+              "Data Retrieved", 
+              "Copied %u satellites from buffer", 
+              count);
   return count;
 }
 
 /* Public Functions ***********************************************************/
 
-char *gy_neo6mv2_data_to_json(const gy_neo6mv2_data_t *gy_neo6mv2_data)
+esp_err_t gy_neo6mv2_data_to_json_buf(const gy_neo6mv2_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Creation Failed", 
-              "Unable to allocate memory for JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "gps")) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "latitude", gy_neo6mv2_data->latitude)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add latitude field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "longitude", gy_neo6mv2_data->longitude)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add longitude field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "speed", gy_neo6mv2_data->speed)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add speed field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "time", gy_neo6mv2_data->time)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add time field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "fix_status", gy_neo6mv2_data->fix_status)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add fix_status field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "satellite_count", gy_neo6mv2_data->satellite_count)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add satellite_count field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "hdop", gy_neo6mv2_data->hdop)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add hdop field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "retry_count", gy_neo6mv2_data->retry_count)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add retry_count field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "retry_interval", gy_neo6mv2_data->retry_interval)) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Field Error", 
-              "Failed to add retry_interval field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(gy_neo6mv2_tag, 
-              "JSON Serialization Failed", 
-              "Unable to convert JSON object to string format");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_gy_neo6mv2_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *gy_neo6mv2_data_to_json(const gy_neo6mv2_data_t *data)
+{
+  return sensor_json_to_string(&s_gy_neo6mv2_json_schema, data);
 }
 
 esp_err_t gy_neo6mv2_init(void *sensor_data)
@@ -437,11 +361,11 @@ esp_err_t gy_neo6mv2_read(gy_neo6mv2_data_t *sensor_data)
           /* Extract and log status */
           if (fields[2]) {
             const char *status = fields[2];
-            log_info(gy_neo6mv2_tag, 
-                     "GPS Status", 
-                     "Fix status: %s (%s)", 
-                     status, 
-                     (status[0] == 'A') ? "Fix acquired" : "No fix");
+            log_debug(gy_neo6mv2_tag, 
+                      "GPS Status", 
+                      "Fix status: %s (%s)", 
+                      status, 
+                      (status[0] == 'A') ? "Fix acquired" : "No fix");
 
             /* Process only valid readings */
             if (status[0] == 'A') {
@@ -454,12 +378,12 @@ esp_err_t gy_neo6mv2_read(gy_neo6mv2_data_t *sensor_data)
               sensor_data->fix_status = 1; /* Fix acquired */
               strncpy(sensor_data->time, fields[1], sizeof(sensor_data->time) - 1);
 
-              log_info(gy_neo6mv2_tag, 
-                       "Position Updated", 
-                       "Lat: %.6f°, Lon: %.6f°, Speed: %.2f m/s",
-                       sensor_data->latitude, 
-                       sensor_data->longitude, 
-                       sensor_data->speed);
+              log_debug(gy_neo6mv2_tag, 
+                        "Position Updated", 
+                        "Lat: %.6f°, Lon: %.6f°, Speed: %.2f m/s",
+                        sensor_data->latitude, 
+                        sensor_data->longitude, 
+                        sensor_data->speed);
             } else {
               sensor_data->fix_status = 0; /* No fix */
               log_warn(gy_neo6mv2_tag, 
@@ -478,12 +402,12 @@ esp_err_t gy_neo6mv2_read(gy_neo6mv2_data_t *sensor_data)
           uint8_t sentence_number  = fields[2] ? (uint8_t)atoi(fields[2]) : 0;
           uint8_t total_satellites = fields[3] ? (uint8_t)atoi(fields[3]) : 0;
 
-          log_info(gy_neo6mv2_tag, 
-                   "Satellite Info", 
-                   "Sentence %u of %u, Total satellites in view: %u", 
-                   sentence_number, 
-                   total_sentences, 
-                   total_satellites);
+          log_debug(gy_neo6mv2_tag, 
+                    "Satellite Info", 
+                    "Sentence %u of %u, Total satellites in view: %u", 
+                    sentence_number, 
+                    total_sentences, 
+                    total_satellites);
 
           /* Clear satellite data if this is the first sentence */
           if (sentence_number == 1) {
@@ -519,13 +443,13 @@ esp_err_t gy_neo6mv2_read(gy_neo6mv2_data_t *sensor_data)
 
     /* Process satellite data as needed */
     for (uint8_t i = 0; i < satellite_count; i++) {
-      log_info(gy_neo6mv2_tag, 
-               "Satellite Details", 
-               "Retrieved satellite PRN=%u, Elevation=%u°, Azimuth=%u°, SNR=%u",
-               local_satellites[i].prn, 
-               local_satellites[i].elevation,
-               local_satellites[i].azimuth, 
-               local_satellites[i].snr);
+      log_verbose(gy_neo6mv2_tag, 
+                  "Satellite Details", 
+                  "Retrieved satellite PRN=%u, Elevation=%u°, Azimuth=%u°, SNR=%u",
+                  local_satellites[i].prn, 
+                  local_satellites[i].elevation,
+                  local_satellites[i].azimuth, 
+                  local_satellites[i].snr);
     }
 
     return ESP_OK;
@@ -550,10 +474,24 @@ void gy_neo6mv2_tasks(void *sensor_data)
   gy_neo6mv2_data_t *gy_neo6mv2_data = (gy_neo6mv2_data_t *)sensor_data;
   while (1) {
     if (gy_neo6mv2_read(gy_neo6mv2_data) == ESP_OK) {
-      char *json = gy_neo6mv2_data_to_json(gy_neo6mv2_data);
-      send_sensor_data_to_webserver(json);
-      file_write_enqueue("gy_neo6mv2.txt", json);
-      free(json);
+      float values[] = {
+        gy_neo6mv2_data->latitude,
+        gy_neo6mv2_data->longitude,
+        gy_neo6mv2_data->speed,
+        gy_neo6mv2_data->hdop,
+        gy_neo6mv2_data->fix_status,
+        gy_neo6mv2_data->satellite_count,
+      };
+      int64_t now_us = esp_timer_get_time();
+      sensor_log_write(k_sensor_record_gy_neo6mv2, now_us, values);
+      sensor_history_insert(k_sensor_record_gy_neo6mv2, now_us, values);
+      sensor_bus_publish(k_sensor_record_gy_neo6mv2, now_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (gy_neo6mv2_data_to_json_buf(gy_neo6mv2_data, json, sizeof(json), NULL) == ESP_OK) {
+        send_sensor_data_to_webserver(json);
+      } else {
+        log_error(gy_neo6mv2_tag, "JSON Error", "Failed to convert sensor data to JSON format");
+      }
     } else {
       gy_neo6mv2_reset_on_error(gy_neo6mv2_data);
     }
@@ -0,0 +1,90 @@
+/* components/sensors/include/ahrs.h */
+
+#ifndef TOPOROBO_AHRS_H
+#define TOPOROBO_AHRS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ahrs_filter.h"
+#include "mpu6050_hal.h"
+
+/* Constants ******************************************************************/
+
+extern const char *ahrs_tag; /**< Logging tag for log_handler messages related to the orientation estimate. */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Counters of the orientation estimate, kept since `ahrs_init`.
+ */
+typedef struct {
+  uint32_t updates;        /**< MPU6050 samples fused. */
+  uint32_t mag_fused;      /**< Updates that also corrected the heading with the magnetometer. */
+  uint32_t accel_rejected; /**< Updates that left the accelerometer out, e.g. during a fall or an impact. */
+  uint32_t gaps;           /**< Steps not integrated, mostly samples lost to FIFO overflows. */
+  uint32_t mag_samples;    /**< Readings handed over with `ahrs_update_mag`. */
+  uint32_t read_retries;   /**< Reads of the orientation that overlapped a publish and copied again. */
+} ahrs_stats_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Starts estimating the robot's orientation.
+ *
+ * Registers as the MPU6050 batch callback, so every IMU sample is fused in
+ * the MPU6050 task at the sensor's rate, with the newest magnetometer
+ * reading from `ahrs_update_mag`. The estimate is published after every
+ * batch. The filter state is static; nothing is allocated.
+ *
+ * @param[in,out] imu MPU6050 whose samples are fused.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if `imu` is NULL.
+ */
+esp_err_t ahrs_init(mpu6050_data_t *imu);
+
+/**
+ * @brief Hands a magnetometer reading to the orientation estimate.
+ *
+ * Only the latest reading is kept. It corrects the heading until it is
+ * older than `ahrs_filter_config_t::mag_max_age_us`.
+ *
+ * @param[in] timestamp_us `esp_timer_get_time` when the field was measured.
+ * @param[in] mag_x        X-axis field in µT, in the MPU6050's axes.
+ * @param[in] mag_y        Y-axis field in µT.
+ * @param[in] mag_z        Z-axis field in µT.
+ */
+void ahrs_update_mag(int64_t timestamp_us, float mag_x, float mag_y, float mag_z);
+
+/**
+ * @brief Copies the latest orientation estimate.
+ *
+ * Lock-free: the reader never blocks the MPU6050 task, and only copies
+ * again if a new estimate was published meanwhile. Callable from any task.
+ *
+ * @param[out] orientation Destination for the estimate.
+ *
+ * @return
+ * - ESP_OK                on success.
+ * - ESP_ERR_INVALID_ARG   if `orientation` is NULL.
+ * - ESP_ERR_INVALID_STATE if no estimate was published yet.
+ */
+esp_err_t ahrs_get_orientation(ahrs_orientation_t *orientation);
+
+/**
+ * @brief Copies the counters of the orientation estimate.
+ *
+ * @param[out] stats Destination for the counters.
+ */
+void ahrs_get_stats(ahrs_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_AHRS_H */
@@ -0,0 +1,116 @@
+/* components/sensors/include/ahrs_filter.h */
+
+#ifndef TOPOROBO_AHRS_FILTER_H
+#define TOPOROBO_AHRS_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Mahony complementary filter estimating orientation from gyroscope,
+ * accelerometer and magnetometer samples. The state has a fixed size and
+ * nothing is allocated. Only the C standard library is used, so host tools
+ * can replay recorded traces through the firmware's filter.
+ *
+ * Frames: the body frame is the MPU6050's, and the magnetometer axes are
+ * assumed to be aligned with it. The earth frame has x towards magnetic
+ * north and z up, so a level sensor reads +1 g on z. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Filter tuning
+ */
+typedef struct {
+  float   kp;             /* Proportional gain in 1/s, how fast the references pull the estimate */
+  float   ki;             /* Integral gain in 1/s², how fast the gyro bias estimate follows */
+  float   accel_reject_g; /* Accelerometer not fused when its norm is further than this from 1 g */
+  float   bias_limit_dps; /* Bound of the gyro bias estimate per axis */
+  int64_t max_gap_us;     /* Longer steps between samples, e.g. lost samples, are not integrated */
+  int64_t mag_max_age_us; /* Older magnetometer readings are not fused */
+} ahrs_filter_config_t;
+
+/**
+ * @brief Filter state
+ */
+typedef struct {
+  ahrs_filter_config_t config;         /* Tuning given to ahrs_filter_init */
+  float                q[4];           /* Body to earth rotation, w x y z */
+  float                integral[3];    /* Integral feedback in rad/s, minus the gyro bias */
+  int64_t              last_us;        /* Timestamp of the previous sample */
+  bool                 aligned;        /* Whether q was set from the references */
+  bool                 heading_set;    /* Whether the heading came from the magnetometer */
+  uint32_t             updates;        /* Samples fused */
+  uint32_t             mag_fused;      /* Updates that used the magnetometer */
+  uint32_t             accel_rejected; /* Updates with the accelerometer left out */
+  uint32_t             gaps;           /* Steps longer than max_gap_us, or going back in time */
+} ahrs_filter_t;
+
+/**
+ * @brief Orientation in the forms consumers use
+ */
+typedef struct {
+  int64_t timestamp_us;   /* Time of the last fused sample */
+  float   q[4];           /* Body to earth rotation, w x y z */
+  float   roll;           /* Rotation about body x in degrees, positive right side down */
+  float   pitch;          /* Rotation about body y in degrees */
+  float   heading;        /* Tilt compensated compass heading in degrees, 0 to 360 clockwise from magnetic north */
+  float   gyro_bias[3];   /* Estimated gyro output at rest in °/s, x y z */
+  bool    magnetic;       /* Whether the heading is magnetic, otherwise relative to the start */
+} ahrs_orientation_t;
+
+/* Constants ******************************************************************/
+
+extern const ahrs_filter_config_t ahrs_filter_default_config; /* Tuning of the firmware, the replay tool's default */
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Resets a filter
+ *
+ * The orientation is set from the first accelerometer sample, and the
+ * heading from the first magnetometer sample, so the filter does not need
+ * to converge from an arbitrary start.
+ *
+ * @param filter Filter to reset
+ * @param config Tuning, copied
+ */
+void ahrs_filter_init(ahrs_filter_t *filter, const ahrs_filter_config_t *config);
+
+/**
+ * @brief Fuses one IMU sample
+ *
+ * The step is the time since the previous sample; after a gap the sample
+ * only restarts the timing.
+ *
+ * @param filter           Filter
+ * @param timestamp_us     Time the IMU sample was taken
+ * @param gyro             Angular velocity in °/s, x y z
+ * @param accel            Acceleration in g, x y z
+ * @param mag              Latest magnetic field in any unit, x y z, NULL if none
+ * @param mag_timestamp_us Time `mag` was taken, it is left out when older
+ *                         than `mag_max_age_us`
+ */
+void ahrs_filter_update(ahrs_filter_t *filter,
+                        int64_t        timestamp_us,
+                        const float   *gyro,
+                        const float   *accel,
+                        const float   *mag,
+                        int64_t        mag_timestamp_us);
+
+/**
+ * @brief Converts the filter state to an orientation
+ *
+ * @param filter      Filter
+ * @param orientation Filled with the estimate
+ */
+void ahrs_filter_get_orientation(const ahrs_filter_t *filter, ahrs_orientation_t *orientation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_AHRS_FILTER_H */
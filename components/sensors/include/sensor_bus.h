@@ -0,0 +1,179 @@
+/* components/sensors/include/sensor_bus.h */
+
+#ifndef TOPOROBO_SENSOR_BUS_H
+#define TOPOROBO_SENSOR_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "sensor_record.h"
+
+/* Constants ******************************************************************/
+
+extern const char *sensor_bus_tag; /**< Logging tag for log_handler messages related to the sensor bus. */
+
+/* Macros *********************************************************************/
+
+#define SENSOR_BUS_MAX_SUBSCRIBERS (4) /**< Tasks woken per sensor. */
+
+#define SENSOR_SEQLOCK_INITIALIZER { 0, false, portMUX_INITIALIZER_UNLOCKED }
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Sequence lock guarding a latest-value slot.
+ *
+ * The writer makes the sequence odd, updates the slot and makes it even
+ * again. Readers copy the slot and retry if the sequence was odd or changed
+ * meanwhile, so they never block the writer. The writer holds a critical
+ * section while it writes, which also keeps a reader that preempts it on
+ * the same core from spinning on a half-written slot; keep writes short.
+ */
+typedef struct {
+  _Atomic uint32_t sequence; /**< Odd while the slot is written. */
+  _Atomic bool     written;  /**< Whether the slot was written at least once. */
+  portMUX_TYPE     lock;     /**< Held by the writer, serializes writers. */
+} sensor_seqlock_t;
+
+/**
+ * @brief Latest sample of one sensor.
+ */
+typedef struct {
+  int64_t  timestamp_us;                      /**< `esp_timer_get_time` when the sample was taken, monotonic. */
+  uint32_t sequence;                          /**< Samples published for the sensor so far, a jump means missed samples. */
+  uint8_t  column_count;                      /**< Entries used in `values`. */
+  float    values[SENSOR_RECORD_MAX_COLUMNS]; /**< In `sensor_record_schema` column order and units. */
+} sensor_bus_sample_t;
+
+/**
+ * @brief Counters of one sensor's topic, kept since boot.
+ */
+typedef struct {
+  uint32_t published;    /**< Samples published. */
+  uint32_t read_retries; /**< Reads that overlapped a publish and copied again. */
+  uint8_t  subscribers;  /**< Tasks woken by a publish. */
+} sensor_bus_stats_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Starts writing a seqlock-guarded slot.
+ *
+ * Enters a critical section; only plain stores may follow until
+ * `sensor_seqlock_write_end`.
+ *
+ * @param[in,out] seqlock Lock of the slot.
+ */
+void sensor_seqlock_write_begin(sensor_seqlock_t *seqlock);
+
+/**
+ * @brief Finishes writing a seqlock-guarded slot.
+ *
+ * @param[in,out] seqlock Lock of the slot.
+ */
+void sensor_seqlock_write_end(sensor_seqlock_t *seqlock);
+
+/**
+ * @brief Copies a seqlock-guarded slot.
+ *
+ * @param[in,out] seqlock Lock of the slot.
+ * @param[in]     slot    Slot to copy.
+ * @param[out]    value   Destination, a coherent copy on return.
+ * @param[in]     size    Bytes of the slot.
+ * @param[out]    retries Incremented per copy that overlapped a write, may be NULL.
+ *
+ * @return false if the slot was never written, `value` is left alone then.
+ */
+bool sensor_seqlock_read(sensor_seqlock_t *seqlock,
+                         const void       *slot,
+                         void             *value,
+                         size_t            size,
+                         _Atomic uint32_t *retries);
+
+/**
+ * @brief Publishes a sensor's latest sample and wakes its subscribers.
+ *
+ * Never waits. Called by each sensor's task after a successful read, with
+ * the same values as `sensor_log_write`. Each sensor has a single writer,
+ * its own task. A batched sensor publishes only its newest sample, while
+ * every sample goes to `sensor_history_insert` first.
+ *
+ * @param[in] type         Sensor of the sample.
+ * @param[in] timestamp_us `esp_timer_get_time` when the sample was taken.
+ * @param[in] values       One value per column of the sensor's schema.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type or values are invalid.
+ */
+esp_err_t sensor_bus_publish(sensor_record_type_t type, int64_t timestamp_us, const float *values);
+
+/**
+ * @brief Copies a sensor's latest sample.
+ *
+ * Lock-free and callable from any task. The copy is coherent: all values
+ * come from the same publish, which `timestamp_us` and `sequence` identify.
+ *
+ * @param[in]  type   Sensor.
+ * @param[out] sample Destination for the sample.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type or `sample` is invalid.
+ * - ESP_ERR_NOT_FOUND   if the sensor has not published yet.
+ */
+esp_err_t sensor_bus_read(sensor_record_type_t type, sensor_bus_sample_t *sample);
+
+/**
+ * @brief Returns how many samples a sensor has published.
+ *
+ * A single atomic load, so consumers can poll for news without copying.
+ *
+ * @param[in] type Sensor, 0 is returned for an invalid one.
+ */
+uint32_t sensor_bus_sequence(sensor_record_type_t type);
+
+/**
+ * @brief Wakes a task whenever a sensor publishes.
+ *
+ * The task's notification value gets `bits` set with `eSetBits`, so one task
+ * can wait for several sensors with `xTaskNotifyWait` and read the ones
+ * whose bits are set. The task must not use its notification otherwise.
+ * Subscriptions last until reboot.
+ *
+ * @param[in] type Sensor.
+ * @param[in] task Task to wake.
+ * @param[in] bits Notification bits set for this sensor, non-zero.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type, task or bits are invalid.
+ * - ESP_ERR_NO_MEM      if the sensor has `SENSOR_BUS_MAX_SUBSCRIBERS` already.
+ */
+esp_err_t sensor_bus_subscribe(sensor_record_type_t type, TaskHandle_t task, uint32_t bits);
+
+/**
+ * @brief Copies a sensor's topic counters.
+ *
+ * @param[in]  type  Sensor.
+ * @param[out] stats Filled with the counters.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type or `stats` is invalid.
+ */
+esp_err_t sensor_bus_get_stats(sensor_record_type_t type, sensor_bus_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SENSOR_BUS_H */
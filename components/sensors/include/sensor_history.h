@@ -0,0 +1,159 @@
+/* components/sensors/include/sensor_history.h */
+
+#ifndef TOPOROBO_SENSOR_HISTORY_H
+#define TOPOROBO_SENSOR_HISTORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sensor_record.h"
+
+/* Constants ******************************************************************/
+
+extern const char *sensor_history_tag; /**< Logging tag for log_handler messages related to the sensor history. */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief Resolution of a sensor's history
+ */
+typedef enum : uint8_t {
+  k_sensor_history_raw,        /* Every published sample */
+  k_sensor_history_second,     /* Mean, minimum and maximum per second */
+  k_sensor_history_minute,     /* Mean, minimum and maximum per minute, folded from the seconds */
+  k_sensor_history_tier_count,
+} sensor_history_tier_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Entries kept per tier of one sensor's history.
+ *
+ * All three are allocated at once by `sensor_history_init`; a tier of 0
+ * entries costs nothing and cannot be queried.
+ */
+typedef struct {
+  uint16_t raw;    /**< Latest samples kept. */
+  uint16_t second; /**< Latest completed 1 s buckets kept. */
+  uint16_t minute; /**< Latest completed 1 min buckets kept. */
+} sensor_history_config_t;
+
+/**
+ * @brief One sample or bucket of a sensor's history.
+ *
+ * Raw samples have a count of 1 and the value in `mean`, `min` and `max`.
+ * Means are arithmetic, so a heading averaged across north is meaningless.
+ */
+typedef struct {
+  int64_t  timestamp_us;                    /**< Sample time, or the start of the bucket, `esp_timer_get_time` based. */
+  uint32_t count;                           /**< Samples in the bucket. */
+  uint8_t  column_count;                    /**< Entries used in the value arrays. */
+  float    mean[SENSOR_RECORD_MAX_COLUMNS]; /**< In `sensor_record_schema` column order and units. */
+  float    min[SENSOR_RECORD_MAX_COLUMNS];  /**< Smallest value per column. */
+  float    max[SENSOR_RECORD_MAX_COLUMNS];  /**< Largest value per column. */
+} sensor_history_point_t;
+
+/**
+ * @brief Counters of one sensor's history, kept since boot.
+ */
+typedef struct {
+  uint32_t samples;      /**< Samples inserted. */
+  uint32_t seconds;      /**< 1 s buckets completed. */
+  uint32_t minutes;      /**< 1 min buckets completed. */
+  uint32_t read_retries; /**< Queries that lost entries to the producer and copied again. */
+  uint32_t bytes;        /**< Memory held by the rings. */
+} sensor_history_stats_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Allocates a sensor's history.
+ *
+ * Called once per sensor before its task starts publishing, sized by the
+ * sensor's entry in the `s_sensors` table. The rings are taken from PSRAM
+ * when there is any and never grow.
+ *
+ * @param[in] type   Sensor.
+ * @param[in] config Entries kept per tier.
+ *
+ * @return
+ * - ESP_OK                on success.
+ * - ESP_ERR_INVALID_ARG   if the type or `config` is invalid, or every tier is 0.
+ * - ESP_ERR_INVALID_STATE if the sensor's history already exists.
+ * - ESP_ERR_NO_MEM        if the rings cannot be allocated.
+ */
+esp_err_t sensor_history_init(sensor_record_type_t type, const sensor_history_config_t *config);
+
+/**
+ * @brief Adds a sample to a sensor's history.
+ *
+ * Called by the sensor's own task for every sample it takes, including
+ * batched samples that are never published, and before `sensor_bus_publish`
+ * so a woken subscriber finds the sample in the history too.
+ * Appends to the raw ring and folds the sample into the current second;
+ * a completed second is appended and folded into the current minute.
+ * Constant time, never waits and never allocates. The oldest entries of a
+ * full ring are overwritten.
+ *
+ * @param[in] type         Sensor of the sample.
+ * @param[in] timestamp_us `esp_timer_get_time` when the sample was taken, non-decreasing.
+ * @param[in] values       One value per column of the sensor's schema.
+ *
+ * @return
+ * - ESP_OK                on success.
+ * - ESP_ERR_INVALID_ARG   if the type or values are invalid.
+ * - ESP_ERR_INVALID_STATE if the sensor has no history.
+ */
+esp_err_t sensor_history_insert(sensor_record_type_t type, int64_t timestamp_us, const float *values);
+
+/**
+ * @brief Copies a time range of a sensor's history.
+ *
+ * Lock-free and callable from any task: the producer is never blocked, and
+ * the copy is repeated if the producer overwrote entries it was reading.
+ * Points come oldest first; if the range holds more than `max_points`,
+ * continue from the last timestamp plus one. Buckets still collecting
+ * samples are not returned.
+ *
+ * @param[in]  type        Sensor.
+ * @param[in]  tier        Resolution.
+ * @param[in]  from_us     Earliest timestamp returned.
+ * @param[in]  to_us       Latest timestamp returned.
+ * @param[out] points      Destination for the points.
+ * @param[in]  max_points  Entries in `points`.
+ * @param[out] point_count Points copied.
+ *
+ * @return
+ * - ESP_OK                on success, also when the range is empty.
+ * - ESP_ERR_INVALID_ARG   if an argument is invalid.
+ * - ESP_ERR_INVALID_STATE if the sensor keeps no entries at this tier.
+ */
+esp_err_t sensor_history_query(sensor_record_type_t    type,
+                               sensor_history_tier_t   tier,
+                               int64_t                 from_us,
+                               int64_t                 to_us,
+                               sensor_history_point_t *points,
+                               size_t                  max_points,
+                               size_t                 *point_count);
+
+/**
+ * @brief Copies a sensor's history counters.
+ *
+ * @param[in]  type  Sensor.
+ * @param[out] stats Filled with the counters, all 0 if the sensor has no history.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type or `stats` is invalid.
+ */
+esp_err_t sensor_history_get_stats(sensor_record_type_t type, sensor_history_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SENSOR_HISTORY_H */
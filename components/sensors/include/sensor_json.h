@@ -0,0 +1,61 @@
+/* components/sensors/include/sensor_json.h */
+
+#ifndef TOPOROBO_SENSOR_JSON_H
+#define TOPOROBO_SENSOR_JSON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+/* Macros *********************************************************************/
+
+#define SENSOR_JSON_PAYLOAD_SIZE (256) /**< Stack buffer that fits the largest sensor payload, the GPS one. */
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Writes a sensor's data struct as its JSON payload into a buffer.
+ *
+ * Backs the `*_data_to_json_buf` functions of the sensor HALs. Nothing is
+ * allocated; each HAL describes its payload with a static `json_schema_t`.
+ *
+ * @param[in]  schema Payload fields of the sensor.
+ * @param[in]  data   Sensor data struct the schema describes.
+ * @param[out] buffer Output, NUL-terminated.
+ * @param[in]  size   Bytes of `buffer`, `SENSOR_JSON_PAYLOAD_SIZE` fits every sensor.
+ * @param[out] length Characters written without the NUL, may be NULL.
+ *
+ * @return
+ * - ESP_OK               on success.
+ * - ESP_ERR_INVALID_ARG  if an argument is NULL.
+ * - ESP_ERR_INVALID_SIZE if the payload does not fit, `buffer` holds a cut short prefix.
+ */
+esp_err_t sensor_json_write(const json_schema_t *schema,
+                            const void          *data,
+                            char                *buffer,
+                            size_t               size,
+                            size_t              *length);
+
+/**
+ * @brief Writes a sensor's JSON payload into an exactly sized heap string.
+ *
+ * Backs the allocating `*_data_to_json` functions kept for existing callers.
+ *
+ * @param[in] schema Payload fields of the sensor.
+ * @param[in] data   Sensor data struct the schema describes.
+ *
+ * @return
+ * - Pointer to the JSON string on success, the caller must free it.
+ * - `NULL` if memory allocation fails.
+ */
+char *sensor_json_to_string(const json_schema_t *schema, const void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SENSOR_JSON_H */
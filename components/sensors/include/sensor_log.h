@@ -0,0 +1,97 @@
+/* components/sensors/include/sensor_log.h */
+
+#ifndef TOPOROBO_SENSOR_LOG_H
+#define TOPOROBO_SENSOR_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sensor_record.h"
+
+/* Constants ******************************************************************/
+
+extern const char    *sensor_log_tag;               /**< Logging tag for log_handler messages related to the sensor log. */
+extern const uint32_t sensor_log_flush_interval_ms; /**< Longest time a partly filled block is held back, the data lost on power loss. */
+extern const uint32_t sensor_log_flush_wait_ms;     /**< Longest time `sensor_log_flush` waits for write buffers in total. */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Counters of one sensor's log, kept since boot.
+ */
+typedef struct {
+  uint32_t records;         /**< Samples written into blocks. */
+  uint32_t blocks;          /**< Blocks handed to the file writer. */
+  uint32_t dropped_records; /**< Samples lost because no write buffer was free for their block. */
+} sensor_log_stats_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Initializes the sensor log.
+ *
+ * Sensor samples are written to `sensors/<sensor>.tsns` as columnar binary
+ * blocks of a fixed size per sensor, see `sensor_record.h`. Block buffers
+ * are allocated with a sensor's first sample, so unused sensors cost no RAM.
+ * Decode the files with `tools/sensor_decoder`.
+ *
+ * @return
+ * - ESP_OK   on success.
+ * - ESP_FAIL if a mutex cannot be created.
+ */
+esp_err_t sensor_log_init(void);
+
+/**
+ * @brief Adds a sample to its sensor's current block.
+ *
+ * Full blocks, and blocks older than `sensor_log_flush_interval_ms`, are
+ * handed to the file writer's telemetry lane. Never waits for the file
+ * writer; if it has no free buffer the block's samples are dropped.
+ *
+ * @param[in] type         Sensor of the sample.
+ * @param[in] timestamp_us `esp_timer_get_time` when the sample was taken.
+ * @param[in] values       One value per column of the sensor's schema, in
+ *                         `sensor_record_schema` order and unscaled units.
+ *
+ * @return
+ * - ESP_OK              if the sample was added.
+ * - ESP_ERR_INVALID_ARG if the type or values are invalid.
+ * - ESP_ERR_NO_MEM      if the sensor's block buffer cannot be allocated.
+ * - ESP_FAIL            if the log is not initialized.
+ */
+esp_err_t sensor_log_write(sensor_record_type_t type, int64_t timestamp_us, const float *values);
+
+/**
+ * @brief Hands every partly filled block to the file writer.
+ *
+ * Called before files are closed, e.g. by `shutdown_manager_quiesce`.
+ * Unlike `sensor_log_write` it waits for the file writer to free a buffer,
+ * up to `sensor_log_flush_wait_ms` over all sensors, so the last blocks are
+ * not dropped while the writer is still returning buffers of earlier ones.
+ *
+ * @return
+ * - ESP_OK   if every block was queued.
+ * - ESP_FAIL if a block could not be queued or the log is not initialized.
+ */
+esp_err_t sensor_log_flush(void);
+
+/**
+ * @brief Copies a sensor's log counters.
+ *
+ * @param[in]  type  Sensor.
+ * @param[out] stats Filled with the counters.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if the type or `stats` is invalid.
+ */
+esp_err_t sensor_log_get_stats(sensor_record_type_t type, sensor_log_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SENSOR_LOG_H */
@@ -0,0 +1,145 @@
+/* components/sensors/mpu6050_hal/include/mpu6050_frame.h */
+
+#ifndef TOPOROBO_MPU6050_FRAME_H
+#define TOPOROBO_MPU6050_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoding of MPU6050 accel/temperature/gyro frames and the temperature
+ * compensated gyro bias table. Only the C standard library is used, so host
+ * tools and tests can decode recorded frames with the firmware's code. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Macros *********************************************************************/
+
+#define MPU6050_FRAME_SIZE          (14)     /* ACCEL_XOUT_H to GYRO_ZOUT_L, also one FIFO entry */
+#define MPU6050_TEMP_LSB_PER_C      (340.0f) /* Temperature sensitivity, as per the datasheet */
+#define MPU6050_TEMP_OFFSET_C       (36.53f) /* Temperature at a raw value of 0 */
+#define MPU6050_GYRO_BIAS_POINTS    (8)      /* Calibration temperatures kept in a bias table */
+#define MPU6050_GYRO_BIAS_MERGE_C   (1.0f)   /* A new point this close to an existing one replaces it */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Raw register values of one frame, in frame order
+ */
+typedef struct {
+  int16_t accel_x;     /* ACCEL_XOUT */
+  int16_t accel_y;     /* ACCEL_YOUT */
+  int16_t accel_z;     /* ACCEL_ZOUT */
+  int16_t temperature; /* TEMP_OUT */
+  int16_t gyro_x;      /* GYRO_XOUT */
+  int16_t gyro_y;      /* GYRO_YOUT */
+  int16_t gyro_z;      /* GYRO_ZOUT */
+} mpu6050_raw_frame_t;
+
+/**
+ * @brief One timestamped MPU6050 sample, in physical units
+ */
+typedef struct {
+  int64_t timestamp_us; /* esp_timer_get_time when the sample was taken */
+  float   accel_x;      /* X-axis acceleration in g */
+  float   accel_y;      /* Y-axis acceleration in g */
+  float   accel_z;      /* Z-axis acceleration in g */
+  float   gyro_x;       /* X-axis angular velocity in °/s, bias corrected */
+  float   gyro_y;       /* Y-axis angular velocity in °/s, bias corrected */
+  float   gyro_z;       /* Z-axis angular velocity in °/s, bias corrected */
+  float   temperature;  /* Die temperature in degrees Celsius */
+} mpu6050_sample_t;
+
+/**
+ * @brief Sensitivities of the configured full-scale ranges
+ */
+typedef struct {
+  float accel_lsb_per_g;  /* Raw accelerometer counts per g */
+  float gyro_lsb_per_dps; /* Raw gyroscope counts per °/s */
+} mpu6050_frame_scale_t;
+
+/**
+ * @brief Gyroscope output at rest, measured at one die temperature
+ */
+typedef struct {
+  float temperature; /* Die temperature in degrees Celsius */
+  float bias_x;      /* X-axis output at rest in °/s */
+  float bias_y;      /* Y-axis output at rest in °/s */
+  float bias_z;      /* Z-axis output at rest in °/s */
+} mpu6050_gyro_bias_point_t;
+
+/**
+ * @brief Gyroscope bias over temperature
+ *
+ * The bias between two points is interpolated linearly, outside the
+ * calibrated range the nearest point is used. An empty table means no
+ * correction. Stored as is in NVS, so the layout only ever grows at the end.
+ */
+typedef struct {
+  uint8_t                   count;                            /* Points in use */
+  mpu6050_gyro_bias_point_t points[MPU6050_GYRO_BIAS_POINTS]; /* Ascending temperature */
+} mpu6050_gyro_bias_table_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Splits a frame into its big endian register values
+ *
+ * @param frame `MPU6050_FRAME_SIZE` bytes as read from the sensor
+ * @param raw   Filled with the register values
+ */
+void mpu6050_frame_unpack(const uint8_t *frame, mpu6050_raw_frame_t *raw);
+
+/**
+ * @brief Converts a frame to physical units and removes the gyro bias
+ *
+ * The bias is looked up at the frame's own temperature, which the burst
+ * read sampled at the same instant as the rates.
+ *
+ * @param frame  `MPU6050_FRAME_SIZE` bytes as read from the sensor
+ * @param scale  Sensitivities of the configured ranges
+ * @param bias   Bias table, NULL for no correction
+ * @param sample Filled with the values, the timestamp is left alone
+ */
+void mpu6050_frame_decode(const uint8_t                   *frame,
+                          const mpu6050_frame_scale_t     *scale,
+                          const mpu6050_gyro_bias_table_t *bias,
+                          mpu6050_sample_t                *sample);
+
+/**
+ * @brief Interpolates the gyro bias at a temperature
+ *
+ * @param table       Bias table
+ * @param temperature Die temperature in degrees Celsius
+ * @param bias        Filled with the bias, temperature set to the argument
+ */
+void mpu6050_gyro_bias_at(const mpu6050_gyro_bias_table_t *table,
+                          float                            temperature,
+                          mpu6050_gyro_bias_point_t       *bias);
+
+/**
+ * @brief Adds a calibration point, keeping the table sorted
+ *
+ * A point within `MPU6050_GYRO_BIAS_MERGE_C` of an existing one replaces it.
+ * When the table is full the nearest point is replaced.
+ *
+ * @param table Bias table
+ * @param point Measured bias, must be finite
+ * @return false if the point is not finite and was not added
+ */
+bool mpu6050_gyro_bias_add(mpu6050_gyro_bias_table_t *table, const mpu6050_gyro_bias_point_t *point);
+
+/**
+ * @brief Checks a table read from storage
+ *
+ * @return true if the count is in range and the points are finite and in
+ *         strictly ascending temperature order
+ */
+bool mpu6050_gyro_bias_is_valid(const mpu6050_gyro_bias_table_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_MPU6050_FRAME_H */
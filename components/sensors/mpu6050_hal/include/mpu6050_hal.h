@@ -7,10 +7,12 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "driver/i2c.h"
+#include "mpu6050_frame.h"
 
 /* Constants ******************************************************************/
 
@@ -24,12 +26,18 @@ extern const uint32_t   mpu6050_polling_rate_ticks; /**< Polling interval for MP
 extern const uint8_t    mpu6050_sample_rate_div;    /**< Sample rate divider for MPU6050 (default divides gyro rate). */
 extern const uint8_t    mpu6050_config_dlpf;        /**< Digital Low Pass Filter (DLPF) setting for noise reduction. */
 extern const uint8_t    mpu6050_int_io;             /**< GPIO pin for MPU6050 interrupt signal (INT pin). */
+extern const bool       mpu6050_fifo_enabled;       /**< Whether samples are collected in the MPU6050 FIFO and read in batches instead of polled. */
+extern const uint8_t    mpu6050_fifo_watermark;     /**< Samples in the FIFO that wake the MPU6050 task, i.e. the batch size. */
+extern const char      *mpu6050_nvs_namespace;      /**< NVS namespace holding the gyro bias table. */
+extern const float      mpu6050_cal_max_noise_dps;  /**< Largest gyro standard deviation accepted as "at rest" during calibration. */
 
 /* Macros *********************************************************************/
 
 #define MPU6050_ACCEL_DATA_SIZE (6)
 #define MPU6050_GYRO_DATA_SIZE  (6)
 #define MPU6050_TEMP_DATA_SIZE  (2)
+#define MPU6050_FIFO_SIZE       (1024)                                   /**< Bytes of the on-chip FIFO. */
+#define MPU6050_FIFO_MAX_FRAMES (MPU6050_FIFO_SIZE / MPU6050_FRAME_SIZE) /**< Most frames one FIFO read returns, see `mpu6050_frame.h`. */
 
 /* Enums **********************************************************************/
 
@@ -86,6 +94,24 @@ typedef enum : uint8_t {
   k_mpu6050_event_pll_ready       = 0x80, /**< Bit for Phase-Locked Loop (PLL) Ready event. */
 } mpu6050_event_bits_t;
 
+/**
+ * @brief Enumeration of FIFO related bits of the FIFO_EN and USER_CTRL registers.
+ *
+ * The FIFO stores the enabled measurements in register order, so with
+ * `k_mpu6050_fifo_en_frame` every entry has the layout of the registers from
+ * ACCEL_XOUT_H to GYRO_ZOUT_L.
+ */
+typedef enum : uint8_t {
+  k_mpu6050_fifo_en_accel         = 0x08, /**< FIFO_EN: Store accelerometer X, Y and Z. */
+  k_mpu6050_fifo_en_gyro_z        = 0x10, /**< FIFO_EN: Store gyroscope Z. */
+  k_mpu6050_fifo_en_gyro_y        = 0x20, /**< FIFO_EN: Store gyroscope Y. */
+  k_mpu6050_fifo_en_gyro_x        = 0x40, /**< FIFO_EN: Store gyroscope X. */
+  k_mpu6050_fifo_en_temp          = 0x80, /**< FIFO_EN: Store temperature. */
+  k_mpu6050_fifo_en_frame         = 0xF8, /**< FIFO_EN: Store all of the above, one `MPU6050_FRAME_SIZE` frame per sample. */
+  k_mpu6050_user_ctrl_fifo_reset  = 0x04, /**< USER_CTRL: Empty the FIFO, clears itself. */
+  k_mpu6050_user_ctrl_fifo_enable = 0x40, /**< USER_CTRL: Enable the FIFO. */
+} mpu6050_fifo_bits_t;
+
 /**
  * @brief Enumeration of MPU6050 sensor states.
  *
@@ -124,6 +150,7 @@ typedef enum : uint8_t {
   k_mpu6050_who_am_i_cmd        = 0x75, /**< WHO_AM_I register to verify sensor identity. */
   
   /* Interrupt Configuration Commands */
+  k_mpu6050_int_pin_cfg_cmd     = 0x37, /**< INT Pin / Bypass Enable Configuration register. */
   k_mpu6050_int_enable_cmd      = 0x38, /**< Interrupt Enable register. */
   k_mpu6050_int_status_cmd      = 0x3A, /**< Interrupt Status register. */
 
@@ -160,6 +187,7 @@ typedef enum : uint8_t {
   k_mpu6050_gyro_zout_l_cmd     = 0x48, /**< Gyroscope Z-axis Low byte. */
 
   /* Unused or Optional Commands */
+  k_mpu6050_user_ctrl_cmd       = 0x6A, /**< User Control register (FIFO enable and reset). */
   k_mpu6050_pwr_mgmt_2_cmd      = 0x6C, /**< Power Management 2 register. */
   k_mpu6050_fifo_en_cmd         = 0x23, /**< FIFO Enable register. */
   k_mpu6050_fifo_count_h_cmd    = 0x72, /**< FIFO Count High byte. */
@@ -207,6 +235,38 @@ typedef struct {
   float   gyro_scale;  /**< Scaling factor to convert raw data to angular velocity in °/s. */
 } mpu6050_gyro_config_t;
 
+/**
+ * @brief Consecutive samples read from the MPU6050 FIFO in one transaction.
+ *
+ * Valid only during the batch callback; copy what is needed afterwards.
+ */
+typedef struct {
+  const mpu6050_sample_t *samples;          /**< Samples, oldest first. */
+  uint16_t                count;            /**< Samples in the batch, at most `MPU6050_FIFO_MAX_FRAMES`. */
+  uint32_t                sample_period_us; /**< Time between two samples. */
+  uint32_t                dropped;          /**< Samples lost to FIFO overflows since the previous batch, a lower bound without the INT pin. */
+} mpu6050_batch_t;
+
+/**
+ * @brief Function pointer type for MPU6050 batch callbacks.
+ *
+ * @param[in] batch   Samples just read from the FIFO
+ * @param[in] context Pointer given to `mpu6050_register_batch_callback`
+ */
+typedef void (*mpu6050_batch_callback_t)(const mpu6050_batch_t *batch, void *context);
+
+/**
+ * @brief Counters of the MPU6050 FIFO acquisition, kept since boot.
+ */
+typedef struct {
+  uint32_t samples;      /**< Samples read from the FIFO. */
+  uint32_t batches;      /**< FIFO reads that returned samples. */
+  uint32_t late_batches; /**< Batches read after waiting for the INT pin timed out. */
+  uint32_t overflows;    /**< Times the FIFO filled up and was reset. */
+  uint32_t dropped;      /**< Samples lost to overflows. */
+  uint32_t read_errors;  /**< Failed FIFO count or data reads. */
+} mpu6050_fifo_stats_t;
+
 /**
  * @brief Structure to store MPU6050 sensor data and state.
  *
@@ -214,17 +274,19 @@ typedef struct {
  * and semaphore for signaling data readiness. Also holds I2C communication details.
  */
 typedef struct {
-  uint8_t           i2c_address;    /**< I2C address used for communication with the sensor. */
-  uint8_t           i2c_bus;        /**< I2C bus number used for communication. */
-  float             accel_x;        /**< Measured X-axis acceleration in g. */
-  float             accel_y;        /**< Measured Y-axis acceleration in g. */
-  float             accel_z;        /**< Measured Z-axis acceleration in g. */
-  float             gyro_x;         /**< Measured X-axis angular velocity in °/s. */
-  float             gyro_y;         /**< Measured Y-axis angular velocity in °/s. */
-  float             gyro_z;         /**< Measured Z-axis angular velocity in °/s. */
-  float             temperature;    /**< Measured temperature from the sensor in degrees Celsius. */
-  uint8_t           state;          /**< Current operational state of the sensor (see `mpu6050_states_t`). */
-  SemaphoreHandle_t data_ready_sem; /**< Semaphore to signal when new data is available. */
+  uint8_t                  i2c_address;    /**< I2C address used for communication with the sensor. */
+  uint8_t                  i2c_bus;        /**< I2C bus number used for communication. */
+  float                    accel_x;        /**< Measured X-axis acceleration in g. */
+  float                    accel_y;        /**< Measured Y-axis acceleration in g. */
+  float                    accel_z;        /**< Measured Z-axis acceleration in g. */
+  float                    gyro_x;         /**< Measured X-axis angular velocity in °/s. */
+  float                    gyro_y;         /**< Measured Y-axis angular velocity in °/s. */
+  float                    gyro_z;         /**< Measured Z-axis angular velocity in °/s. */
+  float                    temperature;    /**< Measured temperature from the sensor in degrees Celsius. */
+  uint8_t                  state;          /**< Current operational state of the sensor (see `mpu6050_states_t`). */
+  SemaphoreHandle_t        data_ready_sem; /**< Semaphore to signal when new data is available. */
+  mpu6050_batch_callback_t batch_callback; /**< Called with every batch of samples, see `mpu6050_register_batch_callback`. */
+  void                    *batch_context;  /**< Passed to `batch_callback`. */
 } mpu6050_data_t;
 
 /* Public Functions ***********************************************************/
@@ -245,6 +307,23 @@ typedef struct {
  */
 char *mpu6050_data_to_json(const mpu6050_data_t *data);
 
+/**
+ * @brief Writes MPU6050 data as its JSON payload into a caller-provided buffer.
+ *
+ * Allocation-free counterpart of `mpu6050_data_to_json`, used by the sensor task.
+ *
+ * @param[in]  data   Pointer to the `mpu6050_data_t` structure with valid sensor data.
+ * @param[out] buffer Output, NUL-terminated.
+ * @param[in]  size   Bytes of `buffer`, `SENSOR_JSON_PAYLOAD_SIZE` always fits.
+ * @param[out] length Characters written without the NUL, may be NULL.
+ *
+ * @return
+ * - ESP_OK               on success.
+ * - ESP_ERR_INVALID_ARG  if an argument is NULL.
+ * - ESP_ERR_INVALID_SIZE if the payload does not fit `size`.
+ */
+esp_err_t mpu6050_data_to_json_buf(const mpu6050_data_t *data, char *buffer, size_t size, size_t *length);
+
 /**
  * @brief Initializes the MPU6050 sensor in continuous measurement mode.
  *
@@ -264,11 +343,125 @@ char *mpu6050_data_to_json(const mpu6050_data_t *data);
  */
 esp_err_t mpu6050_init(void *sensor_data);
 
+/**
+ * @brief Registers a function that receives every batch of FIFO samples.
+ *
+ * Called from the MPU6050 task right after each FIFO read, before the
+ * samples are logged, so it should return quickly. Without
+ * `mpu6050_fifo_enabled` every polled sample is passed as a batch of one.
+ *
+ * @param[in,out] sensor_data Pointer to the `mpu6050_data_t` structure of the sensor.
+ * @param[in]     callback    Function to call, or NULL to remove it.
+ * @param[in]     context     Passed to `callback`.
+ */
+void mpu6050_register_batch_callback(mpu6050_data_t          *sensor_data,
+                                     mpu6050_batch_callback_t callback,
+                                     void                    *context);
+
+/**
+ * @brief Reads every complete sample queued in the MPU6050 FIFO.
+ *
+ * Reads the FIFO count, then all queued frames in a single I2C transaction,
+ * and timestamps them from the time of the latest data ready interrupt. If
+ * the FIFO overflowed it is reset and the lost samples are counted in `dropped`.
+ *
+ * @param[in,out] sensor_data Pointer to the `mpu6050_data_t` structure, updated
+ *                            with the newest sample.
+ * @param[out]    samples     Receives up to `MPU6050_FIFO_MAX_FRAMES` samples, oldest first.
+ * @param[out]    count       Number of samples written, may be 0.
+ * @param[out]    dropped     Samples lost to an overflow, may be NULL.
+ *
+ * @return
+ * - `ESP_OK`   on success, including an empty FIFO or an overflow.
+ * - `ESP_FAIL` if the FIFO could not be read.
+ */
+esp_err_t mpu6050_read_fifo(mpu6050_data_t   *sensor_data,
+                            mpu6050_sample_t *samples,
+                            uint16_t         *count,
+                            uint32_t         *dropped);
+
+/**
+ * @brief Copies the counters of the FIFO acquisition.
+ *
+ * @param[out] stats Destination for the counters.
+ */
+void mpu6050_get_fifo_stats(mpu6050_fifo_stats_t *stats);
+
+/**
+ * @brief Reads one coherent sample from the MPU6050 sensor.
+ *
+ * Reads the 14 contiguous registers from ACCEL_XOUT_H to GYRO_ZOUT_L in a
+ * single I2C transaction, so accelerometer, temperature and gyroscope come
+ * from the same sampling instant. The gyro bias is removed at the sample's
+ * temperature. Readings outside the configured ranges are rejected.
+ *
+ * @param[in,out] sensor_data Pointer to the `mpu6050_data_t` structure, updated
+ *                            with the sample on success.
+ * @param[out]    sample      Filled with the sample and the time of the read.
+ *
+ * @return 
+ * - `ESP_OK`   on successful read.
+ * - `ESP_FAIL` on failure or an out-of-range reading.
+ */
+esp_err_t mpu6050_read_sample(mpu6050_data_t *sensor_data, mpu6050_sample_t *sample);
+
+/**
+ * @brief Measures the gyro bias at the current die temperature.
+ *
+ * Averages `sample_count` readings, one per sample period, and adds the
+ * result to the bias table at their mean temperature. The robot must not
+ * move meanwhile; a standard deviation above `mpu6050_cal_max_noise_dps`
+ * on any axis rejects the run. Calibrating at several temperatures, e.g.
+ * cold after boot and again warmed up, fills the table. The table is
+ * only persisted by `mpu6050_save_calibration`.
+ *
+ * @param[in] sensor_data  Pointer to the initialized `mpu6050_data_t` structure.
+ * @param[in] sample_count Readings to average, at least 10.
+ *
+ * @return
+ * - `ESP_OK`                on success.
+ * - `ESP_ERR_INVALID_ARG`   if an argument is invalid.
+ * - `ESP_ERR_INVALID_STATE` if the sensor moved during the measurement.
+ * - `ESP_FAIL`              if the sensor could not be read.
+ */
+esp_err_t mpu6050_calibrate_gyro(mpu6050_data_t *sensor_data, uint16_t sample_count);
+
+/**
+ * @brief Replaces the gyro bias table, e.g. with factory measurements.
+ *
+ * Takes effect with the next read but is only persisted by
+ * `mpu6050_save_calibration`.
+ *
+ * @param[in] table New table.
+ *
+ * @return
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if the table is NULL or not valid, see
+ *                         `mpu6050_gyro_bias_is_valid`.
+ */
+esp_err_t mpu6050_set_gyro_bias_table(const mpu6050_gyro_bias_table_t *table);
+
+/**
+ * @brief Copies the gyro bias table in use.
+ *
+ * @param[out] table Destination for the table.
+ */
+void mpu6050_get_gyro_bias_table(mpu6050_gyro_bias_table_t *table);
+
+/**
+ * @brief Persists the gyro bias table to NVS, loaded again by `mpu6050_init`.
+ *
+ * @return
+ * - `ESP_OK` on success.
+ * - Relevant NVS `esp_err_t` codes on storage failure.
+ */
+esp_err_t mpu6050_save_calibration(void);
+
 /**
  * @brief Reads accelerometer and gyroscope data from the MPU6050 sensor.
  *
- * Retrieves the latest measurements from the MPU6050 sensor and updates the 
- * `mpu6050_data_t` structure.
+ * Retrieves the latest measurements from the MPU6050 sensor with
+ * `mpu6050_read_sample` and updates the `mpu6050_data_t` structure.
  *
  * @param[in,out] sensor_data Pointer to the `mpu6050_data_t` structure to store
  *                            the sensor data and read status.
@@ -303,11 +496,16 @@ void mpu6050_reset_on_error(mpu6050_data_t *sensor_data);
  * Periodically reads data and handles errors for the MPU6050 sensor. Uses
  * `mpu6050_reset_on_error` for recovery. Intended to run in a FreeRTOS task.
  *
+ * With `mpu6050_fifo_enabled` the task instead sleeps until the INT pin has
+ * signalled `mpu6050_fifo_watermark` samples, reads them with
+ * `mpu6050_read_fifo`, hands the batch to the batch callback and logs every
+ * sample. The newest sample of each batch goes to the web server.
+ *
  * @param[in,out] sensor_data Pointer to the `mpu6050_data_t` structure for managing
  *                            sensor data and error recovery.
  *
  * @note 
- * - Should run at intervals defined by `mpu6050_polling_rate_ticks`.
+ * - Should run at intervals defined by `mpu6050_polling_rate_ticks` when polling.
  * - Handles error recovery internally to maintain stable operation.
  */
 void mpu6050_tasks(void *sensor_data);
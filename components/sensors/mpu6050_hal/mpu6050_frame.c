@@ -0,0 +1,148 @@
+/* components/sensors/mpu6050_hal/mpu6050_frame.c */
+
+#include "mpu6050_frame.h"
+#include <math.h>
+#include <string.h>
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Reads a big endian register pair
+ */
+static inline int16_t priv_be16(const uint8_t *bytes)
+{
+  return (int16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+/**
+ * @brief Whether every value of a point is a finite number
+ */
+static bool priv_point_is_finite(const mpu6050_gyro_bias_point_t *point)
+{
+  return isfinite(point->temperature) && isfinite(point->bias_x) &&
+         isfinite(point->bias_y) && isfinite(point->bias_z);
+}
+
+/* Public Functions ***********************************************************/
+
+void mpu6050_frame_unpack(const uint8_t *frame, mpu6050_raw_frame_t *raw)
+{
+  raw->accel_x     = priv_be16(&frame[0]);
+  raw->accel_y     = priv_be16(&frame[2]);
+  raw->accel_z     = priv_be16(&frame[4]);
+  raw->temperature = priv_be16(&frame[6]);
+  raw->gyro_x      = priv_be16(&frame[8]);
+  raw->gyro_y      = priv_be16(&frame[10]);
+  raw->gyro_z      = priv_be16(&frame[12]);
+}
+
+void mpu6050_frame_decode(const uint8_t                   *frame,
+                          const mpu6050_frame_scale_t     *scale,
+                          const mpu6050_gyro_bias_table_t *bias,
+                          mpu6050_sample_t                *sample)
+{
+  mpu6050_raw_frame_t raw;
+  mpu6050_frame_unpack(frame, &raw);
+
+  sample->accel_x     = raw.accel_x / scale->accel_lsb_per_g;
+  sample->accel_y     = raw.accel_y / scale->accel_lsb_per_g;
+  sample->accel_z     = raw.accel_z / scale->accel_lsb_per_g;
+  sample->temperature = raw.temperature / MPU6050_TEMP_LSB_PER_C + MPU6050_TEMP_OFFSET_C;
+  sample->gyro_x      = raw.gyro_x / scale->gyro_lsb_per_dps;
+  sample->gyro_y      = raw.gyro_y / scale->gyro_lsb_per_dps;
+  sample->gyro_z      = raw.gyro_z / scale->gyro_lsb_per_dps;
+
+  if (bias != NULL && bias->count > 0) {
+    mpu6050_gyro_bias_point_t offset;
+    mpu6050_gyro_bias_at(bias, sample->temperature, &offset);
+    sample->gyro_x -= offset.bias_x;
+    sample->gyro_y -= offset.bias_y;
+    sample->gyro_z -= offset.bias_z;
+  }
+}
+
+void mpu6050_gyro_bias_at(const mpu6050_gyro_bias_table_t *table,
+                          float                            temperature,
+                          mpu6050_gyro_bias_point_t       *bias)
+{
+  bias->temperature = temperature;
+  if (table->count == 0) {
+    bias->bias_x = bias->bias_y = bias->bias_z = 0.0f;
+    return;
+  }
+
+  const mpu6050_gyro_bias_point_t *first = &table->points[0];
+  const mpu6050_gyro_bias_point_t *last  = &table->points[table->count - 1];
+  if (temperature <= first->temperature || table->count == 1) {
+    *bias             = *first;
+    bias->temperature = temperature;
+    return;
+  }
+  if (temperature >= last->temperature) {
+    *bias             = *last;
+    bias->temperature = temperature;
+    return;
+  }
+
+  /* Points are few, a linear scan beats anything cleverer */
+  uint8_t upper = 1;
+  while (table->points[upper].temperature < temperature) {
+    upper++;
+  }
+  const mpu6050_gyro_bias_point_t *low  = &table->points[upper - 1];
+  const mpu6050_gyro_bias_point_t *high = &table->points[upper];
+  float t = (temperature - low->temperature) / (high->temperature - low->temperature);
+  bias->bias_x = low->bias_x + t * (high->bias_x - low->bias_x);
+  bias->bias_y = low->bias_y + t * (high->bias_y - low->bias_y);
+  bias->bias_z = low->bias_z + t * (high->bias_z - low->bias_z);
+}
+
+bool mpu6050_gyro_bias_add(mpu6050_gyro_bias_table_t *table, const mpu6050_gyro_bias_point_t *point)
+{
+  if (!priv_point_is_finite(point)) {
+    return false;
+  }
+
+  /* Replace the nearest point if it is close, or if there is no room left */
+  uint8_t nearest       = 0;
+  float   nearest_delta = INFINITY;
+  for (uint8_t i = 0; i < table->count; i++) {
+    float delta = fabsf(table->points[i].temperature - point->temperature);
+    if (delta < nearest_delta) {
+      nearest       = i;
+      nearest_delta = delta;
+    }
+  }
+  if (table->count > 0 &&
+      (nearest_delta < MPU6050_GYRO_BIAS_MERGE_C || table->count == MPU6050_GYRO_BIAS_POINTS)) {
+    memmove(&table->points[nearest], &table->points[nearest + 1],
+            (size_t)(table->count - nearest - 1) * sizeof(table->points[0]));
+    table->count--;
+  }
+
+  uint8_t slot = 0;
+  while (slot < table->count && table->points[slot].temperature < point->temperature) {
+    slot++;
+  }
+  memmove(&table->points[slot + 1], &table->points[slot],
+          (size_t)(table->count - slot) * sizeof(table->points[0]));
+  table->points[slot] = *point;
+  table->count++;
+  return true;
+}
+
+bool mpu6050_gyro_bias_is_valid(const mpu6050_gyro_bias_table_t *table)
+{
+  if (table->count > MPU6050_GYRO_BIAS_POINTS) {
+    return false;
+  }
+  for (uint8_t i = 0; i < table->count; i++) {
+    if (!priv_point_is_finite(&table->points[i])) {
+      return false;
+    }
+    if (i > 0 && !(table->points[i].temperature > table->points[i - 1].temperature)) {
+      return false;
+    }
+  }
+  return true;
+}
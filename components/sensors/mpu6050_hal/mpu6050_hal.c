@@ -1,13 +1,16 @@
 /* components/sensors/mpu6050_hal/mpu6050_hal.c */
 
 /* TODO: The values retrieved from this sensor seems a bit sus, needs to be configured a bit better */
-/* TODO: Implement the interrupt handler and use GPIO_NUM_26 */
 
 #include "mpu6050_hal.h"
 #include <math.h>
-#include "file_write_manager.h"
+#include "nvs.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "common/i2c.h"
 #include "driver/gpio.h"
 #include "error_handler.h"
@@ -22,9 +25,13 @@ const uint8_t    mpu6050_scl_io             = GPIO_NUM_22;
 const uint8_t    mpu6050_sda_io             = GPIO_NUM_21;
 const uint32_t   mpu6050_i2c_freq_hz        = 100000;
 const uint32_t   mpu6050_polling_rate_ticks = pdMS_TO_TICKS(20);
-const uint8_t    mpu6050_sample_rate_div    = 4;
+const uint8_t    mpu6050_sample_rate_div    = 4; /* 200 Hz with the DLPF on, past ~500 Hz the FIFO reads need a 400 kHz bus */
 const uint8_t    mpu6050_config_dlpf        = k_mpu6050_config_dlpf_94hz;
 const uint8_t    mpu6050_int_io             = GPIO_NUM_26;
+const bool       mpu6050_fifo_enabled       = true;
+const uint8_t    mpu6050_fifo_watermark     = 10; /* 50 ms batches at the 200 Hz sample rate */
+const char      *mpu6050_nvs_namespace      = "mpu6050";
+const float      mpu6050_cal_max_noise_dps  = 0.5f; /* About 10x the datasheet's rate noise at the 94 Hz DLPF */
 
 /**
  * @brief Static constant array of accelerometer configurations and scaling factors.
@@ -84,14 +91,47 @@ static const uint8_t   mpu6050_gyro_config_idx  = 1; /**< Using ±500°/s for be
 static const uint8_t   mpu6050_accel_config_idx = 1; /**< Using ±4g for better precision in normal use */
 static error_handler_t s_mpu6050_error_handler  = { 0 };
 
+/* Globals (Static) ***********************************************************/
+
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_mpu6050_json_fields[] = {
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_x, "accel_x", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_y, "accel_y", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_z, "accel_z", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_x,  "gyro_x", 3),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_y,  "gyro_y", 3),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_z,  "gyro_z", 3),
+};
+static const json_schema_t s_mpu6050_json_schema   = JSON_SCHEMA("accelerometer_gyroscope", s_mpu6050_json_fields);
+
+/* Data ready pulses since the FIFO was last reset, and the time of the latest one, written by the ISR */
+static portMUX_TYPE         s_mpu6050_int_lock    = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t             s_mpu6050_int_count   = 0;
+static int64_t              s_mpu6050_int_time_us = 0;
+
+/* FIFO acquisition, only touched by the MPU6050 task apart from the stats */
+static bool                 s_mpu6050_fifo_running = false;
+static uint32_t             s_mpu6050_fifo_read    = 0; /* Frames read since the FIFO was last reset */
+static mpu6050_fifo_stats_t s_mpu6050_fifo_stats   = { 0 };
+static portMUX_TYPE         s_mpu6050_stats_lock   = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t              s_mpu6050_fifo_frames[MPU6050_FIFO_MAX_FRAMES * MPU6050_FRAME_SIZE];
+static mpu6050_sample_t     s_mpu6050_batch[MPU6050_FIFO_MAX_FRAMES];
+
+/* Gyro bias over temperature, loaded from NVS by mpu6050_init and copied out per read */
+static mpu6050_gyro_bias_table_t s_mpu6050_gyro_bias      = { 0 };
+static portMUX_TYPE              s_mpu6050_gyro_bias_lock = portMUX_INITIALIZER_UNLOCKED;
+static const char               *s_mpu6050_gyro_bias_key  = "gyro_bias";
+
 /* Static (Private) Functions **************************************************/
 
 /**
  * @brief Interrupt Service Routine (ISR) for handling MPU6050 data ready interrupts.
  *
  * This function is called when the MPU6050 asserts its INT pin, indicating that new data
- * is ready to be read. It gives the `data_ready_sem` semaphore to unblock the task waiting
- * to read the data.
+ * is ready to be read. It records the time of the pulse and gives the `data_ready_sem`
+ * semaphore to unblock the task waiting to read the data. With the FIFO running the
+ * semaphore is only given once every `mpu6050_fifo_watermark` pulses: the MPU6050 has
+ * no FIFO level interrupt, so the watermark is counted here.
  *
  * @param[in] arg Pointer to the `mpu6050_data_t` structure.
  *
@@ -102,6 +142,16 @@ static void IRAM_ATTR priv_mpu6050_interrupt_handler(void *arg)
 {
   mpu6050_data_t *sensor_data              = (mpu6050_data_t *)arg;
   BaseType_t      xHigherPriorityTaskWoken = pdFALSE;
+  int64_t         now_us                   = esp_timer_get_time();
+
+  portENTER_CRITICAL_ISR(&s_mpu6050_int_lock);
+  uint32_t pulses       = ++s_mpu6050_int_count;
+  s_mpu6050_int_time_us = now_us;
+  portEXIT_CRITICAL_ISR(&s_mpu6050_int_lock);
+
+  if (s_mpu6050_fifo_running && pulses % mpu6050_fifo_watermark != 0) {
+    return;
+  }
 
   /* Give the semaphore to signal that data is ready */
   xSemaphoreGiveFromISR(sensor_data->data_ready_sem, &xHigherPriorityTaskWoken);
@@ -111,85 +161,241 @@ static void IRAM_ATTR priv_mpu6050_interrupt_handler(void *arg)
   }
 }
 
-/* Public Functions ***********************************************************/
+/**
+ * @brief Returns the time between two samples, as set by the DLPF and the sample rate divider.
+ */
+static uint32_t priv_mpu6050_sample_period_us(void)
+{
+  /* The gyro output rate is 8 kHz with the DLPF off (settings 0 and 7), 1 kHz otherwise */
+  bool     dlpf_off    = mpu6050_config_dlpf == k_mpu6050_config_dlpf_260hz || mpu6050_config_dlpf == 7;
+  uint32_t gyro_period = dlpf_off ? 125 : 1000;
+  return gyro_period * (1 + (uint32_t)mpu6050_sample_rate_div);
+}
 
-char *mpu6050_data_to_json(const mpu6050_data_t *data)
+/**
+ * @brief Returns the sensitivities of the configured full-scale ranges.
+ */
+static mpu6050_frame_scale_t priv_mpu6050_frame_scale(void)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(mpu6050_tag, 
-              "JSON Creation Failed", 
-              "Memory allocation failed while creating JSON object");
-    return NULL;
-  }
+  mpu6050_frame_scale_t scale = {
+    .accel_lsb_per_g  = mpu6050_accel_configs[mpu6050_accel_config_idx].accel_scale,
+    .gyro_lsb_per_dps = mpu6050_gyro_configs[mpu6050_gyro_config_idx].gyro_scale,
+  };
+  return scale;
+}
 
-  if (!cJSON_AddStringToObject(json, "sensor_type", "accelerometer_gyroscope")) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
+/**
+ * @brief Loads the gyro bias table from NVS, leaving it empty if there is none.
+ */
+static void priv_mpu6050_load_calibration(void)
+{
+  mpu6050_gyro_bias_table_t stored = { 0 };
+  size_t                    length = sizeof(stored);
+  bool                      loaded = false;
+  nvs_handle_t              handle;
 
-  if (!cJSON_AddNumberToObject(json, "accel_x", data->accel_x)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add accel_x field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  if (nvs_open(mpu6050_nvs_namespace, NVS_READONLY, &handle) == ESP_OK) {
+    loaded = nvs_get_blob(handle, s_mpu6050_gyro_bias_key, &stored, &length) == ESP_OK &&
+             length == sizeof(stored);
+    nvs_close(handle);
   }
 
-  if (!cJSON_AddNumberToObject(json, "accel_y", data->accel_y)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add accel_y field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  if (loaded && !mpu6050_gyro_bias_is_valid(&stored)) {
+    log_warn(mpu6050_tag,
+             "Calibration",
+             "Ignoring invalid gyro bias table in NVS");
+    loaded = false;
   }
-
-  if (!cJSON_AddNumberToObject(json, "accel_z", data->accel_z)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add accel_z field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  if (!loaded) {
+    log_info(mpu6050_tag,
+             "Calibration",
+             "No gyro bias table stored, gyro rates are not bias corrected");
+    return;
   }
 
-  if (!cJSON_AddNumberToObject(json, "gyro_x", data->gyro_x)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add gyro_x field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  portENTER_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  s_mpu6050_gyro_bias = stored;
+  portEXIT_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  log_info(mpu6050_tag,
+           "Calibration",
+           "Loaded gyro bias table with %u temperatures",
+           stored.count);
+}
+
+/**
+ * @brief Reads the 14 data registers from ACCEL_XOUT_H in one transaction.
+ *
+ * @param[in]  sensor_data Sensor to read.
+ * @param[out] frame       `MPU6050_FRAME_SIZE` bytes.
+ */
+static esp_err_t priv_mpu6050_read_frame(const mpu6050_data_t *sensor_data, uint8_t *frame)
+{
+  return priv_i2c_read_reg_bytes(k_mpu6050_accel_xout_h_cmd,
+                                 frame,
+                                 MPU6050_FRAME_SIZE,
+                                 sensor_data->i2c_bus,
+                                 sensor_data->i2c_address,
+                                 mpu6050_tag);
+}
+
+/**
+ * @brief Empties the FIFO and restarts the watermark count.
+ *
+ * The FIFO only resets while it is disabled, so it is disabled, reset and
+ * enabled again.
+ */
+static esp_err_t priv_mpu6050_fifo_reset(mpu6050_data_t *sensor_data)
+{
+  esp_err_t ret = priv_i2c_write_reg_byte(k_mpu6050_user_ctrl_cmd,
+                                          k_mpu6050_user_ctrl_fifo_reset,
+                                          sensor_data->i2c_bus,
+                                          sensor_data->i2c_address,
+                                          mpu6050_tag);
+  if (ret == ESP_OK) {
+    ret = priv_i2c_write_reg_byte(k_mpu6050_user_ctrl_cmd,
+                                  k_mpu6050_user_ctrl_fifo_enable,
+                                  sensor_data->i2c_bus,
+                                  sensor_data->i2c_address,
+                                  mpu6050_tag);
+  }
+  if (ret != ESP_OK) {
+    log_error(mpu6050_tag,
+              "FIFO Error",
+              "Failed to reset the MPU6050 FIFO: %s",
+              esp_err_to_name(ret));
+    return ret;
   }
 
-  if (!cJSON_AddNumberToObject(json, "gyro_y", data->gyro_y)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add gyro_y field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  portENTER_CRITICAL(&s_mpu6050_int_lock);
+  s_mpu6050_int_count = 0;
+  portEXIT_CRITICAL(&s_mpu6050_int_lock);
+  s_mpu6050_fifo_read = 0;
+  return ESP_OK;
+}
+
+/**
+ * @brief Routes accel, temperature and gyro samples into the FIFO and starts it.
+ */
+static esp_err_t priv_mpu6050_fifo_start(mpu6050_data_t *sensor_data)
+{
+  esp_err_t ret = priv_i2c_write_reg_byte(k_mpu6050_fifo_en_cmd,
+                                          k_mpu6050_fifo_en_frame,
+                                          sensor_data->i2c_bus,
+                                          sensor_data->i2c_address,
+                                          mpu6050_tag);
+  if (ret != ESP_OK) {
+    log_error(mpu6050_tag,
+              "FIFO Error",
+              "Failed to select the MPU6050 FIFO contents");
+    return ret;
   }
 
-  if (!cJSON_AddNumberToObject(json, "gyro_z", data->gyro_z)) {
-    log_error(mpu6050_tag, 
-              "JSON Field Error", 
-              "Failed to add gyro_z field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
+  ret = priv_mpu6050_fifo_reset(sensor_data);
+  if (ret != ESP_OK) {
+    return ret;
   }
 
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(mpu6050_tag, 
-              "JSON Serialization Failed", 
-              "Unable to convert JSON object to string format");
-    cJSON_Delete(json);
-    return NULL;
+  s_mpu6050_fifo_running = true;
+  log_info(mpu6050_tag,
+           "FIFO Started",
+           "Reading batches of %u samples taken every %lu us",
+           mpu6050_fifo_watermark,
+           (unsigned long)priv_mpu6050_sample_period_us());
+  return ESP_OK;
+}
+
+/**
+ * @brief Task loop of the FIFO acquisition, never returns.
+ *
+ * Sleeps until the ISR counted `mpu6050_fifo_watermark` samples, then reads
+ * the FIFO and hands the batch on. Should the INT pin stay silent, e.g. when
+ * it is not wired, the FIFO is read after twice the expected batch time.
+ */
+static void priv_mpu6050_fifo_tasks(mpu6050_data_t *mpu6050_data)
+{
+  uint32_t   sample_period_us = priv_mpu6050_sample_period_us();
+  TickType_t batch_timeout    = pdMS_TO_TICKS(2 * mpu6050_fifo_watermark * sample_period_us / 1000) + 1;
+  bool       int_warned       = false;
+  uint32_t   dropped_total    = 0; /* Lost since the last batch, reported with the next one */
+
+  while (1) {
+    bool     late    = xSemaphoreTake(mpu6050_data->data_ready_sem, batch_timeout) != pdTRUE;
+    uint16_t count   = 0;
+    uint32_t dropped = 0;
+    if (mpu6050_read_fifo(mpu6050_data, s_mpu6050_batch, &count, &dropped) != ESP_OK) {
+      mpu6050_reset_on_error(mpu6050_data);
+      vTaskDelay(mpu6050_polling_rate_ticks);
+      continue;
+    }
+    dropped_total += dropped;
+    if (count == 0) {
+      continue;
+    }
+
+    if (late) {
+      portENTER_CRITICAL(&s_mpu6050_stats_lock);
+      s_mpu6050_fifo_stats.late_batches++;
+      portEXIT_CRITICAL(&s_mpu6050_stats_lock);
+      if (!int_warned) {
+        log_warn(mpu6050_tag,
+                 "INT Timeout",
+                 "No data ready interrupt on GPIO %u, reading the FIFO on a timer instead",
+                 mpu6050_int_io);
+        int_warned = true;
+      }
+    }
+
+    mpu6050_batch_t batch = {
+      .samples          = s_mpu6050_batch,
+      .count            = count,
+      .sample_period_us = sample_period_us,
+      .dropped          = dropped_total,
+    };
+    dropped_total = 0;
+    mpu6050_batch_callback_t callback = mpu6050_data->batch_callback;
+    if (callback != NULL) {
+      callback(&batch, mpu6050_data->batch_context);
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+      const mpu6050_sample_t *sample = &s_mpu6050_batch[i];
+      float values[] = {
+        sample->accel_x,
+        sample->accel_y,
+        sample->accel_z,
+        sample->gyro_x,
+        sample->gyro_y,
+        sample->gyro_z,
+        sample->temperature,
+      };
+      sensor_log_write(k_sensor_record_mpu6050, sample->timestamp_us, values);
+      sensor_history_insert(k_sensor_record_mpu6050, sample->timestamp_us, values);
+      /* Every sample goes into the history, only the newest is published so subscribers wake once per batch */
+      if (i == count - 1) {
+        sensor_bus_publish(k_sensor_record_mpu6050, sample->timestamp_us, values);
+      }
+    }
+
+    /* The web server gets the newest sample of each batch, every sample would only fill its queue */
+    char json[SENSOR_JSON_PAYLOAD_SIZE];
+    if (mpu6050_data_to_json_buf(mpu6050_data, json, sizeof(json), NULL) == ESP_OK) {
+      send_sensor_data_to_webserver(json);
+    } else {
+      log_error(mpu6050_tag, "JSON Error", "Failed to convert sensor data to JSON format");
+    }
   }
+}
 
-  cJSON_Delete(json);
-  return json_string;
+/* Public Functions ***********************************************************/
+
+esp_err_t mpu6050_data_to_json_buf(const mpu6050_data_t *data, char *buffer, size_t size, size_t *length)
+{
+  return sensor_json_write(&s_mpu6050_json_schema, data, buffer, size, length);
+}
+
+char *mpu6050_data_to_json(const mpu6050_data_t *data)
+{
+  return sensor_json_to_string(&s_mpu6050_json_schema, data);
 }
 
 esp_err_t mpu6050_init(void *sensor_data)
@@ -339,8 +545,12 @@ esp_err_t mpu6050_init(void *sensor_data)
     return ret;
   }
 
-  /* Create a binary semaphore for data readiness */
-  mpu6050_data->data_ready_sem = xSemaphoreCreateBinary();
+  priv_mpu6050_load_calibration();
+
+  /* Create a binary semaphore for data readiness, kept across reinitialization */
+  if (mpu6050_data->data_ready_sem == NULL) {
+    mpu6050_data->data_ready_sem = xSemaphoreCreateBinary();
+  }
   if (mpu6050_data->data_ready_sem == NULL) {
     log_error(mpu6050_tag, 
               "Memory Error", 
@@ -348,6 +558,19 @@ esp_err_t mpu6050_init(void *sensor_data)
     return ESP_FAIL;
   }
 
+  /* INT pin active high, push-pull, 50 us pulse per sample, so nothing has to be read to clear it */
+  ret = priv_i2c_write_reg_byte(k_mpu6050_int_pin_cfg_cmd,
+                                0x00,
+                                mpu6050_i2c_bus,
+                                mpu6050_i2c_address,
+                                mpu6050_tag);
+  if (ret != ESP_OK) {
+    log_error(mpu6050_tag,
+              "Interrupt Error",
+              "Failed to configure the MPU6050 INT pin");
+    return ret;
+  }
+
   /* Configure the MPU6050 to generate Data Ready interrupts */
   ret = priv_i2c_write_reg_byte(k_mpu6050_int_enable_cmd, 
                                 k_mpu6050_int_enable_data_rdy,
@@ -363,7 +586,7 @@ esp_err_t mpu6050_init(void *sensor_data)
 
   /* Configure the INT (interrupt) pin on the ESP32 */
   gpio_config_t io_conf = {
-    .intr_type     = GPIO_INTR_NEGEDGE, /* MPU6050 INT pin is active low */
+    .intr_type     = GPIO_INTR_POSEDGE, /* MPU6050 INT pin is active high, see INT_PIN_CFG above */
     .pin_bit_mask  = (1ULL << mpu6050_int_io),
     .mode          = GPIO_MODE_INPUT,
     .pull_up_en    = GPIO_PULLUP_DISABLE,
@@ -397,6 +620,14 @@ esp_err_t mpu6050_init(void *sensor_data)
     return ret;
   }
 
+  /* Collect samples in the FIFO, read in batches by mpu6050_tasks */
+  if (mpu6050_fifo_enabled) {
+    ret = priv_mpu6050_fifo_start(mpu6050_data);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+
   mpu6050_data->state = k_mpu6050_ready; /* Sensor is initialized */
   log_info(mpu6050_tag, 
            "Init Complete", 
@@ -404,73 +635,193 @@ esp_err_t mpu6050_init(void *sensor_data)
   return ESP_OK;
 }
 
-esp_err_t mpu6050_read(mpu6050_data_t *sensor_data)
+void mpu6050_register_batch_callback(mpu6050_data_t          *sensor_data,
+                                     mpu6050_batch_callback_t callback,
+                                     void                    *context)
 {
-  if (sensor_data == NULL) {
-    log_error(mpu6050_tag, 
-              "Invalid Parameter", 
-              "Sensor data pointer is NULL, cannot proceed with read operation");
+  sensor_data->batch_callback = NULL; /* Never call the new callback with the old context */
+  sensor_data->batch_context  = context;
+  sensor_data->batch_callback = callback;
+}
+
+esp_err_t mpu6050_read_fifo(mpu6050_data_t   *sensor_data,
+                            mpu6050_sample_t *samples,
+                            uint16_t         *count,
+                            uint32_t         *dropped)
+{
+  if (sensor_data == NULL || samples == NULL || count == NULL) {
+    log_error(mpu6050_tag,
+              "Invalid Parameter",
+              "NULL argument, cannot proceed with FIFO read");
     return ESP_FAIL;
   }
+  *count = 0;
+  if (dropped != NULL) {
+    *dropped = 0;
+  }
 
-  uint8_t accel_data[MPU6050_ACCEL_DATA_SIZE];
-  uint8_t gyro_data[MPU6050_GYRO_DATA_SIZE];
-  uint8_t temp[MPU6050_TEMP_DATA_SIZE]; /* TODO: Add temperature data */
+  /* The newest frame belongs to the latest data ready pulse, so the pulse
+   * must not change while the FIFO count is read */
+  uint8_t   count_data[2] = { 0 };
+  uint32_t  pulses        = 0;
+  uint32_t  pulses_after  = 0;
+  int64_t   pulse_time_us = 0;
+  int64_t   count_time_us = 0;
+  uint8_t   attempts      = 0;
+  esp_err_t ret           = ESP_OK;
+  do {
+    portENTER_CRITICAL(&s_mpu6050_int_lock);
+    pulses        = s_mpu6050_int_count;
+    pulse_time_us = s_mpu6050_int_time_us;
+    portEXIT_CRITICAL(&s_mpu6050_int_lock);
+
+    ret = priv_i2c_read_reg_bytes(k_mpu6050_fifo_count_h_cmd,
+                                  count_data,
+                                  sizeof(count_data),
+                                  sensor_data->i2c_bus,
+                                  sensor_data->i2c_address,
+                                  mpu6050_tag);
+    count_time_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mpu6050_int_lock);
+    pulses_after = s_mpu6050_int_count;
+    portEXIT_CRITICAL(&s_mpu6050_int_lock);
+  } while (ret == ESP_OK && pulses_after != pulses && ++attempts < 3);
 
-  /* Read accelerometer data starting from ACCEL_XOUT_H */
-  esp_err_t ret = priv_i2c_read_reg_bytes(k_mpu6050_accel_xout_h_cmd, 
-                                          accel_data, 
-                                          MPU6050_ACCEL_DATA_SIZE,
-                                          sensor_data->i2c_bus, 
-                                          sensor_data->i2c_address,
-                                          mpu6050_tag);
   if (ret != ESP_OK) {
-    log_error(mpu6050_tag, 
-              "Read Error", 
-              "Failed to read accelerometer data from MPU6050");
+    log_error(mpu6050_tag,
+              "Read Error",
+              "Failed to read FIFO count from MPU6050");
+    portENTER_CRITICAL(&s_mpu6050_stats_lock);
+    s_mpu6050_fifo_stats.read_errors++;
+    portEXIT_CRITICAL(&s_mpu6050_stats_lock);
     sensor_data->state = k_mpu6050_error;
     return ESP_FAIL;
   }
 
-  /* Read gyroscope data starting from GYRO_XOUT_H */
-  ret = priv_i2c_read_reg_bytes(k_mpu6050_gyro_xout_h_cmd, 
-                                gyro_data, 
-                                MPU6050_GYRO_DATA_SIZE,
-                                sensor_data->i2c_bus, 
-                                sensor_data->i2c_address, 
+  uint16_t fifo_bytes = (uint16_t)((count_data[0] << 8) | count_data[1]);
+  if (fifo_bytes >= MPU6050_FIFO_SIZE) {
+    /* A full FIFO keeps overwriting its oldest bytes, so it is no longer frame
+     * aligned. Every pulse that was not read is lost, without pulses at least
+     * what is in the FIFO is. */
+    uint32_t lost = fifo_bytes / MPU6050_FRAME_SIZE;
+    if (pulses > s_mpu6050_fifo_read + lost) {
+      lost = pulses - s_mpu6050_fifo_read;
+    }
+    log_warn(mpu6050_tag,
+             "FIFO Overflow",
+             "MPU6050 FIFO overflowed, dropping %lu samples",
+             (unsigned long)lost);
+    portENTER_CRITICAL(&s_mpu6050_stats_lock);
+    s_mpu6050_fifo_stats.overflows++;
+    s_mpu6050_fifo_stats.dropped += lost;
+    portEXIT_CRITICAL(&s_mpu6050_stats_lock);
+    if (dropped != NULL) {
+      *dropped = lost;
+    }
+    if (priv_mpu6050_fifo_reset(sensor_data) != ESP_OK) {
+      sensor_data->state = k_mpu6050_error;
+      return ESP_FAIL;
+    }
+    return ESP_OK;
+  }
+
+  uint16_t frames = fifo_bytes / MPU6050_FRAME_SIZE;
+  if (frames == 0) {
+    return ESP_OK;
+  }
+
+  /* All queued frames in one transaction */
+  ret = priv_i2c_read_reg_bytes(k_mpu6050_fifo_r_w_cmd,
+                                s_mpu6050_fifo_frames,
+                                frames * MPU6050_FRAME_SIZE,
+                                sensor_data->i2c_bus,
+                                sensor_data->i2c_address,
                                 mpu6050_tag);
   if (ret != ESP_OK) {
-    log_error(mpu6050_tag, 
-              "Read Error", 
-              "Failed to read gyroscope data from MPU6050");
+    log_error(mpu6050_tag,
+              "Read Error",
+              "Failed to read %u FIFO frames from MPU6050",
+              frames);
+    portENTER_CRITICAL(&s_mpu6050_stats_lock);
+    s_mpu6050_fifo_stats.read_errors++;
+    portEXIT_CRITICAL(&s_mpu6050_stats_lock);
+    /* Part of the frames may have been consumed, realign on an empty FIFO */
+    priv_mpu6050_fifo_reset(sensor_data);
     sensor_data->state = k_mpu6050_error;
     return ESP_FAIL;
   }
 
-  /* Combine high and low bytes to form the raw accelerometer data */
-  int16_t accel_x_raw = (int16_t)((accel_data[0] << 8) | accel_data[1]);
-  int16_t accel_y_raw = (int16_t)((accel_data[2] << 8) | accel_data[3]);
-  int16_t accel_z_raw = (int16_t)((accel_data[4] << 8) | accel_data[5]);
+  /* Without any pulse, e.g. with the INT pin not wired, the time of the count is the best estimate */
+  uint32_t                  sample_period_us = priv_mpu6050_sample_period_us();
+  int64_t                   newest_us        = pulses != 0 ? pulse_time_us : count_time_us;
+  mpu6050_frame_scale_t     scale            = priv_mpu6050_frame_scale();
+  mpu6050_gyro_bias_table_t bias;
+  mpu6050_get_gyro_bias_table(&bias);
+  for (uint16_t i = 0; i < frames; i++) {
+    mpu6050_frame_decode(&s_mpu6050_fifo_frames[i * MPU6050_FRAME_SIZE], &scale, &bias, &samples[i]);
+    samples[i].timestamp_us = newest_us - (int64_t)(frames - 1 - i) * sample_period_us;
+  }
 
-  /* Combine high and low bytes to form the raw gyroscope data */
-  int16_t gyro_x_raw = (int16_t)((gyro_data[0] << 8) | gyro_data[1]);
-  int16_t gyro_y_raw = (int16_t)((gyro_data[2] << 8) | gyro_data[3]);
-  int16_t gyro_z_raw = (int16_t)((gyro_data[4] << 8) | gyro_data[5]);
+  const mpu6050_sample_t *newest = &samples[frames - 1];
+  sensor_data->accel_x     = newest->accel_x;
+  sensor_data->accel_y     = newest->accel_y;
+  sensor_data->accel_z     = newest->accel_z;
+  sensor_data->gyro_x      = newest->gyro_x;
+  sensor_data->gyro_y      = newest->gyro_y;
+  sensor_data->gyro_z      = newest->gyro_z;
+  sensor_data->temperature = newest->temperature;
+  sensor_data->state       = k_mpu6050_data_updated;
 
-  /* Convert raw data to physical units by dividing by sensitivity */
-  float accel_sensitivity = mpu6050_accel_configs[mpu6050_accel_config_idx].accel_scale;
-  float gyro_sensitivity  = mpu6050_gyro_configs[mpu6050_gyro_config_idx].gyro_scale;
+  portENTER_CRITICAL(&s_mpu6050_stats_lock);
+  s_mpu6050_fifo_stats.samples += frames;
+  s_mpu6050_fifo_stats.batches++;
+  portEXIT_CRITICAL(&s_mpu6050_stats_lock);
 
-  /* Calculate new values */
-  float new_accel_x = accel_x_raw / accel_sensitivity;
-  float new_accel_y = accel_y_raw / accel_sensitivity;
-  float new_accel_z = accel_z_raw / accel_sensitivity;
-  float new_gyro_x  = gyro_x_raw / gyro_sensitivity;
-  float new_gyro_y  = gyro_y_raw / gyro_sensitivity;
-  float new_gyro_z  = gyro_z_raw / gyro_sensitivity;
+  s_mpu6050_fifo_read += frames;
+  *count               = frames;
+  return ESP_OK;
+}
+
+void mpu6050_get_fifo_stats(mpu6050_fifo_stats_t *stats)
+{
+  if (stats == NULL) {
+    return;
+  }
+  portENTER_CRITICAL(&s_mpu6050_stats_lock);
+  *stats = s_mpu6050_fifo_stats;
+  portEXIT_CRITICAL(&s_mpu6050_stats_lock);
+}
+
+esp_err_t mpu6050_read_sample(mpu6050_data_t *sensor_data, mpu6050_sample_t *sample)
+{
+  if (sensor_data == NULL || sample == NULL) {
+    log_error(mpu6050_tag, 
+              "Invalid Parameter", 
+              "Sensor data pointer is NULL, cannot proceed with read operation");
+    return ESP_FAIL;
+  }
+
+  /* Accel, temperature and gyro in one burst, all from the same sampling instant */
+  uint8_t   frame[MPU6050_FRAME_SIZE];
+  int64_t   read_time_us = esp_timer_get_time();
+  esp_err_t ret          = priv_mpu6050_read_frame(sensor_data, frame);
+  if (ret != ESP_OK) {
+    log_error(mpu6050_tag, 
+              "Read Error", 
+              "Failed to read accelerometer, temperature and gyroscope data from MPU6050");
+    sensor_data->state = k_mpu6050_error;
+    return ESP_FAIL;
+  }
+
+  mpu6050_frame_scale_t     scale = priv_mpu6050_frame_scale();
+  mpu6050_gyro_bias_table_t bias;
+  mpu6050_get_gyro_bias_table(&bias);
+  mpu6050_frame_decode(frame, &scale, &bias, sample);
+  sample->timestamp_us = read_time_us;
 
   /* Validate accelerometer readings (should be within ±4g range) */
-  if (fabsf(new_accel_x) > 4.0f || fabsf(new_accel_y) > 4.0f || fabsf(new_accel_z) > 4.0f) {
+  if (fabsf(sample->accel_x) > 4.0f || fabsf(sample->accel_y) > 4.0f || fabsf(sample->accel_z) > 4.0f) {
     log_warn(mpu6050_tag, 
              "Range Error", 
              "Accelerometer readings exceed ±4g measurement range");
@@ -479,7 +830,7 @@ esp_err_t mpu6050_read(mpu6050_data_t *sensor_data)
   }
 
   /* Validate gyroscope readings (should be within ±500°/s range) */
-  if (fabsf(new_gyro_x) > 500.0f || fabsf(new_gyro_y) > 500.0f || fabsf(new_gyro_z) > 500.0f) {
+  if (fabsf(sample->gyro_x) > 500.0f || fabsf(sample->gyro_y) > 500.0f || fabsf(sample->gyro_z) > 500.0f) {
     log_warn(mpu6050_tag, 
              "Range Error", 
              "Gyroscope readings exceed ±500°/s measurement range");
@@ -488,27 +839,157 @@ esp_err_t mpu6050_read(mpu6050_data_t *sensor_data)
   }
 
   /* Update sensor data with validated readings */
-  sensor_data->accel_x = new_accel_x;
-  sensor_data->accel_y = new_accel_y;
-  sensor_data->accel_z = new_accel_z;
-  sensor_data->gyro_x  = new_gyro_x;
-  sensor_data->gyro_y  = new_gyro_y;
-  sensor_data->gyro_z  = new_gyro_z;
+  sensor_data->accel_x     = sample->accel_x;
+  sensor_data->accel_y     = sample->accel_y;
+  sensor_data->accel_z     = sample->accel_z;
+  sensor_data->gyro_x      = sample->gyro_x;
+  sensor_data->gyro_y      = sample->gyro_y;
+  sensor_data->gyro_z      = sample->gyro_z;
+  sensor_data->temperature = sample->temperature;
 
-  log_info(mpu6050_tag, 
-           "Data Updated", 
-           "Accel: [%f, %f, %f] g, Gyro: [%f, %f, %f] °/s",
-           sensor_data->accel_x, 
-           sensor_data->accel_y, 
-           sensor_data->accel_z,
-           sensor_data->gyro_x, 
-           sensor_data->gyro_y, 
-           sensor_data->gyro_z);
+  log_debug(mpu6050_tag, 
+            "Data Updated", 
+            "Accel: [%f, %f, %f] g, Gyro: [%f, %f, %f] °/s, Temp: %f °C",
+            sensor_data->accel_x, 
+            sensor_data->accel_y, 
+            sensor_data->accel_z,
+            sensor_data->gyro_x, 
+            sensor_data->gyro_y, 
+            sensor_data->gyro_z,
+            sensor_data->temperature);
 
   sensor_data->state = k_mpu6050_data_updated;
   return ESP_OK;
 }
 
+esp_err_t mpu6050_read(mpu6050_data_t *sensor_data)
+{
+  mpu6050_sample_t sample;
+  return mpu6050_read_sample(sensor_data, &sample);
+}
+
+esp_err_t mpu6050_calibrate_gyro(mpu6050_data_t *sensor_data, uint16_t sample_count)
+{
+  if (sensor_data == NULL || sample_count < 10) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  /* One reading per sample period, raw rates without any bias removed */
+  TickType_t            sample_delay = pdMS_TO_TICKS(priv_mpu6050_sample_period_us() / 1000);
+  mpu6050_frame_scale_t scale        = priv_mpu6050_frame_scale();
+  double                sum[4]       = { 0 };
+  double                sum_sq[3]    = { 0 };
+  if (sample_delay == 0) {
+    sample_delay = 1;
+  }
+
+  log_info(mpu6050_tag,
+           "Calibration",
+           "Measuring gyro bias over %u samples, keep the robot still",
+           sample_count);
+  for (uint16_t i = 0; i < sample_count; i++) {
+    uint8_t          frame[MPU6050_FRAME_SIZE];
+    mpu6050_sample_t sample;
+    if (priv_mpu6050_read_frame(sensor_data, frame) != ESP_OK) {
+      log_error(mpu6050_tag,
+                "Calibration",
+                "Failed to read MPU6050 during gyro calibration");
+      return ESP_FAIL;
+    }
+    mpu6050_frame_decode(frame, &scale, NULL, &sample);
+    sum[0]    += sample.gyro_x;
+    sum[1]    += sample.gyro_y;
+    sum[2]    += sample.gyro_z;
+    sum[3]    += sample.temperature;
+    sum_sq[0] += (double)sample.gyro_x * sample.gyro_x;
+    sum_sq[1] += (double)sample.gyro_y * sample.gyro_y;
+    sum_sq[2] += (double)sample.gyro_z * sample.gyro_z;
+    vTaskDelay(sample_delay);
+  }
+
+  mpu6050_gyro_bias_point_t point = {
+    .temperature = (float)(sum[3] / sample_count),
+    .bias_x      = (float)(sum[0] / sample_count),
+    .bias_y      = (float)(sum[1] / sample_count),
+    .bias_z      = (float)(sum[2] / sample_count),
+  };
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    double mean     = sum[axis] / sample_count;
+    double variance = sum_sq[axis] / sample_count - mean * mean;
+    if (variance > (double)mpu6050_cal_max_noise_dps * mpu6050_cal_max_noise_dps) {
+      log_warn(mpu6050_tag,
+               "Calibration",
+               "Gyro calibration rejected, axis %u deviates by %.2f °/s: the robot moved",
+               axis,
+               sqrt(variance));
+      return ESP_ERR_INVALID_STATE;
+    }
+  }
+
+  portENTER_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  mpu6050_gyro_bias_add(&s_mpu6050_gyro_bias, &point);
+  uint8_t count = s_mpu6050_gyro_bias.count;
+  portEXIT_CRITICAL(&s_mpu6050_gyro_bias_lock);
+
+  log_info(mpu6050_tag,
+           "Calibration",
+           "Gyro bias at %.1f °C: [%.3f, %.3f, %.3f] °/s, %u temperatures calibrated",
+           point.temperature,
+           point.bias_x,
+           point.bias_y,
+           point.bias_z,
+           count);
+  return ESP_OK;
+}
+
+esp_err_t mpu6050_set_gyro_bias_table(const mpu6050_gyro_bias_table_t *table)
+{
+  if (table == NULL || !mpu6050_gyro_bias_is_valid(table)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  portENTER_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  s_mpu6050_gyro_bias = *table;
+  portEXIT_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  return ESP_OK;
+}
+
+void mpu6050_get_gyro_bias_table(mpu6050_gyro_bias_table_t *table)
+{
+  if (table == NULL) {
+    return;
+  }
+  portENTER_CRITICAL(&s_mpu6050_gyro_bias_lock);
+  *table = s_mpu6050_gyro_bias;
+  portEXIT_CRITICAL(&s_mpu6050_gyro_bias_lock);
+}
+
+esp_err_t mpu6050_save_calibration(void)
+{
+  mpu6050_gyro_bias_table_t table;
+  mpu6050_get_gyro_bias_table(&table);
+
+  nvs_handle_t handle;
+  esp_err_t    ret = nvs_open(mpu6050_nvs_namespace, NVS_READWRITE, &handle);
+  if (ret == ESP_OK) {
+    ret = nvs_set_blob(handle, s_mpu6050_gyro_bias_key, &table, sizeof(table));
+    if (ret == ESP_OK) {
+      ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+
+  if (ret != ESP_OK) {
+    log_error(mpu6050_tag, 
+              "NVS Error", 
+              "Failed to save gyro bias table: %s", 
+              esp_err_to_name(ret));
+    return ret;
+  }
+
+  log_info(mpu6050_tag, "Calibration", "Saved gyro bias table with %u temperatures", table.count);
+  return ESP_OK;
+}
+
 void mpu6050_reset_on_error(mpu6050_data_t *sensor_data)
 {
   /* Check if the state indicates any error */
@@ -520,12 +1001,42 @@ void mpu6050_reset_on_error(mpu6050_data_t *sensor_data)
 void mpu6050_tasks(void *sensor_data)
 {
   mpu6050_data_t *mpu6050_data = (mpu6050_data_t *)sensor_data;
+  if (s_mpu6050_fifo_running) {
+    priv_mpu6050_fifo_tasks(mpu6050_data);
+  }
+
   while (1) {
-    if (mpu6050_read(mpu6050_data) == ESP_OK) {
-      char *json = mpu6050_data_to_json(mpu6050_data);
-      send_sensor_data_to_webserver(json);
-      file_write_enqueue("mpu6050.txt", json);
-      free(json);
+    mpu6050_sample_t sample;
+    if (mpu6050_read_sample(mpu6050_data, &sample) == ESP_OK) {
+      mpu6050_batch_callback_t callback = mpu6050_data->batch_callback;
+      if (callback != NULL) {
+        mpu6050_batch_t batch = {
+          .samples          = &sample,
+          .count            = 1,
+          .sample_period_us = pdTICKS_TO_MS(mpu6050_polling_rate_ticks) * 1000,
+          .dropped          = 0,
+        };
+        callback(&batch, mpu6050_data->batch_context);
+      }
+
+      float values[] = {
+        sample.accel_x,
+        sample.accel_y,
+        sample.accel_z,
+        sample.gyro_x,
+        sample.gyro_y,
+        sample.gyro_z,
+        sample.temperature,
+      };
+      sensor_log_write(k_sensor_record_mpu6050, sample.timestamp_us, values);
+      sensor_history_insert(k_sensor_record_mpu6050, sample.timestamp_us, values);
+      sensor_bus_publish(k_sensor_record_mpu6050, sample.timestamp_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (mpu6050_data_to_json_buf(mpu6050_data, json, sizeof(json), NULL) == ESP_OK) {
+        send_sensor_data_to_webserver(json);
+      } else {
+        log_error(mpu6050_tag, "JSON Error", "Failed to convert sensor data to JSON format");
+      }
     } else {
       mpu6050_reset_on_error(mpu6050_data);
     }
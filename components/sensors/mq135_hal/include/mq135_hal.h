@@ -71,6 +71,23 @@ typedef struct {
  */
 char *mq135_data_to_json(const mq135_data_t *data);
 
+/**
+ * @brief Writes MQ135 data as its JSON payload into a caller-provided buffer.
+ *
+ * Allocation-free counterpart of `mq135_data_to_json`, used by the sensor task.
+ *
+ * @param[in]  data   Pointer to the `mq135_data_t` structure with valid sensor data.
+ * @param[out] buffer Output, NUL-terminated.
+ * @param[in]  size   Bytes of `buffer`, `SENSOR_JSON_PAYLOAD_SIZE` always fits.
+ * @param[out] length Characters written without the NUL, may be NULL.
+ *
+ * @return
+ * - ESP_OK               on success.
+ * - ESP_ERR_INVALID_ARG  if an argument is NULL.
+ * - ESP_ERR_INVALID_SIZE if the payload does not fit `size`.
+ */
+esp_err_t mq135_data_to_json_buf(const mq135_data_t *data, char *buffer, size_t size, size_t *length);
+
 /**
  * @brief Initializes the MQ135 sensor.
  *
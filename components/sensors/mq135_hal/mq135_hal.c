@@ -2,9 +2,12 @@
 
 #include "mq135_hal.h"
 #include <math.h>
-#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "esp_adc/adc_oneshot.h"
 #include "driver/gpio.h"
 #include "error_handler.h"
@@ -26,6 +29,12 @@ const uint32_t mq135_max_backoff_interval   = pdMS_TO_TICKS(480000);
 static adc_oneshot_unit_handle_t s_adc1_handle         = { 0 }; /**< ADC handle for the MQ135 sensor. */
 static error_handler_t           s_mq135_error_handler = { 0 };
 
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_mq135_json_fields[] = {
+  JSON_FIELD_FLOAT(mq135_data_t, gas_concentration, "gas_concentration", 2),
+};
+static const json_schema_t s_mq135_json_schema   = JSON_SCHEMA("gas", s_mq135_json_fields);
+
 /* Static (Private) Functions **************************************************/
 
 /**
@@ -50,43 +59,14 @@ static float priv_mq135_calculate_ppm(int raw_adc_value)
 
 /* Public Functions ***********************************************************/
 
-char *mq135_data_to_json(const mq135_data_t *data)
+esp_err_t mq135_data_to_json_buf(const mq135_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(mq135_tag, 
-              "JSON Error", 
-              "Failed to allocate memory for JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "gas")) {
-    log_error(mq135_tag, 
-              "JSON Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "gas_concentration", data->gas_concentration)) {
-    log_error(mq135_tag, 
-              "JSON Error", 
-              "Failed to add gas_concentration field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(mq135_tag, 
-              "JSON Error", 
-              "Failed to serialize JSON object to string");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_mq135_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *mq135_data_to_json(const mq135_data_t *data)
+{
+  return sensor_json_to_string(&s_mq135_json_schema, data);
 }
 
 esp_err_t mq135_init(void *sensor_data)
@@ -150,9 +130,9 @@ esp_err_t mq135_read(mq135_data_t *sensor_data)
   mq135_data->raw_adc_value     = raw_adc;
   mq135_data->gas_concentration = priv_mq135_calculate_ppm(raw_adc);
 
-  log_info(mq135_tag, "Data Update", 
-           "New reading - Raw ADC: %u, Gas Concentration: %.2f ppm", 
-           raw_adc, mq135_data->gas_concentration);
+  log_debug(mq135_tag, "Data Update", 
+            "New reading - Raw ADC: %u, Gas Concentration: %.2f ppm", 
+            raw_adc, mq135_data->gas_concentration);
 
   mq135_data->state = k_mq135_ready;
   return ESP_OK;
@@ -199,11 +179,14 @@ void mq135_tasks(void *sensor_data)
 
   while (1) {
     if (mq135_read(mq135_data) == ESP_OK) {
-      char *json = mq135_data_to_json(mq135_data);
-      if (json) {
+      float values[] = { mq135_data->raw_adc_value, mq135_data->gas_concentration };
+      int64_t now_us = esp_timer_get_time();
+      sensor_log_write(k_sensor_record_mq135, now_us, values);
+      sensor_history_insert(k_sensor_record_mq135, now_us, values);
+      sensor_bus_publish(k_sensor_record_mq135, now_us, values);
+      char json[SENSOR_JSON_PAYLOAD_SIZE];
+      if (mq135_data_to_json_buf(mq135_data, json, sizeof(json), NULL) == ESP_OK) {
         send_sensor_data_to_webserver(json);
-        file_write_enqueue("mq135.txt", json);
-        free(json);
       } else {
         log_error(mq135_tag, 
                   "JSON Error", 
@@ -22,7 +22,8 @@ extern const uint8_t    qmc5883l_scl_io;                 /**< GPIO pin for I2C S
 extern const uint8_t    qmc5883l_sda_io;                 /**< GPIO pin for I2C Serial Data Line (SDA) for QMC5883L. */
 extern const gpio_num_t qmc5883l_drdy_pin;               /**< GPIO pin for Data Ready (DRDY) signal from QMC5883L. */
 extern const uint32_t   qmc5883l_i2c_freq_hz;            /**< I2C bus frequency for QMC5883L communication in Hz. */
-extern const uint32_t   qmc5883l_polling_rate_ticks;     /**< Polling rate for QMC5883L sensor reads in system ticks. */
+extern const uint32_t   qmc5883l_polling_rate_ticks;     /**< Interval between logged and uploaded QMC5883L samples in system ticks. */
+extern const uint32_t   qmc5883l_read_rate_ticks;        /**< Interval between QMC5883L reads in system ticks, each one is fused by the AHRS. */
 extern const uint8_t    qmc5883l_odr_setting;            /**< Output Data Rate (ODR) setting for the QMC5883L sensor. */
 extern const uint8_t    qmc5883l_max_retries;            /**< Maximum retry attempts for QMC5883L reinitialization. */
 extern const uint32_t   qmc5883l_initial_retry_interval; /**< Initial retry interval for QMC5883L reinitialization in ticks. */
@@ -145,6 +146,23 @@ typedef struct {
  */
 char *qmc5883l_data_to_json(const qmc5883l_data_t *data);
 
+/**
+ * @brief Writes QMC5883L data as its JSON payload into a caller-provided buffer.
+ *
+ * Allocation-free counterpart of `qmc5883l_data_to_json`, used by the sensor task.
+ *
+ * @param[in]  data   Pointer to the `qmc5883l_data_t` structure with valid sensor data.
+ * @param[out] buffer Output, NUL-terminated.
+ * @param[in]  size   Bytes of `buffer`, `SENSOR_JSON_PAYLOAD_SIZE` always fits.
+ * @param[out] length Characters written without the NUL, may be NULL.
+ *
+ * @return
+ * - ESP_OK               on success.
+ * - ESP_ERR_INVALID_ARG  if an argument is NULL.
+ * - ESP_ERR_INVALID_SIZE if the payload does not fit `size`.
+ */
+esp_err_t qmc5883l_data_to_json_buf(const qmc5883l_data_t *data, char *buffer, size_t size, size_t *length);
+
 /**
  * @brief Initializes the QMC5883L sensor in continuous measurement mode.
  *
@@ -200,14 +218,16 @@ void qmc5883l_reset_on_error(qmc5883l_data_t *sensor_data);
 /**
  * @brief Executes periodic tasks for the QMC5883L sensor.
  *
- * Periodically reads data and handles errors for the QMC5883L sensor. Uses
- * `qmc5883l_reset_on_error` for recovery. Intended to run in a FreeRTOS task.
+ * Reads the QMC5883L every `qmc5883l_read_rate_ticks` and hands each reading
+ * to the AHRS for its heading; every `qmc5883l_polling_rate_ticks` a reading
+ * is also logged and sent to the web server. Uses `qmc5883l_reset_on_error`
+ * for recovery. Intended to run in a FreeRTOS task.
  *
  * @param[in,out] sensor_data Pointer to the `qmc5883l_data_t` structure for managing
  *                            sensor data and error recovery.
  *
  * @note 
- * - Should run at intervals defined by `qmc5883l_polling_rate_ticks`.
+ * - Should run at intervals defined by `qmc5883l_read_rate_ticks`.
  * - Handles error recovery internally to maintain stable operation.
  */
 void qmc5883l_tasks(void *sensor_data);
@@ -2,9 +2,13 @@
 
 #include "qmc5883l_hal.h"
 #include <math.h>
-#include "file_write_manager.h"
+#include "ahrs.h"
+#include "sensor_log.h"
+#include "sensor_bus.h"
+#include "sensor_history.h"
+#include "esp_timer.h"
 #include "webserver_tasks.h"
-#include "cJSON.h"
+#include "sensor_json.h"
 #include "common/i2c.h"
 #include "error_handler.h"
 #include "log_handler.h"
@@ -19,6 +23,7 @@ const uint8_t    qmc5883l_sda_io                 = GPIO_NUM_21;
 const gpio_num_t qmc5883l_drdy_pin               = GPIO_NUM_18;
 const uint32_t   qmc5883l_i2c_freq_hz            = 100000;
 const uint32_t   qmc5883l_polling_rate_ticks     = pdMS_TO_TICKS(5 * 1000);
+const uint32_t   qmc5883l_read_rate_ticks        = pdMS_TO_TICKS(50);    /* 20 Hz, within the AHRS's 100 ms magnetometer age */
 const uint8_t    qmc5883l_odr_setting            = k_qmc5883l_odr_100hz;
 const uint8_t    qmc5883l_max_retries            = 4;
 const uint32_t   qmc5883l_initial_retry_interval = pdMS_TO_TICKS(15);
@@ -35,6 +40,15 @@ static const qmc5883l_scale_t qmc5883l_scale_configs[] = {
 static const uint8_t   qmc5883l_scale_config_idx = 0; /**< Index of chosen values (0 for ±2G, 1 for ±8G) */
 static error_handler_t s_qmc5883l_error_handler  = { 0 };
 
+/* Webserver payload, written in table order after "sensor_type" */
+static const json_field_t  s_qmc5883l_json_fields[] = {
+  JSON_FIELD_FLOAT(qmc5883l_data_t, mag_x,   "mag_x", 3),
+  JSON_FIELD_FLOAT(qmc5883l_data_t, mag_y,   "mag_y", 3),
+  JSON_FIELD_FLOAT(qmc5883l_data_t, mag_z,   "mag_z", 3),
+  JSON_FIELD_FLOAT(qmc5883l_data_t, heading, "heading", 2),
+};
+static const json_schema_t s_qmc5883l_json_schema   = JSON_SCHEMA("magnetometer", s_qmc5883l_json_fields);
+
 /* Private Functions **********************************************************/
 
 static esp_err_t priv_qmc5883l_configure_drdy_pin(void)
@@ -56,67 +70,14 @@ static bool priv_qmc5883l_is_data_ready(void)
 
 /* Public Functions ***********************************************************/
 
-char *qmc5883l_data_to_json(const qmc5883l_data_t *data)
+esp_err_t qmc5883l_data_to_json_buf(const qmc5883l_data_t *data, char *buffer, size_t size, size_t *length)
 {
-  cJSON *json = cJSON_CreateObject();
-  if (!json) {
-    log_error(qmc5883l_tag, 
-              "JSON Creation Failed", 
-              "Memory allocation failed while creating JSON object");
-    return NULL;
-  }
-
-  if (!cJSON_AddStringToObject(json, "sensor_type", "magnetometer")) {
-    log_error(qmc5883l_tag, 
-              "JSON Field Error", 
-              "Failed to add sensor_type field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "mag_x", data->mag_x)) {
-    log_error(qmc5883l_tag, 
-              "JSON Field Error", 
-              "Failed to add mag_x field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "mag_y", data->mag_y)) {
-    log_error(qmc5883l_tag, 
-              "JSON Field Error", 
-              "Failed to add mag_y field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "mag_z", data->mag_z)) {
-    log_error(qmc5883l_tag, 
-              "JSON Field Error", 
-              "Failed to add mag_z field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  if (!cJSON_AddNumberToObject(json, "heading", data->heading)) {
-    log_error(qmc5883l_tag, 
-              "JSON Field Error", 
-              "Failed to add heading field to JSON object");
-    cJSON_Delete(json);
-    return NULL;
-  }
-
-  char *json_string = cJSON_PrintUnformatted(json);
-  if (!json_string) {
-    log_error(qmc5883l_tag, 
-              "JSON Serialization Failed", 
-              "Unable to convert JSON object to string format");
-    cJSON_Delete(json);
-    return NULL;
-  }
+  return sensor_json_write(&s_qmc5883l_json_schema, data, buffer, size, length);
+}
 
-  cJSON_Delete(json);
-  return json_string;
+char *qmc5883l_data_to_json(const qmc5883l_data_t *data)
+{
+  return sensor_json_to_string(&s_qmc5883l_json_schema, data);
 }
 
 esp_err_t qmc5883l_init(void *sensor_data)
@@ -240,13 +201,13 @@ esp_err_t qmc5883l_read(qmc5883l_data_t *sensor_data)
   }
   sensor_data->heading = heading;
 
-  log_info(qmc5883l_tag, 
-           "Data Updated", 
-           "Magnetic field: [%f, %f, %f] µT, Heading: %.1f°",
-           sensor_data->mag_x, 
-           sensor_data->mag_y, 
-           sensor_data->mag_z,
-           sensor_data->heading);
+  log_debug(qmc5883l_tag, 
+            "Data Updated", 
+            "Magnetic field: [%f, %f, %f] µT, Heading: %.1f°",
+            sensor_data->mag_x, 
+            sensor_data->mag_y, 
+            sensor_data->mag_z,
+            sensor_data->heading);
 
   sensor_data->state = k_qmc5883l_data_updated;
   return ESP_OK;
@@ -280,15 +241,33 @@ void qmc5883l_reset_on_error(qmc5883l_data_t *sensor_data)
 void qmc5883l_tasks(void *sensor_data)
 {
   qmc5883l_data_t *qmc5883l_data = (qmc5883l_data_t *)sensor_data;
+  TickType_t       last_logged   = xTaskGetTickCount() - qmc5883l_polling_rate_ticks;
   while (1) {
     if (qmc5883l_read(qmc5883l_data) == ESP_OK) {
-      char *json = qmc5883l_data_to_json(qmc5883l_data);
-      send_sensor_data_to_webserver(json);
-      file_write_enqueue("qmc5883l.txt", json);
-      free(json);
+      int64_t now_us   = esp_timer_get_time();
+      float   values[] = {
+        qmc5883l_data->mag_x,
+        qmc5883l_data->mag_y,
+        qmc5883l_data->mag_z,
+        qmc5883l_data->heading,
+      };
+      ahrs_update_mag(now_us, qmc5883l_data->mag_x, qmc5883l_data->mag_y, qmc5883l_data->mag_z);
+      sensor_history_insert(k_sensor_record_qmc5883l, now_us, values);
+      sensor_bus_publish(k_sensor_record_qmc5883l, now_us, values);
+
+      if (xTaskGetTickCount() - last_logged >= qmc5883l_polling_rate_ticks) {
+        last_logged = xTaskGetTickCount();
+        sensor_log_write(k_sensor_record_qmc5883l, now_us, values);
+        char json[SENSOR_JSON_PAYLOAD_SIZE];
+        if (qmc5883l_data_to_json_buf(qmc5883l_data, json, sizeof(json), NULL) == ESP_OK) {
+          send_sensor_data_to_webserver(json);
+        } else {
+          log_error(qmc5883l_tag, "JSON Error", "Failed to convert sensor data to JSON format");
+        }
+      }
     } else {
       qmc5883l_reset_on_error(qmc5883l_data);
     }
-    vTaskDelay(qmc5883l_polling_rate_ticks);
+    vTaskDelay(qmc5883l_read_rate_ticks);
   }
 }
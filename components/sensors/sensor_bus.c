@@ -0,0 +1,171 @@
+/* components/sensors/sensor_bus.c */
+
+#include "sensor_bus.h"
+#include <string.h>
+#include "log_handler.h"
+
+/* Constants ******************************************************************/
+
+const char *sensor_bus_tag = "SENSOR_BUS";
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief Task woken by a sensor's publishes.
+ */
+typedef struct {
+  TaskHandle_t task; /**< Task to notify. */
+  uint32_t     bits; /**< Bits set in its notification value. */
+} sensor_bus_subscriber_t;
+
+/**
+ * @brief Latest sample of one sensor and who to wake for the next.
+ */
+typedef struct {
+  sensor_seqlock_t        seqlock;                                 /**< Guards sample. */
+  sensor_bus_sample_t     sample;                                  /**< Latest sample. */
+  _Atomic uint32_t        published;                               /**< Samples published, readable without the seqlock. */
+  _Atomic uint32_t        read_retries;                            /**< Reads that overlapped a publish. */
+  sensor_bus_subscriber_t subscribers[SENSOR_BUS_MAX_SUBSCRIBERS]; /**< Filled before subscriber_count is raised. */
+  _Atomic uint8_t         subscriber_count;                        /**< Entries publishers may read. */
+} sensor_bus_topic_t;
+
+/* Globals (Static) ***********************************************************/
+
+static sensor_bus_topic_t s_topics[k_sensor_record_type_count] = {
+  [0 ... k_sensor_record_type_count - 1] = { .seqlock = SENSOR_SEQLOCK_INITIALIZER },
+};
+
+static portMUX_TYPE s_subscribe_lock = portMUX_INITIALIZER_UNLOCKED; /* Serializes sensor_bus_subscribe */
+
+/* Public Functions ***********************************************************/
+
+void sensor_seqlock_write_begin(sensor_seqlock_t *seqlock)
+{
+  portENTER_CRITICAL(&seqlock->lock);
+  uint32_t sequence = atomic_load_explicit(&seqlock->sequence, memory_order_relaxed);
+  atomic_store_explicit(&seqlock->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+}
+
+void sensor_seqlock_write_end(sensor_seqlock_t *seqlock)
+{
+  uint32_t sequence = atomic_load_explicit(&seqlock->sequence, memory_order_relaxed);
+  atomic_store_explicit(&seqlock->sequence, sequence + 1, memory_order_release);
+  atomic_store_explicit(&seqlock->written, true, memory_order_release);
+  portEXIT_CRITICAL(&seqlock->lock);
+}
+
+bool sensor_seqlock_read(sensor_seqlock_t *seqlock,
+                         const void       *slot,
+                         void             *value,
+                         size_t            size,
+                         _Atomic uint32_t *retries)
+{
+  if (!atomic_load_explicit(&seqlock->written, memory_order_acquire)) {
+    return false;
+  }
+
+  while (true) {
+    uint32_t sequence = atomic_load_explicit(&seqlock->sequence, memory_order_acquire);
+    if ((sequence & 1) == 0) {
+      memcpy(value, slot, size);
+      atomic_thread_fence(memory_order_acquire);
+      if (atomic_load_explicit(&seqlock->sequence, memory_order_relaxed) == sequence) {
+        return true;
+      }
+    }
+    if (retries != NULL) {
+      atomic_fetch_add_explicit(retries, 1, memory_order_relaxed);
+    }
+  }
+}
+
+esp_err_t sensor_bus_publish(sensor_record_type_t type, int64_t timestamp_us, const float *values)
+{
+  const sensor_schema_t *schema = sensor_record_schema(type);
+  if (schema == NULL || values == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_bus_topic_t *topic     = &s_topics[type];
+  uint32_t            published = atomic_load_explicit(&topic->published, memory_order_relaxed) + 1;
+
+  sensor_seqlock_write_begin(&topic->seqlock);
+  topic->sample.timestamp_us = timestamp_us;
+  topic->sample.sequence     = published;
+  topic->sample.column_count = schema->column_count;
+  memcpy(topic->sample.values, values, schema->column_count * sizeof(float));
+  sensor_seqlock_write_end(&topic->seqlock);
+  atomic_store_explicit(&topic->published, published, memory_order_release);
+
+  /* Subscribers are only ever appended, the count is raised after the entry is filled */
+  uint8_t count = atomic_load_explicit(&topic->subscriber_count, memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    xTaskNotify(topic->subscribers[i].task, topic->subscribers[i].bits, eSetBits);
+  }
+  return ESP_OK;
+}
+
+esp_err_t sensor_bus_read(sensor_record_type_t type, sensor_bus_sample_t *sample)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || sample == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_bus_topic_t *topic = &s_topics[type];
+  if (!sensor_seqlock_read(&topic->seqlock, &topic->sample, sample, sizeof(*sample), &topic->read_retries)) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  return ESP_OK;
+}
+
+uint32_t sensor_bus_sequence(sensor_record_type_t type)
+{
+  if ((unsigned)type >= k_sensor_record_type_count) {
+    return 0;
+  }
+  return atomic_load_explicit(&s_topics[type].published, memory_order_acquire);
+}
+
+esp_err_t sensor_bus_subscribe(sensor_record_type_t type, TaskHandle_t task, uint32_t bits)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || task == NULL || bits == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_bus_topic_t *topic = &s_topics[type];
+  bool                added = false;
+  portENTER_CRITICAL(&s_subscribe_lock);
+  uint8_t count = atomic_load_explicit(&topic->subscriber_count, memory_order_relaxed);
+  if (count < SENSOR_BUS_MAX_SUBSCRIBERS) {
+    topic->subscribers[count].task = task;
+    topic->subscribers[count].bits = bits;
+    atomic_store_explicit(&topic->subscriber_count, count + 1, memory_order_release);
+    added = true;
+  }
+  portEXIT_CRITICAL(&s_subscribe_lock);
+
+  if (!added) {
+    log_error(sensor_bus_tag,
+              "Subscribe Error",
+              "%s already has %u subscribers",
+              sensor_record_schema(type)->name,
+              SENSOR_BUS_MAX_SUBSCRIBERS);
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+esp_err_t sensor_bus_get_stats(sensor_record_type_t type, sensor_bus_stats_t *stats)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || stats == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_bus_topic_t *topic = &s_topics[type];
+  stats->published    = atomic_load_explicit(&topic->published, memory_order_relaxed);
+  stats->read_retries = atomic_load_explicit(&topic->read_retries, memory_order_relaxed);
+  stats->subscribers  = atomic_load_explicit(&topic->subscriber_count, memory_order_relaxed);
+  return ESP_OK;
+}
@@ -0,0 +1,416 @@
+/* components/sensors/sensor_history.c */
+
+#include "sensor_history.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "sensor_bus.h"
+#include "log_handler.h"
+
+/* Constants ******************************************************************/
+
+const char *sensor_history_tag = "SENSOR_HISTORY";
+
+/* Macros *********************************************************************/
+
+#define SENSOR_HISTORY_SECOND_US (1000000LL)      /* Length of a second bucket */
+#define SENSOR_HISTORY_MINUTE_US (60 * 1000000LL) /* Length of a minute bucket */
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief One entry of a ring, `stride` bytes apart
+ */
+typedef struct {
+  int64_t  timestamp_us; /**< Sample time or bucket start. */
+  uint32_t count;        /**< Samples in the entry. */
+  float    values[];     /**< Raw: one per column. Buckets: means, then minimums, then maximums. */
+} sensor_history_entry_t;
+
+/**
+ * @brief Fill state of a ring, copied by readers under the ring's seqlock
+ */
+typedef struct {
+  uint32_t appended; /**< Entries appended since boot, only differences are used so it may wrap. */
+  uint16_t head;     /**< Slot of the next entry. */
+  uint16_t length;   /**< Entries held, at most the capacity. */
+} sensor_history_position_t;
+
+/**
+ * @brief Fixed-capacity ring of one tier, written only by the sensor's task
+ */
+typedef struct {
+  uint8_t                  *entries;  /**< `capacity` entries of `stride` bytes, NULL if the tier is off. */
+  uint16_t                  capacity; /**< Entries kept. */
+  uint16_t                  stride;   /**< Bytes per entry. */
+  uint8_t                   floats;   /**< Values per entry. */
+  sensor_seqlock_t          seqlock;  /**< Guards position and the entry being appended. */
+  sensor_history_position_t position; /**< Where the next entry goes. */
+} sensor_history_ring_t;
+
+/**
+ * @brief Bucket being collected
+ */
+typedef struct {
+  int64_t  start_us;                       /**< Start of the bucket. */
+  uint32_t count;                          /**< Samples so far, 0 if the bucket is empty. */
+  float    sum[SENSOR_RECORD_MAX_COLUMNS]; /**< Sum of the samples, the mean once divided by count. */
+  float    min[SENSOR_RECORD_MAX_COLUMNS]; /**< Smallest value per column. */
+  float    max[SENSOR_RECORD_MAX_COLUMNS]; /**< Largest value per column. */
+} sensor_history_bucket_t;
+
+/**
+ * @brief History of one sensor
+ */
+typedef struct {
+  sensor_history_ring_t   rings[k_sensor_history_tier_count]; /**< Indexed by sensor_history_tier_t. */
+  sensor_history_bucket_t second;                             /**< Current second, only touched by the sensor's task. */
+  sensor_history_bucket_t minute;                             /**< Current minute, only touched by the sensor's task. */
+  uint8_t                 column_count;                       /**< Columns of the sensor's schema. */
+  uint32_t                bytes;                              /**< Memory held by the rings. */
+  _Atomic bool            ready;                              /**< Set once the rings are allocated. */
+  _Atomic uint32_t        samples;                            /**< Samples inserted. */
+  _Atomic uint32_t        seconds;                            /**< Second buckets completed. */
+  _Atomic uint32_t        minutes;                            /**< Minute buckets completed. */
+  _Atomic uint32_t        read_retries;                       /**< Queries repeated after entries were overwritten. */
+} sensor_history_t;
+
+/* Globals (Static) ***********************************************************/
+
+static sensor_history_t s_histories[k_sensor_record_type_count] = {
+  [0 ... k_sensor_record_type_count - 1] = {
+    .rings = {
+      [0 ... k_sensor_history_tier_count - 1] = { .seqlock = SENSOR_SEQLOCK_INITIALIZER },
+    },
+  },
+};
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Returns the entry at an offset from a ring's oldest entry
+ *
+ * @param[in] ring     Ring to index
+ * @param[in] position Fill state the offset refers to
+ * @param[in] offset   0 for the oldest entry
+ */
+static const sensor_history_entry_t *priv_sensor_history_at(const sensor_history_ring_t     *ring,
+                                                            const sensor_history_position_t *position,
+                                                            uint16_t                         offset)
+{
+  uint32_t slot = (uint32_t)position->head + ring->capacity - position->length + offset;
+  if (slot >= ring->capacity) {
+    slot -= ring->capacity;
+  }
+  return (const sensor_history_entry_t *)(ring->entries + slot * ring->stride);
+}
+
+/**
+ * @brief Appends an entry to a ring, overwriting the oldest once full
+ *
+ * @param[in,out] ring         Ring of the tier, skipped if the tier is off
+ * @param[in]     timestamp_us Sample time or bucket start
+ * @param[in]     count        Samples in the entry
+ * @param[in]     values       `ring->floats` values
+ */
+static void priv_sensor_history_append(sensor_history_ring_t *ring,
+                                       int64_t                timestamp_us,
+                                       uint32_t               count,
+                                       const float           *values)
+{
+  if (ring->capacity == 0) {
+    return;
+  }
+
+  sensor_history_position_t *position = &ring->position;
+  sensor_history_entry_t    *entry    = (sensor_history_entry_t *)(ring->entries + position->head * ring->stride);
+
+  sensor_seqlock_write_begin(&ring->seqlock);
+  entry->timestamp_us = timestamp_us;
+  entry->count        = count;
+  memcpy(entry->values, values, ring->floats * sizeof(float));
+  position->head = (position->head + 1 == ring->capacity) ? 0 : position->head + 1;
+  if (position->length < ring->capacity) {
+    position->length++;
+  }
+  position->appended++;
+  sensor_seqlock_write_end(&ring->seqlock);
+}
+
+/**
+ * @brief Adds samples to a bucket, starting it if it is empty
+ *
+ * @param[in,out] bucket       Bucket being collected
+ * @param[in]     column_count Columns of the sensor
+ * @param[in]     start_us     Start of the bucket the samples belong to
+ * @param[in]     count        Samples added
+ * @param[in]     sum          Sum of the samples per column
+ * @param[in]     min          Smallest sample per column
+ * @param[in]     max          Largest sample per column
+ */
+static void priv_sensor_history_fold(sensor_history_bucket_t *bucket,
+                                     uint8_t                  column_count,
+                                     int64_t                  start_us,
+                                     uint32_t                 count,
+                                     const float             *sum,
+                                     const float             *min,
+                                     const float             *max)
+{
+  if (bucket->count == 0) {
+    bucket->start_us = start_us;
+    memcpy(bucket->sum, sum, column_count * sizeof(float));
+    memcpy(bucket->min, min, column_count * sizeof(float));
+    memcpy(bucket->max, max, column_count * sizeof(float));
+    bucket->count = count;
+    return;
+  }
+
+  for (uint8_t i = 0; i < column_count; i++) {
+    bucket->sum[i] += sum[i];
+    if (min[i] < bucket->min[i]) {
+      bucket->min[i] = min[i];
+    }
+    if (max[i] > bucket->max[i]) {
+      bucket->max[i] = max[i];
+    }
+  }
+  bucket->count += count;
+}
+
+/**
+ * @brief Appends a completed bucket to its ring as mean, minimum and maximum
+ *
+ * @param[in,out] ring         Ring of the bucket's tier
+ * @param[in]     bucket       Completed bucket, not empty
+ * @param[in]     column_count Columns of the sensor
+ */
+static void priv_sensor_history_close(sensor_history_ring_t         *ring,
+                                      const sensor_history_bucket_t *bucket,
+                                      uint8_t                        column_count)
+{
+  float values[3 * SENSOR_RECORD_MAX_COLUMNS];
+  for (uint8_t i = 0; i < column_count; i++) {
+    values[i]                    = bucket->sum[i] / bucket->count;
+    values[column_count + i]     = bucket->min[i];
+    values[2 * column_count + i] = bucket->max[i];
+  }
+  priv_sensor_history_append(ring, bucket->start_us, bucket->count, values);
+}
+
+/**
+ * @brief Closes the current second and folds it into the current minute
+ *
+ * @param[in,out] history History of the sensor, its second not empty
+ */
+static void priv_sensor_history_close_second(sensor_history_t *history)
+{
+  sensor_history_bucket_t *second = &history->second;
+  sensor_history_bucket_t *minute = &history->minute;
+  uint8_t                  n      = history->column_count;
+
+  priv_sensor_history_close(&history->rings[k_sensor_history_second], second, n);
+  atomic_fetch_add_explicit(&history->seconds, 1, memory_order_relaxed);
+
+  int64_t minute_start = second->start_us - second->start_us % SENSOR_HISTORY_MINUTE_US;
+  if (minute->count > 0 && minute->start_us != minute_start) {
+    priv_sensor_history_close(&history->rings[k_sensor_history_minute], minute, n);
+    atomic_fetch_add_explicit(&history->minutes, 1, memory_order_relaxed);
+    minute->count = 0;
+  }
+  priv_sensor_history_fold(minute, n, minute_start, second->count, second->sum, second->min, second->max);
+  second->count = 0;
+}
+
+/**
+ * @brief Copies a ring entry into a query result
+ *
+ * @param[in]  entry        Entry to copy
+ * @param[in]  tier         Tier of the entry's ring
+ * @param[in]  column_count Columns of the sensor
+ * @param[out] point        Destination
+ */
+static void priv_sensor_history_copy(const sensor_history_entry_t *entry,
+                                     sensor_history_tier_t         tier,
+                                     uint8_t                       column_count,
+                                     sensor_history_point_t       *point)
+{
+  size_t      size = column_count * sizeof(float);
+  const float *min = (tier == k_sensor_history_raw) ? entry->values : entry->values + column_count;
+  const float *max = (tier == k_sensor_history_raw) ? entry->values : entry->values + 2 * column_count;
+
+  point->timestamp_us = entry->timestamp_us;
+  point->count        = entry->count;
+  point->column_count = column_count;
+  memcpy(point->mean, entry->values, size);
+  memcpy(point->min, min, size);
+  memcpy(point->max, max, size);
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t sensor_history_init(sensor_record_type_t type, const sensor_history_config_t *config)
+{
+  const sensor_schema_t *schema = sensor_record_schema(type);
+  if (schema == NULL || config == NULL ||
+      (config->raw == 0 && config->second == 0 && config->minute == 0)) {
+    log_error(sensor_history_tag, "Invalid Parameter", "History needs a sensor and at least one tier");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_history_t *history = &s_histories[type];
+  if (atomic_load_explicit(&history->ready, memory_order_relaxed)) {
+    log_error(sensor_history_tag, "Init Error", "%s history already exists", schema->name);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  const uint16_t capacities[k_sensor_history_tier_count] = {
+    [k_sensor_history_raw]    = config->raw,
+    [k_sensor_history_second] = config->second,
+    [k_sensor_history_minute] = config->minute,
+  };
+  const size_t align = _Alignof(sensor_history_entry_t);
+  size_t       size  = 0;
+  for (uint8_t tier = 0; tier < k_sensor_history_tier_count; tier++) {
+    sensor_history_ring_t *ring = &history->rings[tier];
+    size_t                 floats = (tier == k_sensor_history_raw) ? schema->column_count : 3 * schema->column_count;
+    size_t                 stride = offsetof(sensor_history_entry_t, values) + floats * sizeof(float);
+
+    ring->capacity = capacities[tier];
+    ring->floats   = floats;
+    ring->stride   = (stride + align - 1) / align * align;
+    size          += (size_t)ring->capacity * ring->stride;
+  }
+
+  uint8_t *memory = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (memory == NULL) {
+    memory = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  if (memory == NULL) {
+    log_error(sensor_history_tag,
+              "Memory Error",
+              "Failed to allocate %u bytes for the %s history",
+              (unsigned)size,
+              schema->name);
+    return ESP_ERR_NO_MEM;
+  }
+
+  for (uint8_t tier = 0; tier < k_sensor_history_tier_count; tier++) {
+    sensor_history_ring_t *ring = &history->rings[tier];
+    ring->entries               = (ring->capacity > 0) ? memory : NULL;
+    memory                     += (size_t)ring->capacity * ring->stride;
+  }
+  history->column_count = schema->column_count;
+  history->bytes        = size;
+  atomic_store_explicit(&history->ready, true, memory_order_release);
+
+  log_info(sensor_history_tag,
+           "Init Complete",
+           "%s keeps %u samples, %u seconds and %u minutes in %u bytes",
+           schema->name,
+           config->raw,
+           config->second,
+           config->minute,
+           (unsigned)size);
+  return ESP_OK;
+}
+
+esp_err_t sensor_history_insert(sensor_record_type_t type, int64_t timestamp_us, const float *values)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || values == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_history_t *history = &s_histories[type];
+  if (!atomic_load_explicit(&history->ready, memory_order_acquire)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  priv_sensor_history_append(&history->rings[k_sensor_history_raw], timestamp_us, 1, values);
+
+  int64_t second_start = timestamp_us - timestamp_us % SENSOR_HISTORY_SECOND_US;
+  if (history->second.count > 0 && history->second.start_us != second_start) {
+    priv_sensor_history_close_second(history);
+  }
+  priv_sensor_history_fold(&history->second, history->column_count, second_start, 1, values, values, values);
+  atomic_fetch_add_explicit(&history->samples, 1, memory_order_relaxed);
+  return ESP_OK;
+}
+
+esp_err_t sensor_history_query(sensor_record_type_t    type,
+                               sensor_history_tier_t   tier,
+                               int64_t                 from_us,
+                               int64_t                 to_us,
+                               sensor_history_point_t *points,
+                               size_t                  max_points,
+                               size_t                 *point_count)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || (unsigned)tier >= k_sensor_history_tier_count ||
+      points == NULL || point_count == NULL || from_us > to_us) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  *point_count = 0;
+  sensor_history_t *history = &s_histories[type];
+  if (!atomic_load_explicit(&history->ready, memory_order_acquire) || history->rings[tier].capacity == 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  sensor_history_ring_t *ring = &history->rings[tier];
+  while (true) {
+    sensor_history_position_t before;
+    if (!sensor_seqlock_read(&ring->seqlock, &ring->position, &before, sizeof(before), NULL)) {
+      return ESP_OK; /* Nothing appended yet */
+    }
+
+    /* Entries are in time order, find the first one at or after from_us */
+    uint16_t low  = 0;
+    uint16_t high = before.length;
+    while (low < high) {
+      uint16_t middle = low + (high - low) / 2;
+      if (priv_sensor_history_at(ring, &before, middle)->timestamp_us < from_us) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    size_t count = 0;
+    for (uint16_t i = low; i < before.length && count < max_points; i++) {
+      const sensor_history_entry_t *entry = priv_sensor_history_at(ring, &before, i);
+      if (entry->timestamp_us > to_us) {
+        break;
+      }
+      priv_sensor_history_copy(entry, tier, history->column_count, &points[count++]);
+    }
+
+    /* Appends since `before` overwrite the oldest entries once the free slots
+     * are used up. A copy that saw part of an append also sees it counted. */
+    atomic_thread_fence(memory_order_acquire);
+    sensor_history_position_t after;
+    sensor_seqlock_read(&ring->seqlock, &ring->position, &after, sizeof(after), NULL);
+    uint32_t appended    = after.appended - before.appended;
+    uint32_t free_slots  = ring->capacity - before.length;
+    uint32_t overwritten = (appended > free_slots) ? appended - free_slots : 0;
+    if (overwritten <= low) {
+      *point_count = count;
+      return ESP_OK;
+    }
+    atomic_fetch_add_explicit(&history->read_retries, 1, memory_order_relaxed);
+  }
+}
+
+esp_err_t sensor_history_get_stats(sensor_record_type_t type, sensor_history_stats_t *stats)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || stats == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_history_t *history = &s_histories[type];
+  stats->samples      = atomic_load_explicit(&history->samples, memory_order_relaxed);
+  stats->seconds      = atomic_load_explicit(&history->seconds, memory_order_relaxed);
+  stats->minutes      = atomic_load_explicit(&history->minutes, memory_order_relaxed);
+  stats->read_retries = atomic_load_explicit(&history->read_retries, memory_order_relaxed);
+  stats->bytes        = atomic_load_explicit(&history->ready, memory_order_acquire) ? history->bytes : 0;
+  return ESP_OK;
+}
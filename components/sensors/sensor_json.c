@@ -0,0 +1,34 @@
+/* components/sensors/sensor_json.c */
+
+#include "sensor_json.h"
+#include <stdlib.h>
+
+/* Public Functions ***********************************************************/
+
+esp_err_t sensor_json_write(const json_schema_t *schema,
+                            const void          *data,
+                            char                *buffer,
+                            size_t               size,
+                            size_t              *length)
+{
+  if (schema == NULL || data == NULL || buffer == NULL || size == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  size_t needed = json_writer_write_schema(schema, data, buffer, size);
+  if (length != NULL) {
+    *length = needed < size ? needed : size - 1;
+  }
+  return needed < size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+char *sensor_json_to_string(const json_schema_t *schema, const void *data)
+{
+  /* A first pass without a buffer measures the payload */
+  size_t size   = json_writer_write_schema(schema, data, NULL, 0) + 1;
+  char  *string = malloc(size);
+  if (string != NULL) {
+    json_writer_write_schema(schema, data, string, size);
+  }
+  return string;
+}
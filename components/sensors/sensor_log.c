@@ -0,0 +1,279 @@
+/* components/sensors/sensor_log.c */
+
+#include "sensor_log.h"
+#include <stdbool.h>
+#include <string.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "file_write_manager.h"
+#include "time_manager.h"
+#include "log_handler.h"
+
+/* Constants ******************************************************************/
+
+const char    *sensor_log_tag               = "SENSOR_LOG";
+const uint32_t sensor_log_flush_interval_ms = 60 * 1000; /* A 512 byte block a minute for the slow sensors */
+const uint32_t sensor_log_flush_wait_ms     = 200;       /* Well inside the shortest quiesce timeout */
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief Binary log of one sensor.
+ */
+typedef struct {
+  const char            *file_path;      /**< Path relative to the mount point. */
+  uint16_t               block_size;     /**< Bytes per block, sized for the sensor's rate. */
+  uint16_t               max_rows;       /**< Rows staged per block. */
+  sensor_encoding_t      encoding;       /**< Payload encoding of the blocks. */
+  SemaphoreHandle_t      mutex;          /**< Guards the rest, a sample and a flush may race. */
+  void                  *staging;        /**< Rows of the current block, allocated with the first sample. */
+  sensor_block_encoder_t encoder;        /**< Current block. */
+  file_write_id_t        file_id;        /**< Interned file_path. */
+  uint32_t               sequence;       /**< Number of the next block. */
+  bool                   header_written; /**< Whether this boot's file header block was queued. */
+  sensor_log_stats_t     stats;          /**< Counters. */
+} sensor_log_stream_t;
+
+/* Globals (Static) ***********************************************************/
+
+/* Indexed by sensor_record_type_t. Blocks of slow sensors are small, so a
+ * flush after `sensor_log_flush_interval_ms` doesn't pad much. */
+static sensor_log_stream_t s_streams[k_sensor_record_type_count] = {
+  [k_sensor_record_bh1750]     = { "sensors/bh1750.tsns",     512,  64,  k_sensor_encoding_delta },
+  [k_sensor_record_dht22]      = { "sensors/dht22.tsns",      512,  64,  k_sensor_encoding_delta },
+  [k_sensor_record_mpu6050]    = { "sensors/mpu6050.tsns",    2048, 255, k_sensor_encoding_delta },
+  [k_sensor_record_qmc5883l]   = { "sensors/qmc5883l.tsns",   512,  64,  k_sensor_encoding_delta },
+  [k_sensor_record_gy_neo6mv2] = { "sensors/gy_neo6mv2.tsns", 1024, 128, k_sensor_encoding_delta },
+  [k_sensor_record_ccs811]     = { "sensors/ccs811.tsns",     512,  64,  k_sensor_encoding_delta },
+  [k_sensor_record_mq135]      = { "sensors/mq135.tsns",      512,  64,  k_sensor_encoding_delta },
+};
+
+static bool s_initialized = false;
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Allocates a stream's staging rows and registers its file
+ *
+ * @param[in,out] stream Stream of the sample being written
+ * @param[in]     type   Sensor of the stream
+ * @return ESP_OK if successful, ESP_ERR_NO_MEM otherwise
+ */
+static esp_err_t priv_stream_open(sensor_log_stream_t *stream, sensor_record_type_t type)
+{
+  size_t size     = sensor_record_staging_size(type, stream->max_rows);
+  stream->staging = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (stream->staging == NULL) {
+    stream->staging = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  if (stream->staging == NULL) {
+    log_error(sensor_log_tag,
+              "Memory Error",
+              "Failed to allocate %u bytes for %s",
+              (unsigned)size,
+              stream->file_path);
+    return ESP_ERR_NO_MEM;
+  }
+
+  sensor_record_encoder_init(&stream->encoder,
+                             type,
+                             stream->encoding,
+                             stream->block_size,
+                             stream->max_rows,
+                             stream->staging);
+  if (file_write_register_path(stream->file_path, &stream->file_id) != ESP_OK) {
+    stream->file_id = FILE_WRITE_INVALID_ID; /* Retried with the next block */
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Hands one block from a pooled buffer to the file writer
+ *
+ * @param[in] stream Stream the block belongs to
+ * @param[in] buffer Filled buffer, the request takes the reference
+ * @return ESP_OK if queued, ESP_FAIL otherwise
+ */
+static esp_err_t priv_enqueue_block(sensor_log_stream_t *stream, file_write_buffer_t *buffer)
+{
+  buffer->length = stream->block_size;
+  return file_write_buffer_enqueue(stream->file_id,
+                                   buffer,
+                                   k_file_write_lane_telemetry,
+                                   k_file_write_binary);
+}
+
+/**
+ * @brief Queues the stream's current block, preceded by the file header once per boot
+ *
+ * The staged rows are kept if the file writer has no free buffer.
+ *
+ * @param[in,out] stream Stream to flush, its mutex held
+ * @param[in]     wait   Ticks to wait for each write buffer, 0 on the sample path
+ * @return ESP_OK if queued or empty, ESP_FAIL otherwise
+ */
+static esp_err_t priv_stream_flush(sensor_log_stream_t *stream, TickType_t wait)
+{
+  if (stream->staging == NULL || stream->encoder.row_count == 0) {
+    return ESP_OK;
+  }
+  if (stream->file_id == FILE_WRITE_INVALID_ID &&
+      file_write_register_path(stream->file_path, &stream->file_id) != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  if (!stream->header_written) {
+    file_write_buffer_t *header = file_write_buffer_alloc(stream->block_size, wait);
+    if (header == NULL) {
+      return ESP_FAIL;
+    }
+    sensor_record_encode_file_header(stream->encoder.type, stream->block_size, header->data);
+    if (priv_enqueue_block(stream, header) != ESP_OK) {
+      return ESP_FAIL;
+    }
+    stream->header_written = true;
+  }
+
+  file_write_buffer_t *buffer = file_write_buffer_alloc(stream->block_size, wait);
+  if (buffer == NULL) {
+    return ESP_FAIL;
+  }
+
+  /* Block times are esp_timer time, the offset maps them to wall time */
+  int64_t unix_offset_us = 0;
+  if (time_manager_is_initialized()) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    unix_offset_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec - esp_timer_get_time();
+  }
+
+  uint16_t rows = stream->encoder.row_count;
+  sensor_record_finish_block(&stream->encoder, stream->sequence++, unix_offset_us, buffer->data);
+  if (priv_enqueue_block(stream, buffer) != ESP_OK) {
+    stream->stats.dropped_records += rows; /* The rows were in the buffer the writer released */
+    return ESP_FAIL;
+  }
+  stream->stats.blocks++;
+  return ESP_OK;
+}
+
+/**
+ * @brief Empties a full block whose rows could not be queued
+ *
+ * @param[in,out] stream Stream whose rows are dropped, its mutex held
+ */
+static void priv_stream_discard(sensor_log_stream_t *stream)
+{
+  stream->stats.dropped_records += stream->encoder.row_count;
+  sensor_record_encoder_init(&stream->encoder,
+                             stream->encoder.type,
+                             stream->encoding,
+                             stream->block_size,
+                             stream->max_rows,
+                             stream->staging);
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t sensor_log_init(void)
+{
+  if (s_initialized) {
+    return ESP_OK;
+  }
+
+  for (uint8_t i = 0; i < k_sensor_record_type_count; i++) {
+    s_streams[i].file_id = FILE_WRITE_INVALID_ID;
+    s_streams[i].mutex   = xSemaphoreCreateMutex();
+    if (s_streams[i].mutex == NULL) {
+      log_error(sensor_log_tag, "Init Error", "Failed to create mutex");
+      return ESP_FAIL;
+    }
+  }
+
+  s_initialized = true;
+  log_info(sensor_log_tag, "Init Complete", "Sensor log initialized");
+  return ESP_OK;
+}
+
+esp_err_t sensor_log_write(sensor_record_type_t type, int64_t timestamp_us, const float *values)
+{
+  if (!s_initialized) {
+    return ESP_FAIL;
+  }
+  if ((unsigned)type >= k_sensor_record_type_count || values == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  sensor_log_stream_t *stream = &s_streams[type];
+  esp_err_t            ret    = ESP_OK;
+  xSemaphoreTake(stream->mutex, portMAX_DELAY);
+  if (stream->staging == NULL) {
+    ret = priv_stream_open(stream, type);
+  }
+
+  if (ret == ESP_OK && !sensor_record_append(&stream->encoder, timestamp_us, values)) {
+    /* Full, or too far in time from the block's first row */
+    if (priv_stream_flush(stream, 0) != ESP_OK && stream->encoder.row_count > 0) {
+      priv_stream_discard(stream);
+    }
+    if (!sensor_record_append(&stream->encoder, timestamp_us, values)) {
+      ret = ESP_ERR_INVALID_ARG; /* Cannot happen with a valid table, even an empty block refused it */
+    }
+  }
+
+  if (ret == ESP_OK) {
+    stream->stats.records++;
+    if (timestamp_us - stream->encoder.first_us >= (int64_t)sensor_log_flush_interval_ms * 1000) {
+      priv_stream_flush(stream, 0); /* Kept for the next sample if it fails */
+    }
+  }
+  xSemaphoreGive(stream->mutex);
+  return ret;
+}
+
+esp_err_t sensor_log_flush(void)
+{
+  if (!s_initialized) {
+    return ESP_FAIL;
+  }
+
+  /* Blocks share the writer's large pool, so wait for it to return buffers
+   * of earlier blocks rather than drop the last ones */
+  esp_err_t  ret    = ESP_OK;
+  TickType_t start  = xTaskGetTickCount();
+  TickType_t budget = pdMS_TO_TICKS(sensor_log_flush_wait_ms);
+  for (uint8_t i = 0; i < k_sensor_record_type_count; i++) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    TickType_t wait    = (elapsed < budget) ? budget - elapsed : 0;
+    xSemaphoreTake(s_streams[i].mutex, portMAX_DELAY);
+    if (priv_stream_flush(&s_streams[i], wait) != ESP_OK) {
+      log_warn(sensor_log_tag,
+               "Flush Failed",
+               "Failed to queue the last block of %s",
+               s_streams[i].file_path);
+      ret = ESP_FAIL;
+    }
+    xSemaphoreGive(s_streams[i].mutex);
+  }
+  return ret;
+}
+
+esp_err_t sensor_log_get_stats(sensor_record_type_t type, sensor_log_stats_t *stats)
+{
+  if ((unsigned)type >= k_sensor_record_type_count || stats == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_streams[type].mutex == NULL) {
+    memset(stats, 0, sizeof(*stats));
+    return ESP_OK;
+  }
+
+  xSemaphoreTake(s_streams[type].mutex, portMAX_DELAY);
+  *stats = s_streams[type].stats;
+  xSemaphoreGive(s_streams[type].mutex);
+  return ESP_OK;
+}
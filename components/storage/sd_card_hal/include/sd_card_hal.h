@@ -73,6 +73,19 @@ bool sd_card_is_available(void);
  */
 esp_err_t sd_card_register_availability_callback(void (*callback)(bool available));
 
+/**
+ * @brief Registers a callback function to be called when the SD card is removed.
+ *
+ * Runs in the mount task before the card is unmounted, with
+ * `sd_card_is_available` already false, so files still open on the card can
+ * be closed. The unmount waits for the callback to return.
+ *
+ * @param callback Function to call on removal.
+ * @return ESP_OK if successful, ESP_FAIL if `callback` is NULL or
+ *         `sd_card_detection_init` has not run.
+ */
+esp_err_t sd_card_register_removal_callback(void (*callback)(void));
+
 #ifdef __cplusplus
 }
 #endif
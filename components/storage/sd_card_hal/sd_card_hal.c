@@ -26,7 +26,7 @@ const uint8_t           sd_card_data_from_card       = GPIO_NUM_19;
 const uint8_t           sd_card_cd                   = GPIO_NUM_13; /* Card Detect pin */
 const uint32_t          sd_card_spi_freq_hz          = 1000000;     /* 1 MHz SPI frequency */
 const spi_host_device_t sd_card_spi_host             = SPI2_HOST;
-const uint8_t           sd_card_max_files            = 5;
+const uint8_t           sd_card_max_files            = 10;
 const uint32_t          sd_card_allocation_unit_size = 16 * 1024;
 const uint32_t          sd_card_max_transfer_sz      = 4092;        /* Default size in Bytes */
 const uint8_t           sd_card_max_retries          = 5;
@@ -41,6 +41,7 @@ static SemaphoreHandle_t s_sd_mutex                     = NULL;  /**< Mutex for
 static bool              s_sd_card_available            = false; /**< Flag to track SD card availability */
 static bool              s_sd_card_initialized          = false; /**< Flag to track initialization status */
 static void            (*s_availability_callback)(bool) = NULL;  /**< Callback for SD card availability changes */
+static void            (*s_removal_callback)(void)      = NULL;  /**< Callback run on removal before unmounting */
 static TaskHandle_t      s_mount_task_handle            = NULL;  /**< Handle for the mount/unmount task */
 
 /* Private (Static) Functions *************************************************/
@@ -101,10 +102,16 @@ static void priv_sd_card_mount_task(void *arg)
                       esp_err_to_name(ret));
           }
         } else {
-          /* Card removed - unmount */
+          /* Card removed - close open files, then unmount */
           log_info(sd_card_tag, "Card Removed", "SD card removed, unmounting");
-          priv_sd_card_cleanup();
           s_sd_card_available = false;
+          if (s_removal_callback != NULL) {
+            /* Released meanwhile, the callback waits on tasks that check availability */
+            xSemaphoreGive(s_sd_mutex);
+            s_removal_callback();
+            xSemaphoreTake(s_sd_mutex, portMAX_DELAY);
+          }
+          priv_sd_card_cleanup();
         }
         
         /* Call the availability callback if registered */
@@ -325,3 +332,18 @@ esp_err_t sd_card_register_availability_callback(void (*callback)(bool available
   return ESP_FAIL;
 }
 
+esp_err_t sd_card_register_removal_callback(void (*callback)(void))
+{
+  if (callback == NULL || s_sd_mutex == NULL) {
+    return ESP_FAIL;
+  }
+  
+  if (xSemaphoreTake(s_sd_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    s_removal_callback = callback;
+    xSemaphoreGive(s_sd_mutex);
+    return ESP_OK;
+  }
+  
+  return ESP_FAIL;
+}
+
@@ -3,356 +3,333 @@
 #include "gait_movement.h"
 #include <math.h>
 #include "hexapod_geometry.h"
+#include "hexapod_kinematics.h"
+#include "motion_frame.h"
 #include "pca9685_hal.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "log_handler.h"
 
-/* Globals (Static) ***********************************************************/
+/* Structs (Private) **********************************************************/
 
-static leg_t s_legs[NUMBER_OF_LEGS] = {};
+/**
+ * @brief Timing of a gait pattern.
+ *
+ * Phases are expressed as Q16 fractions of a full gait cycle (65536 = one 
+ * cycle). A leg is in stance while its local phase is below `duty_q16` and in 
+ * swing for the rest of the cycle.
+ */
+typedef struct {
+  uint16_t duty_q16;                   /**< Fraction of the cycle each leg spends in stance. */
+  uint16_t offset_q16[NUMBER_OF_LEGS]; /**< Phase offset of each leg within the cycle. */
+  uint8_t  active_mask;                /**< Bit N is set when leg N takes part in the gait. */
+} gait_pattern_t;
 
 /* Constants ******************************************************************/
 
-const char *gait_tag = "Gait Movement";
-
-/* Private Functions (Static) *************************************************/
+const char    *gait_tag              = "Gait Movement";
+const uint16_t gait_control_rate_hz  = 50;
+const uint16_t gait_cycle_ticks      = 50;    /**< One gait cycle per second at 50 Hz */
+const float    gait_step_height_cm   = 3.0f;
+const float    gait_max_stride_cm    = 6.0f;
+/* Neutral stance in the middle of the joint ranges (hip 30°, knee 21°, tibia -6°). Full strides
+ * in any heading plus the step height stay at least 12° inside every joint limit (tibia -32° vs -45°). */
+const float    gait_body_height_cm   = 8.0f;
+const float    gait_neutral_reach_cm = 17.5f;
+const float    gait_neutral_yaw_deg  = 30.0f; /**< Middle of the 0° to 60° hip range */
 
 /**
- * @brief Sets a relative angle for a motor based on its joint type.
+ * @brief Mounting direction of each leg around the body, in degrees.
  *
- * Converts a relative angle (e.g., -30°, +30°) to an absolute angle (0°–180°)
- * for a PCA9685-controlled servo motor and validates it against joint constraints.
- *
- * @param[in] pwm_controller Pointer to the PCA9685 board controller.
- * @param[in] motor_mask     Mask indicating the motor(s) to control.
- * @param[in] board_id       ID of the PCA9685 board controlling the motor(s).
- * @param[in] joint_type     Type of joint (e.g., hip, knee, or tibia).
- * @param[in] relative_angle Desired angle relative to the neutral position (90°).
- *
- * @return 
- * - `ESP_OK` on success.
- * - Relevant `esp_err_t` codes on failure.
+ * Measured from the robot's forward axis, positive towards the left side.
  */
-esp_err_t priv_set_relative_angle(pca9685_board_t *pwm_controller, 
-                                  uint16_t         motor_mask, 
-                                  uint8_t          board_id, 
-                                  joint_type_t     joint_type, 
-                                  float            relative_angle) 
-{
-  float absolute_angle = 90.0f; /* Default neutral position */
-  float angle_min      = 0.0f, angle_max = 180.0f;
-
-  /* Determine angle constraints based on joint type */
-  switch (joint_type) {
-    case k_hip:
-      angle_min = 90.0f + hip_angle_from_90_min;
-      angle_max = 90.0f + hip_angle_from_90_max;
-      break;
-    case k_knee:
-      angle_min = 90.0f + knee_angle_from_90_min;
-      angle_max = 90.0f + knee_angle_from_90_max;
-      break;
-    case k_tibia:
-      angle_min = 90.0f + tibia_angle_from_90_min;
-      angle_max = 90.0f + tibia_angle_from_90_max;
-      break;
-    default:
-      log_error(gait_tag, "Joint Error", "Invalid joint type: %u", joint_type);
-      return ESP_ERR_INVALID_ARG;
-  }
+static const float s_leg_mount_angle_deg[NUMBER_OF_LEGS] = {
+  -45.0f,  /* k_leg_right_front */
+  -90.0f,  /* k_leg_right_middle */
+  -135.0f, /* k_leg_right_rear */
+  135.0f,  /* k_leg_left_rear */
+  90.0f,   /* k_leg_left_middle */
+  45.0f,   /* k_leg_left_front */
+};
+
+/**
+ * @brief Phase tables for each gait, indexed by `gait_type_t`.
+ */
+static const gait_pattern_t s_gait_patterns[k_gait_count] = {
+  [k_gait_tripod] = {
+    .duty_q16    = 32768, /* 1/2 */
+    .offset_q16  = { 0, 32768, 0, 32768, 0, 32768 },
+    .active_mask = 0x3F,
+  },
+  [k_gait_wave] = {
+    .duty_q16    = 54613, /* 5/6 */
+    .offset_q16  = { 21845, 10923, 0, 32768, 43691, 54613 },
+    .active_mask = 0x3F,
+  },
+  [k_gait_ripple] = {
+    .duty_q16    = 43691, /* 2/3 */
+    .offset_q16  = { 0, 21845, 43691, 10923, 54613, 32768 },
+    .active_mask = 0x3F,
+  },
+  [k_gait_quadruped] = {
+    .duty_q16    = 49152, /* 3/4 */
+    .offset_q16  = { 0, 0, 49152, 16384, 0, 32768 },
+    .active_mask = 0x2D, /* Corner legs only */
+  },
+};
 
-  /* Calculate the absolute angle */
-  absolute_angle = 90.0f + relative_angle;
+/* Globals (Static) ***********************************************************/
 
-  /* Clamp the angle to the joint's range */
-  if (absolute_angle < angle_min) {
-    log_warn(gait_tag, 
-             "Angle Clamp", 
-             "Joint angle %.2f° clamped to minimum %.2f° for joint type %u", 
-             absolute_angle, 
-             angle_min, 
-             joint_type);
-    absolute_angle = angle_min;
-  } else if (absolute_angle > angle_max) {
-    log_warn(gait_tag, 
-             "Angle Clamp", 
-             "Joint angle %.2f° clamped to maximum %.2f° for joint type %u", 
-             absolute_angle, 
-             angle_max, 
-             joint_type);
-    absolute_angle = angle_max;
-  }
+static leg_t   s_legs[NUMBER_OF_LEGS]     = {};
+static motor_t s_motors[NUMBER_OF_JOINTS] = {}; /* Flat joint state, indexed by `hexapod_joint_index` */
+
+static float                 s_swing_progress[GAIT_TRAJECTORY_TABLE_SIZE]  = {0};   /* Foot travel during swing (-0.5 to +0.5 of a stride) */
+static float                 s_swing_lift[GAIT_TRAJECTORY_TABLE_SIZE]      = {0};   /* Foot lift during swing (0 to 1 of the step height) */
+static float                 s_stance_progress[GAIT_TRAJECTORY_TABLE_SIZE] = {0};   /* Foot travel during stance (+0.5 to -0.5 of a stride) */
+static float                 s_leg_mount_cos[NUMBER_OF_LEGS]               = {0};
+static float                 s_leg_mount_sin[NUMBER_OF_LEGS]               = {0};
+static float                 s_neutral_x_cm                                = 0.0f;  /* Neutral foot position, radial */
+static float                 s_neutral_y_cm                                = 0.0f;  /* Neutral foot position, tangential */
+static bool                  s_tables_ready                                = false;
+static const gait_pattern_t *s_pattern                                     = NULL;  /* Active gait pattern */
+static float                 s_stride_x_cm[NUMBER_OF_LEGS]                 = {0};   /* Per-leg stride vector, radial */
+static float                 s_stride_y_cm[NUMBER_OF_LEGS]                 = {0};   /* Per-leg stride vector, tangential */
+static uint32_t              s_phase_q32                                   = 0;     /* Gait phase, one cycle = 2^32 */
+static uint32_t              s_phase_step_q32                              = 0;     /* Phase advance per tick */
+static uint32_t              s_stance_scale                                = 0;     /* Q16 phase to stance table index */
+static uint32_t              s_swing_scale                                 = 0;     /* Q16 phase to swing table index */
+static uint32_t              s_tick                                        = 0;
+static gait_frame_t          s_gait_frame                                  = {0};
+#if KINEMATICS_USE_FIXED_POINT
+static leg_positions_q16_t   s_leg_positions_q16                           = {0};
+static leg_angles_q16_t      s_leg_angles_q16                              = {0};
+static leg_servo_positions_t s_leg_servo                                   = {0};
+#else
+static leg_angles_t          s_leg_angles                                  = {0};
+#endif
 
-  /* Set the angle on the PCA9685 */
-  return pca9685_set_angle(pwm_controller, motor_mask, board_id, absolute_angle);
-}
+/* Private Functions (Static) *************************************************/
 
 /**
- * @brief Configures a motor with joint type, board ID, and motor ID.
+ * @brief Precomputes the swing and stance curves used by the gait engine.
  *
- * Assigns joint type, board ID, motor ID, and initializes the motor's position 
- * to 0.0 degrees. Adjusts motor indices to wrap correctly across multiple 
- * PCA9685 boards when needed.
- *
- * @param[in,out] motor       Pointer to the `motor_t` structure to configure.
- * @param[in]     joint_type  Type of joint (e.g., hip, knee, tibia).
- * @param[in]     board       Pointer to the current PCA9685 board.
- * @param[in,out] motor_index Pointer to the motor index on the current board.
- * @param[in,out] board_id    Pointer to the current PCA9685 board ID.
- *
- * @note 
- * - Updates `motor_index` and `board_id` when indices exceed the board's capacity (16 motors).
- * - Returns an error if a new board is required but unavailable.
- *
- * @return 
- * - `ESP_OK`   on success.
- * - `ESP_FAIL` if a new board is required but unavailable.
+ * The swing curve accelerates and decelerates the foot with a half-cosine 
+ * profile while lifting it along a half-sine, so the foot leaves and touches 
+ * the ground vertically and with zero horizontal speed. Stance is linear so 
+ * the body moves at a constant speed. Table entry `i` corresponds to 
+ * `i / (GAIT_TRAJECTORY_TABLE_SIZE - 1)` of the phase.
  */
-static esp_err_t priv_assign_motor(motor_t          *motor, 
-                                   joint_type_t      joint_type, 
-                                   pca9685_board_t **board, 
-                                   uint8_t          *motor_index, 
-                                   uint8_t          *board_id)
+static void priv_build_trajectory_tables(void)
 {
-  if (*motor_index >= 16) {
-    if ((*board)->next == NULL) {
-      log_error(gait_tag, 
-                "Board Error", 
-                "Insufficient PCA9685 boards available for motor assignment");
-      return ESP_FAIL;
-    }
-    *board       = (*board)->next;
-    *motor_index = 0;
-    (*board_id)++;
+  for (uint16_t i = 0; i < GAIT_TRAJECTORY_TABLE_SIZE; ++i) {
+    float t = (float)i / (float)(GAIT_TRAJECTORY_TABLE_SIZE - 1);
+
+    s_swing_progress[i]  = -0.5f + (0.5f - 0.5f * cosf((float)M_PI * t));
+    s_swing_lift[i]      = sinf((float)M_PI * t);
+    s_stance_progress[i] = 0.5f - t;
   }
 
-  motor->joint_type = joint_type;
-  motor->pos_deg    = 0.0f;
-  motor->board_id   = *board_id;
-  motor->motor_id   = *motor_index;
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    float mount_rad      = s_leg_mount_angle_deg[leg] * ((float)M_PI / 180.0f);
+    s_leg_mount_cos[leg] = cosf(mount_rad);
+    s_leg_mount_sin[leg] = sinf(mount_rad);
+  }
 
-  (*motor_index)++;
-  return ESP_OK;
+  float neutral_yaw_rad = gait_neutral_yaw_deg * ((float)M_PI / 180.0f);
+  s_neutral_x_cm        = gait_neutral_reach_cm * cosf(neutral_yaw_rad);
+  s_neutral_y_cm        = gait_neutral_reach_cm * sinf(neutral_yaw_rad);
+
+  s_tables_ready = true;
 }
 
 /**
- * @brief Calculates the step distance based on joint angles.
+ * @brief Runs a gait pattern until the requested distance has been covered.
  *
- * Computes the horizontal stride distance of a leg using the relative angles 
- * of the hip, knee, and tibia joints. Also calculates vertical clearance for 
- * diagnostics. Angles must fall within their respective valid ranges.
+ * Splits the distance into whole gait cycles no longer than 
+ * `gait_max_stride_cm`, then ticks the gait engine at `gait_control_rate_hz`.
  *
- * @param[in] hip_angle_deg   Relative angle of the hip joint in degrees.
- * @param[in] knee_angle_deg  Relative angle of the knee joint in degrees.
- * @param[in] tibia_angle_deg Relative angle of the tibia joint in degrees.
+ * @param[in] pwm_controller Pointer to the PCA9685 board controller.
+ * @param[in] type           Gait pattern to run.
+ * @param[in] heading        Desired heading in degrees.
+ * @param[in] distance       Distance to be traveled in centimeters.
  *
  * @return 
- * - Horizontal stride distance in centimeters if angles are valid.
- * - `-1.0f` if any angle is invalid.
- *
- * @note 
- * - Requires `femur_length_cm` and `tibia_length_cm` to be defined globally.
- * - Uses `gait_tag` for logging errors and diagnostics.
+ * - `ESP_OK` on success.
+ * - Relevant `esp_err_t` codes on failure.
  */
-float priv_calculate_step_distance(float hip_angle_deg, 
-                                   float knee_angle_deg, 
-                                   float tibia_angle_deg)
+static esp_err_t priv_run_gait(pca9685_board_t *pwm_controller, 
+                               gait_type_t      type, 
+                               float            heading, 
+                               uint16_t         distance)
 {
-  /* TODO: Verify this for accuracy */
-
-  /* Validate input parameters */
-  if (hip_angle_deg < hip_angle_from_90_min || 
-      hip_angle_deg > hip_angle_from_90_max) {
-    log_error(gait_tag, 
-              "Hip Error", 
-              "Hip angle %.2f° outside valid range [%.2f°, %.2f°]",
-              hip_angle_deg, 
-              hip_angle_from_90_min, 
-              hip_angle_from_90_max);
-    return -1.0f;
+  if (pwm_controller == NULL) {
+    log_error(gait_tag, "Gait Error", "PCA9685 controller pointer is NULL");
+    return ESP_ERR_INVALID_ARG;
   }
 
-  if (knee_angle_deg < knee_angle_from_90_min || 
-      knee_angle_deg > knee_angle_from_90_max) {
-    log_error(gait_tag, 
-              "Knee Error", 
-              "Knee angle %.2f° outside valid range [%.2f°, %.2f°]",
-              knee_angle_deg, 
-              knee_angle_from_90_min, 
-              knee_angle_from_90_max);
-    return -1.0f;
+  if (distance == 0) {
+    return ESP_OK;
   }
 
-  if (tibia_angle_deg < tibia_angle_from_90_min || 
-      tibia_angle_deg > tibia_angle_from_90_max) {
+  uint32_t  cycles = (uint32_t)ceilf((float)distance / gait_max_stride_cm);
+  float     stride = (float)distance / (float)cycles;
+  esp_err_t ret    = gait_engine_configure(type, heading, stride);
+  if (ret != ESP_OK) {
     log_error(gait_tag, 
-              "Tibia Error", 
-              "Tibia angle %.2f° outside valid range [%.2f°, %.2f°]",
-              tibia_angle_deg, 
-              tibia_angle_from_90_min, 
-              tibia_angle_from_90_max);
-    return -1.0f;
+              "Gait Error", 
+              "Failed to configure gait engine: %s", 
+              esp_err_to_name(ret));
+    return ret;
   }
 
-  /* Convert angles to radians */
-  float hip_angle_rad   = hip_angle_deg * (M_PI / 180.0f);
-  float knee_angle_rad  = knee_angle_deg * (M_PI / 180.0f);
-  float tibia_angle_rad = tibia_angle_deg * (M_PI / 180.0f);
-
-  /* Calculate horizontal stride */
-  float horizontal_stride = 2.0f * femur_length_cm * sinf(hip_angle_rad / 2.0f) +
-                            tibia_length_cm * sinf(tibia_angle_rad);
-
-  /* Calculate vertical clearance (for diagnostics) */
-  float vertical_clearance = femur_length_cm * cosf(knee_angle_rad) +
-                             tibia_length_cm * cosf(tibia_angle_rad);
+  uint32_t   total_ticks = cycles * gait_cycle_ticks;
+  TickType_t period      = pdMS_TO_TICKS(1000 / gait_control_rate_hz);
+  TickType_t last_wake   = xTaskGetTickCount();
+  if (period == 0) {
+    period = 1;
+  }
 
-  log_info(gait_tag, 
-           "Step Calc", 
-           "Horizontal stride: %.2f cm, vertical clearance: %.2f cm", 
-           horizontal_stride, vertical_clearance);
+  uint32_t unreachable_ticks = 0;
+  uint8_t  unreachable_legs  = 0;
+  for (uint32_t tick = 0; tick < total_ticks; ++tick) {
+    uint8_t mask = 0;
+    gait_engine_tick(&s_gait_frame);
+
+#if KINEMATICS_USE_FIXED_POINT
+    for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+      s_leg_positions_q16.x_cm[leg] = kinematics_float_to_q16(s_gait_frame.feet.x_cm[leg]);
+      s_leg_positions_q16.y_cm[leg] = kinematics_float_to_q16(s_gait_frame.feet.y_cm[leg]);
+      s_leg_positions_q16.z_cm[leg] = kinematics_float_to_q16(s_gait_frame.feet.z_cm[leg]);
+    }
 
-  return horizontal_stride;
-}
+    /* Unreachable legs are still driven to the closest reachable pose */
+    if (kinematics_solve_legs_q16(&s_leg_positions_q16, &s_leg_angles_q16, &mask) != ESP_OK) {
+      unreachable_ticks++;
+      unreachable_legs |= mask;
+    }
 
-/**
- * @brief Extracts a chunk of active motors from a motor mask.
- *
- * Splits the given motor mask into chunks, ensuring the number of active motors 
- * in the chunk does not exceed the specified limit.
- *
- * @param[in]  mask              Full 16-bit motor mask.
- * @param[in]  max_active_servos Maximum number of active motors per chunk.
- * @param[out] chunk             Pointer to store the resulting motor chunk.
- *
- * @return Updated mask with the processed chunk removed.
- */
-static uint16_t priv_extract_chunk(uint16_t  mask, 
-                                   uint8_t   max_active_servos, 
-                                   uint16_t *chunk) 
-{
-  uint8_t active_count = 0;
-  *chunk               = 0;
-
-  for (uint8_t i = 0; i < 16; ++i) {
-    if ((mask & (1 << i)) && active_count < max_active_servos) {
-      *chunk |= (1 << i);
-      mask   &= ~(1 << i); /* Clear the bit from the original mask */
-      active_count++;
+    kinematics_angles_to_servo_q16(&s_leg_angles_q16, &s_leg_servo);
+    ret = motion_frame_submit_servo(&s_leg_servo);
+#else
+    /* Unreachable legs are still driven to the closest reachable pose */
+    if (kinematics_solve_legs(&s_gait_frame.feet, &s_leg_angles, &mask) != ESP_OK) {
+      unreachable_ticks++;
+      unreachable_legs |= mask;
     }
-    if (active_count == max_active_servos) {
-      break;
+
+    ret = motion_frame_submit(&s_leg_angles);
+#endif
+    if (ret != ESP_OK) {
+      log_error(gait_tag, 
+                "Gait Error", 
+                "Failed to drive legs at tick %lu: %s", 
+                (unsigned long)tick, 
+                esp_err_to_name(ret));
+      return ret;
     }
+    vTaskDelayUntil(&last_wake, period);
+  }
+
+  if (unreachable_ticks > 0) {
+    log_warn(gait_tag, 
+             "Reach Warning", 
+             "Foot targets out of reach on %lu of %lu ticks (leg mask 0x%02X)", 
+             (unsigned long)unreachable_ticks, 
+             (unsigned long)total_ticks, 
+             unreachable_legs);
   }
-  return mask;
+
+  log_info(gait_tag, 
+           "Gait Complete", 
+           "Completed %lu gait cycles (%.2f cm per cycle)", 
+           (unsigned long)cycles, 
+           stride);
+  return ESP_OK;
 }
 
-/**
- * @brief Processes a motor mask in chunks, limiting the number of active servos.
- *
- * Divides a 16-bit motor mask into chunks, each containing up to `max_active_servos` active motors. 
- * Sets the specified relative angle for the given joint type on the motors in each chunk, with a delay 
- * between chunks to reduce current draw.
- *
- * @param[in] pwm_controller    Pointer to the PCA9685 board controller.
- * @param[in] mask              16-bit motor mask indicating the motors to process.
- * @param[in] max_active_servos Maximum number of active servos per chunk.
- * @param[in] relative_angle    Relative angle in degrees to set for the motors.
- *
- * @return 
- * - `ESP_OK` if all chunks are processed successfully.
- * - Relevant `esp_err_t` code on failure.
- *
- * @note 
- * - The `joint_type` parameter must be a valid value from `joint_type_t`.
- * - Includes delays (`vTaskDelay`) between chunk processing to minimize current draw.
- */
-esp_err_t priv_process_mask_in_chunks(pca9685_board_t *pwm_controller, 
-                                      uint16_t         mask,
-                                      float            relative_angle)
+/* Public Functions ***********************************************************/
+
+esp_err_t gait_engine_configure(gait_type_t type, float heading, float stride_cm)
 {
-  if (pwm_controller == NULL) {
-    log_error(gait_tag, "Process Error", "PCA9685 controller pointer is NULL");
+  if (type >= k_gait_count) {
+    log_error(gait_tag, "Config Error", "Invalid gait type: %u", type);
     return ESP_ERR_INVALID_ARG;
   }
 
-  uint16_t  chunk          = 0;
-  uint16_t  remaining_mask = mask;
-  esp_err_t ret            = ESP_OK;
-
-  /* Process hip motors first for clearance */
-  uint16_t hip_mask = mask;
-  for (uint8_t i = 0; i < 16; ++i) {
-    if (pwm_controller->motors[i].joint_type != k_hip) {
-      hip_mask &= ~(1 << i); /* Remove non-hip motors from the hip mask */
-    }
+  if (!s_tables_ready) {
+    log_error(gait_tag, "Config Error", "Trajectory tables not built, call gait_init first");
+    return ESP_ERR_INVALID_STATE;
   }
 
-  while (hip_mask) {
-    hip_mask = priv_extract_chunk(hip_mask, max_active_servos, &chunk);
-
-    /* Apply relative angle to hip motors in the current chunk */
-    ret = pca9685_set_angle(pwm_controller, 
-                            chunk, 
-                            pwm_controller->board_id, 
-                            relative_angle);
-    if (ret != ESP_OK) {
-      log_error(gait_tag, 
-                "Hip Error", 
-                "Failed to set hip motor angles, error: %s", 
-                esp_err_to_name(ret));
-      return ret;
-    }
-
-    /* Update motor positions */
-    for (uint8_t i = 0; i < 16; ++i) {
-      if (chunk & (1 << i)) {
-        pwm_controller->motors[i].pos_deg += relative_angle;
-      }
-    }
-
-    /* Delay to reduce current draw */
-    vTaskDelay(pdMS_TO_TICKS(100));
+  if (stride_cm > gait_max_stride_cm) {
+    stride_cm = gait_max_stride_cm;
+  } else if (stride_cm < 0.0f) {
+    stride_cm = 0.0f;
   }
 
-  /* Remove processed hip motors from the remaining mask */
-  remaining_mask &= ~hip_mask;
+  /* Resolve the heading into each leg's radial/tangential frame */
+  float heading_rad = heading * ((float)M_PI / 180.0f);
+  float heading_cos = cosf(heading_rad);
+  float heading_sin = sinf(heading_rad);
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    s_stride_x_cm[leg] = stride_cm * (heading_cos * s_leg_mount_cos[leg] + 
+                                      heading_sin * s_leg_mount_sin[leg]);
+    s_stride_y_cm[leg] = stride_cm * (heading_sin * s_leg_mount_cos[leg] - 
+                                      heading_cos * s_leg_mount_sin[leg]);
+  }
 
-  /* Process remaining motors after hip motors */
-  while (remaining_mask) {
-    remaining_mask = priv_extract_chunk(remaining_mask, max_active_servos, &chunk);
+  s_pattern        = &s_gait_patterns[type];
+  s_phase_q32      = 0;
+  s_phase_step_q32 = (uint32_t)((1ULL << 32) / gait_cycle_ticks);
+  s_stance_scale   = ((uint32_t)GAIT_TRAJECTORY_TABLE_SIZE << 16) / s_pattern->duty_q16;
+  s_swing_scale    = ((uint32_t)GAIT_TRAJECTORY_TABLE_SIZE << 16) / (65536u - s_pattern->duty_q16);
+  s_tick           = 0;
 
-    /* Apply relative angle to motors in the current chunk */
-    ret = pca9685_set_angle(pwm_controller, 
-                            chunk, 
-                            pwm_controller->board_id, 
-                            relative_angle);
-    if (ret != ESP_OK) {
-      log_error(gait_tag, 
-                "Motor Error", 
-                "Failed to set motor angles, error: %s", 
-                esp_err_to_name(ret));
-      return ret;
-    }
+  log_info(gait_tag, 
+           "Gait Config", 
+           "Gait %u configured (heading: %.2f°, stride: %.2f cm)", 
+           type, 
+           heading, 
+           stride_cm);
+  return ESP_OK;
+}
 
-    /* Update motor positions */
-    for (uint8_t i = 0; i < 16; ++i) {
-      if (chunk & (1 << i)) {
-        pwm_controller->motors[i].pos_deg += relative_angle;
+void gait_engine_tick(gait_frame_t *frame)
+{
+  const gait_pattern_t *pattern = s_pattern;
+  uint16_t              phase   = (uint16_t)(s_phase_q32 >> 16);
+
+  frame->swing_mask = 0;
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    float progress = 0.0f;
+    float lift     = 1.0f; /* Legs outside the gait are held clear of the ground */
+
+    if (pattern->active_mask & (1 << leg)) {
+      uint16_t local = (uint16_t)(phase + pattern->offset_q16[leg]);
+      uint32_t index;
+
+      if (local < pattern->duty_q16) {
+        index    = ((uint32_t)local * s_stance_scale) >> 16;
+        progress = s_stance_progress[index & (GAIT_TRAJECTORY_TABLE_SIZE - 1)];
+        lift     = 0.0f;
+      } else {
+        index    = ((uint32_t)(local - pattern->duty_q16) * s_swing_scale) >> 16;
+        index   &= (GAIT_TRAJECTORY_TABLE_SIZE - 1);
+        progress = s_swing_progress[index];
+        lift     = s_swing_lift[index];
+        frame->swing_mask |= (1 << leg);
       }
     }
 
-    /* Delay to reduce current draw */
-    vTaskDelay(pdMS_TO_TICKS(100));
+    frame->feet.x_cm[leg] = s_neutral_x_cm + s_stride_x_cm[leg] * progress;
+    frame->feet.y_cm[leg] = s_neutral_y_cm + s_stride_y_cm[leg] * progress;
+    frame->feet.z_cm[leg] = -gait_body_height_cm + gait_step_height_cm * lift;
   }
 
-  log_info(gait_tag, "Process Complete", "All motor angles set successfully");
-  return ESP_OK;
+  frame->tick  = s_tick++;
+  s_phase_q32 += s_phase_step_q32;
 }
 
-/* Public Functions ***********************************************************/
-
 esp_err_t tripod_gait(pca9685_board_t *pwm_controller, 
                       float            heading, 
                       uint16_t         distance)
@@ -363,8 +340,7 @@ esp_err_t tripod_gait(pca9685_board_t *pwm_controller,
            heading, 
            distance);
 
-  /* TODO: Implement this */
-  return ESP_OK;
+  return priv_run_gait(pwm_controller, k_gait_tripod, heading, distance);
 }
 
 esp_err_t wave_gait(pca9685_board_t *pwm_controller, 
@@ -377,8 +353,7 @@ esp_err_t wave_gait(pca9685_board_t *pwm_controller,
            heading, 
            distance);
 
-  /* TODO: Implement this */
-  return ESP_OK;
+  return priv_run_gait(pwm_controller, k_gait_wave, heading, distance);
 }
 
 esp_err_t ripple_gait(pca9685_board_t *pwm_controller, 
@@ -391,8 +366,7 @@ esp_err_t ripple_gait(pca9685_board_t *pwm_controller,
            heading, 
            distance);
 
-  /* TODO: Implement this */
-  return ESP_OK;
+  return priv_run_gait(pwm_controller, k_gait_ripple, heading, distance);
 }
 
 esp_err_t quadruped_gait(pca9685_board_t *pwm_controller, 
@@ -405,8 +379,7 @@ esp_err_t quadruped_gait(pca9685_board_t *pwm_controller,
            heading, 
            distance);
 
-  /* TODO: Implement this */
-  return ESP_OK;
+  return priv_run_gait(pwm_controller, k_gait_quadruped, heading, distance);
 }
 
 esp_err_t gait_init(pca9685_board_t *pwm_controller)
@@ -416,52 +389,48 @@ esp_err_t gait_init(pca9685_board_t *pwm_controller)
     return ESP_ERR_INVALID_ARG;
   }
 
-  /* Initialize leg configurations */
-  uint8_t          motor_index = 0;
-  uint8_t          board_id    = 0;
-  pca9685_board_t *board       = pwm_controller;
-
   log_info(gait_tag, 
            "Init Start", 
            "Beginning gait initialization, mapping motors to legs");
 
-  /* Map motors to s_legs and joints */
-  for (uint8_t leg_id = 0; leg_id < 6; ++leg_id) {
-    s_legs[leg_id].id = leg_id;
-
-    /* Assign motors to each joint */
-    esp_err_t ret1, ret2, ret3;
-    s_legs[leg_id].hip_motor   = &(board->motors[motor_index]);
-    s_legs[leg_id].knee_motor  = &(board->motors[motor_index]);
-    s_legs[leg_id].tibia_motor = &(board->motors[motor_index]);
-
-    ret1 = priv_assign_motor(s_legs[leg_id].hip_motor,   
-                             k_hip,   
-                             &board, 
-                             &motor_index, 
-                             &board_id);
-    ret2 = priv_assign_motor(s_legs[leg_id].knee_motor,  
-                             k_knee,  
-                             &board, 
-                             &motor_index, 
-                             &board_id);
-    ret3 = priv_assign_motor(s_legs[leg_id].tibia_motor, 
-                             k_tibia, 
-                             &board, 
-                             &motor_index, 
-                             &board_id);
-
-    if (ret1 != ESP_OK || ret2 != ESP_OK || ret3 != ESP_OK) {
+  /* Precompute trajectory curves so the control loop only does table lookups */
+  priv_build_trajectory_tables();
+  kinematics_init();
+
+  /* Map every joint to its servo straight from the wiring table */
+  for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; ++joint) {
+    const joint_channel_t *wiring = &joint_channels[joint];
+    if (wiring->board_id >= pwm_controller->num_boards) {
       log_error(gait_tag, 
-                "Motor Error", 
-                "Failed to assign motors for leg %u", 
-                leg_id);
+                "Board Error", 
+                "Joint %u is wired to board %u but only %u PCA9685 boards are available", 
+                joint, 
+                wiring->board_id, 
+                pwm_controller->num_boards);
       return ESP_FAIL;
     }
-    log_info(gait_tag, 
-             "Leg Init", 
-             "Successfully assigned all motors for leg %u", 
-             leg_id);
+
+    motor_t *motor    = &s_motors[joint];
+    motor->joint_type = (joint_type_t)(joint % JOINTS_PER_LEG);
+    motor->pos_deg    = 0.0f;
+    motor->board_id   = wiring->board_id;
+    motor->motor_id   = wiring->channel;
+  }
+
+  for (uint8_t leg_id = 0; leg_id < NUMBER_OF_LEGS; ++leg_id) {
+    s_legs[leg_id].id          = leg_id;
+    s_legs[leg_id].hip_motor   = &s_motors[hexapod_joint_index(leg_id, k_hip)];
+    s_legs[leg_id].knee_motor  = &s_motors[hexapod_joint_index(leg_id, k_knee)];
+    s_legs[leg_id].tibia_motor = &s_motors[hexapod_joint_index(leg_id, k_tibia)];
+  }
+
+  esp_err_t ret = motion_frame_init(pwm_controller, s_motors);
+  if (ret != ESP_OK) {
+    log_error(gait_tag, 
+              "Init Error", 
+              "Failed to set up motion frames: %s", 
+              esp_err_to_name(ret));
+    return ret;
   }
 
   log_info(gait_tag, 
@@ -4,7 +4,7 @@
 
 /* Constants ******************************************************************/
 
-/* TODO: This might also need to have custom values for each motor's max and min angles (found via trial and error w/ec11) */
+/* TODO: The joint angle limits might need custom values for each motor (found via trial and error w/ec11) */
 const float hip_angle_from_90_min   = 0.0f;   /**< This means the min is 90deg */
 const float hip_angle_from_90_max   = 60.0f;  /**< This means the max is 90+60=150deg */
 const float knee_angle_from_90_min  = 0.0f;   /**< This means the min is 90deg */
@@ -17,4 +17,16 @@ const float hip_length_cm   = 5.0f;  /**< Distance from the body center to the h
 const float femur_length_cm = 10.0f; /**< Length of the femur (thigh segment) */
 const float tibia_length_cm = 12.0f; /**< Length of the tibia (shin segment) */
 
-const uint8_t max_active_servos = 3; /**< Maximum number of servos allowed to move simultaneously */
+const uint8_t max_active_servos = 3; /**< Maximum number of servo pulses allowed to overlap within a PWM period */
+
+/* Globals ********************************************************************/
+
+/* Joints are wired in leg order, hip/knee/tibia, filling each board's 16 channels before the next */
+const joint_channel_t joint_channels[NUMBER_OF_JOINTS] = {
+  { 0,  0 }, { 0,  1 }, { 0,  2 }, /* Leg 0 */
+  { 0,  3 }, { 0,  4 }, { 0,  5 }, /* Leg 1 */
+  { 0,  6 }, { 0,  7 }, { 0,  8 }, /* Leg 2 */
+  { 0,  9 }, { 0, 10 }, { 0, 11 }, /* Leg 3 */
+  { 0, 12 }, { 0, 13 }, { 0, 14 }, /* Leg 4 */
+  { 0, 15 }, { 1,  0 }, { 1,  1 }, /* Leg 5 */
+};
@@ -0,0 +1,121 @@
+/* main/hexapod_kinematics.c */
+
+#include "hexapod_kinematics.h"
+#include <math.h>
+#include <stddef.h>
+
+/* Constants ******************************************************************/
+
+const char *kinematics_tag = "Kinematics";
+
+static const float s_rad_to_deg      = 180.0f / (float)M_PI;
+static const float s_deg_to_rad      = (float)M_PI / 180.0f;
+static const float s_reach_margin_cm = 1e-3f; /**< Keeps clamped targets strictly inside the workspace */
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Clamps a cosine argument to [-1, 1] to absorb rounding error.
+ *
+ * @param[in] value Cosine value to clamp.
+ *
+ * @return The clamped value.
+ */
+static inline float priv_clamp_unit(float value)
+{
+  if (value > 1.0f) {
+    return 1.0f;
+  }
+  if (value < -1.0f) {
+    return -1.0f;
+  }
+  return value;
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t kinematics_solve_legs(const leg_positions_t *positions, 
+                                leg_angles_t          *angles,
+                                uint8_t               *unreachable_mask)
+{
+  if (positions == NULL || angles == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  /* Terms shared by every leg, hoisted out of the loop */
+  const float femur    = femur_length_cm;
+  const float tibia    = tibia_length_cm;
+  const float femur_sq = femur * femur;
+  const float tibia_sq = tibia * tibia;
+  const float min_d    = fabsf(femur - tibia) + s_reach_margin_cm;
+  const float max_d    = femur + tibia - s_reach_margin_cm;
+  uint8_t     mask     = 0;
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    float x = positions->x_cm[leg];
+    float y = positions->y_cm[leg];
+    float z = positions->z_cm[leg];
+
+    /* Hip yaw places the leg plane through the foot */
+    float hip_rad = atan2f(y, x);
+
+    /* Planar femur/tibia problem in the leg plane */
+    float r  = sqrtf(x * x + y * y) - hip_length_cm;
+    float d2 = r * r + z * z;
+    float d  = sqrtf(d2);
+
+    if (d > max_d || d < min_d) {
+      float target = (d > max_d) ? max_d : min_d;
+      if (d > 0.0f) {
+        r *= target / d;
+        z *= target / d;
+      } else {
+        r = target; /* Degenerate target on the femur joint, reach straight out */
+        z = 0.0f;
+      }
+      d     = target;
+      d2    = target * target;
+      mask |= (1 << leg);
+    }
+
+    float femur_rad = atan2f(z, r) + 
+                      acosf(priv_clamp_unit((femur_sq + d2 - tibia_sq) / (2.0f * femur * d)));
+    float inner_rad = acosf(priv_clamp_unit((femur_sq + tibia_sq - d2) / (2.0f * femur * tibia)));
+
+    angles->hip_deg[leg]   = hip_rad * s_rad_to_deg;
+    angles->knee_deg[leg]  = femur_rad * s_rad_to_deg;
+    angles->tibia_deg[leg] = inner_rad * s_rad_to_deg - 90.0f;
+  }
+
+  if (unreachable_mask != NULL) {
+    *unreachable_mask = mask;
+  }
+  return (mask == 0) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t kinematics_forward_legs(const leg_angles_t *angles, 
+                                  leg_positions_t    *positions)
+{
+  if (angles == NULL || positions == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    float hip_rad   = angles->hip_deg[leg] * s_deg_to_rad;
+    float femur_rad = angles->knee_deg[leg] * s_deg_to_rad;
+    float inner_rad = (angles->tibia_deg[leg] + 90.0f) * s_deg_to_rad;
+
+    /* The tibia leaves the knee at (pi - inner) below the femur direction */
+    float tibia_rad = femur_rad - ((float)M_PI - inner_rad);
+    float r         = hip_length_cm + 
+                      femur_length_cm * cosf(femur_rad) + 
+                      tibia_length_cm * cosf(tibia_rad);
+
+    positions->x_cm[leg] = r * cosf(hip_rad);
+    positions->y_cm[leg] = r * sinf(hip_rad);
+    positions->z_cm[leg] = femur_length_cm * sinf(femur_rad) + 
+                           tibia_length_cm * sinf(tibia_rad);
+  }
+
+  return ESP_OK;
+}
@@ -0,0 +1,271 @@
+/* main/hexapod_kinematics_q16.c */
+
+#include "hexapod_kinematics.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Constants ******************************************************************/
+
+static const int32_t s_quarter_turn     = KINEMATICS_ANGLE_FULL_TURN / 4;
+static const int64_t s_q16_one_sq       = (int64_t)KINEMATICS_Q16_ONE * KINEMATICS_Q16_ONE;
+static const int32_t s_reach_margin_q16 = 66; /**< ~1e-3 cm, matches the float path */
+
+/* Globals (Static) ***********************************************************/
+
+static q16_t              s_sine_table[KINEMATICS_SINE_TABLE_SIZE + 1] = {0}; /* sin over [0, quarter turn], Q16 */
+static kinematics_angle_t s_atan_table[KINEMATICS_ATAN_TABLE_SIZE + 1] = {0}; /* atan over [0, 1], binary angle */
+static q16_t              s_hip_q16                                    = 0;
+static q16_t              s_femur_q16                                  = 0;
+static q16_t              s_tibia_q16                                  = 0;
+static q16_t              s_min_reach_q16                              = 0;
+static q16_t              s_max_reach_q16                              = 0;
+static kinematics_angle_t s_joint_min[3]                               = {0}; /* Absolute servo limits per joint_type_t */
+static kinematics_angle_t s_joint_max[3]                               = {0};
+static bool               s_tables_ready                               = false;
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Integer square root of a 64-bit value.
+ *
+ * The square root of a Q32 value is the Q16 root.
+ *
+ * @param[in] value Value to take the root of.
+ *
+ * @return floor(sqrt(value)).
+ */
+static uint32_t priv_isqrt64(uint64_t value)
+{
+  uint64_t result = 0;
+  uint64_t bit    = 1ULL << 62;
+
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= result + bit) {
+      value  -= result + bit;
+      result  = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)result;
+}
+
+/**
+ * @brief Table-driven arccosine.
+ *
+ * @param[in] value Cosine in Q16, clamped to [-1, 1].
+ *
+ * @return acos(value) as a binary angle in [0, half turn].
+ */
+static kinematics_angle_t priv_acos_q16(int64_t value)
+{
+  if (value > KINEMATICS_Q16_ONE) {
+    value = KINEMATICS_Q16_ONE;
+  } else if (value < -KINEMATICS_Q16_ONE) {
+    value = -KINEMATICS_Q16_ONE;
+  }
+  q16_t sine = (q16_t)priv_isqrt64((uint64_t)(s_q16_one_sq - value * value));
+  return kinematics_atan2_q16(sine, (q16_t)value);
+}
+
+/**
+ * @brief Converts a joint limit to an absolute servo binary angle.
+ *
+ * @param[in] angle_from_90_deg Limit in degrees relative to the 90° neutral.
+ *
+ * @return The absolute servo angle, 0° to 180° mapping to 0 to half a turn.
+ */
+static kinematics_angle_t priv_limit_to_angle(float angle_from_90_deg)
+{
+  return (kinematics_angle_t)lroundf((90.0f + angle_from_90_deg) *
+                                     ((float)KINEMATICS_ANGLE_FULL_TURN / 360.0f));
+}
+
+/**
+ * @brief Maps a joint angle onto an absolute servo position.
+ *
+ * @param[in] angle      Joint angle relative to the 90° neutral.
+ * @param[in] joint_type Joint the angle belongs to, selects the limits.
+ *
+ * @return The clamped servo position in 0.1° steps (0-1800).
+ */
+static inline uint16_t priv_angle_to_servo(kinematics_angle_t angle,
+                                           joint_type_t       joint_type)
+{
+  int32_t absolute = angle + s_quarter_turn;
+  if (absolute < s_joint_min[joint_type]) {
+    absolute = s_joint_min[joint_type];
+  } else if (absolute > s_joint_max[joint_type]) {
+    absolute = s_joint_max[joint_type];
+  }
+
+  /* 180° spans the half turn, so the scale is a shift */
+  return (uint16_t)((1800 * absolute + (KINEMATICS_ANGLE_HALF_TURN / 2)) >> 15);
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t kinematics_init(void)
+{
+  for (uint16_t i = 0; i <= KINEMATICS_SINE_TABLE_SIZE; ++i) {
+    float rad       = ((float)M_PI / 2.0f) * (float)i / (float)KINEMATICS_SINE_TABLE_SIZE;
+    s_sine_table[i] = kinematics_float_to_q16(sinf(rad));
+  }
+
+  for (uint16_t i = 0; i <= KINEMATICS_ATAN_TABLE_SIZE; ++i) {
+    float rad       = atanf((float)i / (float)KINEMATICS_ATAN_TABLE_SIZE);
+    s_atan_table[i] = (kinematics_angle_t)lroundf(rad * (float)KINEMATICS_ANGLE_HALF_TURN /
+                                                   (float)M_PI);
+  }
+
+  s_hip_q16       = kinematics_float_to_q16(hip_length_cm);
+  s_femur_q16     = kinematics_float_to_q16(femur_length_cm);
+  s_tibia_q16     = kinematics_float_to_q16(tibia_length_cm);
+  s_min_reach_q16 = kinematics_float_to_q16(fabsf(femur_length_cm - tibia_length_cm)) +
+                    s_reach_margin_q16;
+  s_max_reach_q16 = s_femur_q16 + s_tibia_q16 - s_reach_margin_q16;
+
+  s_joint_min[k_hip]   = priv_limit_to_angle(hip_angle_from_90_min);
+  s_joint_max[k_hip]   = priv_limit_to_angle(hip_angle_from_90_max);
+  s_joint_min[k_knee]  = priv_limit_to_angle(knee_angle_from_90_min);
+  s_joint_max[k_knee]  = priv_limit_to_angle(knee_angle_from_90_max);
+  s_joint_min[k_tibia] = priv_limit_to_angle(tibia_angle_from_90_min);
+  s_joint_max[k_tibia] = priv_limit_to_angle(tibia_angle_from_90_max);
+
+  s_tables_ready = true;
+  return ESP_OK;
+}
+
+q16_t kinematics_sin_q16(kinematics_angle_t angle)
+{
+  uint16_t turn     = (uint16_t)angle; /* Wraps to one turn */
+  uint8_t  quadrant = turn >> 14;
+  uint16_t offset   = turn & (s_quarter_turn - 1);
+
+  if (quadrant & 1) {
+    offset = s_quarter_turn - offset;
+  }
+
+  /* 16384 units per quarter over 256 intervals: 64 units per entry */
+  uint16_t index = offset >> 6;
+  int32_t  frac  = offset & 0x3F;
+  q16_t    value = s_sine_table[index];
+  if (frac != 0) {
+    value += ((s_sine_table[index + 1] - value) * frac) >> 6;
+  }
+  return (quadrant & 2) ? -value : value;
+}
+
+q16_t kinematics_cos_q16(kinematics_angle_t angle)
+{
+  return kinematics_sin_q16(angle + s_quarter_turn);
+}
+
+kinematics_angle_t kinematics_atan2_q16(q16_t y, q16_t x)
+{
+  int64_t ax = (x < 0) ? -(int64_t)x : x;
+  int64_t ay = (y < 0) ? -(int64_t)y : y;
+  if (ax == 0 && ay == 0) {
+    return 0;
+  }
+
+  /* Reduce to the first octant, where the ratio is in [0, 1] */
+  bool    swap  = ay > ax;
+  int64_t ratio = swap ? (ax << 16) / ay : (ay << 16) / ax;
+
+  /* 65536 ratio units over 256 intervals: 256 units per entry */
+  uint32_t           index = (uint32_t)(ratio >> 8);
+  int32_t            frac  = (int32_t)(ratio & 0xFF);
+  kinematics_angle_t angle = s_atan_table[index];
+  if (frac != 0) {
+    angle += ((s_atan_table[index + 1] - angle) * frac + 128) >> 8;
+  }
+
+  if (swap) {
+    angle = s_quarter_turn - angle;
+  }
+  if (x < 0) {
+    angle = KINEMATICS_ANGLE_HALF_TURN - angle;
+  }
+  return (y < 0) ? -angle : angle;
+}
+
+esp_err_t kinematics_solve_legs_q16(const leg_positions_q16_t *positions,
+                                    leg_angles_q16_t          *angles,
+                                    uint8_t                   *unreachable_mask)
+{
+  if (positions == NULL || angles == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_tables_ready) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  /* Terms shared by every leg, hoisted out of the loop (Q32) */
+  const int64_t femur_sq    = (int64_t)s_femur_q16 * s_femur_q16;
+  const int64_t tibia_sq    = (int64_t)s_tibia_q16 * s_tibia_q16;
+  const int64_t inner_denom = 2 * (int64_t)s_femur_q16 * s_tibia_q16;
+  uint8_t       mask        = 0;
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    int64_t x = positions->x_cm[leg];
+    int64_t y = positions->y_cm[leg];
+    int64_t z = positions->z_cm[leg];
+
+    /* Hip yaw places the leg plane through the foot */
+    angles->hip[leg] = kinematics_atan2_q16((q16_t)y, (q16_t)x);
+
+    /* Planar femur/tibia problem in the leg plane */
+    int64_t r  = (int64_t)priv_isqrt64((uint64_t)(x * x + y * y)) - s_hip_q16;
+    int64_t d2 = r * r + z * z;
+    int64_t d  = priv_isqrt64((uint64_t)d2);
+
+    if (d > s_max_reach_q16 || d < s_min_reach_q16) {
+      int64_t target = (d > s_max_reach_q16) ? s_max_reach_q16 : s_min_reach_q16;
+      if (d > 0) {
+        r = r * target / d;
+        z = z * target / d;
+      } else {
+        r = target; /* Degenerate target on the femur joint, reach straight out */
+        z = 0;
+      }
+      d     = target;
+      d2    = target * target;
+      mask |= (1 << leg);
+    }
+
+    int64_t cos_femur = ((femur_sq + d2 - tibia_sq) << 16) / (2 * s_femur_q16 * d);
+    int64_t cos_inner = ((femur_sq + tibia_sq - d2) << 16) / inner_denom;
+
+    angles->knee[leg]  = kinematics_atan2_q16((q16_t)z, (q16_t)r) + priv_acos_q16(cos_femur);
+    angles->tibia[leg] = priv_acos_q16(cos_inner) - s_quarter_turn;
+  }
+
+  if (unreachable_mask != NULL) {
+    *unreachable_mask = mask;
+  }
+  return (mask == 0) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t kinematics_angles_to_servo_q16(const leg_angles_q16_t *angles,
+                                         leg_servo_positions_t  *positions)
+{
+  if (angles == NULL || positions == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_tables_ready) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    positions->hip[leg]   = priv_angle_to_servo(angles->hip[leg],   k_hip);
+    positions->knee[leg]  = priv_angle_to_servo(angles->knee[leg],  k_knee);
+    positions->tibia[leg] = priv_angle_to_servo(angles->tibia[leg], k_tibia);
+  }
+  return ESP_OK;
+}
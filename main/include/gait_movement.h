@@ -7,16 +7,67 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include "esp_err.h"
 #include "pca9685_hal.h"
+#include "hexapod_kinematics.h"
 
 /* Constants ******************************************************************/
 
-extern const char *gait_tag; /**< Tag for logs */
+extern const char    *gait_tag;              /**< Tag for logs */
+extern const uint16_t gait_control_rate_hz;  /**< Rate at which the gait engine produces foot targets (ticks per second). */
+extern const uint16_t gait_cycle_ticks;      /**< Number of control ticks in one full gait cycle (swing + stance). */
+extern const float    gait_step_height_cm;   /**< Peak foot lift above the ground during swing, in centimeters. */
+extern const float    gait_max_stride_cm;    /**< Maximum distance the body travels per gait cycle, in centimeters. */
+extern const float    gait_body_height_cm;   /**< Height of the hip joints above the ground in the neutral stance. */
+extern const float    gait_neutral_reach_cm; /**< Horizontal distance from the hip joint to the foot in the neutral stance. */
+extern const float    gait_neutral_yaw_deg;  /**< Hip angle of the neutral stance, relative to 90°. */
 
 /* Macros *********************************************************************/
 
-#define NUMBER_OF_LEGS (6)
+#define GAIT_TRAJECTORY_TABLE_SIZE (64) /**< Entries per precomputed swing/stance curve; must be a power of two. */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief Leg positions around the body.
+ *
+ * Legs are numbered clockwise starting at the right front leg, so even and
+ * odd legs form the two tripods.
+ */
+typedef enum : uint8_t {
+  k_leg_right_front  = 0, /**< Right front leg. */
+  k_leg_right_middle = 1, /**< Right middle leg. */
+  k_leg_right_rear   = 2, /**< Right rear leg. */
+  k_leg_left_rear    = 3, /**< Left rear leg. */
+  k_leg_left_middle  = 4, /**< Left middle leg. */
+  k_leg_left_front   = 5, /**< Left front leg. */
+} leg_position_t;
+
+/**
+ * @brief Gait patterns supported by the gait engine.
+ */
+typedef enum : uint8_t {
+  k_gait_tripod    = 0, /**< Two alternating tripods, 50% duty factor. */
+  k_gait_wave      = 1, /**< One leg in swing at a time, 5/6 duty factor. */
+  k_gait_ripple    = 2, /**< Overlapping waves on each side, 2/3 duty factor. */
+  k_gait_quadruped = 3, /**< Four corner legs walk, middle legs held clear of the ground. */
+  k_gait_count,         /**< Number of gait patterns (not a valid gait). */
+} gait_type_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Foot targets for all legs at a single control tick.
+ *
+ * Foot positions use the leg frames described in `leg_positions_t` and can be
+ * handed straight to `kinematics_solve_legs`.
+ */
+typedef struct {
+  leg_positions_t feet;       /**< Foot target for each leg. */
+  uint8_t         swing_mask; /**< Bit N is set when leg N is in its swing phase. */
+  uint32_t        tick;       /**< Number of ticks produced since the gait was started. */
+} gait_frame_t;
 
 /* Public Functions ***********************************************************/
 
@@ -39,6 +90,39 @@ extern const char *gait_tag; /**< Tag for logs */
  */
 esp_err_t gait_init(pca9685_board_t *pwm_controller);
 
+/**
+ * @brief Configures the gait engine for a new motion.
+ *
+ * Selects the gait pattern, resolves the heading into a per-leg stride vector
+ * and resets the gait phase. All trigonometry happens here so that
+ * `gait_engine_tick` only performs table lookups and multiply-adds.
+ *
+ * @param[in] type      Gait pattern to run.
+ * @param[in] heading   Desired heading in degrees (0 is straight ahead, 90 is
+ *                      to the left).
+ * @param[in] stride_cm Distance the body travels per gait cycle, clamped to
+ *                      `gait_max_stride_cm`.
+ *
+ * @return 
+ * - `ESP_OK`                if the engine is ready to tick.
+ * - `ESP_ERR_INVALID_ARG`   if `type` is not a valid gait pattern.
+ * - `ESP_ERR_INVALID_STATE` if `gait_init` has not built the trajectory tables.
+ */
+esp_err_t gait_engine_configure(gait_type_t type, float heading, float stride_cm);
+
+/**
+ * @brief Advances the gait engine by one control tick.
+ *
+ * Produces the foot target of every leg for the current tick and then moves
+ * the gait phase forward by `1 / gait_cycle_ticks` of a cycle.
+ *
+ * @param[out] frame Foot targets for all legs.
+ *
+ * @note This runs in the control loop: it does not log, allocate or call any 
+ *       trigonometric function. `gait_engine_configure` must be called first.
+ */
+void gait_engine_tick(gait_frame_t *frame);
+
 /**
  * @brief Executes a tripod gait motion for the hexapod robot.
  *
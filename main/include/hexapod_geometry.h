@@ -21,7 +21,13 @@ extern const float   tibia_angle_from_90_max; /**< Maximum allowable angle from
 extern const float   hip_length_cm;           /**< Length of the hip segment in centimeters (from the base to the femur). */
 extern const float   femur_length_cm;         /**< Length of the femur segment in centimeters (from the femur to the tibia). */
 extern const float   tibia_length_cm;         /**< Length of the tibia segment in centimeters (from the tibia to the ground). */
-extern const uint8_t max_active_servos;       /**< Limit on simultaneously active servos to manage power draw. */
+extern const uint8_t max_active_servos;       /**< Limit on overlapping servo pulses per PWM period to manage power draw. */
+
+/* Macros *********************************************************************/
+
+#define NUMBER_OF_LEGS   (6)
+#define JOINTS_PER_LEG   (3)
+#define NUMBER_OF_JOINTS (NUMBER_OF_LEGS * JOINTS_PER_LEG)
 
 /* Enums **********************************************************************/
 
@@ -52,6 +58,14 @@ typedef struct {
   ec11_data_t  ec11_data;  /**< Data for the EC11 encoder (if applicable). */
 } motor_t;
 
+/**
+ * @brief Where a joint's servo is wired on the PCA9685 boards.
+ */
+typedef struct {
+  uint8_t board_id; /**< ID of the PCA9685 board driving the joint. */
+  uint8_t channel;  /**< Channel on that board (range: 0 to 15). */
+} joint_channel_t;
+
 /**
  * @brief Represents the configuration of a single leg in the hexapod robot.
  *
@@ -65,6 +79,25 @@ typedef struct {
   motor_t *tibia_motor; /**< Pointer to the tibia motor configuration. */
 } leg_t;
 
+/* Globals ********************************************************************/
+
+extern const joint_channel_t joint_channels[NUMBER_OF_JOINTS]; /**< Servo wiring per joint, see `hexapod_joint_index`. */
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Index of a joint in the flat per-joint tables.
+ *
+ * @param[in] leg   Leg ID (range: 0 to 5).
+ * @param[in] joint Joint on that leg.
+ *
+ * @return `leg * JOINTS_PER_LEG + joint`.
+ */
+static inline uint8_t hexapod_joint_index(uint8_t leg, joint_type_t joint)
+{
+  return leg * JOINTS_PER_LEG + joint;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,265 @@
+/* main/include/hexapod_kinematics.h */
+
+#ifndef TOPOROBO_HEXAPOD_KINEMATICS_H
+#define TOPOROBO_HEXAPOD_KINEMATICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "hexapod_geometry.h"
+
+/* Constants ******************************************************************/
+
+extern const char *kinematics_tag; /**< Tag for logs */
+
+/* Macros *********************************************************************/
+
+/* Set to 1 to drive the gait control loop through the fixed-point (Q16) path */
+#ifndef KINEMATICS_USE_FIXED_POINT
+#define KINEMATICS_USE_FIXED_POINT 0
+#endif
+
+#define KINEMATICS_Q16_ONE          (65536) /**< 1.0 in Q16.16 fixed point. */
+#define KINEMATICS_ANGLE_FULL_TURN  (65536) /**< Binary angle units in one full turn (360°). */
+#define KINEMATICS_ANGLE_HALF_TURN  (32768) /**< Binary angle units in half a turn (180°). */
+#define KINEMATICS_SINE_TABLE_SIZE  (256)   /**< Intervals in the quarter-wave sine table. */
+#define KINEMATICS_ATAN_TABLE_SIZE  (256)   /**< Intervals in the atan table over [0, 1]. */
+
+/* Typedefs *******************************************************************/
+
+typedef int32_t q16_t;              /**< Signed Q16.16 fixed-point value. */
+typedef int32_t kinematics_angle_t; /**< Binary angle, `KINEMATICS_ANGLE_FULL_TURN` units per turn. */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Foot positions for all legs, one array per axis.
+ *
+ * Positions are expressed in each leg's own frame, with the origin at the hip 
+ * joint: x points radially away from the body, y is tangential (positive 
+ * counter-clockwise when viewed from above) and z points up.
+ */
+typedef struct {
+  float x_cm[NUMBER_OF_LEGS]; /**< Radial foot position for each leg, in centimeters. */
+  float y_cm[NUMBER_OF_LEGS]; /**< Tangential foot position for each leg, in centimeters. */
+  float z_cm[NUMBER_OF_LEGS]; /**< Vertical foot position for each leg, in centimeters. */
+} leg_positions_t;
+
+/**
+ * @brief Joint angles for all legs, one array per joint.
+ *
+ * Angles are relative to the 90° servo neutral, matching the convention used
+ * by the gait layer and the `*_angle_from_90_*` joint limits:
+ * - hip:   0° points the leg radially, positive swings it counter-clockwise.
+ * - knee:  0° holds the femur level, positive raises it.
+ * - tibia: 0° holds the tibia square to the femur, positive opens the joint.
+ */
+typedef struct {
+  float hip_deg[NUMBER_OF_LEGS];   /**< Hip joint angle for each leg, in degrees. */
+  float knee_deg[NUMBER_OF_LEGS];  /**< Knee joint angle for each leg, in degrees. */
+  float tibia_deg[NUMBER_OF_LEGS]; /**< Tibia joint angle for each leg, in degrees. */
+} leg_angles_t;
+
+/**
+ * @brief Fixed-point foot positions for all legs, one array per axis.
+ *
+ * Same frames as `leg_positions_t`, with every coordinate in Q16 centimeters.
+ */
+typedef struct {
+  q16_t x_cm[NUMBER_OF_LEGS]; /**< Radial foot position for each leg, Q16 centimeters. */
+  q16_t y_cm[NUMBER_OF_LEGS]; /**< Tangential foot position for each leg, Q16 centimeters. */
+  q16_t z_cm[NUMBER_OF_LEGS]; /**< Vertical foot position for each leg, Q16 centimeters. */
+} leg_positions_q16_t;
+
+/**
+ * @brief Fixed-point joint angles for all legs, one array per joint.
+ *
+ * Same conventions as `leg_angles_t`, in binary angle units.
+ */
+typedef struct {
+  kinematics_angle_t hip[NUMBER_OF_LEGS];   /**< Hip joint angle for each leg. */
+  kinematics_angle_t knee[NUMBER_OF_LEGS];  /**< Knee joint angle for each leg. */
+  kinematics_angle_t tibia[NUMBER_OF_LEGS]; /**< Tibia joint angle for each leg. */
+} leg_angles_q16_t;
+
+/**
+ * @brief Absolute servo positions for every joint of every leg.
+ *
+ * Positions are in 0.1° steps from 0 (0°) to 1800 (180°), the index into 
+ * each channel's calibrated angle-to-tick table in the PCA9685 driver.
+ */
+typedef struct {
+  uint16_t hip[NUMBER_OF_LEGS];   /**< Hip servo position for each leg, in 0.1°. */
+  uint16_t knee[NUMBER_OF_LEGS];  /**< Knee servo position for each leg, in 0.1°. */
+  uint16_t tibia[NUMBER_OF_LEGS]; /**< Tibia servo position for each leg, in 0.1°. */
+} leg_servo_positions_t;
+
+/* Public Inline Functions ****************************************************/
+
+/**
+ * @brief Converts a float to Q16.16 fixed point.
+ *
+ * @param[in] value Value to convert.
+ *
+ * @return The value in Q16.16, rounded to nearest.
+ */
+static inline q16_t kinematics_float_to_q16(float value)
+{
+  return (q16_t)(value * (float)KINEMATICS_Q16_ONE + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief Converts degrees to a binary angle.
+ *
+ * @param[in] angle_deg Angle in degrees.
+ *
+ * @return The angle in binary angle units, rounded to nearest.
+ */
+static inline kinematics_angle_t kinematics_deg_to_angle(float angle_deg)
+{
+  float units = angle_deg * ((float)KINEMATICS_ANGLE_FULL_TURN / 360.0f);
+  return (kinematics_angle_t)(units + (units >= 0.0f ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief Converts a binary angle to degrees.
+ *
+ * @param[in] angle Binary angle to convert.
+ *
+ * @return The angle in degrees.
+ */
+static inline float kinematics_angle_to_deg(kinematics_angle_t angle)
+{
+  return (float)angle * (360.0f / (float)KINEMATICS_ANGLE_FULL_TURN);
+}
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Builds the lookup tables used by the fixed-point kinematics path.
+ *
+ * Fills the quarter-wave sine table and the arctangent table, and converts 
+ * the joint limits into binary angle units. Must be called before any `_q16` 
+ * function; `gait_init` calls it.
+ *
+ * @return `ESP_OK` on success.
+ */
+esp_err_t kinematics_init(void);
+
+/**
+ * @brief Solves the joint angles of every leg for the given foot positions.
+ *
+ * Uses the closed-form solution for a 3-DOF leg (hip yaw followed by a planar
+ * femur/tibia pair) with `hip_length_cm`, `femur_length_cm` and 
+ * `tibia_length_cm`. Targets outside the femur/tibia workspace are pulled 
+ * back onto its boundary along the same direction so the result is always 
+ * usable, and the leg is reported in `unreachable_mask`.
+ *
+ * @param[in]  positions        Foot positions for all legs.
+ * @param[out] angles           Solved joint angles for all legs.
+ * @param[out] unreachable_mask Bit N is set when leg N's target was outside 
+ *                              its workspace. May be NULL.
+ *
+ * @return 
+ * - `ESP_OK`              if every leg reached its target.
+ * - `ESP_ERR_INVALID_ARG` if `positions` or `angles` is NULL.
+ * - `ESP_FAIL`            if one or more legs were unreachable.
+ *
+ * @note This is called from the control loop and does not log.
+ */
+esp_err_t kinematics_solve_legs(const leg_positions_t *positions, 
+                                leg_angles_t          *angles,
+                                uint8_t               *unreachable_mask);
+
+/**
+ * @brief Computes the foot positions produced by the given joint angles.
+ *
+ * Forward counterpart of `kinematics_solve_legs`, using the same frames and
+ * angle conventions. Useful for checking solutions and for diagnostics.
+ *
+ * @param[in]  angles    Joint angles for all legs.
+ * @param[out] positions Resulting foot positions for all legs.
+ *
+ * @return 
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if `angles` or `positions` is NULL.
+ */
+esp_err_t kinematics_forward_legs(const leg_angles_t *angles, 
+                                  leg_positions_t    *positions);
+
+/**
+ * @brief Fixed-point counterpart of `kinematics_solve_legs`.
+ *
+ * Uses integer square roots and table-driven arctangents only, so it never 
+ * touches the FPU.
+ *
+ * @param[in]  positions        Foot positions for all legs, Q16 centimeters.
+ * @param[out] angles           Solved joint angles for all legs.
+ * @param[out] unreachable_mask Bit N is set when leg N's target was outside 
+ *                              its workspace. May be NULL.
+ *
+ * @return 
+ * - `ESP_OK`                if every leg reached its target.
+ * - `ESP_ERR_INVALID_ARG`   if `positions` or `angles` is NULL.
+ * - `ESP_ERR_INVALID_STATE` if `kinematics_init` has not been called.
+ * - `ESP_FAIL`              if one or more legs were unreachable.
+ *
+ * @note This is called from the control loop and does not log.
+ */
+esp_err_t kinematics_solve_legs_q16(const leg_positions_q16_t *positions, 
+                                    leg_angles_q16_t          *angles,
+                                    uint8_t                   *unreachable_mask);
+
+/**
+ * @brief Converts fixed-point joint angles to absolute servo positions.
+ *
+ * Adds the 90° servo neutral, clamps each joint to its limits and scales 
+ * the result to 0.1° steps with a multiply and a shift.
+ *
+ * @param[in]  angles    Joint angles for all legs.
+ * @param[out] positions Absolute servo positions for all joints.
+ *
+ * @return 
+ * - `ESP_OK`                on success.
+ * - `ESP_ERR_INVALID_ARG`   if `angles` or `positions` is NULL.
+ * - `ESP_ERR_INVALID_STATE` if `kinematics_init` has not been called.
+ */
+esp_err_t kinematics_angles_to_servo_q16(const leg_angles_q16_t *angles, 
+                                         leg_servo_positions_t  *positions);
+
+/**
+ * @brief Table-driven sine of a binary angle.
+ *
+ * @param[in] angle Binary angle.
+ *
+ * @return sin(angle) in Q16.16.
+ */
+q16_t kinematics_sin_q16(kinematics_angle_t angle);
+
+/**
+ * @brief Table-driven cosine of a binary angle.
+ *
+ * @param[in] angle Binary angle.
+ *
+ * @return cos(angle) in Q16.16.
+ */
+q16_t kinematics_cos_q16(kinematics_angle_t angle);
+
+/**
+ * @brief Table-driven four-quadrant arctangent.
+ *
+ * @param[in] y Y component, any fixed-point scale shared with `x`.
+ * @param[in] x X component, any fixed-point scale shared with `y`.
+ *
+ * @return atan2(y, x) as a binary angle in [-half turn, half turn].
+ */
+kinematics_angle_t kinematics_atan2_q16(q16_t y, q16_t x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HEXAPOD_KINEMATICS_H */
@@ -1,10 +1,10 @@
 /* main/include/managers/file_write_manager.c */
 
 /* TODO: Test this */
-/* TODO: Don't use a buffer, but like dynamically allocate memory for the file path and data */
 
 #include "file_write_manager.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -15,21 +15,12 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
 #include "log_handler.h"
 #include "time_manager.h"
 
-/* TODO: Implement a graceful shutdown mechanism for the file writer
- *
- * When power management is implemented, add a function to:
- * - Process any remaining items in the write queue
- * - Close any open files properly
- * - Free allocated resources
- * - Signal completion to allow safe power down
- *
- * This is important because sudden power loss (like unplugging the USB)
- * could lead to data corruption or loss, even with fsync() in place.
- */
-
 /* TODO: Enhance error handling mechanisms
  *
  * Current error handling primarily logs errors but doesn't provide
@@ -42,23 +33,362 @@
  * 3. Error statistics: Track error rates and types for diagnostics
  * 4. Watchdog integration: Reset the system if file operations
  *    consistently fail
- * 5. Critical data prioritization: Ensure critical data is written
- *    first and with higher reliability guarantees
  */
 
 /* Constants ******************************************************************/
 
-const char    *file_manager_tag = "FILE_MANAGER";
-const uint32_t max_pending_writes = 20;
+const char    *file_manager_tag                 = "FILE_MANAGER";
+const uint32_t file_write_default_sync_bytes    = 16 * 1024; /* Four 4 KB clusters between syncs */
+const uint32_t file_write_default_sync_interval = 1000;      /* At most a second of data lost on power loss */
+
+/* Macros *********************************************************************/
+
+#define FILE_WRITE_DRAINED_BIT (BIT0) /**< The writer task reached a drain request and closed every file. */
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief An interned file path.
+ */
+typedef struct {
+  char     file_path[MAX_FILE_PATH_LENGTH]; /**< Path relative to the mount point. */
+  uint16_t pending;                         /**< Queued requests for the path, the slot is not reused while nonzero. */
+  uint8_t  generation;                      /**< Changed whenever the slot gets a new path. */
+  bool     used;                            /**< Whether the slot holds a path. */
+  bool     pinned;                          /**< Registered by a caller, kept until released. */
+} file_write_path_t;
+
+/**
+ * @brief A pool of equally sized write buffers.
+ */
+typedef struct {
+  file_write_buffer_t *free_list; /**< Buffers not in use, guarded by s_pool_lock. */
+  SemaphoreHandle_t    available; /**< Counts the buffers in free_list. */
+} file_write_pool_t;
+
+/**
+ * @brief A priority lane of the writer task.
+ */
+typedef struct {
+  const char             *name;         /**< Lane name for logs. */
+  uint8_t                 depth;        /**< Requests the queue holds. */
+  uint8_t                 weight;       /**< Requests taken per round of a pass. */
+  uint16_t                send_wait_ms; /**< How long an enqueue waits for room, 0 never blocks. */
+  QueueHandle_t           queue;        /**< Requests waiting. */
+  file_write_lane_stats_t stats;        /**< Counters, guarded by s_lane_lock. */
+} file_write_lane_state_t;
+
+/**
+ * @brief A file kept open by the writer task.
+ */
+typedef struct {
+  FILE           *file;           /**< Open stream, unbuffered since writes are already coalesced. NULL if unused. */
+  file_write_id_t file_id;        /**< Interned path of the file. */
+  uint8_t         generation;     /**< Generation of the path slot when opened, a mismatch means the slot was reused. */
+  uint32_t        last_used;      /**< `s_use_counter` at the last write, the lowest is evicted first. */
+  uint32_t        unsynced_bytes; /**< Bytes written since the last `fsync`. */
+  TickType_t      last_sync;      /**< Tick of the last `fsync`, or of the open. */
+} file_handle_t;
 
 /* Globals (Static) ***********************************************************/
 
-static QueueHandle_t s_file_write_queue = NULL;
-static TaskHandle_t  s_file_write_task  = NULL;
-static bool          s_initialized      = false;
+/* Indexed by file_write_lane_t, the weights add up to FILE_WRITE_BATCH_SIZE */
+static file_write_lane_state_t s_lanes[k_file_write_lane_count] = {
+  { "critical",  8,  8, 100 },
+  { "telemetry", 16, 8, 0   }, /* One per small buffer, sensors never wait */
+  { "bulk",      4,  4, 500 },
+};
+
+static TaskHandle_t             s_file_write_task                                                   = NULL;
+static bool                     s_initialized                                                       = false;
+static file_write_path_t        s_paths[FILE_WRITE_MAX_PATHS]                                       = {0};   /* Indexed by file_write_id_t */
+static SemaphoreHandle_t        s_path_mutex                                                        = NULL;  /* Guards s_paths except strings with pending requests */
+static uint8_t                  s_small_data[FILE_WRITE_SMALL_BUFFERS][FILE_WRITE_SMALL_BUFFER_SIZE] = {0};
+static uint8_t                  s_large_data[FILE_WRITE_LARGE_BUFFERS][FILE_WRITE_LARGE_BUFFER_SIZE] = {0};
+static file_write_buffer_t      s_buffers[FILE_WRITE_SMALL_BUFFERS + FILE_WRITE_LARGE_BUFFERS]      = {0};
+static file_write_pool_t        s_pools[2]                                                          = {0};   /* Small, then large */
+static portMUX_TYPE             s_pool_lock                                                         = portMUX_INITIALIZER_UNLOCKED;
+static file_handle_t            s_handles[FILE_WRITE_MAX_OPEN_FILES]                                = {0};
+static uint32_t                 s_use_counter                                                       = 0;
+static char                     s_known_dirs[FILE_WRITE_DIR_CACHE_SIZE][MAX_FILE_PATH_LENGTH]       = {0};   /* Directories known to exist, full paths */
+static uint8_t                  s_next_known_dir                                                    = 0;     /* Slot replaced by the next new directory */
+static file_write_request_t     s_batch[FILE_WRITE_BATCH_SIZE]                                      = {0};   /* Requests of the current pass, buffer NULL once written */
+static file_write_lane_t        s_batch_lanes[FILE_WRITE_BATCH_SIZE]                                = {0};   /* Lane of each request in s_batch */
+static portMUX_TYPE             s_lane_lock                                                         = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t                  s_coalesce_buffer[FILE_WRITE_COALESCE_BUFFER_SIZE]                  = {0};   /* Bytes collected for one file */
+static size_t                   s_coalesce_length                                                   = 0;
+static char                     s_timestamp[TIMESTAMP_BUFFER_SIZE]                                  = {0};   /* Formatted s_timestamp_time */
+static time_t                   s_timestamp_time                                                    = 0;
+static bool                     s_sd_was_available                                                  = false;
+static file_write_sync_policy_t s_sync_policy                                                       = {0};
+static file_write_stats_t       s_stats                                                             = {0};
+static EventGroupHandle_t       s_file_write_events                                                 = NULL;  /* FILE_WRITE_DRAINED_BIT */
+static SemaphoreHandle_t        s_drain_mutex                                                       = NULL;  /* One drain request in flight at a time */
+static volatile bool            s_stopped                                                           = false; /* Enqueue functions refuse requests, see file_write_shutdown */
+static bool                     s_closed                                                            = false; /* Shut down and drained, writer task only */
+static volatile uint8_t         s_drain_sequence                                                    = 0;     /* Sequence of the last drain request, under s_drain_mutex */
+static volatile uint8_t         s_drained_sequence                                                  = 0;     /* Sequence of the last drain the writer finished */
 
 /* Private Functions **********************************************************/
 
+/**
+ * @brief Links a pool's buffers into its free list
+ * 
+ * @param[in] pool     Index in s_pools
+ * @param[in] buffers  First buffer of the pool in s_buffers
+ * @param[in] data     Storage of the pool's buffers
+ * @param[in] count    Number of buffers
+ * @param[in] capacity Bytes per buffer
+ * @return ESP_OK if successful, ESP_ERR_NO_MEM if the semaphore cannot be created
+ */
+static esp_err_t priv_pool_init(uint8_t              pool,
+                                file_write_buffer_t *buffers,
+                                uint8_t             *data,
+                                uint32_t             count,
+                                uint16_t             capacity)
+{
+  s_pools[pool].available = xSemaphoreCreateCounting(count, count);
+  if (s_pools[pool].available == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  
+  s_pools[pool].free_list = NULL;
+  for (uint32_t i = 0; i < count; i++) {
+    buffers[i].data         = &data[i * capacity];
+    buffers[i].capacity     = capacity;
+    buffers[i].pool         = pool;
+    buffers[i].next         = s_pools[pool].free_list;
+    s_pools[pool].free_list = &buffers[i];
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Takes a buffer from a pool
+ * 
+ * @param[in] pool Index in s_pools
+ * @param[in] wait Ticks to wait for a free buffer
+ * @return The buffer, NULL if none became free in time
+ */
+static file_write_buffer_t *priv_pool_take(uint8_t pool, TickType_t wait)
+{
+  if (xSemaphoreTake(s_pools[pool].available, wait) != pdTRUE) {
+    return NULL;
+  }
+  
+  portENTER_CRITICAL(&s_pool_lock);
+  file_write_buffer_t *buffer = s_pools[pool].free_list;
+  s_pools[pool].free_list     = buffer->next;
+  portEXIT_CRITICAL(&s_pool_lock);
+  
+  buffer->next   = NULL;
+  buffer->refs   = 1;
+  buffer->length = 0;
+  return buffer;
+}
+
+/**
+ * @brief Interns a path and counts a request queued for it
+ * 
+ * @param[in]  file_path Path relative to the mount point
+ * @param[in]  pin       Whether the slot is kept until released
+ * @param[in]  reserve   Whether a queued request is counted, so the slot is not reused
+ * @param[out] file_id   ID of the path
+ * @return ESP_OK if successful, ESP_ERR_NO_MEM if every slot is in use
+ */
+static esp_err_t priv_intern_path(const char      *file_path, 
+                                  bool             pin,
+                                  bool             reserve,
+                                  file_write_id_t *file_id)
+{
+  xSemaphoreTake(s_path_mutex, portMAX_DELAY);
+  
+  /* Reuse the path's slot, else an empty one, else one nothing refers to */
+  int32_t slot   = -1;
+  int32_t empty  = -1;
+  int32_t unused = -1;
+  for (uint8_t i = 0; i < FILE_WRITE_MAX_PATHS && slot < 0; i++) {
+    file_write_path_t *path = &s_paths[i];
+    if (!path->used) {
+      empty = (empty < 0) ? i : empty;
+    } else if (strcmp(path->file_path, file_path) == 0) {
+      slot = i;
+    } else if (!path->pinned && path->pending == 0) {
+      unused = (unused < 0) ? i : unused;
+    }
+  }
+  
+  if (slot < 0) {
+    slot = (empty >= 0) ? empty : unused;
+    if (slot < 0) {
+      xSemaphoreGive(s_path_mutex);
+      return ESP_ERR_NO_MEM;
+    }
+    file_write_path_t *path = &s_paths[slot];
+    strcpy(path->file_path, file_path);
+    path->generation++;
+    path->used   = true;
+    path->pinned = false;
+  }
+  
+  s_paths[slot].pinned  |= pin;
+  s_paths[slot].pending += reserve ? 1 : 0;
+  *file_id               = slot;
+  
+  xSemaphoreGive(s_path_mutex);
+  return ESP_OK;
+}
+
+/**
+ * @brief Counts queued requests for a path as done
+ * 
+ * @param[in] file_id  ID the requests were queued for
+ * @param[in] requests Number of requests done
+ */
+static void priv_path_done(file_write_id_t file_id, uint32_t requests)
+{
+  xSemaphoreTake(s_path_mutex, portMAX_DELAY);
+  s_paths[file_id].pending -= requests;
+  xSemaphoreGive(s_path_mutex);
+}
+
+/**
+ * @brief Queues a request whose path already counts it as pending
+ * 
+ * Releases the buffer and the pending count if the request is refused.
+ * The lane is marked congested when it fills up or refuses a request,
+ * which is logged once per congestion rather than per request.
+ * 
+ * @param[in] file_id ID of the target file
+ * @param[in] buffer  Data to write, the request takes the reference
+ * @param[in] lane    Lane to queue in
+ * @param[in] flags   `file_write_flags_t` values
+ * @return ESP_OK if successful, ESP_ERR_INVALID_STATE if the writer is shut
+ *         down, ESP_FAIL if the lane stayed full
+ */
+static esp_err_t priv_enqueue(file_write_id_t      file_id, 
+                              file_write_buffer_t *buffer, 
+                              file_write_lane_t    lane,
+                              uint8_t              flags)
+{
+  if (s_stopped) {
+    file_write_buffer_release(buffer);
+    priv_path_done(file_id, 1);
+    return ESP_ERR_INVALID_STATE;
+  }
+  
+  file_write_lane_state_t *state   = &s_lanes[lane];
+  file_write_request_t     request = {
+    .buffer     = buffer,
+    .enqueue_us = (uint32_t)esp_timer_get_time(),
+    .file_id    = file_id,
+    .flags      = flags,
+  };
+  
+  bool sent = xQueueSend(state->queue, &request, pdMS_TO_TICKS(state->send_wait_ms)) == pdTRUE;
+  
+  uint32_t queued = uxQueueMessagesWaiting(state->queue);
+  portENTER_CRITICAL(&s_lane_lock);
+  bool was_congested = state->stats.congested;
+  if (sent) {
+    state->stats.enqueued++;
+    if (queued > state->stats.high_water) {
+      state->stats.high_water = queued;
+    }
+  } else {
+    state->stats.dropped++;
+  }
+  if (!sent || queued * 4 >= state->depth * 3u) {
+    state->stats.congested = true;
+  }
+  portEXIT_CRITICAL(&s_lane_lock);
+  
+  if (!was_congested && state->stats.congested) {
+    log_warn(file_manager_tag, 
+             "Lane Congested", 
+             "The %s lane is %s, writing %s", 
+             state->name,
+             sent ? "filling up" : "full",
+             s_paths[file_id].file_path);
+  }
+  
+  if (!sent) {
+    file_write_buffer_release(buffer);
+    priv_path_done(file_id, 1);
+    return ESP_FAIL;
+  }
+  xTaskNotifyGive(s_file_write_task);
+  return ESP_OK;
+}
+
+/**
+ * @brief Copies data into a pooled buffer and queues it for a path
+ * 
+ * @param[in] file_path   Path relative to the mount point, interned on the way
+ * @param[in] data        Data to write
+ * @param[in] data_length Bytes of data
+ * @param[in] lane        Lane to queue in
+ * @param[in] flags       `file_write_flags_t` values
+ * @return ESP_OK if successful, ESP_ERR_INVALID_ARG if the data or path is
+ *         too long, ESP_ERR_INVALID_STATE if the writer is shut down,
+ *         ESP_FAIL otherwise
+ */
+static esp_err_t priv_copy_enqueue(const char       *file_path,
+                                   const void       *data,
+                                   size_t            data_length,
+                                   file_write_lane_t lane,
+                                   uint8_t           flags)
+{
+  if (s_stopped) {
+    return ESP_ERR_INVALID_STATE; /* Before taking a buffer the writer would only drop */
+  }
+  if (data_length > FILE_WRITE_LARGE_BUFFER_SIZE || strlen(file_path) >= MAX_FILE_PATH_LENGTH) {
+    log_error(file_manager_tag, 
+              "Enqueue Error", 
+              "Write request for %s too large: %zu bytes", 
+              file_path, 
+              data_length);
+    return ESP_ERR_INVALID_ARG;
+  }
+  
+  /* A lane that never waits for queue space doesn't wait for a buffer either */
+  file_write_lane_state_t *state  = &s_lanes[lane];
+  file_write_buffer_t     *buffer = file_write_buffer_alloc(data_length, 
+                                                            pdMS_TO_TICKS(state->send_wait_ms));
+  if (buffer == NULL) {
+    portENTER_CRITICAL(&s_lane_lock);
+    state->stats.dropped++;
+    portEXIT_CRITICAL(&s_lane_lock);
+    log_error(file_manager_tag, 
+              "Memory Error", 
+              "No free write buffer for %s", 
+              file_path);
+    return ESP_FAIL;
+  }
+  memcpy(buffer->data, data, data_length);
+  buffer->length = data_length;
+  
+  file_write_id_t file_id;
+  if (priv_intern_path(file_path, false, true, &file_id) != ESP_OK) {
+    log_error(file_manager_tag, 
+              "Enqueue Error", 
+              "No free path slot for %s", 
+              file_path);
+    file_write_buffer_release(buffer);
+    return ESP_FAIL;
+  }
+  
+  esp_err_t ret = priv_enqueue(file_id, buffer, lane, flags);
+  if (ret == ESP_OK) {
+    log_debug(file_manager_tag, 
+              "Enqueue Success", 
+              "Enqueued write request for file: %s (%zu bytes)", 
+              file_path, 
+              data_length);
+  }
+  return ret;
+}
+
 /**
  * @brief Creates all directories in a file path if they don't exist
  * 
@@ -92,6 +422,13 @@ static esp_err_t priv_create_directories(const char *file_path)
     return ESP_OK;
   }
   
+  /* Skip the stat/mkdir walk for directories already seen */
+  for (uint8_t i = 0; i < FILE_WRITE_DIR_CACHE_SIZE; i++) {
+    if (strcmp(s_known_dirs[i], path_copy) == 0) {
+      return ESP_OK;
+    }
+  }
+  
   /* Create the directory path recursively */
   char *p = path_copy;
   
@@ -138,173 +475,447 @@ static esp_err_t priv_create_directories(const char *file_path)
     }
   }
   
+  if (strlen(path_copy) < MAX_FILE_PATH_LENGTH) {
+    strcpy(s_known_dirs[s_next_known_dir], path_copy);
+    s_next_known_dir = (s_next_known_dir + 1) % FILE_WRITE_DIR_CACHE_SIZE;
+  }
   return ESP_OK;
 }
 
 /**
- * @brief Writes a string to a file with timestamp
+ * @brief Commits a file's written data to the SD card
  * 
- * @param[in] file_path Path to the file
- * @param[in] data      String to write
- * @return ESP_OK if successful, ESP_FAIL otherwise
+ * @param[in,out] handle Open file to sync
  */
-static esp_err_t priv_write_to_file(const char *file_path, const char *data)
+static void priv_sync_handle(file_handle_t *handle)
 {
-  if (file_path == NULL || data == NULL) {
-    log_error(file_manager_tag, 
-              "Write Error", 
-              "Invalid arguments: file_path or data is NULL");
-    return ESP_ERR_INVALID_ARG;
+  if (fsync(fileno(handle->file)) != 0) {
+    log_warn(file_manager_tag, 
+             "Sync Failed", 
+             "Failed to sync file: %s (errno: %d)", 
+             s_paths[handle->file_id].file_path, 
+             errno);
   }
-  
-  /* Check if SD card is available */
-  if (!sd_card_is_available()) {
-    log_error(file_manager_tag, 
-              "SD Card Error", 
-              "SD card not available, cannot write to file: %s", 
-              file_path);
-    return ESP_FAIL;
+  handle->unsynced_bytes = 0;
+  handle->last_sync      = xTaskGetTickCount();
+  s_stats.syncs++;
+}
+
+/**
+ * @brief Closes a cached file and frees its slot
+ * 
+ * @param[in,out] handle Open file to close
+ * @param[in]     sync   Whether unsynced data should be synced first, false
+ *                       when the SD card is gone
+ */
+static void priv_close_handle(file_handle_t *handle, bool sync)
+{
+  if (handle->file == NULL) {
+    return;
+  }
+  if (sync && handle->unsynced_bytes > 0) {
+    priv_sync_handle(handle);
+  }
+  fclose(handle->file);
+  memset(handle, 0, sizeof(*handle));
+}
+
+/**
+ * @brief Closes every cached file and forgets the known directories
+ * 
+ * @param[in] sync Whether unsynced data should be synced first
+ */
+static void priv_close_all_handles(bool sync)
+{
+  for (uint8_t i = 0; i < FILE_WRITE_MAX_OPEN_FILES; i++) {
+    priv_close_handle(&s_handles[i], sync);
+  }
+  memset(s_known_dirs, 0, sizeof(s_known_dirs));
+}
+
+/**
+ * @brief Returns the open file for a path, opening it if it is not cached
+ * 
+ * When every slot is in use, the least recently written file is closed.
+ * The path cannot change meanwhile, a request for it is pending.
+ * 
+ * @param[in] file_id Interned path of the file
+ * @return Open file, NULL if it could not be opened
+ */
+static file_handle_t *priv_get_handle(file_write_id_t file_id)
+{
+  const char    *file_path  = s_paths[file_id].file_path;
+  uint8_t        generation = s_paths[file_id].generation;
+  file_handle_t *slot       = &s_handles[0];
+  for (uint8_t i = 0; i < FILE_WRITE_MAX_OPEN_FILES; i++) {
+    file_handle_t *handle = &s_handles[i];
+    if (handle->file != NULL && handle->file_id == file_id && handle->generation == generation) {
+      handle->last_used = ++s_use_counter;
+      return handle;
+    }
+    if (slot->file != NULL && (handle->file == NULL || handle->last_used < slot->last_used)) {
+      slot = handle;
+    }
   }
+  priv_close_handle(slot, true);
   
   /* Prepend the SD card mount path to the file path */
   char full_path[MAX_FILE_PATH_LENGTH * 2];
   snprintf(full_path, sizeof(full_path), "%s/%s", sd_card_mount_path, file_path);
   
   /* Create directories if they don't exist */
-  esp_err_t ret = priv_create_directories(full_path);
-  if (ret != ESP_OK) {
+  if (priv_create_directories(full_path) != ESP_OK) {
     log_error(file_manager_tag, 
               "Dir Create Error", 
               "Failed to create directories for file: %s", 
               full_path);
-    return ret;
+    return NULL;
   }
   
-  /* Open the file for writing (append mode) */
-  FILE *file = fopen(full_path, "a");
+  /* Text and binary data are both appended as bytes */
+  FILE *file = fopen(full_path, "ab");
   if (file == NULL) {
     log_error(file_manager_tag, 
               "File Open Error", 
               "Failed to open file: %s (errno: %d)",
               full_path, 
               errno);
-    return ESP_FAIL;
+    return NULL;
   }
+  setvbuf(file, NULL, _IONBF, 0);
   
-  /* Get current timestamp */
-  char   timestamp[TIMESTAMP_BUFFER_SIZE];
-  time_t now         = time(NULL);
-  struct tm timeinfo = { 0 };
-  localtime_r(&now, &timeinfo);
-  
-  /* Format timestamp */
-  snprintf(timestamp, 
-           sizeof(timestamp), 
-           "%04d-%02d-%02d %02d:%02d:%02d",
-           timeinfo.tm_year + 1900, 
-           timeinfo.tm_mon + 1, 
-           timeinfo.tm_mday,
-           timeinfo.tm_hour, 
-           timeinfo.tm_min, 
-           timeinfo.tm_sec);
-  
-  /* Write timestamp and data to file */
-  fprintf(file, "%s: %s\n", timestamp, data);
-  
-  /* Ensure data is written to disk */
-  fflush(file);
-  fsync(fileno(file));
-  
-  /* Close file */
-  fclose(file);
-  
-  log_debug(file_manager_tag, 
-            "Write Success", 
-            "Data written to file: %s", 
-            file_path);
-  return ESP_OK;
+  slot->file           = file;
+  slot->file_id        = file_id;
+  slot->generation     = generation;
+  slot->last_used      = ++s_use_counter;
+  slot->unsynced_bytes = 0;
+  slot->last_sync      = xTaskGetTickCount();
+  s_stats.opens++;
+  return slot;
 }
 
 /**
- * @brief Writes binary data to a file
+ * @brief Writes the collected bytes to a file
  * 
- * @param[in] file_path   Path to the file
- * @param[in] data        Binary data to write
- * @param[in] data_length Length of the binary data
+ * @param[in,out] handle Open file the bytes belong to
+ * @param[in]     data   Bytes to write
+ * @param[in]     length Number of bytes
  * @return ESP_OK if successful, ESP_FAIL otherwise
  */
-static esp_err_t priv_write_binary_to_file(const char *file_path, 
-                                           const void *data, 
-                                           uint32_t    data_length)
+static esp_err_t priv_write_handle(file_handle_t *handle, const void *data, size_t length)
 {
-  if (file_path == NULL || data == NULL || data_length == 0) {
-    log_error(file_manager_tag, 
-              "Binary Write Error", 
-              "Invalid arguments: file_path or data is NULL, or data_length is 0");
-    return ESP_ERR_INVALID_ARG;
+  if (length == 0) {
+    return ESP_OK;
   }
   
-  /* Check if SD card is available */
-  if (!sd_card_is_available()) {
+  size_t bytes_written = fwrite(data, 1, length, handle->file);
+  s_stats.writes++;
+  s_stats.bytes          += bytes_written;
+  handle->unsynced_bytes += bytes_written;
+  if (bytes_written != length) {
     log_error(file_manager_tag, 
-              "SD Card Error", 
-              "SD card not available, cannot write binary data to file: %s", 
-              file_path);
+              "Write Error", 
+              "Failed to write all data to %s: %zu of %zu bytes written (errno: %d)",
+              s_paths[handle->file_id].file_path,
+              bytes_written, 
+              length,
+              errno);
     return ESP_FAIL;
   }
+  return ESP_OK;
+}
+
+/**
+ * @brief Appends a request's data to the bytes collected for its file
+ * 
+ * Text requests get the `YYYY-MM-DD HH:MM:SS: ` prefix and a newline.
+ * The collected bytes are written whenever the next request does not fit.
+ * 
+ * @param[in,out] handle  Open file of the request
+ * @param[in]     request Request to append
+ * @return ESP_OK if successful, ESP_FAIL otherwise
+ */
+static esp_err_t priv_coalesce_request(file_handle_t *handle, const file_write_request_t *request)
+{
+  const char *prefix      = "";
+  const bool  is_binary   = (request->flags & k_file_write_binary) != 0;
+  const void *data        = request->buffer->data;
+  size_t      data_length = request->buffer->length;
+  if (!is_binary) {
+    /* Seconds resolution, so the timestamp is formatted at most once per second */
+    time_t now = time(NULL);
+    if (now != s_timestamp_time || s_timestamp[0] == '\0') {
+      struct tm timeinfo = { 0 };
+      localtime_r(&now, &timeinfo);
+      snprintf(s_timestamp, 
+               sizeof(s_timestamp), 
+               "%04d-%02d-%02d %02d:%02d:%02d: ",
+               timeinfo.tm_year + 1900, 
+               timeinfo.tm_mon + 1, 
+               timeinfo.tm_mday,
+               timeinfo.tm_hour, 
+               timeinfo.tm_min, 
+               timeinfo.tm_sec);
+      s_timestamp_time = now;
+    }
+    prefix = s_timestamp;
+  }
   
-  /* Prepend the SD card mount path to the file path */
-  char full_path[MAX_FILE_PATH_LENGTH * 2];
-  snprintf(full_path, sizeof(full_path), "%s/%s", sd_card_mount_path, file_path);
+  size_t prefix_length = strlen(prefix);
+  size_t line_length   = prefix_length + data_length + (is_binary ? 0 : 1);
+  if (s_coalesce_length + line_length > sizeof(s_coalesce_buffer)) {
+    esp_err_t ret     = priv_write_handle(handle, s_coalesce_buffer, s_coalesce_length);
+    s_coalesce_length = 0;
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
   
-  /* Create directories if they don't exist */
-  esp_err_t ret = priv_create_directories(full_path);
-  if (ret != ESP_OK) {
-    log_error(file_manager_tag, 
-              "Dir Create Error", 
-              "Failed to create directories for binary file: %s", 
-              full_path);
-    return ret;
+  /* Larger than the whole buffer, only binary requests can be */
+  if (line_length > sizeof(s_coalesce_buffer)) {
+    return priv_write_handle(handle, data, data_length);
   }
   
-  /* Open the file for writing (binary mode) */
-  FILE *file = fopen(full_path, "wb");
-  if (file == NULL) {
-    log_error(file_manager_tag, 
-              "Binary File Open Error", 
-              "Failed to open file: %s (errno: %d)",
-              full_path, 
-              errno);
-    return ESP_FAIL;
+  memcpy(&s_coalesce_buffer[s_coalesce_length], prefix, prefix_length);
+  s_coalesce_length += prefix_length;
+  memcpy(&s_coalesce_buffer[s_coalesce_length], data, data_length);
+  s_coalesce_length += data_length;
+  if (!is_binary) {
+    s_coalesce_buffer[s_coalesce_length++] = '\n';
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Writes every request of the current pass, one file at a time
+ * 
+ * Requests for the same file are combined in their queued order.
+ * 
+ * @param[in] count Requests in s_batch
+ */
+static void priv_write_batch(uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    if (s_batch[i].buffer == NULL) {
+      continue; /* Already written with an earlier request for its file */
+    }
+    
+    file_write_id_t file_id  = s_batch[i].file_id;
+    file_handle_t  *handle   = priv_get_handle(file_id);
+    esp_err_t       ret      = (handle != NULL) ? ESP_OK : ESP_FAIL;
+    bool            critical = false;
+    uint32_t        requests = 0;
+    
+    s_coalesce_length = 0;
+    for (uint32_t j = i; j < count; j++) {
+      file_write_request_t *request = &s_batch[j];
+      if (request->buffer == NULL || request->file_id != file_id) {
+        continue;
+      }
+      if (ret == ESP_OK) {
+        ret = priv_coalesce_request(handle, request);
+      }
+      critical |= (request->flags & k_file_write_critical) != 0;
+      requests++;
+      file_write_buffer_release(request->buffer);
+      request->buffer = NULL;
+    }
+    if (ret == ESP_OK) {
+      ret = priv_write_handle(handle, s_coalesce_buffer, s_coalesce_length);
+    }
+    
+    if (ret != ESP_OK) {
+      s_stats.failed += requests;
+      if (handle != NULL) {
+        /* Reopened on the next write, in case the stream is in an error state */
+        priv_close_handle(handle, false);
+      }
+    } else {
+      if ((critical && s_sync_policy.sync_on_critical) ||
+          (s_sync_policy.sync_bytes > 0 && handle->unsynced_bytes >= s_sync_policy.sync_bytes)) {
+        priv_sync_handle(handle);
+      }
+      log_debug(file_manager_tag, 
+                "Write Success", 
+                "%lu requests written to file: %s", 
+                requests,
+                s_paths[file_id].file_path);
+    }
+    priv_path_done(file_id, requests);
+  }
+}
+
+/**
+ * @brief Syncs files whose data has been unsynced for the sync interval
+ */
+static void priv_sync_expired_handles(void)
+{
+  if (s_sync_policy.sync_interval_ms == 0) {
+    return;
   }
   
-  /* Write the binary data to the file */
-  size_t bytes_written = fwrite(data, 1, data_length, file);
-  if (bytes_written != data_length) {
+  TickType_t now = xTaskGetTickCount();
+  for (uint8_t i = 0; i < FILE_WRITE_MAX_OPEN_FILES; i++) {
+    file_handle_t *handle = &s_handles[i];
+    if (handle->file != NULL && 
+        handle->unsynced_bytes > 0 &&
+        now - handle->last_sync >= pdMS_TO_TICKS(s_sync_policy.sync_interval_ms)) {
+      priv_sync_handle(handle);
+    }
+  }
+}
+
+/**
+ * @brief Releases a batch without writing it
+ * 
+ * @param[in] count  Requests in s_batch
+ * @param[in] reason Why the requests are dropped, for the log
+ */
+static void priv_drop_batch(uint32_t count, const char *reason)
+{
+  uint32_t dropped = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    file_write_buffer_release(s_batch[i].buffer);
+    priv_path_done(s_batch[i].file_id, 1);
+    dropped++;
+  }
+  if (dropped > 0) {
     log_error(file_manager_tag, 
-              "Binary Write Error", 
-              "Failed to write all data: %zu of %lu bytes written",
-              bytes_written, 
-              data_length);
+              "Write Dropped", 
+              "%s, dropping %lu write requests", 
+              reason,
+              dropped);
+  }
+  s_stats.failed += dropped;
+}
+
+/**
+ * @brief Takes the next batch of requests from the lanes
+ * 
+ * Takes up to each lane's weight in turn, critical first, and goes round
+ * again while there is room, so idle lanes leave their share to the others.
+ * 
+ * @param[in,out] budget Requests still allowed per lane, decremented, or
+ *                       NULL for no limit
+ * @return Requests in s_batch
+ */
+static uint32_t priv_take_batch(uint32_t *budget)
+{
+  uint32_t count = 0;
+  bool     took  = true;
+  while (count < FILE_WRITE_BATCH_SIZE && took) {
+    took = false;
+    for (uint8_t lane = 0; lane < k_file_write_lane_count; lane++) {
+      file_write_lane_state_t *state = &s_lanes[lane];
+      uint32_t                 taken = 0;
+      while (taken < state->weight && 
+             count < FILE_WRITE_BATCH_SIZE &&
+             (budget == NULL || budget[lane] > 0) &&
+             xQueueReceive(state->queue, &s_batch[count], 0) == pdTRUE) {
+        s_batch_lanes[count++] = lane;
+        taken++;
+        if (budget != NULL) {
+          budget[lane]--;
+        }
+      }
+      if (taken > 0 && uxQueueMessagesWaiting(state->queue) * 4 <= state->depth) {
+        portENTER_CRITICAL(&s_lane_lock);
+        state->stats.congested = false;
+        portEXIT_CRITICAL(&s_lane_lock);
+      }
+      took |= (taken > 0);
+    }
+  }
+  s_stats.requests += count;
+  return count;
+}
+
+/**
+ * @brief Writes or drops a batch, then counts it per lane
+ * 
+ * @param[in] count Requests in s_batch
+ */
+static void priv_process_batch(uint32_t count)
+{
+  if (s_closed && !s_stopped) {
+    s_closed = false; /* Resumed */
   }
   
-  /* Ensure data is written to disk */
-  fflush(file);
-  fsync(fileno(file));
+  /* Check if SD card is available */
+  bool available = sd_card_is_available();
+  if (!available) {
+    if (s_sd_was_available) {
+      /* The open files belong to the removed card */
+      priv_close_all_handles(false);
+    }
+    priv_drop_batch(count, "SD card not available");
+  } else if (s_closed) {
+    /* Raced with file_write_shutdown, the files must stay closed */
+    priv_drop_batch(count, "File writer shut down");
+  } else {
+    priv_write_batch(count);
+  }
+  s_sd_was_available = available;
   
-  /* Close the file */
-  fclose(file);
+  /* Latency up to the end of the pass, the requests' data is written by now */
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  portENTER_CRITICAL(&s_lane_lock);
+  for (uint32_t i = 0; i < count; i++) {
+    file_write_lane_stats_t *stats   = &s_lanes[s_batch_lanes[i]].stats;
+    uint32_t                 latency = now - s_batch[i].enqueue_us;
+    stats->completed++;
+    stats->total_latency_us += latency;
+    if (latency > stats->max_latency_us) {
+      stats->max_latency_us = latency;
+    }
+  }
+  portEXIT_CRITICAL(&s_lane_lock);
+}
+
+/**
+ * @brief Asks the writer task for a drain and waits until it is done
+ * 
+ * Each drain has a sequence number, so a drain that timed out and finishes
+ * late does not end a later wait early.
+ * 
+ * @param[in] timeout Longest wait
+ * @return ESP_OK if every earlier request is done and the files are closed,
+ *         ESP_ERR_TIMEOUT otherwise
+ */
+static esp_err_t priv_drain(TickType_t timeout)
+{
+  TickType_t start = xTaskGetTickCount();
+  if (xSemaphoreTake(s_drain_mutex, timeout) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
   
-  log_debug(file_manager_tag, 
-            "Binary Write Success", 
-            "Binary data written to file: %s (%lu bytes)",
-            file_path, 
-            data_length);
-  return ESP_OK;
+  uint8_t sequence = s_drain_sequence + 1;
+  s_drain_sequence = sequence;
+  xTaskNotifyGive(s_file_write_task);
+  while (s_drained_sequence != sequence) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= timeout) {
+      break;
+    }
+    xEventGroupWaitBits(s_file_write_events, 
+                        FILE_WRITE_DRAINED_BIT, 
+                        pdTRUE, 
+                        pdTRUE, 
+                        timeout - elapsed);
+  }
+  esp_err_t ret = (s_drained_sequence == sequence) ? ESP_OK : ESP_ERR_TIMEOUT;
+  
+  xSemaphoreGive(s_drain_mutex);
+  return ret;
 }
 
 /**
- * @brief Task that processes file write requests from the queue
+ * @brief Task that processes file write requests from the lanes
+ * 
+ * Woken by a notification per request. Takes one weighted batch per pass,
+ * writes it per file and wakes up at least once per sync interval to sync
+ * files that went quiet. For a drain it handles every request that was
+ * queued when the drain was asked for, then syncs and closes every file.
  * 
  * @param param Task parameters (unused)
  */
@@ -312,34 +923,36 @@ static void priv_file_write_task(void *param)
 {
   log_info(file_manager_tag, "Task Start", "File write task started");
   
+  bool more = false;
   while (1) {
-    /* Wait for a request from the queue */
-    file_write_request_t request;
+    TickType_t wait = (s_sync_policy.sync_interval_ms > 0) ? 
+                      pdMS_TO_TICKS(s_sync_policy.sync_interval_ms) : 
+                      portMAX_DELAY;
+    ulTaskNotifyTake(pdTRUE, more ? 0 : wait);
     
-    if (xQueueReceive(s_file_write_queue, &request, portMAX_DELAY) == pdTRUE) {
-      /* Check if this is a binary request */
-      if (request.is_binary) {
-        /* Process binary write request */
-        priv_write_binary_to_file(request.file_path,
-                                  request.data,
-                                  request.data_length);
-        
-        /* Free the allocated data buffer */
-        if (request.data) {
-          free(request.data);
-          request.data = NULL;
-        }
-      } else {
-        /* Process text write request */
-        priv_write_to_file(request.file_path, (const char *)request.data);
-        
-        /* Free the allocated data buffer */
-        if (request.data) {
-          free(request.data);
-          request.data = NULL;
-        }
+    /* Read before the lanes, so every request queued before the drain was asked for is counted */
+    uint8_t drain = s_drain_sequence;
+    if (drain != s_drained_sequence) {
+      uint32_t budget[k_file_write_lane_count];
+      for (uint8_t lane = 0; lane < k_file_write_lane_count; lane++) {
+        budget[lane] = uxQueueMessagesWaiting(s_lanes[lane].queue);
+      }
+      uint32_t count;
+      while ((count = priv_take_batch(budget)) > 0) {
+        priv_process_batch(count);
       }
+      priv_close_all_handles(s_sd_was_available);
+      s_closed           = s_stopped;
+      s_drained_sequence = drain;
+      xEventGroupSetBits(s_file_write_events, FILE_WRITE_DRAINED_BIT);
+    }
+    
+    uint32_t count = priv_take_batch(NULL);
+    priv_process_batch(count);
+    if (s_sd_was_available && !s_closed) {
+      priv_sync_expired_handles();
     }
+    more = (count == FILE_WRITE_BATCH_SIZE);
   }
 }
 
@@ -356,11 +969,42 @@ esp_err_t file_write_manager_init(void)
   
   log_info(file_manager_tag, "Init Start", "Initializing file write manager");
   
-  /* Create queue for file write requests */
-  s_file_write_queue = xQueueCreate(max_pending_writes, sizeof(file_write_request_t));
-  if (s_file_write_queue == NULL) {
-    log_error(file_manager_tag, "Queue Error", "Failed to create file write queue");
-    return ESP_FAIL;
+  s_sync_policy.sync_bytes       = file_write_default_sync_bytes;
+  s_sync_policy.sync_interval_ms = file_write_default_sync_interval;
+  s_sync_policy.sync_on_critical = true;
+  
+  /* Buffer pools and path table, so queued requests are only a few words */
+  s_path_mutex        = xSemaphoreCreateMutex();
+  s_drain_mutex       = xSemaphoreCreateMutex();
+  s_file_write_events = xEventGroupCreate();
+  if (s_path_mutex == NULL ||
+      s_drain_mutex == NULL ||
+      s_file_write_events == NULL ||
+      priv_pool_init(0, 
+                     &s_buffers[0], 
+                     &s_small_data[0][0], 
+                     FILE_WRITE_SMALL_BUFFERS, 
+                     FILE_WRITE_SMALL_BUFFER_SIZE) != ESP_OK ||
+      priv_pool_init(1, 
+                     &s_buffers[FILE_WRITE_SMALL_BUFFERS], 
+                     &s_large_data[0][0], 
+                     FILE_WRITE_LARGE_BUFFERS, 
+                     FILE_WRITE_LARGE_BUFFER_SIZE) != ESP_OK) {
+    log_error(file_manager_tag, "Pool Error", "Failed to create write buffer pools");
+    return ESP_ERR_NO_MEM;
+  }
+  
+  /* Create a queue per lane for file write requests */
+  for (uint8_t lane = 0; lane < k_file_write_lane_count; lane++) {
+    s_lanes[lane].queue       = xQueueCreate(s_lanes[lane].depth, sizeof(file_write_request_t));
+    s_lanes[lane].stats.depth = s_lanes[lane].depth;
+    if (s_lanes[lane].queue == NULL) {
+      log_error(file_manager_tag, 
+                "Queue Error", 
+                "Failed to create the %s write queue", 
+                s_lanes[lane].name);
+      return ESP_FAIL;
+    }
   }
   
   /* Initialize SD card detection system */
@@ -381,8 +1025,10 @@ esp_err_t file_write_manager_init(void)
   
   if (task_created != pdPASS) {
     log_error(file_manager_tag, "Task Error", "Failed to create file write task");
-    vQueueDelete(s_file_write_queue);
-    s_file_write_queue = NULL;
+    for (uint8_t lane = 0; lane < k_file_write_lane_count; lane++) {
+      vQueueDelete(s_lanes[lane].queue);
+      s_lanes[lane].queue = NULL;
+    }
     return ESP_FAIL;
   }
   
@@ -409,47 +1055,17 @@ esp_err_t file_write_enqueue(const char *file_path, const char *data)
     return ESP_ERR_INVALID_ARG;
   }
   
-  /* Create a request */
-  file_write_request_t request;
-  memset(&request, 0, sizeof(request));
-  
-  /* Copy file path to the request */
-  strncpy(request.file_path, file_path, MAX_FILE_PATH_LENGTH - 1);
-  request.file_path[MAX_FILE_PATH_LENGTH - 1] = '\0';
-  
-  /* Allocate memory for the text data and copy it */
-  size_t data_length = strlen(data) + 1; /* Include null terminator */
-  request.data       = malloc(data_length);
-  if (!request.data) {
-    log_error(file_manager_tag, 
-              "Memory Error", 
-              "Failed to allocate memory for text data");
-    return ESP_FAIL;
-  }
-  
-  memcpy(request.data, data, data_length);
-  request.data_length = data_length;
-  request.is_binary   = false; /* This is a text request */
-  
-  /* Send the request to the queue */
-  if (xQueueSend(s_file_write_queue, &request, pdMS_TO_TICKS(100)) != pdTRUE) {
-    log_error(file_manager_tag, 
-              "Queue Error", 
-              "Failed to enqueue file write request: queue full");
-    free(request.data);
-    return ESP_FAIL;
-  }
-  
-  log_debug(file_manager_tag, 
-            "Enqueue Success", 
-            "Enqueued write request for file: %s", 
-            file_path);
-  return ESP_OK;
+  return priv_copy_enqueue(file_path, 
+                           data, 
+                           strlen(data), 
+                           k_file_write_lane_telemetry, 
+                           k_file_write_text);
 }
 
 esp_err_t file_write_binary_enqueue(const char *file_path, 
                                     const void *data, 
-                                    uint32_t    data_length)
+                                    uint32_t    data_length,
+                                    bool        critical)
 {
   if (!s_initialized) {
     log_error(file_manager_tag, 
@@ -465,40 +1081,211 @@ esp_err_t file_write_binary_enqueue(const char *file_path,
     return ESP_ERR_INVALID_ARG;
   }
   
-  /* Create a binary request */
-  file_write_request_t request;
-  memset(&request, 0, sizeof(request));
+  return priv_copy_enqueue(file_path, 
+                           data, 
+                           data_length, 
+                           k_file_write_lane_bulk,
+                           k_file_write_binary | (critical ? k_file_write_critical : 0));
+}
+
+esp_err_t file_write_register_path(const char *file_path, file_write_id_t *file_id)
+{
+  if (!s_initialized) {
+    log_error(file_manager_tag, "Register Error", "File write manager not initialized");
+    return ESP_FAIL;
+  }
   
-  /* Copy file path to the request */
-  strncpy(request.file_path, file_path, MAX_FILE_PATH_LENGTH - 1);
-  request.file_path[MAX_FILE_PATH_LENGTH - 1] = '\0';
+  if (file_path == NULL || file_id == NULL || strlen(file_path) >= MAX_FILE_PATH_LENGTH) {
+    log_error(file_manager_tag, 
+              "Register Error", 
+              "Invalid arguments: file_path or file_id is NULL, or the path is too long");
+    return ESP_ERR_INVALID_ARG;
+  }
   
-  /* Allocate memory for the binary data and copy it */
-  request.data = malloc(data_length);
-  if (!request.data) {
+  esp_err_t ret = priv_intern_path(file_path, true, false, file_id);
+  if (ret != ESP_OK) {
     log_error(file_manager_tag, 
-              "Memory Error", 
-              "Failed to allocate memory for binary data");
-    return ESP_FAIL;
+              "Register Error", 
+              "No free path slot for %s, %d paths are in use", 
+              file_path, 
+              FILE_WRITE_MAX_PATHS);
+  }
+  return ret;
+}
+
+void file_write_release_path(file_write_id_t file_id)
+{
+  if (file_id >= FILE_WRITE_MAX_PATHS || s_path_mutex == NULL) {
+    return;
   }
   
-  memcpy(request.data, data, data_length);
-  request.data_length = data_length;
-  request.is_binary   = true; /* This is a binary request */
+  xSemaphoreTake(s_path_mutex, portMAX_DELAY);
+  s_paths[file_id].pinned = false;
+  xSemaphoreGive(s_path_mutex);
+}
+
+file_write_buffer_t *file_write_buffer_alloc(size_t size, TickType_t wait)
+{
+  if (!s_initialized || size > FILE_WRITE_LARGE_BUFFER_SIZE) {
+    return NULL;
+  }
+  
+  if (size <= FILE_WRITE_SMALL_BUFFER_SIZE) {
+    file_write_buffer_t *buffer = priv_pool_take(0, wait);
+    if (buffer != NULL) {
+      return buffer;
+    }
+    /* Fall back to a large buffer rather than fail */
+    return priv_pool_take(1, 0);
+  }
+  return priv_pool_take(1, wait);
+}
+
+void file_write_buffer_ref(file_write_buffer_t *buffer)
+{
+  portENTER_CRITICAL(&s_pool_lock);
+  buffer->refs++;
+  portEXIT_CRITICAL(&s_pool_lock);
+}
+
+void file_write_buffer_release(file_write_buffer_t *buffer)
+{
+  if (buffer == NULL) {
+    return;
+  }
+  
+  portENTER_CRITICAL(&s_pool_lock);
+  bool last = (--buffer->refs == 0);
+  if (last) {
+    buffer->next                    = s_pools[buffer->pool].free_list;
+    s_pools[buffer->pool].free_list = buffer;
+  }
+  portEXIT_CRITICAL(&s_pool_lock);
+  
+  if (last) {
+    xSemaphoreGive(s_pools[buffer->pool].available);
+  }
+}
+
+esp_err_t file_write_buffer_enqueue(file_write_id_t      file_id,
+                                    file_write_buffer_t *buffer,
+                                    file_write_lane_t    lane,
+                                    uint8_t              flags)
+{
+  if (buffer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_initialized) {
+    file_write_buffer_release(buffer);
+    return ESP_FAIL;
+  }
   
-  /* Send the request to the queue */
-  if (xQueueSend(s_file_write_queue, &request, pdMS_TO_TICKS(100)) != pdTRUE) {
+  bool registered = false;
+  if (file_id < FILE_WRITE_MAX_PATHS && lane < k_file_write_lane_count && buffer->length > 0) {
+    xSemaphoreTake(s_path_mutex, portMAX_DELAY);
+    registered = s_paths[file_id].used;
+    if (registered) {
+      s_paths[file_id].pending++;
+    }
+    xSemaphoreGive(s_path_mutex);
+  }
+  if (!registered) {
     log_error(file_manager_tag, 
-              "Queue Error", 
-              "Failed to enqueue binary write request: queue full");
-    free(request.data);
+              "Enqueue Error", 
+              "Invalid arguments: empty buffer, unregistered file %u or lane %u", 
+              file_id,
+              lane);
+    file_write_buffer_release(buffer);
+    return ESP_ERR_INVALID_ARG;
+  }
+  
+  return priv_enqueue(file_id, buffer, lane, flags);
+}
+
+esp_err_t file_write_set_sync_policy(const file_write_sync_policy_t *policy)
+{
+  if (policy == NULL) {
+    log_error(file_manager_tag, "Config Error", "Invalid argument: policy is NULL");
+    return ESP_ERR_INVALID_ARG;
+  }
+  
+  s_sync_policy = *policy;
+  log_info(file_manager_tag, 
+           "Sync Policy", 
+           "Syncing every %lu bytes, every %lu ms%s", 
+           policy->sync_bytes, 
+           policy->sync_interval_ms,
+           policy->sync_on_critical ? " and on critical writes" : "");
+  return ESP_OK;
+}
+
+esp_err_t file_write_drain(TickType_t timeout)
+{
+  if (!s_initialized) {
+    log_error(file_manager_tag, "Drain Error", "File write manager not initialized");
     return ESP_FAIL;
   }
   
-  log_debug(file_manager_tag, 
-            "Binary Enqueue Success", 
-            "Enqueued binary write request for file: %s (%lu bytes)", 
-            file_path, (unsigned long)data_length);
+  esp_err_t ret = priv_drain(timeout);
+  if (ret != ESP_OK) {
+    log_warn(file_manager_tag, 
+             "Drain Timeout", 
+             "Queued writes not finished in %lu ms", 
+             (unsigned long)pdTICKS_TO_MS(timeout));
+  }
+  return ret;
+}
+
+esp_err_t file_write_shutdown(TickType_t timeout)
+{
+  if (!s_initialized) {
+    log_error(file_manager_tag, "Shutdown Error", "File write manager not initialized");
+    return ESP_FAIL;
+  }
+  
+  s_stopped = true;
+  log_info(file_manager_tag, 
+           "Shutdown", 
+           "Refusing new writes, draining the write queue");
+  return file_write_drain(timeout);
+}
+
+void file_write_resume(void)
+{
+  if (!s_stopped) {
+    return;
+  }
+  
+  s_stopped = false;
+  log_info(file_manager_tag, "Resume", "Accepting writes again");
+}
+
+void file_write_get_stats(file_write_stats_t *stats)
+{
+  if (stats == NULL) {
+    return;
+  }
+  *stats = s_stats;
+}
+
+esp_err_t file_write_get_lane_stats(file_write_lane_t lane, file_write_lane_stats_t *stats)
+{
+  if (lane >= k_file_write_lane_count || stats == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  
+  uint32_t queued = (s_lanes[lane].queue != NULL) ? uxQueueMessagesWaiting(s_lanes[lane].queue) : 0;
+  portENTER_CRITICAL(&s_lane_lock);
+  *stats = s_lanes[lane].stats;
+  portEXIT_CRITICAL(&s_lane_lock);
+  stats->queued = queued;
   return ESP_OK;
 }
 
+bool file_write_lane_congested(file_write_lane_t lane)
+{
+  if (lane >= k_file_write_lane_count) {
+    return false;
+  }
+  return s_lanes[lane].stats.congested;
+}
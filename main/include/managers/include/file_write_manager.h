@@ -12,8 +12,9 @@ extern "C" {
 
 /* Constants ******************************************************************/
 
-extern const char    *file_manager_tag;   /**< Logging tag for log_handler messages related to the file write manager. */
-extern const uint32_t max_pending_writes; /**< Maximum number of queued file write requests to prevent overflow. */
+extern const char    *file_manager_tag;                 /**< Logging tag for log_handler messages related to the file write manager. */
+extern const uint32_t file_write_default_sync_bytes;    /**< Default `file_write_sync_policy_t::sync_bytes`. */
+extern const uint32_t file_write_default_sync_interval; /**< Default `file_write_sync_policy_t::sync_interval_ms`. */
 
 /* Macros *********************************************************************/
 
@@ -21,6 +22,47 @@ extern const uint32_t max_pending_writes; /**< Maximum number of queued file wri
 #define MAX_DATA_LENGTH       (256) /**< Maximum data length per write request, including the null terminator. */
 #define TIMESTAMP_BUFFER_SIZE (64)  /**< Size of buffer for timestamp strings. */
 
+#define FILE_WRITE_MAX_OPEN_FILES       (8)    /**< Files kept open by the writer task, least recently used is closed first. */
+#define FILE_WRITE_DIR_CACHE_SIZE       (8)    /**< Directories remembered as existing, so they are not checked again. */
+#define FILE_WRITE_BATCH_SIZE           (20)   /**< Queued requests taken per pass of the writer task, the sum of the lane weights. */
+#define FILE_WRITE_COALESCE_BUFFER_SIZE (4096) /**< Bytes collected for one file before they are written. */
+#define FILE_WRITE_MAX_PATHS            (16)   /**< Paths interned at once, see `file_write_register_path`. */
+#define FILE_WRITE_SMALL_BUFFER_SIZE    (MAX_DATA_LENGTH) /**< Bytes per buffer of the small pool, sized for text lines. */
+#define FILE_WRITE_SMALL_BUFFERS        (16)   /**< Buffers in the small pool. */
+#define FILE_WRITE_LARGE_BUFFER_SIZE    (4096) /**< Bytes per buffer of the large pool, sized for log chunks. */
+#define FILE_WRITE_LARGE_BUFFERS        (6)    /**< Buffers in the large pool, shared by log chunks and sensor blocks. */
+#define FILE_WRITE_INVALID_ID           (0xFF) /**< `file_write_id_t` of no path. */
+
+/* Typedefs *******************************************************************/
+
+typedef uint8_t file_write_id_t; /**< Interned file path, see `file_write_register_path`. */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief How a write request's data is written, combined with `|`.
+ */
+typedef enum : uint8_t {
+  k_file_write_text     = 0,      /**< Text line, written with a timestamp prefix and a newline. */
+  k_file_write_binary   = 1 << 0, /**< Bytes written as they are. */
+  k_file_write_critical = 1 << 1, /**< Sync the file right after writing, see `file_write_sync_policy_t`. */
+} file_write_flags_t;
+
+/**
+ * @brief Queues of the writer task, each with its own depth and share of a pass.
+ *
+ * Each pass takes up to a lane's weight of requests from every lane in turn,
+ * critical first, so a burst in one lane cannot hold back the others.
+ * Requests for one file must all use the same lane, order is only kept
+ * within a lane.
+ */
+typedef enum : uint8_t {
+  k_file_write_lane_critical,  /**< Log files. */
+  k_file_write_lane_telemetry, /**< Sensor records, `file_write_enqueue`. Never blocks, drops when full. */
+  k_file_write_lane_bulk,      /**< Large binary data such as images, `file_write_binary_enqueue`. */
+  k_file_write_lane_count,     /**< Number of lanes. */
+} file_write_lane_t;
+
 /* Structs ********************************************************************/
 
 /**
@@ -35,35 +77,90 @@ typedef struct {
   bool        enabled;     /**< Flag indicating if the file writer is enabled (true) or disabled (false). */
 } file_writer_config_t;
 
+/**
+ * @brief Reference-counted write buffer from the file writer's pools.
+ *
+ * Obtained with `file_write_buffer_alloc`. The owner fills `data`, sets
+ * `length` and hands the buffer to `file_write_buffer_enqueue`, which takes
+ * over its reference, so the data is never copied again.
+ */
+typedef struct file_write_buffer {
+  uint8_t                  *data;     /**< Payload, `capacity` bytes. */
+  uint16_t                  capacity; /**< Size of `data`. */
+  uint16_t                  length;   /**< Bytes of `data` to write. */
+  uint8_t                   refs;     /**< References held, changed only through the API. */
+  uint8_t                   pool;     /**< Pool the buffer returns to. */
+  struct file_write_buffer *next;     /**< Free list link while in the pool. */
+} file_write_buffer_t;
+
 /**
  * @brief Represents a request to write data to a file.
  *
- * Contains the file path, data, and data length for a file write operation.
- * The is_binary flag indicates whether the data should be treated as binary or text.
- * 
- * @note
- * - The `file_path` must be null-terminated and have a length defined by 
- *   the `max_file_path_length` macro to prevent memory overflow.
- * - For text data (is_binary = false), the data field contains the null-terminated string.
- * - For binary data (is_binary = true), the data field contains a pointer to the binary data.
+ * Queued by value, so the queue holds a few words per request. The data
+ * stays in its pooled buffer until the writer task releases it.
  */
 typedef struct {
-  char     file_path[MAX_FILE_PATH_LENGTH]; /**< Path to the target file. Must be null-terminated and within the length limit. */
-  void    *data;                            /**< Pointer to the data to write. For text, this is a null-terminated string. */
-  uint32_t data_length;                     /**< Length of the data in bytes. For text, this can be 0 (will use strlen). */
-  bool     is_binary;                       /**< Flag indicating if this is a binary write request (true) or text (false). */
+  file_write_buffer_t *buffer;     /**< Data to write, the request holds one reference. */
+  uint32_t             enqueue_us; /**< Low 32 bits of `esp_timer_get_time` when queued, for latency. */
+  file_write_id_t      file_id;    /**< Target file, interned with `file_write_register_path`. */
+  uint8_t              flags;      /**< `file_write_flags_t` values. */
 } file_write_request_t;
 
+/**
+ * @brief When written data is committed to the SD card with `fsync`.
+ *
+ * Files stay open between writes, so data reaches the card's FAT and
+ * directory entries only when synced or closed. Each enabled condition
+ * triggers an `fsync` of the file on its own.
+ */
+typedef struct {
+  uint32_t sync_bytes;       /**< Sync a file once this many bytes were written since its last sync, 0 disables. */
+  uint32_t sync_interval_ms; /**< Sync files with unsynced data this long after their last sync, 0 disables. */
+  bool     sync_on_critical; /**< Sync right after writing a request marked `critical`. */
+} file_write_sync_policy_t;
+
+/**
+ * @brief Counters of the file writer task, kept since `file_write_manager_init`.
+ */
+typedef struct {
+  uint32_t requests; /**< Write requests taken from the queue. */
+  uint32_t writes;   /**< `fwrite` calls, after coalescing requests for the same file. */
+  uint32_t syncs;    /**< `fsync` calls. */
+  uint32_t opens;    /**< Files opened, i.e. misses of the open file cache. */
+  uint32_t failed;   /**< Requests dropped because their file could not be written. */
+  uint32_t bytes;    /**< Bytes written, wraps at 4 GB. */
+} file_write_stats_t;
+
+/**
+ * @brief Counters of one lane, kept since `file_write_manager_init`.
+ */
+typedef struct {
+  uint32_t enqueued;         /**< Requests queued. */
+  uint32_t dropped;          /**< Requests refused because the lane or buffer pool stayed full. */
+  uint32_t completed;        /**< Requests taken and handled by the writer task. */
+  uint32_t queued;           /**< Requests waiting now. */
+  uint32_t high_water;       /**< Most requests waiting at once. */
+  uint32_t depth;            /**< Capacity of the lane. */
+  uint32_t max_latency_us;   /**< Longest time from enqueue to written. */
+  uint64_t total_latency_us; /**< Sum over `completed` requests, for the mean latency. */
+  bool     congested;        /**< Backpressure signal, see `file_write_lane_congested`. */
+} file_write_lane_stats_t;
+
 /* Public Functions ***********************************************************/
 
 /**
  * @brief Initializes the file write manager.
  *
- * Sets up a FreeRTOS queue for managing asynchronous file write requests 
- * and starts a background task to process them. Files are always opened 
- * in append mode, creating them if they do not exist. Each line of data 
- * written to a file will include a timestamp at the start in the format 
- * `YYYY-MM-DD HH:MM:SS`.
+ * Sets up a FreeRTOS queue per `file_write_lane_t` for asynchronous file
+ * write requests and starts a background task to process them. Files are
+ * always opened in append mode, creating them if they do not exist. Each
+ * line of data written to a file will include a timestamp at the start in
+ * the format `YYYY-MM-DD HH:MM:SS`.
+ *
+ * The task keeps up to `FILE_WRITE_MAX_OPEN_FILES` files open and remembers
+ * which directories exist. Request data lives in pooled buffers, so queued
+ * writes use no heap. Requests queued for the same file are combined
+ * into one `fwrite`, and files are synced following the sync policy.
  *
  * @return
  * - ESP_OK   if the initialization is successful.
@@ -77,7 +174,7 @@ esp_err_t file_write_manager_init(void);
 /**
  * @brief Enqueues a file write request.
  *
- * Adds a file write request to the queue for asynchronous processing. 
+ * Adds a file write request to the telemetry lane for asynchronous processing. 
  * The data will be written to the specified file in the background by 
  * the file write task. If the file does not exist, it will be created 
  * automatically. All writes append data to the file. Each line written 
@@ -91,13 +188,14 @@ esp_err_t file_write_manager_init(void);
  *                      by the queue.
  *
  * @return
- * - ESP_OK              if the request was successfully enqueued.
- * - ESP_ERR_INVALID_ARG if any argument is invalid (e.g., NULL pointers).
- * - ESP_FAIL            if the queue is full.
+ * - ESP_OK                if the request was successfully enqueued.
+ * - ESP_ERR_INVALID_ARG   if any argument is invalid (e.g., NULL pointers).
+ * - ESP_ERR_INVALID_STATE if the writer is shut down, see `file_write_shutdown`.
+ * - ESP_FAIL              if the lane is full or no pooled buffer is free.
  *
  * @note Ensure `file_write_manager_init` has been called before invoking 
  *       this function. The function does not block but returns immediately 
- *       after enqueueing the request. The data is copied to an internal buffer,
+ *       after enqueueing the request. The data is copied into a pooled buffer,
  *       so the caller can free the original data after this function returns.
  */
 esp_err_t file_write_enqueue(const char *file_path, const char *data);
@@ -105,7 +203,7 @@ esp_err_t file_write_enqueue(const char *file_path, const char *data);
 /**
  * @brief Enqueues a binary file write request.
  *
- * Adds a binary file write request to the queue for asynchronous processing.
+ * Adds a binary file write request to the bulk lane for asynchronous processing.
  * The binary data will be written to the specified file in the background by
  * the file write task. If the file does not exist, it will be created
  * automatically. All writes append data to the file.
@@ -114,21 +212,187 @@ esp_err_t file_write_enqueue(const char *file_path, const char *data);
  *                        This must be a valid file path accessible by
  *                        the system.
  * @param[in] data        Pointer to the binary data to write.
- * @param[in] data_length Length of the binary data in bytes.
+ * @param[in] data_length Length of the binary data in bytes, at most
+ *                        `FILE_WRITE_LARGE_BUFFER_SIZE`.
+ * @param[in] critical    Whether the file should be synced right after this
+ *                        data is written (e.g. it holds error logs).
  *
  * @return
- * - ESP_OK              if the request was successfully enqueued.
- * - ESP_ERR_INVALID_ARG if any argument is invalid (e.g., NULL pointers).
- * - ESP_FAIL            if the queue is full.
+ * - ESP_OK                if the request was successfully enqueued.
+ * - ESP_ERR_INVALID_ARG   if any argument is invalid (e.g., NULL pointers).
+ * - ESP_ERR_INVALID_STATE if the writer is shut down, see `file_write_shutdown`.
+ * - ESP_FAIL              if the lane stayed full or no pooled buffer is free.
  *
  * @note Ensure `file_write_manager_init` has been called before invoking
  *       this function. The function does not block but returns immediately
- *       after enqueueing the request. The data is copied to an internal buffer,
+ *       after enqueueing the request. The data is copied into a pooled buffer,
  *       so the caller can free the original data after this function returns.
  */
 esp_err_t file_write_binary_enqueue(const char *file_path, 
                                     const void *data, 
-                                    uint32_t    data_length);
+                                    uint32_t    data_length,
+                                    bool        critical);
+
+/**
+ * @brief Interns a file path as a small ID for `file_write_buffer_enqueue`.
+ *
+ * Registering a path that is already interned returns its existing ID. The
+ * ID stays valid until `file_write_release_path`. Paths passed to
+ * `file_write_enqueue` and `file_write_binary_enqueue` are interned
+ * automatically, and their slots are reused once no write for them is queued.
+ *
+ * @param[in]  file_path Path relative to the SD card mount point.
+ * @param[out] file_id   ID of the path.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if an argument is NULL or the path is too long.
+ * - ESP_ERR_NO_MEM      if all `FILE_WRITE_MAX_PATHS` slots are in use.
+ */
+esp_err_t file_write_register_path(const char *file_path, file_write_id_t *file_id);
+
+/**
+ * @brief Gives up a path ID from `file_write_register_path`.
+ *
+ * Writes already queued for the path still complete. Its slot is reused
+ * once they are written.
+ *
+ * @param[in] file_id ID to release, `FILE_WRITE_INVALID_ID` is ignored.
+ */
+void file_write_release_path(file_write_id_t file_id);
+
+/**
+ * @brief Takes a buffer from the pool that fits `size` bytes.
+ *
+ * The buffer comes with one reference and `length` 0.
+ *
+ * @param[in] size Bytes needed, at most `FILE_WRITE_LARGE_BUFFER_SIZE`.
+ * @param[in] wait Ticks to wait for a buffer to be released when the pool is empty.
+ *
+ * @return The buffer, or NULL if `size` is too large or none became free in time.
+ */
+file_write_buffer_t *file_write_buffer_alloc(size_t size, TickType_t wait);
+
+/**
+ * @brief Adds a reference to a buffer, e.g. before enqueueing it for a second file.
+ *
+ * @param[in] buffer Buffer to reference.
+ */
+void file_write_buffer_ref(file_write_buffer_t *buffer);
+
+/**
+ * @brief Drops a reference to a buffer, returning it to its pool with the last one.
+ *
+ * @param[in] buffer Buffer to release, NULL is ignored.
+ */
+void file_write_buffer_release(file_write_buffer_t *buffer);
+
+/**
+ * @brief Enqueues a pooled buffer for writing without copying its data.
+ *
+ * Takes over the caller's reference in every case: the writer task releases
+ * it once written, or this function does if the request cannot be queued.
+ *
+ * @param[in] file_id ID from `file_write_register_path`.
+ * @param[in] buffer  Buffer holding `length` bytes to write.
+ * @param[in] lane    Lane to queue in, the same for every write to the file.
+ * @param[in] flags   `file_write_flags_t` values.
+ *
+ * @return
+ * - ESP_OK                if the request was successfully enqueued.
+ * - ESP_ERR_INVALID_ARG   if `buffer` is NULL, empty, `file_id` is not registered
+ *                         or `lane` is out of range.
+ * - ESP_ERR_INVALID_STATE if the writer is shut down, see `file_write_shutdown`.
+ * - ESP_FAIL              if the manager is not initialized or the lane stayed full.
+ */
+esp_err_t file_write_buffer_enqueue(file_write_id_t      file_id,
+                                    file_write_buffer_t *buffer,
+                                    file_write_lane_t    lane,
+                                    uint8_t              flags);
+
+/**
+ * @brief Sets when written files are synced to the SD card.
+ *
+ * Takes effect on the next pass of the writer task. Defaults to
+ * `file_write_default_sync_bytes`, `file_write_default_sync_interval` and
+ * syncing critical writes.
+ *
+ * @param[in] policy New sync policy.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if `policy` is NULL.
+ */
+esp_err_t file_write_set_sync_policy(const file_write_sync_policy_t *policy);
+
+/**
+ * @brief Writes everything queued so far, then syncs and closes all files.
+ *
+ * Requests queued before the call are written first. Files are synced while
+ * the SD card is available; after a removal they are only closed, so the
+ * card can be unmounted without streams pointing into it. Writes continue
+ * normally afterwards and reopen their files.
+ *
+ * @param[in] timeout Longest wait for the writer task.
+ *
+ * @return
+ * - ESP_OK              once every file is closed.
+ * - ESP_ERR_TIMEOUT     if the writer did not get there in time.
+ * - ESP_FAIL            if the manager is not initialized.
+ */
+esp_err_t file_write_drain(TickType_t timeout);
+
+/**
+ * @brief Stops taking requests, then drains like `file_write_drain`.
+ *
+ * For power loss: enqueue functions return ESP_ERR_INVALID_STATE from the
+ * moment this is called, and files stay closed until `file_write_resume`.
+ * Intake stays stopped even if the drain times out.
+ *
+ * @param[in] timeout Longest wait for the writer task.
+ *
+ * @return
+ * - ESP_OK              once every queued request is written and every file closed.
+ * - ESP_ERR_TIMEOUT     if the writer did not get there in time.
+ * - ESP_FAIL            if the manager is not initialized.
+ */
+esp_err_t file_write_shutdown(TickType_t timeout);
+
+/**
+ * @brief Takes requests again after `file_write_shutdown`.
+ */
+void file_write_resume(void);
+
+/**
+ * @brief Copies the file writer counters.
+ *
+ * @param[out] stats Destination for the counters.
+ */
+void file_write_get_stats(file_write_stats_t *stats);
+
+/**
+ * @brief Copies the counters of one lane.
+ *
+ * @param[in]  lane  Lane to read.
+ * @param[out] stats Destination for the counters.
+ *
+ * @return
+ * - ESP_OK              on success.
+ * - ESP_ERR_INVALID_ARG if `lane` is out of range or `stats` is NULL.
+ */
+esp_err_t file_write_get_lane_stats(file_write_lane_t lane, file_write_lane_stats_t *stats);
+
+/**
+ * @brief Backpressure signal of a lane.
+ *
+ * Set once the lane is three quarters full or refused a request, cleared
+ * when the writer task has taken it down to a quarter. Producers that can
+ * thin out their data, such as fast sensors, should do so while it is set.
+ *
+ * @param[in] lane Lane to check.
+ * @return true if the lane is congested, false otherwise or if `lane` is out of range.
+ */
+bool file_write_lane_congested(file_write_lane_t lane);
 
 #ifdef __cplusplus
 }
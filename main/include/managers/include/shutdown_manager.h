@@ -0,0 +1,138 @@
+/* main/include/managers/include/shutdown_manager.h */
+
+#ifndef TOPOROBO_SHUTDOWN_MANAGER_H
+#define TOPOROBO_SHUTDOWN_MANAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+/* Constants ******************************************************************/
+
+extern const char    *shutdown_manager_tag;           /**< Logging tag for log_handler messages related to the shutdown manager. */
+extern const uint32_t shutdown_timeout_ms;            /**< Time given to a requested shutdown, e.g. on low battery. */
+extern const uint32_t shutdown_restart_timeout_ms;    /**< Time `esp_restart` waits for the files to close. */
+extern const uint32_t shutdown_sd_removal_timeout_ms; /**< Time the SD card unmount waits for the files to close. */
+
+/* Macros *********************************************************************/
+
+#define SHUTDOWN_LOGS_CLOSED_BIT  (BIT0) /**< Log file finished, or logs kept in RAM after an SD card removal. */
+#define SHUTDOWN_FILES_CLOSED_BIT (BIT1) /**< Write queue drained, every file synced and closed. */
+#define SHUTDOWN_COMPLETE_BIT     (BIT2) /**< Pipeline ended, the other bits tell which stages succeeded. */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief Why files are being closed.
+ */
+typedef enum : uint8_t {
+  k_shutdown_reason_none,        /**< Not shut down. */
+  k_shutdown_reason_request,     /**< Requested by the application. */
+  k_shutdown_reason_sd_removed,  /**< SD card removed, writes resume with the next card. */
+  k_shutdown_reason_low_battery, /**< Battery below its cutoff. */
+  k_shutdown_reason_power_fail,  /**< Brown-out or power-fail warning from a supply supervisor. */
+  k_shutdown_reason_restart,     /**< `esp_restart` was called. */
+} shutdown_reason_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Initializes the shutdown manager.
+ *
+ * Starts the task that runs requested shutdowns and hooks the pipeline into
+ * SD card removal and `esp_restart`. Call after `file_write_manager_init`.
+ *
+ * @return
+ * - ESP_OK   on success.
+ * - ESP_FAIL if the event group, mutex or task cannot be created.
+ */
+esp_err_t shutdown_manager_init(void);
+
+/**
+ * @brief Flushes and closes log and data files, waiting at most `timeout_ms`.
+ *
+ * Partly filled sensor blocks and the log ring are handed to storage, the
+ * log file's gzip stream finished, then the file writer stops taking
+ * requests, writes what is queued, syncs and closes every file. Records
+ * logged afterwards stay in the RAM buffer.
+ * On `k_shutdown_reason_sd_removed` nothing can be written anymore: buffered
+ * logs are kept for the next card and files are closed without syncing,
+ * while writes keep being accepted. Sets the `SHUTDOWN_*_BIT`s as stages
+ * finish. Blocks, so interrupts use `shutdown_manager_request_from_isr`.
+ *
+ * @param[in] reason     Why files are closed.
+ * @param[in] timeout_ms Longest time to take.
+ *
+ * @return
+ * - ESP_OK          once every stage finished.
+ * - ESP_ERR_TIMEOUT if the file writer did not drain in time.
+ * - ESP_FAIL        if logs could not be written or the manager is not initialized.
+ */
+esp_err_t shutdown_manager_quiesce(shutdown_reason_t reason, uint32_t timeout_ms);
+
+/**
+ * @brief Runs `shutdown_manager_quiesce` in the shutdown task, without waiting.
+ *
+ * For a battery monitor or other task that must not block. Completion is
+ * signalled through `shutdown_manager_get_event_group`.
+ *
+ * @param[in] reason Why files are closed, not `k_shutdown_reason_none`.
+ *
+ * @return
+ * - ESP_OK              if the request was passed on.
+ * - ESP_ERR_INVALID_ARG if `reason` is `k_shutdown_reason_none`.
+ * - ESP_FAIL            if the manager is not initialized.
+ */
+esp_err_t shutdown_manager_request(shutdown_reason_t reason);
+
+/**
+ * @brief ISR version of `shutdown_manager_request`.
+ *
+ * For a supply supervisor's power-fail or low-battery GPIO. The ESP32's own
+ * brown-out detector resets the chip without calling back, so an early
+ * warning like this is needed to close files before power is lost.
+ *
+ * @param[in] reason Why files are closed.
+ */
+void shutdown_manager_request_from_isr(shutdown_reason_t reason);
+
+/**
+ * @brief Waits for the running or last pipeline to complete.
+ *
+ * @param[in] timeout_ms Longest wait.
+ *
+ * @return
+ * - ESP_OK          if every stage finished.
+ * - ESP_ERR_TIMEOUT if the pipeline did not complete in time.
+ * - ESP_FAIL        if it completed with a failed stage.
+ */
+esp_err_t shutdown_manager_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Returns the event group holding the `SHUTDOWN_*_BIT`s.
+ *
+ * The bits are cleared when a pipeline starts and by `shutdown_manager_resume`.
+ *
+ * @return The event group, NULL before `shutdown_manager_init`.
+ */
+EventGroupHandle_t shutdown_manager_get_event_group(void);
+
+/**
+ * @brief Reopens logging and file writes after a shutdown, e.g. once power recovered.
+ *
+ * @return
+ * - ESP_OK   on success.
+ * - ESP_FAIL if the manager is not initialized.
+ */
+esp_err_t shutdown_manager_resume(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_SHUTDOWN_MANAGER_H */
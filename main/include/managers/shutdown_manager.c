@@ -0,0 +1,270 @@
+/* main/include/managers/shutdown_manager.c */
+
+#include "shutdown_manager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "log_handler.h"
+#include "log_storage.h"
+#include "file_write_manager.h"
+#include "sensor_log.h"
+#include "sd_card_hal.h"
+
+/* Constants ******************************************************************/
+
+const char    *shutdown_manager_tag           = "SHUTDOWN";
+const uint32_t shutdown_timeout_ms            = 2000; /* Hold-up time a low battery or supervisor warning leaves */
+const uint32_t shutdown_restart_timeout_ms    = 500;  /* Keeps esp_restart prompt */
+const uint32_t shutdown_sd_removal_timeout_ms = 500;  /* Only closing files, nothing can be written anymore */
+
+/* Globals (Static) ***********************************************************/
+
+static EventGroupHandle_t s_shutdown_events = NULL;
+static SemaphoreHandle_t  s_shutdown_mutex  = NULL;                   /* One pipeline at a time */
+static TaskHandle_t       s_shutdown_task   = NULL;                   /* Runs requested shutdowns */
+static shutdown_reason_t  s_reason          = k_shutdown_reason_none; /* Reason of the last pipeline */
+static bool               s_shut_down       = false;                  /* Writes refused until shutdown_manager_resume */
+
+/* Private Functions **********************************************************/
+
+/**
+ * @brief Names a shutdown reason for the log
+ *
+ * @param[in] reason Shutdown reason
+ * @return Static string
+ */
+static const char *priv_reason_name(shutdown_reason_t reason)
+{
+  switch (reason) {
+    case k_shutdown_reason_request:     return "requested";
+    case k_shutdown_reason_sd_removed:  return "SD card removed";
+    case k_shutdown_reason_low_battery: return "low battery";
+    case k_shutdown_reason_power_fail:  return "power failing";
+    case k_shutdown_reason_restart:     return "restarting";
+    default:                            return "unknown";
+  }
+}
+
+/**
+ * @brief Closes the files of a removed SD card before it is unmounted
+ */
+static void priv_on_sd_removed(void)
+{
+  shutdown_manager_quiesce(k_shutdown_reason_sd_removed, shutdown_sd_removal_timeout_ms);
+}
+
+/**
+ * @brief Closes files before `esp_restart` resets the chip
+ */
+static void priv_on_restart(void)
+{
+  shutdown_manager_quiesce(k_shutdown_reason_restart, shutdown_restart_timeout_ms);
+}
+
+/**
+ * @brief Task that runs shutdowns requested with `shutdown_manager_request`
+ *
+ * The reason arrives as the notification value.
+ *
+ * @param arg Task parameters (unused)
+ */
+static void priv_shutdown_task(void *arg)
+{
+  while (1) {
+    uint32_t reason = k_shutdown_reason_none;
+    if (xTaskNotifyWait(0, UINT32_MAX, &reason, portMAX_DELAY) == pdTRUE &&
+        reason != k_shutdown_reason_none) {
+      shutdown_manager_quiesce((shutdown_reason_t)reason, shutdown_timeout_ms);
+    }
+  }
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t shutdown_manager_init(void)
+{
+  if (s_shutdown_events != NULL) {
+    log_warn(shutdown_manager_tag, "Init Skip", "Shutdown manager already initialized");
+    return ESP_OK;
+  }
+
+  s_shutdown_events = xEventGroupCreate();
+  s_shutdown_mutex  = xSemaphoreCreateMutex();
+  if (s_shutdown_events == NULL || s_shutdown_mutex == NULL) {
+    log_error(shutdown_manager_tag, "Init Error", "Failed to create event group or mutex");
+    return ESP_FAIL;
+  }
+
+  /* Above the motion tasks, so a power warning is acted on at once */
+  if (xTaskCreate(priv_shutdown_task,
+                  "shutdown_task",
+                  4096,
+                  NULL,
+                  7,
+                  &s_shutdown_task) != pdPASS) {
+    log_error(shutdown_manager_tag, "Task Error", "Failed to create shutdown task");
+    s_shutdown_task = NULL;
+    return ESP_FAIL;
+  }
+
+  if (sd_card_register_removal_callback(priv_on_sd_removed) != ESP_OK) {
+    log_warn(shutdown_manager_tag,
+             "SD Card Warning",
+             "Files will not be closed before an SD card removal unmounts them");
+  }
+  if (esp_register_shutdown_handler(priv_on_restart) != ESP_OK) {
+    log_warn(shutdown_manager_tag,
+             "Restart Warning",
+             "Files will not be closed before a restart");
+  }
+
+  log_info(shutdown_manager_tag, "Init Complete", "Shutdown manager initialized");
+  return ESP_OK;
+}
+
+esp_err_t shutdown_manager_quiesce(shutdown_reason_t reason, uint32_t timeout_ms)
+{
+  if (s_shutdown_events == NULL) {
+    log_error(shutdown_manager_tag, "Quiesce Error", "Shutdown manager not initialized");
+    return ESP_FAIL;
+  }
+
+  TickType_t start   = xTaskGetTickCount();
+  TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+  if (xSemaphoreTake(s_shutdown_mutex, timeout) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
+  if (s_shut_down) {
+    xSemaphoreGive(s_shutdown_mutex);
+    return ESP_OK; /* Already closed, e.g. a restart after low battery */
+  }
+
+  bool removal = (reason == k_shutdown_reason_sd_removed);
+  xEventGroupClearBits(s_shutdown_events,
+                       SHUTDOWN_LOGS_CLOSED_BIT | SHUTDOWN_FILES_CLOSED_BIT | SHUTDOWN_COMPLETE_BIT);
+  s_reason = reason;
+  log_warn(shutdown_manager_tag,
+           "Quiesce",
+           "Closing log and data files: %s",
+           priv_reason_name(reason));
+
+  /* Logs and sensor blocks first, their last chunks must be queued before the writer drains */
+  esp_err_t logs_ret = ESP_OK;
+  if (removal) {
+    log_storage_set_sd_available(false); /* Buffered logs wait for the next card */
+  } else {
+    sensor_log_flush();
+    log_flush();
+    logs_ret = log_storage_close();
+  }
+  if (logs_ret == ESP_OK) {
+    xEventGroupSetBits(s_shutdown_events, SHUTDOWN_LOGS_CLOSED_BIT);
+  }
+
+  TickType_t elapsed   = xTaskGetTickCount() - start;
+  TickType_t remaining = (elapsed < timeout) ? timeout - elapsed : 0;
+  esp_err_t  files_ret = removal ? file_write_drain(remaining) : file_write_shutdown(remaining);
+  if (files_ret == ESP_OK) {
+    xEventGroupSetBits(s_shutdown_events, SHUTDOWN_FILES_CLOSED_BIT);
+  }
+
+  s_shut_down = !removal;
+  xEventGroupSetBits(s_shutdown_events, SHUTDOWN_COMPLETE_BIT);
+  xSemaphoreGive(s_shutdown_mutex);
+
+  esp_err_t ret = (files_ret != ESP_OK) ? files_ret : logs_ret;
+  if (ret != ESP_OK) {
+    log_error(shutdown_manager_tag,
+              "Quiesce Failed",
+              "Files not fully closed in %lu ms: %s",
+              timeout_ms,
+              esp_err_to_name(ret));
+  } else {
+    log_info(shutdown_manager_tag,
+             "Quiesce Complete",
+             "Files closed in %lu ms",
+             (unsigned long)pdTICKS_TO_MS(xTaskGetTickCount() - start));
+  }
+  return ret;
+}
+
+esp_err_t shutdown_manager_request(shutdown_reason_t reason)
+{
+  if (reason == k_shutdown_reason_none) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_shutdown_task == NULL) {
+    log_error(shutdown_manager_tag, "Request Error", "Shutdown manager not initialized");
+    return ESP_FAIL;
+  }
+
+  xTaskNotify(s_shutdown_task, reason, eSetValueWithOverwrite);
+  return ESP_OK;
+}
+
+void IRAM_ATTR shutdown_manager_request_from_isr(shutdown_reason_t reason)
+{
+  if (s_shutdown_task == NULL || reason == k_shutdown_reason_none) {
+    return;
+  }
+
+  BaseType_t higher_priority_task_woken = pdFALSE;
+  xTaskNotifyFromISR(s_shutdown_task,
+                     reason,
+                     eSetValueWithOverwrite,
+                     &higher_priority_task_woken);
+  if (higher_priority_task_woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+esp_err_t shutdown_manager_wait(uint32_t timeout_ms)
+{
+  if (s_shutdown_events == NULL) {
+    return ESP_FAIL;
+  }
+
+  EventBits_t bits = xEventGroupWaitBits(s_shutdown_events,
+                                         SHUTDOWN_COMPLETE_BIT,
+                                         pdFALSE,
+                                         pdTRUE,
+                                         pdMS_TO_TICKS(timeout_ms));
+  if ((bits & SHUTDOWN_COMPLETE_BIT) == 0) {
+    return ESP_ERR_TIMEOUT;
+  }
+
+  EventBits_t stages = SHUTDOWN_LOGS_CLOSED_BIT | SHUTDOWN_FILES_CLOSED_BIT;
+  return ((bits & stages) == stages) ? ESP_OK : ESP_FAIL;
+}
+
+EventGroupHandle_t shutdown_manager_get_event_group(void)
+{
+  return s_shutdown_events;
+}
+
+esp_err_t shutdown_manager_resume(void)
+{
+  if (s_shutdown_events == NULL) {
+    log_error(shutdown_manager_tag, "Resume Error", "Shutdown manager not initialized");
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(s_shutdown_mutex, portMAX_DELAY);
+  if (s_shut_down) {
+    file_write_resume();
+    log_storage_set_sd_available(sd_card_is_available()); /* Flushes what was logged meanwhile */
+    s_shut_down = false;
+    log_info(shutdown_manager_tag,
+             "Resume",
+             "Logging and file writes resumed after: %s",
+             priv_reason_name(s_reason));
+  }
+  s_reason = k_shutdown_reason_none;
+  xEventGroupClearBits(s_shutdown_events,
+                       SHUTDOWN_LOGS_CLOSED_BIT | SHUTDOWN_FILES_CLOSED_BIT | SHUTDOWN_COMPLETE_BIT);
+  xSemaphoreGive(s_shutdown_mutex);
+  return ESP_OK;
+}
@@ -0,0 +1,136 @@
+/* main/include/motion_frame.h */
+
+#ifndef TOPOROBO_MOTION_FRAME_H
+#define TOPOROBO_MOTION_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "pca9685_hal.h"
+#include "hexapod_geometry.h"
+#include "hexapod_kinematics.h"
+
+/* Constants ******************************************************************/
+
+extern const char   *motion_frame_tag;         /**< Tag for logs */
+extern const uint8_t motion_frame_accel_steps; /**< Frames needed to ramp from rest to full speed */
+
+/* Enums **********************************************************************/
+
+/**
+ * @brief How servos travel from their current position to a new target.
+ */
+typedef enum : uint8_t {
+  k_motion_profile_direct,      /**< Jump to the target on the next frame. */
+  k_motion_profile_trapezoidal, /**< Ramp up, cruise and ramp down within the speed and acceleration limits. */
+} motion_profile_t;
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Timing statistics for submitted motion frames.
+ */
+typedef struct {
+  uint32_t frames;          /**< Frames that moved at least one servo since `motion_frame_init`. */
+  uint32_t failed_frames;   /**< Frames abandoned because a servo write failed. */
+  uint32_t servo_updates;   /**< Servo channels written, unchanged channels are skipped. */
+  uint32_t last_latency_us; /**< Time from a submit to the first frame written after it. */
+  uint32_t max_latency_us;  /**< Worst `last_latency_us` seen since `motion_frame_init`. */
+} motion_frame_stats_t;
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Prepares the motion frame scheduler for every joint.
+ *
+ * Assigns every servo a time slice within the PWM period. At most
+ * `max_active_servos` pulses share a slice, and slices are as wide as the
+ * longest servo pulse, so no more than `max_active_servos` servos are ever
+ * driven at the same instant.
+ *
+ * Starts the interpolation task on the first call. Every
+ * `pca9685_step_delay_ms` it moves each servo toward its target, at most
+ * `pca9685_step_size_deg` per frame, and writes only the servos that moved.
+ * Once every servo rests on its target the task sleeps until the next
+ * submit.
+ *
+ * @param[in] pwm_controller Pointer to the PCA9685 board controller.
+ * @param[in] motors         `NUMBER_OF_JOINTS` motors indexed by `hexapod_joint_index`.
+ *
+ * @return
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if a pointer is NULL or a motor is on a missing board.
+ * - `ESP_ERR_NO_MEM`      if the target mutex cannot be created.
+ * - `ESP_FAIL`            if the interpolation task cannot be created.
+ */
+esp_err_t motion_frame_init(pca9685_board_t *pwm_controller, const motor_t *motors);
+
+/**
+ * @brief Sets a new target pose for every leg.
+ *
+ * Angles are relative to the 90° servo neutral and are clamped to each
+ * joint's limits. Returns without waiting, the interpolation task moves the
+ * servos there following the active `motion_profile_t`.
+ *
+ * A pose for resting servos is written straight away, unless the previous
+ * frame was less than `pca9685_step_delay_ms` ago: about 7 ms at 100 kHz
+ * for all 18 servos, measured with tools/motion_frame_latency. While servos
+ * are still travelling, the new target waits for the next frame, up to
+ * `pca9685_step_delay_ms` plus the bus burst (about 27 ms).
+ *
+ * @param[in] pose Target joint angles for all legs.
+ *
+ * @return
+ * - `ESP_OK`                on success.
+ * - `ESP_ERR_INVALID_ARG`   if `pose` is NULL.
+ * - `ESP_ERR_INVALID_STATE` if `motion_frame_init` has not been called.
+ * - `ESP_ERR_TIMEOUT`       if the target buffer stayed locked.
+ */
+esp_err_t motion_frame_submit(const leg_angles_t *pose);
+
+/**
+ * @brief Sets a new target pose given as absolute servo positions.
+ *
+ * Same as `motion_frame_submit` for callers that already produce servo
+ * positions (e.g. `kinematics_angles_to_servo_q16`). Each position goes
+ * through its channel's calibration table.
+ *
+ * @param[in] pose Target servo positions for all joints, in 0.1° steps.
+ *
+ * @return
+ * - `ESP_OK`                on success.
+ * - `ESP_ERR_INVALID_ARG`   if `pose` is NULL.
+ * - `ESP_ERR_INVALID_STATE` if `motion_frame_init` has not been called.
+ * - `ESP_ERR_TIMEOUT`       if the target buffer stayed locked.
+ */
+esp_err_t motion_frame_submit_servo(const leg_servo_positions_t *pose);
+
+/**
+ * @brief Selects how servos travel to new targets.
+ *
+ * Takes effect on the next frame. Servos already in motion keep their speed
+ * when switching to `k_motion_profile_trapezoidal`.
+ *
+ * @param[in] profile Profile to use for every servo.
+ *
+ * @return
+ * - `ESP_OK`              on success.
+ * - `ESP_ERR_INVALID_ARG` if `profile` is unknown.
+ */
+esp_err_t motion_frame_set_profile(motion_profile_t profile);
+
+/**
+ * @brief Copies the current motion frame statistics.
+ *
+ * @param[out] stats Destination for the statistics.
+ */
+void motion_frame_get_stats(motion_frame_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_MOTION_FRAME_H */
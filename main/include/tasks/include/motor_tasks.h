@@ -20,12 +20,12 @@ extern const char   *motor_tag;          /**< Tag for logs */
 /**
  * @brief Initializes the motor tasks.
  *
- * Configures and initializes motor control tasks using the provided linked list 
+ * Configures and initializes motor control tasks using the provided array 
  * of PCA9685 board controllers. This function prepares the controllers for 
  * operation but does not start the tasks; call `motor_tasks_start` to begin 
  * execution.
  *
- * @param[in] pwm_controller Pointer to the linked list of PCA9685 board 
+ * @param[in] pwm_controller Pointer to the array of PCA9685 board 
  *                           controllers managing the motors.
  *
  * @return 
@@ -45,7 +45,7 @@ esp_err_t motors_init(pca9685_board_t **pwm_controller);
  * PCA9685 board controllers. This function should be called after 
  * `motors_init` to ensure all motor tasks are ready for execution.
  *
- * @param[in] pwm_controller Pointer to the linked list of PCA9685 board 
+ * @param[in] pwm_controller Pointer to the array of PCA9685 board 
  *                           controllers managing the motors.
  *
  * @return 
@@ -8,6 +8,7 @@ extern "C" {
 #endif
 
 #include "sensor_hal.h"
+#include "sensor_history.h"
 #include "esp_err.h"
 #include "portmacro.h"
 
@@ -17,16 +18,19 @@ extern "C" {
  * @brief Structure to hold configuration for each sensor.
  *
  * Represents a sensor's configuration, including its metadata, initialization 
- * and task functions, data pointer, and an enablement flag.
+ * and task functions, data pointer, an enablement flag, and how much of its
+ * history is kept in RAM.
  */
 typedef struct {
-  const char *sensor_name;            /**< Sensor name used for identification in logs and debugging. */
-  esp_err_t (*init_function)(void *); /**< Pointer to the function that initializes the sensor. */
-  void      (*task_function)(void *); /**< Pointer to the function that handles the sensor's tasks. */
-  void       *data_ptr;               /**< Pointer to the structure holding sensor-specific data. */
-  UBaseType_t priority;               /**< Priority of the sensor's task for scheduling purposes. */
-  uint32_t    stack_depth;            /**< Stack depth allocated for the sensor task, in words. */
-  bool        enabled;                /**< Flag indicating if the sensor is enabled (true) or disabled (false). */
+  const char             *sensor_name;            /**< Sensor name used for identification in logs and debugging. */
+  esp_err_t             (*init_function)(void *); /**< Pointer to the function that initializes the sensor. */
+  void                  (*task_function)(void *); /**< Pointer to the function that handles the sensor's tasks. */
+  void                   *data_ptr;               /**< Pointer to the structure holding sensor-specific data. */
+  UBaseType_t             priority;               /**< Priority of the sensor's task for scheduling purposes. */
+  uint32_t                stack_depth;            /**< Stack depth allocated for the sensor task, in words. */
+  bool                    enabled;                /**< Flag indicating if the sensor is enabled (true) or disabled (false). */
+  sensor_record_type_t    record_type;            /**< Sensor's record schema, also its `sensor_bus` topic. */
+  sensor_history_config_t history;                /**< Samples, seconds and minutes kept by `sensor_history`, allocated when enabled. */
 } sensor_config_t;
 
 /* Public Functions ***********************************************************/
@@ -7,37 +7,93 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
+/* Constants ******************************************************************/
+
+extern const char    *webserver_tag;              /**< Logging tag for log_handler messages related to the telemetry uploader. */
+extern const uint32_t webserver_batch_window_ms;  /**< Longest time a sample waits in a batch before the batch is posted. */
+extern const uint32_t webserver_http_timeout_ms;  /**< Network timeout of one POST. */
+extern const int      webserver_gzip_level;       /**< zlib level of compressed batches, JSON compresses well even at low levels. */
+extern const int      webserver_gzip_window_bits; /**< zlib window with gzip header, 4 KB against an 8 KB batch. */
+extern const int      webserver_gzip_mem_level;   /**< zlib memory level, ~24 KB of state with the window, kept between batches. */
+
+/* Macros *********************************************************************/
+
+#define WEBSERVER_QUEUE_DEPTH     (32)   /**< Samples waiting for the uploader task, later ones are dropped. */
+#define WEBSERVER_MAX_SAMPLE_SIZE (256)  /**< Longest JSON sample, including the null terminator. */
+#define WEBSERVER_BATCH_SIZE      (8192) /**< Bytes of one batched request body before compression. */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Counters of the telemetry uploader, kept since `webserver_task_start`.
+ */
+typedef struct {
+  uint32_t queued;         /**< Samples accepted by `send_sensor_data_to_webserver`. */
+  uint32_t dropped;        /**< Samples lost to a full queue, no network or a failed POST. */
+  uint32_t sent;           /**< Samples delivered, i.e. in batches the server answered with 2xx. */
+  uint32_t batches;        /**< Batches delivered. */
+  uint32_t failed_batches; /**< Batches dropped after a failed POST or without network. */
+  uint32_t connections;    /**< HTTP clients created, a new one is made only after a network error. */
+  uint32_t body_bytes;     /**< JSON bytes of the delivered batches, wraps at 4 GB. */
+  uint32_t sent_bytes;     /**< Request body bytes sent for them, after compression. */
+} webserver_stats_t;
+
 /* Public Functions ***********************************************************/
 
 /**
- * @brief Sends a JSON string containing sensor data to the web server.
- *
- * Transmits a JSON-formatted string to a pre-configured web server endpoint
- * using HTTP POST. This function handles the underlying network communication
- * and ensures that the data is successfully sent. In case of a failure, the
- * error code provides details about the issue.
- *
- * @param[in] json_string Pointer to the null-terminated JSON string to be sent. 
- *                        The string must be properly formatted and must not 
- *                        exceed the maximum payload size supported by the 
- *                        network library.
- *
- * @return 
- * - ESP_OK              if the data is sent successfully.
- * - ESP_ERR_INVALID_ARG if `json_string` is NULL or improperly formatted.
- * - ESP_FAIL            if a network or transmission error occurs.
- * - Other error codes as defined by the network stack.
- *
- * @note 
- * - Ensure that the device is connected to the network before calling this function.
- * - The function does not perform retries; consider implementing retry logic if needed.
- * - The server endpoint and configuration (e.g., URL, port) must be predefined 
- *   in the application.
+ * @brief Starts the telemetry uploader task.
+ *
+ * Samples queued with `send_sensor_data_to_webserver` are collected into one
+ * JSON array per batch and posted to `webserver_url` over a single HTTP
+ * client, whose connection is kept alive between batches. A batch is posted
+ * once it reaches `WEBSERVER_BATCH_SIZE` or its first sample is
+ * `webserver_batch_window_ms` old. Nothing is started if no URL is set.
+ *
+ * @return
+ * - ESP_OK   if the task is running, or no URL is configured.
+ * - ESP_FAIL if the queue, buffers or task cannot be created.
+ */
+esp_err_t webserver_task_start(void);
+
+/**
+ * @brief Queues a JSON sample for the next batch to the web server.
+ *
+ * Never waits: the sample is copied into the uploader's queue and the call
+ * returns, so sensor tasks are not held up by the network. When the queue
+ * is full the sample is dropped and counted in `webserver_stats_t::dropped`.
+ *
+ * @param[in] json_string Null-terminated JSON object, shorter than
+ *                        `WEBSERVER_MAX_SAMPLE_SIZE`.
+ *
+ * @return
+ * - ESP_OK                if the sample was queued.
+ * - ESP_ERR_INVALID_ARG   if `json_string` is NULL, empty or too long.
+ * - ESP_ERR_INVALID_STATE if the uploader is not running.
+ * - ESP_FAIL              if the queue is full.
  */
 esp_err_t send_sensor_data_to_webserver(const char *json_string);
 
+/**
+ * @brief Enables gzip compression of the batched request bodies.
+ *
+ * Compressed batches are sent with `Content-Encoding: gzip`, so the server
+ * must accept it. A batch that does not shrink is sent as it is.
+ *
+ * @param[in] enable Whether to compress the following batches.
+ */
+void webserver_set_compression(bool enable);
+
+/**
+ * @brief Copies the uploader's counters.
+ *
+ * @param[out] stats Destination for the counters.
+ */
+void webserver_get_stats(webserver_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,7 +10,7 @@
 
 /* Constants ******************************************************************/
 
-const uint8_t num_pca9685_boards = 1;
+const uint8_t num_pca9685_boards = 2; /**< 18 joints at 16 channels per board, matching `joint_channels` */
 const char   *motor_tag          = "Motor Tasks";
 
 /* Private Functions (Static) *************************************************/
@@ -4,18 +4,23 @@
 
 #include "sensor_tasks.h"
 #include "system_tasks.h"
+#include "sensor_log.h"
+#include "ahrs.h"
 #include "log_handler.h"
 
 /* Globals (Static) ***********************************************************/
 
+/* History sizes are raw samples, 1 s and 1 min buckets: 2 s of the MPU6050 at
+ * 200 Hz, 10 s of the QMC5883L at 20 Hz, minutes of the slow sensors at their
+ * own rates, and an hour of each. */
 static sensor_config_t s_sensors[] = {
-  { "BH1750",     bh1750_init,     bh1750_tasks,     &(g_sensor_data.bh1750_data),     5, 4096, false },
-  { "QMC5883L",   qmc5883l_init,   qmc5883l_tasks,   &(g_sensor_data.qmc5883l_data),   5, 4096, false },
-  { "MPU6050",    mpu6050_init,    mpu6050_tasks,    &(g_sensor_data.mpu6050_data),    5, 4096, false },
-  { "DHT22",      dht22_init,      dht22_tasks,      &(g_sensor_data.dht22_data),      5, 4096, false },
-  { "GY-NEO6MV2", gy_neo6mv2_init, gy_neo6mv2_tasks, &(g_sensor_data.gy_neo6mv2_data), 5, 4096, false },
-  { "CCS811",     ccs811_init,     ccs811_tasks,     &(g_sensor_data.ccs811_data),     5, 4096, false },
-  { "MQ135",      mq135_init,      mq135_tasks,      &(g_sensor_data.mq135_data),      5, 4096, false },
+  { "BH1750",     bh1750_init,     bh1750_tasks,     &(g_sensor_data.bh1750_data),     5, 4096, false, k_sensor_record_bh1750,     { 60,  0,  60 } },
+  { "QMC5883L",   qmc5883l_init,   qmc5883l_tasks,   &(g_sensor_data.qmc5883l_data),   5, 4096, false, k_sensor_record_qmc5883l,   { 200, 60, 60 } },
+  { "MPU6050",    mpu6050_init,    mpu6050_tasks,    &(g_sensor_data.mpu6050_data),    5, 4096, false, k_sensor_record_mpu6050,    { 400, 60, 60 } },
+  { "DHT22",      dht22_init,      dht22_tasks,      &(g_sensor_data.dht22_data),      5, 4096, false, k_sensor_record_dht22,      { 60,  0,  60 } },
+  { "GY-NEO6MV2", gy_neo6mv2_init, gy_neo6mv2_tasks, &(g_sensor_data.gy_neo6mv2_data), 5, 4096, false, k_sensor_record_gy_neo6mv2, { 120, 0,  60 } },
+  { "CCS811",     ccs811_init,     ccs811_tasks,     &(g_sensor_data.ccs811_data),     5, 4096, false, k_sensor_record_ccs811,     { 120, 0,  60 } },
+  { "MQ135",      mq135_init,      mq135_tasks,      &(g_sensor_data.mq135_data),      5, 4096, false, k_sensor_record_mq135,      { 120, 0,  60 } },
 };
 
 /* Public Functions ***********************************************************/
@@ -29,6 +34,18 @@ esp_err_t sensors_init(sensor_data_t *sensor_data)
            "Init Start", 
            "Beginning initialization of all enabled sensors");
 
+  if (sensor_log_init() != ESP_OK) {
+    log_warn(system_tag, 
+             "Init Warning", 
+             "Sensor log unavailable, samples will not be stored");
+  }
+
+  if (ahrs_init(&sensor_data->mpu6050_data) != ESP_OK) {
+    log_warn(system_tag, 
+             "Init Warning", 
+             "Orientation estimate unavailable");
+  }
+
   for (uint8_t i = 0; i < sizeof(s_sensors) / sizeof(sensor_config_t); i++) {
     if (s_sensors[i].enabled) {
       log_info(system_tag, 
@@ -42,6 +59,12 @@ esp_err_t sensors_init(sensor_data_t *sensor_data)
                  "Init Success", 
                  "%s sensor initialized successfully", 
                  s_sensors[i].sensor_name);
+        if (sensor_history_init(s_sensors[i].record_type, &s_sensors[i].history) != ESP_OK) {
+          log_warn(system_tag, 
+                   "Init Warning", 
+                   "%s sensor history unavailable", 
+                   s_sensors[i].sensor_name);
+        }
       } else {
         log_error(system_tag, 
                   "Init Error", 
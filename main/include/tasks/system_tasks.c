@@ -15,6 +15,7 @@
 #include "webserver_tasks.h"
 #include "time_manager.h"
 #include "file_write_manager.h"
+#include "shutdown_manager.h"
 
 /* Defines ********************************************************************/
 
@@ -26,6 +27,10 @@
 #define ENABLE_LOG_COMPRESSION true
 #endif
 
+#ifndef ENABLE_TELEMETRY_COMPRESSION
+#define ENABLE_TELEMETRY_COMPRESSION false /* The web server must accept Content-Encoding: gzip */
+#endif
+
 /* Constants ******************************************************************/
 
 const char *system_tag = "Project-Star";
@@ -143,6 +148,14 @@ esp_err_t system_tasks_init(void)
     ret = ESP_FAIL;
   }
 
+  /* Close files cleanly on SD card removal, restarts and power warnings */
+  if (shutdown_manager_init() != ESP_OK) {
+    log_error(system_tag, 
+              "Shutdown Error", 
+              "Failed to initialize shutdown manager: files may be cut off on power loss");
+    ret = ESP_FAIL;
+  }
+
   if (ret == ESP_OK) {
     log_info(system_tag, 
              "Init Complete", 
@@ -176,6 +189,15 @@ esp_err_t system_tasks_start(void)
   } 
   TODO: Add this back in/make this work */
 
+  /* Start the telemetry uploader before the sensors queue samples for it */
+  webserver_set_compression(ENABLE_TELEMETRY_COMPRESSION);
+  if (webserver_task_start() != ESP_OK) {
+    log_error(system_tag, 
+              "Upload Error", 
+              "Failed to start telemetry uploader: sensor data stays local");
+    ret = ESP_FAIL;
+  }
+
   /* Start sensor tasks */
   log_info(system_tag, "Sensor Start", "Beginning sensor monitoring system");
   if (sensor_tasks(&g_sensor_data) != ESP_OK) {
@@ -1,72 +1,395 @@
 /* main/include/tasks/webserver_tasks.c */
 
 #include "webserver_tasks.h"
+#include <string.h>
 #include "webserver_info.h"
-#include "system_tasks.h"
+#include "wifi_tasks.h"
 #include "esp_http_client.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "zlib.h"
 #include "log_handler.h"
 
-/* Public Functions ***********************************************************/
+/* Constants ******************************************************************/
 
-esp_err_t send_sensor_data_to_webserver(const char *json_string)
+const char    *webserver_tag              = "WEBSERVER";
+const uint32_t webserver_batch_window_ms  = 1000;
+const uint32_t webserver_http_timeout_ms  = 5000;
+const int      webserver_gzip_level       = 3;
+const int      webserver_gzip_window_bits = 12 + 16; /* 4 KB window with gzip header */
+const int      webserver_gzip_mem_level   = 4;
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief Queued copy of one JSON sample.
+ */
+typedef struct {
+  uint16_t length;                          /**< Characters of json, not terminated. */
+  char     json[WEBSERVER_MAX_SAMPLE_SIZE]; /**< Sample text. */
+} webserver_sample_t;
+
+/* Globals (Static) ***********************************************************/
+
+static QueueHandle_t            s_sample_queue        = NULL;
+static TaskHandle_t             s_uploader_task       = NULL;
+static esp_http_client_handle_t s_client              = NULL;  /**< Kept between batches, so its connection is reused. */
+static char                    *s_batch_body          = NULL;  /**< JSON array being collected, WEBSERVER_BATCH_SIZE bytes. */
+static size_t                   s_batch_length        = 0;
+static uint16_t                 s_batch_samples       = 0;
+static uint8_t                 *s_gzip_body           = NULL;  /**< Compressed batch, allocated when compression is first used. */
+static z_stream                 s_deflate_stream;
+static bool                     s_deflate_open        = false;
+static volatile bool            s_compression_enabled = false;
+static bool                     s_network_up          = true;  /**< Last network state logged. */
+static webserver_sample_t       s_received_sample;             /**< Receive buffer of the uploader task, kept off its stack. */
+static webserver_stats_t        s_stats               = { 0 };
+static portMUX_TYPE             s_stats_lock          = portMUX_INITIALIZER_UNLOCKED;
+
+/* Private (Static) Functions *************************************************/
+
+/**
+ * @brief Allocates a buffer, from PSRAM when there is some.
+ */
+static void *priv_alloc(size_t size)
 {
-  if (json_string == NULL) {
-    log_error(system_tag, "Data Error", "JSON payload is NULL");
-    return ESP_ERR_INVALID_ARG;
+  void *buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (buffer == NULL) {
+    buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  }
+  return buffer;
+}
+
+/**
+ * @brief Frees what `webserver_task_start` allocated, when it fails.
+ */
+static void priv_release_start(void)
+{
+  heap_caps_free(s_batch_body);
+  s_batch_body = NULL;
+  if (s_sample_queue != NULL) {
+    vQueueDelete(s_sample_queue);
+    s_sample_queue = NULL;
+  }
+}
+
+/**
+ * @brief Empties the batch, leaving the array's opening bracket.
+ */
+static void priv_batch_reset(void)
+{
+  s_batch_body[0] = '[';
+  s_batch_length  = 1;
+  s_batch_samples = 0;
+}
+
+/**
+ * @brief Checks whether a sample still fits the batch with its comma and the closing bracket.
+ */
+static bool priv_batch_fits(size_t length)
+{
+  return s_batch_length + 1 + length + 1 <= WEBSERVER_BATCH_SIZE;
+}
+
+/**
+ * @brief Appends a sample to the batch, see `priv_batch_fits`.
+ */
+static void priv_batch_append(const webserver_sample_t *sample)
+{
+  if (s_batch_samples > 0) {
+    s_batch_body[s_batch_length++] = ',';
+  }
+  memcpy(&s_batch_body[s_batch_length], sample->json, sample->length);
+  s_batch_length += sample->length;
+  s_batch_samples++;
+}
+
+/**
+ * @brief Gzips the batch into `s_gzip_body`.
+ *
+ * The deflate state is set up once and reset per batch, so compressing
+ * allocates nothing after the first batch.
+ *
+ * @param[out] compressed_length Bytes of the gzip body.
+ * @return true if the gzip body is smaller than the batch
+ */
+static bool priv_compress_batch(size_t *compressed_length)
+{
+  if (s_gzip_body == NULL) {
+    s_gzip_body = priv_alloc(WEBSERVER_BATCH_SIZE);
+    if (s_gzip_body == NULL) {
+      return false;
+    }
+  }
+
+  if (s_deflate_open) {
+    deflateReset(&s_deflate_stream);
+  } else {
+    memset(&s_deflate_stream, 0, sizeof(s_deflate_stream));
+    if (deflateInit2(&s_deflate_stream,
+                     webserver_gzip_level,
+                     Z_DEFLATED,
+                     webserver_gzip_window_bits,
+                     webserver_gzip_mem_level,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      log_warn(webserver_tag, "Zlib Error", "Failed to initialize zlib, sending uncompressed");
+      return false;
+    }
+    s_deflate_open = true;
+  }
+
+  s_deflate_stream.next_in   = (Bytef *)s_batch_body;
+  s_deflate_stream.avail_in  = s_batch_length;
+  s_deflate_stream.next_out  = s_gzip_body;
+  s_deflate_stream.avail_out = WEBSERVER_BATCH_SIZE;
+  if (deflate(&s_deflate_stream, Z_FINISH) != Z_STREAM_END) {
+    return false; /* Did not fit, so it would not be smaller */
+  }
+
+  *compressed_length = WEBSERVER_BATCH_SIZE - s_deflate_stream.avail_out;
+  return *compressed_length < s_batch_length;
+}
+
+/**
+ * @brief Posts one body over the kept HTTP client, creating it if needed.
+ *
+ * The client is dropped after a network error, so the next post connects
+ * again; an HTTP error status keeps it.
+ *
+ * @param[in]  body    Request body.
+ * @param[in]  length  Bytes of body.
+ * @param[in]  gzip    Whether body is gzip compressed.
+ * @param[out] status  HTTP status code, set on ESP_OK.
+ * @return ESP_OK if the server answered, the error of the client otherwise
+ */
+static esp_err_t priv_perform(const void *body, size_t length, bool gzip, int *status)
+{
+  if (s_client == NULL) {
+    /* One client per connection: it reuses its socket while the server keeps it open */
+    esp_http_client_config_t config = {
+      .url               = webserver_url,
+      .method            = HTTP_METHOD_POST,
+      .timeout_ms        = webserver_http_timeout_ms,
+      .keep_alive_enable = true,
+    };
+    s_client = esp_http_client_init(&config);
+    if (s_client == NULL) {
+      log_error(webserver_tag, "Client Error", "Failed to initialize HTTP client");
+      return ESP_FAIL;
+    }
+    esp_http_client_set_header(s_client, "Content-Type", "application/json");
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.connections++;
+    portEXIT_CRITICAL(&s_stats_lock);
+  }
+
+  if (gzip) {
+    esp_http_client_set_header(s_client, "Content-Encoding", "gzip");
+  } else {
+    esp_http_client_delete_header(s_client, "Content-Encoding");
   }
+  esp_http_client_set_post_field(s_client, (const char *)body, length);
 
-  /* Check if the network is ready */
+  esp_err_t err = esp_http_client_perform(s_client);
+  if (err != ESP_OK) {
+    esp_http_client_cleanup(s_client);
+    s_client = NULL;
+    return err;
+  }
+  *status = esp_http_client_get_status_code(s_client);
+  return ESP_OK;
+}
+
+/**
+ * @brief Posts the collected batch and empties it.
+ *
+ * A batch that cannot be delivered is dropped, so a long outage costs
+ * samples rather than memory.
+ */
+static void priv_post_batch(void)
+{
+  if (s_batch_samples == 0) {
+    return;
+  }
+  s_batch_body[s_batch_length++] = ']';
+
+  bool delivered = false;
   if (wifi_check_connection() != ESP_OK) {
-    log_error(system_tag, 
-              "Network Error", 
-              "Network connection unavailable for data transmission");
-    return ESP_FAIL;
+    if (s_network_up) {
+      log_warn(webserver_tag, "Network Down", "No network connection, dropping telemetry batches");
+      s_network_up = false;
+    }
+    if (s_client != NULL) {
+      esp_http_client_cleanup(s_client);
+      s_client = NULL;
+    }
+  } else {
+    s_network_up = true;
+
+    const void *body   = s_batch_body;
+    size_t      length = s_batch_length;
+    size_t      compressed_length;
+    bool        gzip   = s_compression_enabled && priv_compress_batch(&compressed_length);
+    if (gzip) {
+      body   = s_gzip_body;
+      length = compressed_length;
+    }
+
+    /* An idle keep-alive connection may have been closed by the server, retry once on a new one */
+    int       status = 0;
+    bool      reused = s_client != NULL;
+    esp_err_t err    = priv_perform(body, length, gzip, &status);
+    if (err != ESP_OK && reused) {
+      err = priv_perform(body, length, gzip, &status);
+    }
+
+    if (err != ESP_OK) {
+      log_warn(webserver_tag,
+               "Send Error",
+               "Failed to post %u samples: %s",
+               s_batch_samples,
+               esp_err_to_name(err));
+    } else if (status < 200 || status >= 300) {
+      log_warn(webserver_tag,
+               "Server Error",
+               "Server refused %u samples with status %d",
+               s_batch_samples,
+               status);
+    } else {
+      delivered = true;
+      portENTER_CRITICAL(&s_stats_lock);
+      s_stats.sent       += s_batch_samples;
+      s_stats.batches++;
+      s_stats.body_bytes += s_batch_length;
+      s_stats.sent_bytes += length;
+      portEXIT_CRITICAL(&s_stats_lock);
+    }
   }
 
-  log_info(system_tag, "HTTP Start", "Preparing HTTP client for data transmission");
+  if (!delivered) {
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.dropped += s_batch_samples;
+    s_stats.failed_batches++;
+    portEXIT_CRITICAL(&s_stats_lock);
+  }
+  priv_batch_reset();
+}
 
-  esp_http_client_config_t config = {
-    .url    = webserver_url,
-    .method = HTTP_METHOD_POST,
-  };
+/**
+ * @brief Collects queued samples into batches and posts them.
+ *
+ * A batch is posted when the next sample does not fit or its first sample
+ * is `webserver_batch_window_ms` old, whichever comes first.
+ */
+static void priv_uploader_task(void *arg)
+{
+  const TickType_t window      = pdMS_TO_TICKS(webserver_batch_window_ms);
+  TickType_t       batch_start = 0;
 
-  esp_http_client_handle_t client = esp_http_client_init(&config);
-  if (client == NULL) {
-    log_error(system_tag, "Client Error", "Failed to initialize HTTP client");
-    return ESP_FAIL;
+  while (1) {
+    TickType_t wait = portMAX_DELAY;
+    if (s_batch_samples > 0) {
+      TickType_t age = xTaskGetTickCount() - batch_start;
+      wait           = age < window ? window - age : 0;
+    }
+
+    if (xQueueReceive(s_sample_queue, &s_received_sample, wait) == pdTRUE) {
+      if (!priv_batch_fits(s_received_sample.length)) {
+        priv_post_batch();
+      }
+      if (s_batch_samples == 0) {
+        batch_start = xTaskGetTickCount();
+      }
+      priv_batch_append(&s_received_sample);
+      if (xTaskGetTickCount() - batch_start < window) {
+        continue;
+      }
+    }
+    priv_post_batch();
   }
+}
+
+/* Public Functions ***********************************************************/
 
-  if (esp_http_client_set_header(client, "Content-Type", "application/json") != ESP_OK) {
-    log_error(system_tag, "Header Error", "Failed to set Content-Type header");
-    esp_http_client_cleanup(client);
+esp_err_t webserver_task_start(void)
+{
+  if (s_uploader_task != NULL) {
+    return ESP_OK;
+  }
+  if (webserver_url[0] == '\0') {
+    log_info(webserver_tag, "Upload Skip", "No web server URL configured, telemetry upload disabled");
+    return ESP_OK;
+  }
+
+  s_batch_body   = priv_alloc(WEBSERVER_BATCH_SIZE);
+  s_sample_queue = xQueueCreate(WEBSERVER_QUEUE_DEPTH, sizeof(webserver_sample_t));
+  if (s_batch_body == NULL || s_sample_queue == NULL) {
+    log_error(webserver_tag, "Init Error", "Failed to allocate the telemetry queue and batch buffer");
+    priv_release_start();
     return ESP_FAIL;
   }
+  priv_batch_reset();
 
-  if (esp_http_client_set_post_field(client, json_string, strlen(json_string)) != ESP_OK) {
-    log_error(system_tag, "Post Error", "Failed to set POST data");
-    esp_http_client_cleanup(client);
+  if (xTaskCreate(priv_uploader_task,
+                  "webserver_task",
+                  6144,
+                  NULL,
+                  4,
+                  &s_uploader_task) != pdPASS) {
+    log_error(webserver_tag, "Task Error", "Failed to create telemetry uploader task");
+    priv_release_start();
     return ESP_FAIL;
   }
 
-  log_info(system_tag, 
-           "Send Start", 
-           "Transmitting data to server at %s", 
+  log_info(webserver_tag,
+           "Upload Start",
+           "Posting telemetry batches to %s",
            webserver_url);
-  esp_err_t err = esp_http_client_perform(client);
-  if (err == ESP_OK) {
-    int status_code = esp_http_client_get_status_code(client);
-    log_info(system_tag, 
-             "Send Success", 
-             "Data transmitted successfully, server response code: %u", 
-             status_code);
+  return ESP_OK;
+}
+
+esp_err_t send_sensor_data_to_webserver(const char *json_string)
+{
+  if (json_string == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_uploader_task == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  size_t length = strnlen(json_string, WEBSERVER_MAX_SAMPLE_SIZE);
+  if (length == 0 || length >= WEBSERVER_MAX_SAMPLE_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  webserver_sample_t sample;
+  sample.length = length;
+  memcpy(sample.json, json_string, length);
+
+  bool queued = xQueueSend(s_sample_queue, &sample, 0) == pdTRUE;
+  portENTER_CRITICAL(&s_stats_lock);
+  if (queued) {
+    s_stats.queued++;
   } else {
-    log_error(system_tag, 
-              "Send Error", 
-              "HTTP transmission failed: %s", 
-              esp_err_to_name(err));
+    s_stats.dropped++;
   }
+  portEXIT_CRITICAL(&s_stats_lock);
+  return queued ? ESP_OK : ESP_FAIL;
+}
 
-  esp_http_client_cleanup(client);
-  return err;
+void webserver_set_compression(bool enable)
+{
+  s_compression_enabled = enable;
 }
 
+void webserver_get_stats(webserver_stats_t *stats)
+{
+  if (stats == NULL) {
+    return;
+  }
+  portENTER_CRITICAL(&s_stats_lock);
+  *stats = s_stats;
+  portEXIT_CRITICAL(&s_stats_lock);
+}
@@ -0,0 +1,411 @@
+/* main/motion_frame.c */
+
+#include "motion_frame.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "log_handler.h"
+
+/* Macros *********************************************************************/
+
+#define MOTION_FRAME_POS_SHIFT (4)    /* Positions are tracked in 1/16 of a 0.1° step */
+#define MOTION_FRAME_POS_MAX   (1800) /* 180° in 0.1° steps */
+#define MOTION_FRAME_UNSENT    (0xFFFF)
+
+/* Structs (Private) **********************************************************/
+
+/**
+ * @brief Where and when a single servo is driven.
+ */
+typedef struct {
+  uint8_t  board_id; /**< PCA9685 board driving the servo. */
+  uint8_t  channel;  /**< Channel on that board. */
+  uint16_t on_ticks; /**< Start of the servo's time slice within the PWM period. */
+} motion_frame_slot_t;
+
+/* Constants ******************************************************************/
+
+const char   *motion_frame_tag         = "Motion Frame";
+const uint8_t motion_frame_accel_steps = 4;
+
+/* Globals (Static) ***********************************************************/
+
+static pca9685_board_t      *s_pwm_controller              = NULL;
+static motion_frame_slot_t   s_slots[NUMBER_OF_JOINTS]     = {0}; /* Indexed by hexapod_joint_index */
+static leg_angles_q16_t      s_pose_angles                 = {0};
+static leg_servo_positions_t s_pose_servo                  = {0};
+static int32_t               s_target[NUMBER_OF_JOINTS]    = {0}; /* Guarded by s_target_mutex */
+static int32_t               s_position[NUMBER_OF_JOINTS]  = {0}; /* Owned by the motion frame task */
+static int32_t               s_velocity[NUMBER_OF_JOINTS]  = {0}; /* Signed, per step */
+static uint16_t              s_last_sent[NUMBER_OF_JOINTS] = {0};
+static motion_profile_t      s_profile                     = k_motion_profile_trapezoidal;
+static int64_t               s_pending_submit_us           = 0;   /* 0 when no submit awaits a write */
+static SemaphoreHandle_t     s_target_mutex                = NULL;
+static TaskHandle_t          s_task                        = NULL;
+static motion_frame_stats_t  s_stats                       = {0};
+static bool                  s_initialized                 = false;
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Replaces the targets of every servo.
+ *
+ * @param[in] pose Absolute servo positions for all joints, clamped to 0-180°.
+ *
+ * @return
+ * - `ESP_OK`          on success.
+ * - `ESP_ERR_TIMEOUT` if the target buffer stayed locked.
+ */
+static esp_err_t priv_set_targets(const leg_servo_positions_t *pose)
+{
+  int64_t now_us = esp_timer_get_time();
+
+  if (xSemaphoreTake(s_target_mutex, pdMS_TO_TICKS(pca9685_step_delay_ms)) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    const uint16_t positions[JOINTS_PER_LEG] = { pose->hip[leg],
+                                                 pose->knee[leg],
+                                                 pose->tibia[leg] };
+
+    for (uint8_t joint = 0; joint < JOINTS_PER_LEG; ++joint) {
+      uint16_t position = (positions[joint] > MOTION_FRAME_POS_MAX) ? MOTION_FRAME_POS_MAX :
+                                                                      positions[joint];
+      s_target[hexapod_joint_index(leg, joint)] = (int32_t)position << MOTION_FRAME_POS_SHIFT;
+    }
+  }
+  if (s_pending_submit_us == 0) {
+    s_pending_submit_us = now_us;
+  }
+  xSemaphoreGive(s_target_mutex);
+  xTaskNotifyGive(s_task); /* Wakes the task if it is resting */
+  return ESP_OK;
+}
+
+/**
+ * @brief Distance covered while braking to rest from a given speed.
+ *
+ * @param[in] speed Speed on the current step, position units per step.
+ * @param[in] accel Deceleration per step.
+ *
+ * @return Distance travelled on the steps after the current one.
+ */
+static inline int32_t priv_stopping_distance(int32_t speed, int32_t accel)
+{
+  int32_t steps = speed / accel;
+  return steps * speed - accel * steps * (steps + 1) / 2;
+}
+
+/**
+ * @brief Advances one servo a single step along a trapezoidal velocity profile.
+ *
+ * Picks the fastest of accelerating, cruising or braking that still leaves
+ * room to stop on the target. A servo moving away from its target (the
+ * target jumped behind it) brakes first.
+ *
+ * @param[in] servo     Index of the servo to advance.
+ * @param[in] target    Target position, 1/16 of a 0.1° step.
+ * @param[in] max_speed Speed limit, position units per step.
+ * @param[in] accel     Acceleration limit, position units per step squared.
+ */
+static void priv_step_trapezoidal(uint8_t servo,
+                                  int32_t target,
+                                  int32_t max_speed,
+                                  int32_t accel)
+{
+  int32_t error = target - s_position[servo];
+  if (error == 0 && s_velocity[servo] == 0) {
+    return;
+  }
+
+  int32_t direction = (error >= 0) ? 1 : -1;
+  int32_t distance  = error * direction;
+  int32_t speed     = s_velocity[servo] * direction; /* Negative when moving away */
+
+  if (speed < 0) {
+    speed = (speed + accel > 0) ? 0 : speed + accel;
+  } else {
+    int32_t faster = (speed + accel < max_speed) ? speed + accel : max_speed;
+    if (faster + priv_stopping_distance(faster, accel) <= distance) {
+      speed = faster;
+    } else if (speed + priv_stopping_distance(speed, accel) > distance) {
+      speed -= accel;
+    }
+
+    /* Keep creeping in so short moves still finish */
+    int32_t creep = (accel < distance) ? accel : distance;
+    if (speed < creep) {
+      speed = creep;
+    }
+  }
+  if (speed > distance) {
+    speed = distance;
+  }
+
+  s_position[servo] += speed * direction;
+  s_velocity[servo]  = (s_position[servo] == target) ? 0 : speed * direction;
+}
+
+/**
+ * @brief Moves every servo one step toward its target and writes the changes.
+ *
+ * Only servos whose rounded position moved are staged, and all boards are
+ * flushed together, so idle servos cost no bus traffic.
+ *
+ * @param[in] targets    Snapshot of the servo targets.
+ * @param[in] submit_us  Time of the oldest submit not yet written, 0 if none.
+ *
+ * @return true while a servo has not reached its target or a write failed.
+ */
+static bool priv_step_frame(const int32_t *targets, int64_t submit_us)
+{
+  const int32_t max_speed = ((int32_t)pca9685_step_size_deg * 10) << MOTION_FRAME_POS_SHIFT;
+  const int32_t accel     = (max_speed / motion_frame_accel_steps > 0) ?
+                            max_speed / motion_frame_accel_steps : 1;
+  esp_err_t     ret       = ESP_OK;
+  uint8_t       changed   = 0;
+  bool          moving    = false;
+
+  for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS && ret == ESP_OK; ++servo) {
+    if (s_profile == k_motion_profile_direct) {
+      s_position[servo] = targets[servo];
+      s_velocity[servo] = 0;
+    } else {
+      priv_step_trapezoidal(servo, targets[servo], max_speed, accel);
+    }
+    if (s_position[servo] != targets[servo]) {
+      moving = true;
+    }
+
+    uint16_t position = (uint16_t)((s_position[servo] + (1 << (MOTION_FRAME_POS_SHIFT - 1))) >>
+                                   MOTION_FRAME_POS_SHIFT);
+    if (position == s_last_sent[servo]) {
+      continue;
+    }
+
+    const motion_frame_slot_t *slot = &s_slots[servo];
+    ret = pca9685_stage_angle(s_pwm_controller,
+                              slot->board_id,
+                              slot->channel,
+                              slot->on_ticks,
+                              position);
+    s_last_sent[servo] = position;
+    changed++;
+  }
+
+  if (ret == ESP_OK && changed > 0) {
+    ret = pca9685_flush(s_pwm_controller);
+  }
+  if (ret != ESP_OK) {
+    /* Resend everything next step, the boards may hold a partial frame */
+    for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS; ++servo) {
+      s_last_sent[servo] = MOTION_FRAME_UNSENT;
+    }
+    s_stats.failed_frames++;
+    return true;
+  }
+  if (changed == 0) {
+    return moving;
+  }
+
+  s_stats.frames++;
+  s_stats.servo_updates += changed;
+  if (submit_us != 0) {
+    uint32_t latency_us     = (uint32_t)(esp_timer_get_time() - submit_us);
+    s_stats.last_latency_us = latency_us;
+    if (latency_us > s_stats.max_latency_us) {
+      s_stats.max_latency_us = latency_us;
+    }
+  }
+  return moving;
+}
+
+/**
+ * @brief Interpolation task, steps every servo once per PWM frame.
+ *
+ * While servos travel, frames run every `pca9685_step_delay_ms`. Once all
+ * of them rest on their targets the task sleeps until the next submit and
+ * steps straight away, unless the last frame was less than a period ago,
+ * so a pose sent to resting servos is not held back by the frame phase.
+ *
+ * @param[in] arg Unused.
+ */
+static void priv_motion_frame_task(void *arg)
+{
+  int32_t    targets[NUMBER_OF_JOINTS];
+  TickType_t period = pdMS_TO_TICKS(pca9685_step_delay_ms);
+  if (period == 0) {
+    period = 1;
+  }
+
+  while (1) {
+    TickType_t frame_start = xTaskGetTickCount();
+    bool       moving      = true;
+    int64_t    submit_us   = 0;
+    if (xSemaphoreTake(s_target_mutex, portMAX_DELAY) == pdTRUE) {
+      for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS; ++servo) {
+        targets[servo] = s_target[servo];
+      }
+      submit_us           = s_pending_submit_us;
+      s_pending_submit_us = 0;
+      xSemaphoreGive(s_target_mutex);
+
+      moving = priv_step_frame(targets, submit_us);
+    }
+
+    if (!moving) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    /* Speed and acceleration limits are per frame, so frames stay a period apart */
+    TickType_t elapsed = xTaskGetTickCount() - frame_start;
+    if (elapsed < period) {
+      vTaskDelay(period - elapsed);
+    }
+  }
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t motion_frame_init(pca9685_board_t *pwm_controller, const motor_t *motors)
+{
+  if (pwm_controller == NULL || motors == NULL) {
+    log_error(motion_frame_tag, "Init Error", "PCA9685 controller or motor table is NULL");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  /* Slices are as wide as the longest calibrated pulse, so pulses in different slices never overlap */
+  uint16_t slot_ticks = pca9685_max_pulse_ticks;
+  for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS; ++servo) {
+    pca9685_servo_cal_t cal;
+    if (pca9685_get_calibration(pwm_controller,
+                                motors[servo].board_id,
+                                motors[servo].motor_id,
+                                &cal) != ESP_OK) {
+      log_error(motion_frame_tag,
+                "Init Error",
+                "Joint %u is mapped to missing board %u",
+                servo,
+                motors[servo].board_id);
+      return ESP_ERR_INVALID_ARG;
+    }
+    if (cal.max_pulse_ticks > slot_ticks) {
+      slot_ticks = cal.max_pulse_ticks;
+    }
+  }
+
+  const uint8_t per_slot       = (max_active_servos > 0) ? max_active_servos : 1;
+  const uint8_t slots_needed   = (NUMBER_OF_JOINTS + per_slot - 1) / per_slot;
+  const uint8_t slots_in_frame = pca9685_pwm_resolution / slot_ticks;
+
+  if (slots_needed > slots_in_frame) {
+    log_warn(motion_frame_tag,
+             "Slot Warning",
+             "%u time slices needed but only %u fit in the PWM period, slices will overlap",
+             slots_needed,
+             slots_in_frame);
+  }
+
+  for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS; ++servo) {
+    motion_frame_slot_t *slot = &s_slots[servo];
+    slot->board_id            = motors[servo].board_id;
+    slot->channel             = motors[servo].motor_id;
+    slot->on_ticks            = ((servo / per_slot) % slots_in_frame) * slot_ticks;
+  }
+
+  /* The HAL parks every servo at the default angle during its own init */
+  const int32_t rest = (int32_t)(pca9685_default_angle * 10.0f + 0.5f) << MOTION_FRAME_POS_SHIFT;
+  for (uint8_t servo = 0; servo < NUMBER_OF_JOINTS; ++servo) {
+    s_target[servo]    = rest;
+    s_position[servo]  = rest;
+    s_velocity[servo]  = 0;
+    s_last_sent[servo] = MOTION_FRAME_UNSENT;
+  }
+
+  s_pwm_controller    = pwm_controller;
+  s_pending_submit_us = 0;
+  s_stats             = (motion_frame_stats_t){0};
+
+  if (s_target_mutex == NULL) {
+    s_target_mutex = xSemaphoreCreateMutex();
+    if (s_target_mutex == NULL) {
+      log_error(motion_frame_tag, "Init Error", "Failed to create target mutex");
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  if (s_task == NULL) {
+    BaseType_t task_created = xTaskCreate(priv_motion_frame_task,
+                                          "motion_frame_task",
+                                          4096,
+                                          NULL,
+                                          6,
+                                          &s_task);
+    if (task_created != pdPASS) {
+      log_error(motion_frame_tag, "Task Error", "Failed to create motion frame task");
+      s_task = NULL;
+      return ESP_FAIL;
+    }
+  }
+  s_initialized = true;
+
+  log_info(motion_frame_tag,
+           "Init Complete",
+           "%u servos spread over %u time slices of %u ticks",
+           NUMBER_OF_JOINTS,
+           slots_needed,
+           slot_ticks);
+  return ESP_OK;
+}
+
+esp_err_t motion_frame_submit(const leg_angles_t *pose)
+{
+  if (pose == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  /* Reuse the fixed-point conversion so both paths clamp identically */
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+    s_pose_angles.hip[leg]   = kinematics_deg_to_angle(pose->hip_deg[leg]);
+    s_pose_angles.knee[leg]  = kinematics_deg_to_angle(pose->knee_deg[leg]);
+    s_pose_angles.tibia[leg] = kinematics_deg_to_angle(pose->tibia_deg[leg]);
+  }
+
+  esp_err_t ret = kinematics_angles_to_servo_q16(&s_pose_angles, &s_pose_servo);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  return priv_set_targets(&s_pose_servo);
+}
+
+esp_err_t motion_frame_submit_servo(const leg_servo_positions_t *pose)
+{
+  if (pose == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return priv_set_targets(pose);
+}
+
+esp_err_t motion_frame_set_profile(motion_profile_t profile)
+{
+  if (profile != k_motion_profile_direct && profile != k_motion_profile_trapezoidal) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  s_profile = profile;
+  return ESP_OK;
+}
+
+void motion_frame_get_stats(motion_frame_stats_t *stats)
+{
+  if (stats != NULL) {
+    *stats = s_stats;
+  }
+}
@@ -0,0 +1,623 @@
+/* tools/ahrs_replay/ahrs_replay.c */
+
+/* Replays IMU and magnetometer traces through the firmware's AHRS filter,
+ * and measures its accuracy and update rate.
+ *
+ *   ahrs_replay [options] --imu IMU.csv [--mag MAG.csv]
+ *   ahrs_replay [options] --synthetic SECONDS [--save PREFIX]
+ *
+ * Traces are the CSV output of sensor_decoder for mpu6050.tsns and
+ * qmc5883l.tsns. An IMU trace with roll, pitch and heading columns is used
+ * as ground truth. --synthetic generates a walking trace with known
+ * orientation, gyro bias and noise instead; --save writes it out in the
+ * decoder's format so it can be replayed with other settings.
+ *
+ * Options: --kp, --ki, --accel-reject G, --mag-age MS to override the
+ * firmware tuning, --settle S to leave the start out of the error figures,
+ * --trace to print the estimate after every sample. */
+
+#include "ahrs_filter.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define CSV_MAX_COLUMNS   (16)
+#define CSV_MAX_LINE      (512)
+#define BENCHMARK_SECONDS (1.0)
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief One IMU sample, with the true orientation when known
+ */
+typedef struct {
+  int64_t timestamp_us;
+  float   accel[3]; /* g */
+  float   gyro[3];  /* °/s */
+  float   truth[3]; /* Roll, pitch and heading in degrees */
+} imu_row_t;
+
+/**
+ * @brief One magnetometer sample
+ */
+typedef struct {
+  int64_t timestamp_us;
+  float   mag[3]; /* µT */
+} mag_row_t;
+
+/**
+ * @brief Samples of a replay, sorted by time per sensor
+ */
+typedef struct {
+  imu_row_t *imu;
+  size_t     imu_count;
+  mag_row_t *mag;
+  size_t     mag_count;
+  bool       has_truth;
+  float      true_bias[3]; /* Synthetic traces only, °/s */
+} trace_t;
+
+/**
+ * @brief Error of one angle against the truth
+ */
+typedef struct {
+  double sum_sq;
+  double max;
+  size_t count;
+} error_stats_t;
+
+/**
+ * @brief CSV file held in memory, non-numeric fields are NAN
+ */
+typedef struct {
+  char    names[CSV_MAX_COLUMNS][32];
+  size_t  columns;
+  double *values;
+  size_t  rows;
+} csv_t;
+
+/* Globals (Static) ***********************************************************/
+
+static ahrs_filter_config_t s_config;
+static double               s_settle_s = 5.0;
+static bool                 s_trace    = false;
+static uint64_t             s_rng      = 0x9E3779B97F4A7C15ull;
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_now_s(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Normally distributed noise, reproducible between runs
+ */
+static double priv_gaussian(double sigma)
+{
+  double u[2];
+  for (int i = 0; i < 2; i++) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    u[i]   = ((s_rng >> 11) + 0.5) / 9007199254740992.0;
+  }
+  return sigma * sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+/**
+ * @brief Wraps an angle difference to [-180, 180)
+ */
+static double priv_wrap_deg(double angle)
+{
+  angle = fmod(angle + 180.0, 360.0);
+  return (angle < 0.0 ? angle + 360.0 : angle) - 180.0;
+}
+
+static void priv_error_add(error_stats_t *stats, double error)
+{
+  stats->sum_sq += error * error;
+  stats->max     = fmax(stats->max, fabs(error));
+  stats->count++;
+}
+
+static void priv_error_print(const char *name, const error_stats_t *stats)
+{
+  if (stats->count == 0) {
+    return;
+  }
+  printf("  %-16s rms %7.3f  max %7.3f deg\n", name, sqrt(stats->sum_sq / stats->count), stats->max);
+}
+
+/* Synthetic traces ***********************************************************/
+
+/**
+ * @brief True orientation of the synthetic walk, ZYX angles in radians
+ *
+ * Slow terrain tilts and turns with the sway of the gait on top.
+ */
+static void priv_synthetic_pose(double t, double *roll, double *pitch, double *yaw)
+{
+  const double d = M_PI / 180.0;
+  *roll  = d * (10.0 * sin(2.0 * M_PI * 0.11 * t) + 2.0 * sin(2.0 * M_PI * 1.8 * t));
+  *pitch = d * (7.0 * sin(2.0 * M_PI * 0.07 * t + 1.0) + 1.5 * sin(2.0 * M_PI * 1.8 * t + 0.7));
+  *yaw   = d * (120.0 * sin(2.0 * M_PI * 0.02 * t) + 45.0 * sin(2.0 * M_PI * 0.09 * t));
+}
+
+static void priv_euler_to_q(double roll, double pitch, double yaw, double *q)
+{
+  double cr = cos(roll / 2), sr = sin(roll / 2);
+  double cp = cos(pitch / 2), sp = sin(pitch / 2);
+  double cy = cos(yaw / 2), sy = sin(yaw / 2);
+  q[0] = cr * cp * cy + sr * sp * sy;
+  q[1] = sr * cp * cy - cr * sp * sy;
+  q[2] = cr * sp * cy + sr * cp * sy;
+  q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+/**
+ * @brief Expresses an earth frame vector in the body frame
+ */
+static void priv_to_body(const double *q, const double *earth, double *body)
+{
+  double r[3][3] = {
+    { 1 - 2 * (q[2] * q[2] + q[3] * q[3]), 2 * (q[1] * q[2] - q[0] * q[3]),     2 * (q[1] * q[3] + q[0] * q[2]) },
+    { 2 * (q[1] * q[2] + q[0] * q[3]),     1 - 2 * (q[1] * q[1] + q[3] * q[3]), 2 * (q[2] * q[3] - q[0] * q[1]) },
+    { 2 * (q[1] * q[3] - q[0] * q[2]),     2 * (q[2] * q[3] + q[0] * q[1]),     1 - 2 * (q[1] * q[1] + q[2] * q[2]) },
+  };
+  for (int i = 0; i < 3; i++) {
+    body[i] = r[0][i] * earth[0] + r[1][i] * earth[1] + r[2][i] * earth[2];
+  }
+}
+
+/**
+ * @brief Generates a walk at 200 Hz with a 20 Hz magnetometer
+ *
+ * Noise levels are the datasheet figures of the MPU6050 at its 98 Hz
+ * bandwidth and of the QMC5883L at 512 times oversampling.
+ */
+static void priv_synthetic_trace(trace_t *trace, double seconds)
+{
+  const double imu_rate = 200.0;
+  const double mag_rate = 20.0;
+  const double field[3] = { 20.0, 0.0, -45.0 }; /* µT, north and down, 66° dip */
+  const double bias[3]  = { 1.2, -0.7, 0.9 };   /* °/s */
+
+  trace->imu_count = (size_t)(seconds * imu_rate);
+  trace->mag_count = (size_t)(seconds * mag_rate);
+  trace->imu       = calloc(trace->imu_count, sizeof(imu_row_t));
+  trace->mag       = calloc(trace->mag_count, sizeof(mag_row_t));
+  trace->has_truth = true;
+  for (int i = 0; i < 3; i++) {
+    trace->true_bias[i] = (float)bias[i];
+  }
+  if (trace->imu == NULL || trace->mag == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+
+  for (size_t i = 0; i < trace->imu_count; i++) {
+    double t = i / imu_rate;
+    double roll, pitch, yaw, q[4], q_next[4];
+    priv_synthetic_pose(t, &roll, &pitch, &yaw);
+    priv_euler_to_q(roll, pitch, yaw, q);
+
+    /* Body rates from the change of the true rotation over a short step */
+    const double step = 1e-5;
+    double       roll2, pitch2, yaw2;
+    priv_synthetic_pose(t + step, &roll2, &pitch2, &yaw2);
+    priv_euler_to_q(roll2, pitch2, yaw2, q_next);
+    double dq[4] = {
+      q[0] * q_next[0] + q[1] * q_next[1] + q[2] * q_next[2] + q[3] * q_next[3],
+      q[0] * q_next[1] - q[1] * q_next[0] - q[2] * q_next[3] + q[3] * q_next[2],
+      q[0] * q_next[2] + q[1] * q_next[3] - q[2] * q_next[0] - q[3] * q_next[1],
+      q[0] * q_next[3] - q[1] * q_next[2] + q[2] * q_next[1] - q[3] * q_next[0],
+    };
+
+    /* Gait bounce and surge on top of gravity */
+    double up[3] = {
+      0.05 * sin(4.0 * M_PI * t),
+      0.03 * cos(4.0 * M_PI * t),
+      1.0 + 0.08 * sin(4.0 * M_PI * t + 0.5),
+    };
+    double accel[3];
+    priv_to_body(q, up, accel);
+
+    imu_row_t *row   = &trace->imu[i];
+    row->timestamp_us = (int64_t)llround(t * 1e6);
+    for (int k = 0; k < 3; k++) {
+      row->gyro[k]  = (float)(2.0 * dq[k + 1] / step * 180.0 / M_PI + bias[k] + priv_gaussian(0.05));
+      row->accel[k] = (float)(accel[k] + priv_gaussian(0.004));
+    }
+    double heading = priv_wrap_deg(-yaw * 180.0 / M_PI);
+    row->truth[0]  = (float)(roll * 180.0 / M_PI);
+    row->truth[1]  = (float)(pitch * 180.0 / M_PI);
+    row->truth[2]  = (float)(heading < 0.0 ? heading + 360.0 : heading);
+  }
+
+  for (size_t i = 0; i < trace->mag_count; i++) {
+    double t = (i + 0.3) / mag_rate; /* Not in step with the IMU */
+    double roll, pitch, yaw, q[4], mag[3];
+    priv_synthetic_pose(t, &roll, &pitch, &yaw);
+    priv_euler_to_q(roll, pitch, yaw, q);
+    priv_to_body(q, field, mag);
+    trace->mag[i].timestamp_us = (int64_t)llround(t * 1e6);
+    for (int k = 0; k < 3; k++) {
+      trace->mag[i].mag[k] = (float)(mag[k] + priv_gaussian(0.2));
+    }
+  }
+}
+
+/**
+ * @brief Writes a trace in sensor_decoder's CSV layout
+ */
+static int priv_save_trace(const trace_t *trace, const char *prefix)
+{
+  char  path[256];
+  snprintf(path, sizeof(path), "%s_imu.csv", prefix);
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "%s: cannot write file\n", path);
+    return 1;
+  }
+  fputs("uptime_us,time,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z,temperature,roll,pitch,heading\n", file);
+  for (size_t i = 0; i < trace->imu_count; i++) {
+    const imu_row_t *row = &trace->imu[i];
+    fprintf(file, "%" PRId64 ",,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,30.00,%.3f,%.3f,%.3f\n",
+            row->timestamp_us,
+            row->accel[0], row->accel[1], row->accel[2],
+            row->gyro[0], row->gyro[1], row->gyro[2],
+            row->truth[0], row->truth[1], row->truth[2]);
+  }
+  fclose(file);
+
+  snprintf(path, sizeof(path), "%s_mag.csv", prefix);
+  file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "%s: cannot write file\n", path);
+    return 1;
+  }
+  fputs("uptime_us,time,mag_x,mag_y,mag_z,heading\n", file);
+  for (size_t i = 0; i < trace->mag_count; i++) {
+    const mag_row_t *row     = &trace->mag[i];
+    double           heading = atan2(row->mag[1], row->mag[0]) * 180.0 / M_PI;
+    fprintf(file, "%" PRId64 ",,%.3f,%.3f,%.3f,%.2f\n",
+            row->timestamp_us, row->mag[0], row->mag[1], row->mag[2],
+            heading < 0.0 ? heading + 360.0 : heading);
+  }
+  fclose(file);
+  return 0;
+}
+
+/* Recorded traces ************************************************************/
+
+/**
+ * @brief Loads a CSV file, lines not starting with a number are skipped
+ *
+ * sensor_decoder repeats the header at every boot, so only the first one
+ * names the columns.
+ */
+static bool priv_csv_load(const char *path, csv_t *csv)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "%s: cannot read file\n", path);
+    return false;
+  }
+
+  memset(csv, 0, sizeof(*csv));
+  size_t capacity = 0;
+  char   line[CSV_MAX_LINE];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    line[strcspn(line, "\r\n")] = '\0';
+    char *end = NULL;
+    strtod(line, &end);
+    bool numeric = end != line;
+
+    if (!numeric) {
+      if (csv->columns == 0) {
+        for (char *field = line; field != NULL && csv->columns < CSV_MAX_COLUMNS; csv->columns++) {
+          char *comma = strchr(field, ',');
+          if (comma != NULL) {
+            *comma = '\0';
+          }
+          snprintf(csv->names[csv->columns], sizeof(csv->names[0]), "%.31s", field);
+          field = comma != NULL ? comma + 1 : NULL;
+        }
+      }
+      continue;
+    }
+    if (csv->columns == 0) {
+      fprintf(stderr, "%s: no header line\n", path);
+      fclose(file);
+      return false;
+    }
+
+    if (csv->rows == capacity) {
+      capacity     = capacity == 0 ? 4096 : capacity * 2;
+      csv->values  = realloc(csv->values, capacity * csv->columns * sizeof(double));
+      if (csv->values == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+      }
+    }
+    double *row   = &csv->values[csv->rows * csv->columns];
+    char   *field = line;
+    for (size_t c = 0; c < csv->columns; c++) {
+      row[c] = NAN;
+      if (field == NULL) {
+        continue;
+      }
+      double value = strtod(field, &end);
+      if (end != field) {
+        row[c] = value;
+      }
+      char *comma = strchr(field, ',');
+      field       = comma != NULL ? comma + 1 : NULL;
+    }
+    csv->rows++;
+  }
+  fclose(file);
+  return true;
+}
+
+static int priv_csv_column(const csv_t *csv, const char *name)
+{
+  for (size_t c = 0; c < csv->columns; c++) {
+    if (strcmp(csv->names[c], name) == 0) {
+      return (int)c;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Finds the named columns, all of them or none when optional
+ */
+static bool priv_csv_columns(const csv_t *csv, const char *path, const char **names, int count, int *index,
+                             bool optional)
+{
+  bool found = true;
+  for (int i = 0; i < count; i++) {
+    index[i] = priv_csv_column(csv, names[i]);
+    if (index[i] < 0) {
+      if (!optional) {
+        fprintf(stderr, "%s: no %s column\n", path, names[i]);
+      }
+      found = false;
+    }
+  }
+  return found;
+}
+
+static bool priv_load_trace(trace_t *trace, const char *imu_path, const char *mag_path)
+{
+  static const char *imu_names[]   = { "uptime_us", "accel_x", "accel_y", "accel_z", "gyro_x", "gyro_y", "gyro_z" };
+  static const char *truth_names[] = { "roll", "pitch", "heading" };
+  static const char *mag_names[]   = { "uptime_us", "mag_x", "mag_y", "mag_z" };
+
+  csv_t csv;
+  int   col[7];
+  int   truth[3];
+  if (!priv_csv_load(imu_path, &csv) || !priv_csv_columns(&csv, imu_path, imu_names, 7, col, false)) {
+    return false;
+  }
+  trace->has_truth = priv_csv_columns(&csv, imu_path, truth_names, 3, truth, true);
+  trace->imu_count = csv.rows;
+  trace->imu       = calloc(csv.rows + 1, sizeof(imu_row_t));
+  for (size_t r = 0; r < csv.rows; r++) {
+    const double *row = &csv.values[r * csv.columns];
+    imu_row_t    *out = &trace->imu[r];
+    out->timestamp_us = (int64_t)row[col[0]];
+    for (int k = 0; k < 3; k++) {
+      out->accel[k] = (float)row[col[1 + k]];
+      out->gyro[k]  = (float)row[col[4 + k]];
+      out->truth[k] = trace->has_truth ? (float)row[truth[k]] : NAN;
+    }
+  }
+  free(csv.values);
+
+  if (mag_path == NULL) {
+    return true;
+  }
+  if (!priv_csv_load(mag_path, &csv) || !priv_csv_columns(&csv, mag_path, mag_names, 4, col, false)) {
+    return false;
+  }
+  trace->mag_count = csv.rows;
+  trace->mag       = calloc(csv.rows + 1, sizeof(mag_row_t));
+  for (size_t r = 0; r < csv.rows; r++) {
+    const double *row = &csv.values[r * csv.columns];
+    trace->mag[r].timestamp_us = (int64_t)row[col[0]];
+    for (int k = 0; k < 3; k++) {
+      trace->mag[r].mag[k] = (float)row[col[1 + k]];
+    }
+  }
+  free(csv.values);
+  return true;
+}
+
+/* Replay *********************************************************************/
+
+/**
+ * @brief Runs a trace through a filter, as the firmware feeds it
+ *
+ * Every IMU sample is fused with the newest magnetometer sample taken
+ * before it. Errors are collected when `errors` is given, for roll, pitch,
+ * heading and the untilted atan2 heading of `qmc5883l_read`.
+ */
+static void priv_replay(const trace_t *trace, ahrs_filter_t *filter, error_stats_t *errors)
+{
+  ahrs_filter_init(filter, &s_config);
+  size_t  next_mag = 0;
+  int64_t start_us = trace->imu_count > 0 ? trace->imu[0].timestamp_us : 0;
+
+  for (size_t i = 0; i < trace->imu_count; i++) {
+    const imu_row_t *row = &trace->imu[i];
+    while (next_mag < trace->mag_count && trace->mag[next_mag].timestamp_us <= row->timestamp_us) {
+      next_mag++;
+    }
+    const mag_row_t *mag = next_mag > 0 ? &trace->mag[next_mag - 1] : NULL;
+    ahrs_filter_update(filter, row->timestamp_us, row->gyro, row->accel,
+                       mag != NULL ? mag->mag : NULL, mag != NULL ? mag->timestamp_us : 0);
+
+    if (errors == NULL) {
+      continue;
+    }
+    ahrs_orientation_t orientation;
+    ahrs_filter_get_orientation(filter, &orientation);
+    if (s_trace) {
+      printf("%" PRId64 ",%.3f,%.3f,%.3f,%.4f,%.4f,%.4f\n",
+             row->timestamp_us, orientation.roll, orientation.pitch, orientation.heading,
+             orientation.gyro_bias[0], orientation.gyro_bias[1], orientation.gyro_bias[2]);
+    }
+    if (!trace->has_truth || (row->timestamp_us - start_us) < s_settle_s * 1e6) {
+      continue;
+    }
+    priv_error_add(&errors[0], orientation.roll - row->truth[0]);
+    priv_error_add(&errors[1], orientation.pitch - row->truth[1]);
+    priv_error_add(&errors[2], priv_wrap_deg(orientation.heading - row->truth[2]));
+    if (mag != NULL) {
+      double naive = atan2(mag->mag[1], mag->mag[0]) * 180.0 / M_PI;
+      priv_error_add(&errors[3], priv_wrap_deg(naive - row->truth[2]));
+    }
+  }
+}
+
+/**
+ * @brief Replays the trace in a loop for about a second, returns updates per second
+ */
+static double priv_benchmark(const trace_t *trace)
+{
+  ahrs_filter_t   filter;
+  volatile float  sink   = 0.0f;
+  uint64_t        passes = 0;
+  double          start  = priv_now_s();
+  double          elapsed;
+  do {
+    priv_replay(trace, &filter, NULL);
+    sink += filter.q[0];
+    passes++;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < BENCHMARK_SECONDS);
+  (void)sink;
+  return passes * trace->imu_count / elapsed;
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  const char *imu_path  = NULL;
+  const char *mag_path  = NULL;
+  const char *save      = NULL;
+  double      synthetic = 0.0;
+  s_config              = ahrs_filter_default_config;
+
+  for (int i = 1; i < argc; i++) {
+    bool        has_value = i + 1 < argc;
+    const char *value     = has_value ? argv[i + 1] : NULL;
+    if (strcmp(argv[i], "--trace") == 0) {
+      s_trace = true;
+      continue;
+    }
+    if (!has_value) {
+      imu_path = NULL;
+      synthetic = 0.0;
+      break;
+    }
+    if (strcmp(argv[i], "--imu") == 0) {
+      imu_path = value;
+    } else if (strcmp(argv[i], "--mag") == 0) {
+      mag_path = value;
+    } else if (strcmp(argv[i], "--synthetic") == 0) {
+      synthetic = strtod(value, NULL);
+    } else if (strcmp(argv[i], "--save") == 0) {
+      save = value;
+    } else if (strcmp(argv[i], "--kp") == 0) {
+      s_config.kp = strtof(value, NULL);
+    } else if (strcmp(argv[i], "--ki") == 0) {
+      s_config.ki = strtof(value, NULL);
+    } else if (strcmp(argv[i], "--accel-reject") == 0) {
+      s_config.accel_reject_g = strtof(value, NULL);
+    } else if (strcmp(argv[i], "--mag-age") == 0) {
+      s_config.mag_max_age_us = (int64_t)(strtod(value, NULL) * 1000.0);
+    } else if (strcmp(argv[i], "--settle") == 0) {
+      s_settle_s = strtod(value, NULL);
+    } else {
+      imu_path  = NULL;
+      synthetic = 0.0;
+      break;
+    }
+    i++;
+  }
+  if ((imu_path == NULL) == (synthetic <= 0.0)) {
+    fprintf(stderr,
+            "usage: %s [--kp X] [--ki X] [--accel-reject G] [--mag-age MS] [--settle S] [--trace]\n"
+            "       {--imu IMU.csv [--mag MAG.csv] | --synthetic SECONDS [--save PREFIX]}\n",
+            argv[0]);
+    return 2;
+  }
+
+  trace_t trace = {0};
+  if (synthetic > 0.0) {
+    priv_synthetic_trace(&trace, synthetic);
+    if (save != NULL && priv_save_trace(&trace, save) != 0) {
+      return 1;
+    }
+  } else if (!priv_load_trace(&trace, imu_path, mag_path)) {
+    return 1;
+  }
+  if (trace.imu_count == 0) {
+    fprintf(stderr, "no IMU samples\n");
+    return 1;
+  }
+
+  ahrs_filter_t filter;
+  error_stats_t errors[4] = {0};
+  if (s_trace) {
+    puts("uptime_us,roll,pitch,heading,bias_x,bias_y,bias_z");
+  }
+  priv_replay(&trace, &filter, errors);
+  double rate = priv_benchmark(&trace);
+
+  ahrs_orientation_t orientation;
+  ahrs_filter_get_orientation(&filter, &orientation);
+  FILE *out = s_trace ? stderr : stdout;
+  fprintf(out,
+          "%zu IMU and %zu magnetometer samples over %.1f s\n"
+          "kp %.3f  ki %.3f  accel reject %.2f g  mag age %" PRId64 " ms\n"
+          "%" PRIu32 " updates, %" PRIu32 " with magnetometer, %" PRIu32 " accel rejected, %" PRIu32 " gaps\n"
+          "%.0f updates/s, %.1f ns per update\n",
+          trace.imu_count, trace.mag_count,
+          (trace.imu[trace.imu_count - 1].timestamp_us - trace.imu[0].timestamp_us) / 1e6,
+          s_config.kp, s_config.ki, s_config.accel_reject_g, s_config.mag_max_age_us / 1000,
+          filter.updates, filter.mag_fused, filter.accel_rejected, filter.gaps,
+          rate, 1e9 / rate);
+  fprintf(out, "gyro bias estimate %.3f %.3f %.3f deg/s",
+          orientation.gyro_bias[0], orientation.gyro_bias[1], orientation.gyro_bias[2]);
+  if (synthetic > 0.0) {
+    fprintf(out, " (true %.3f %.3f %.3f)", trace.true_bias[0], trace.true_bias[1], trace.true_bias[2]);
+  }
+  fputc('\n', out);
+
+  if (!trace.has_truth) {
+    fprintf(out, "no roll, pitch and heading columns, accuracy not measured\n");
+  } else if (!s_trace) {
+    printf("error after the first %.1f s:\n", s_settle_s);
+    priv_error_print("roll", &errors[0]);
+    priv_error_print("pitch", &errors[1]);
+    priv_error_print("heading", &errors[2]);
+    priv_error_print("atan2 heading", &errors[3]);
+  }
+
+  free(trace.imu);
+  free(trace.mag);
+  return 0;
+}
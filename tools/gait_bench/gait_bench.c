@@ -0,0 +1,218 @@
+/* tools/gait_bench/gait_bench.c */
+
+/* Measures how many gait control ticks per second the firmware's gait engine
+ * and inverse kinematics sustain for all 18 joints, per gait pattern.
+ *
+ *   gait_bench [--seconds S] [--stride CM] [--heading DEG]
+ *
+ * Three loops run for each gait: the engine alone (`gait_engine_tick`), the
+ * engine followed by the float solver (`kinematics_solve_legs`), and the
+ * engine followed by the fixed-point path the firmware uses with
+ * KINEMATICS_USE_FIXED_POINT (`kinematics_solve_legs_q16` and
+ * `kinematics_angles_to_servo_q16`). Servo writes are left out, motion frames
+ * are stubbed below. Host figures show relative cost only; the ESP32-S3 is
+ * roughly an order of magnitude slower. */
+
+#include "gait_movement.h"
+#include "hexapod_kinematics.h"
+#include "motion_frame.h"
+#include "pca9685_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define BENCHMARK_BATCH (1024) /* Ticks between clock reads */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Result of one benchmark loop
+ */
+typedef struct {
+  double   ticks_per_s;
+  uint32_t unreachable_ticks; /* Ticks with at least one leg out of reach */
+} bench_result_t;
+
+/* Globals (Static) ***********************************************************/
+
+static const char *s_gait_names[k_gait_count] = { "tripod", "wave", "ripple", "quadruped" };
+
+static double            s_seconds   = 1.0;
+static float             s_stride_cm = 6.0f;
+static float             s_heading   = 0.0f;
+static volatile uint32_t s_sink      = 0; /* Keeps the compiler from dropping the loops */
+
+/* Motion Frame Stand-ins *****************************************************/
+
+esp_err_t motion_frame_init(pca9685_board_t *pwm_controller, const motor_t *motors)
+{
+  (void)pwm_controller;
+  (void)motors;
+  return ESP_OK;
+}
+
+esp_err_t motion_frame_submit(const leg_angles_t *pose)
+{
+  (void)pose;
+  return ESP_OK;
+}
+
+esp_err_t motion_frame_submit_servo(const leg_servo_positions_t *pose)
+{
+  (void)pose;
+  return ESP_OK;
+}
+
+esp_err_t pca9685_set_angle(pca9685_board_t *controller_data,
+                            uint16_t         motor_mask,
+                            uint8_t          board_id,
+                            float            angle)
+{
+  (void)controller_data;
+  (void)motor_mask;
+  (void)board_id;
+  (void)angle;
+  return ESP_OK;
+}
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_now_s(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bench_result_t priv_bench_engine(void)
+{
+  gait_frame_t frame;
+  uint64_t     ticks = 0;
+  double       start = priv_now_s();
+  double       elapsed;
+  do {
+    for (uint32_t i = 0; i < BENCHMARK_BATCH; i++) {
+      gait_engine_tick(&frame);
+      s_sink += frame.swing_mask;
+    }
+    ticks  += BENCHMARK_BATCH;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < s_seconds);
+  return (bench_result_t){ .ticks_per_s = ticks / elapsed };
+}
+
+static bench_result_t priv_bench_float(void)
+{
+  gait_frame_t   frame;
+  leg_angles_t   angles;
+  bench_result_t result = {0};
+  uint64_t       ticks  = 0;
+  double         start  = priv_now_s();
+  double         elapsed;
+  do {
+    for (uint32_t i = 0; i < BENCHMARK_BATCH; i++) {
+      gait_engine_tick(&frame);
+      if (kinematics_solve_legs(&frame.feet, &angles, NULL) != ESP_OK) {
+        result.unreachable_ticks++;
+      }
+      s_sink += (uint32_t)angles.tibia_deg[i % NUMBER_OF_LEGS];
+    }
+    ticks  += BENCHMARK_BATCH;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < s_seconds);
+  result.ticks_per_s = ticks / elapsed;
+  return result;
+}
+
+static bench_result_t priv_bench_q16(void)
+{
+  gait_frame_t          frame;
+  leg_positions_q16_t   positions;
+  leg_angles_q16_t      angles;
+  leg_servo_positions_t servo;
+  bench_result_t        result = {0};
+  uint64_t              ticks  = 0;
+  double                start  = priv_now_s();
+  double                elapsed;
+  do {
+    for (uint32_t i = 0; i < BENCHMARK_BATCH; i++) {
+      gait_engine_tick(&frame);
+      for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; ++leg) {
+        positions.x_cm[leg] = kinematics_float_to_q16(frame.feet.x_cm[leg]);
+        positions.y_cm[leg] = kinematics_float_to_q16(frame.feet.y_cm[leg]);
+        positions.z_cm[leg] = kinematics_float_to_q16(frame.feet.z_cm[leg]);
+      }
+      if (kinematics_solve_legs_q16(&positions, &angles, NULL) != ESP_OK) {
+        result.unreachable_ticks++;
+      }
+      kinematics_angles_to_servo_q16(&angles, &servo);
+      s_sink += servo.tibia[i % NUMBER_OF_LEGS];
+    }
+    ticks  += BENCHMARK_BATCH;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < s_seconds);
+  result.ticks_per_s = ticks / elapsed;
+  return result;
+}
+
+static void priv_print(const char *name, bench_result_t result)
+{
+  printf("  %-18s %12.0f ticks/s  %8.3f us/tick  %8.0fx the %u Hz loop",
+         name,
+         result.ticks_per_s,
+         1e6 / result.ticks_per_s,
+         result.ticks_per_s / gait_control_rate_hz,
+         gait_control_rate_hz);
+  if (result.unreachable_ticks > 0) {
+    printf("  (%u ticks out of reach)", result.unreachable_ticks);
+  }
+  printf("\n");
+}
+
+static void priv_usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [--seconds S] [--stride CM] [--heading DEG]\n", program);
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      s_seconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--stride") == 0 && i + 1 < argc) {
+      s_stride_cm = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--heading") == 0 && i + 1 < argc) {
+      s_heading = (float)atof(argv[++i]);
+    } else {
+      priv_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  static pca9685_board_t board = { .num_boards = 2 };
+  if (gait_init(&board) != ESP_OK) {
+    fprintf(stderr, "gait_init failed\n");
+    return 1;
+  }
+
+  printf("%u joints, %u ticks per cycle, stride %.1f cm, heading %.1f deg\n",
+         NUMBER_OF_JOINTS,
+         gait_cycle_ticks,
+         s_stride_cm,
+         s_heading);
+  for (gait_type_t type = 0; type < k_gait_count; type++) {
+    printf("%s\n", s_gait_names[type]);
+    gait_engine_configure(type, s_heading, s_stride_cm);
+    priv_print("engine", priv_bench_engine());
+    gait_engine_configure(type, s_heading, s_stride_cm);
+    priv_print("engine + IK float", priv_bench_float());
+    gait_engine_configure(type, s_heading, s_stride_cm);
+    priv_print("engine + IK Q16", priv_bench_q16());
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+/* tools/host_shims/esp_host.c */
+
+/* ESP-IDF timer, error names, console log and NVS stand-ins for host tools.
+ * NVS keeps blobs in memory for the life of the process. */
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define HOST_LOG_LINE_LENGTH (512)
+#define HOST_NVS_MAX_ENTRIES (32)
+#define HOST_NVS_KEY_LENGTH  (32) /* Namespace and key, NVS caps each at 15 characters */
+
+/* Structs (Private) **********************************************************/
+
+typedef struct {
+  char    key[HOST_NVS_KEY_LENGTH];
+  void   *value;
+  size_t  length;
+} host_nvs_entry_t;
+
+/* Globals (Static) ***********************************************************/
+
+static host_nvs_entry_t s_nvs[HOST_NVS_MAX_ENTRIES] = {0};
+static const char      *s_nvs_namespaces[8]         = {0}; /* Indexed by handle - 1 */
+
+/* Private Functions (Static) *************************************************/
+
+static host_nvs_entry_t *priv_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+  if (handle == 0 || handle > sizeof(s_nvs_namespaces) / sizeof(s_nvs_namespaces[0])) {
+    return NULL;
+  }
+
+  char full_key[HOST_NVS_KEY_LENGTH];
+  snprintf(full_key, sizeof(full_key), "%s/%s", s_nvs_namespaces[handle - 1], key);
+  for (size_t i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+    if (strcmp(s_nvs[i].key, full_key) == 0) {
+      return &s_nvs[i];
+    }
+  }
+  if (!create) {
+    return NULL;
+  }
+  for (size_t i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+    if (s_nvs[i].key[0] == '\0') {
+      strcpy(s_nvs[i].key, full_key);
+      return &s_nvs[i];
+    }
+  }
+  return NULL;
+}
+
+/* Public Functions ***********************************************************/
+
+int64_t esp_timer_get_time(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+  switch (code) {
+    case ESP_OK:                     return "ESP_OK";
+    case ESP_FAIL:                   return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:             return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:       return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:          return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:      return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:            return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:      return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:                         return "UNKNOWN ERROR";
+  }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+  (void)tag;
+  (void)level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+  char    line[HOST_LOG_LINE_LENGTH];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (level <= ESP_LOG_WARN) {
+    fprintf(stderr, "%s: %s\n", tag, line);
+  }
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+  (void)open_mode;
+  const size_t count = sizeof(s_nvs_namespaces) / sizeof(s_nvs_namespaces[0]);
+  for (size_t i = 0; i < count; i++) {
+    if (s_nvs_namespaces[i] == NULL || strcmp(s_nvs_namespaces[i], name) == 0) {
+      s_nvs_namespaces[i] = name;
+      *out_handle         = (nvs_handle_t)(i + 1);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+  host_nvs_entry_t *entry = priv_nvs_find(handle, key, false);
+  if (entry == NULL || entry->value == NULL) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (out_value == NULL) {
+    *length = entry->length;
+    return ESP_OK;
+  }
+  if (*length < entry->length) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, entry->value, entry->length);
+  *length = entry->length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+  host_nvs_entry_t *entry = priv_nvs_find(handle, key, true);
+  if (entry == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  void *copy = malloc(length);
+  if (copy == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(copy, value, length);
+  free(entry->value);
+  entry->value  = copy;
+  entry->length = length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+  (void)handle;
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+  (void)handle;
+}
@@ -0,0 +1,377 @@
+/* tools/host_shims/freertos_host.c */
+
+/* FreeRTOS tasks, notifications and semaphores on pthreads, for host tools
+ * that run firmware sources unchanged. Ticks are milliseconds since the
+ * first call; there is no scheduler, so priorities have no effect. */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Structs (Private) **********************************************************/
+
+struct host_task {
+  pthread_t       thread;
+  char            name[16];
+  TaskFunction_t  function;
+  void           *arg;
+  pthread_mutex_t lock;
+  pthread_cond_t  notified;
+  uint32_t        value;
+  bool            pending;
+};
+
+struct host_semaphore {
+  pthread_mutex_t lock;
+  pthread_cond_t  given;
+  UBaseType_t     count;
+  UBaseType_t     max_count;
+};
+
+/* Globals (Static) ***********************************************************/
+
+static pthread_mutex_t            s_critical      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t             s_clock_once    = PTHREAD_ONCE_INIT;
+static struct timespec            s_clock_start;
+static _Thread_local struct host_task *s_current = NULL;
+
+/* Private Functions (Static) *************************************************/
+
+static void priv_clock_init(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &s_clock_start);
+}
+
+/**
+ * @brief Absolute CLOCK_MONOTONIC time of a tick count.
+ */
+static struct timespec priv_tick_to_time(TickType_t tick)
+{
+  pthread_once(&s_clock_once, priv_clock_init);
+  struct timespec time = s_clock_start;
+  time.tv_sec  += tick / configTICK_RATE_HZ;
+  time.tv_nsec += (long)(tick % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+  if (time.tv_nsec >= 1000000000L) {
+    time.tv_sec++;
+    time.tv_nsec -= 1000000000L;
+  }
+  return time;
+}
+
+/**
+ * @brief Waits on a condition until `done` holds or the ticks run out.
+ *
+ * The caller holds `lock`. Condition variables use CLOCK_MONOTONIC.
+ *
+ * @return true if `done` held before the timeout.
+ */
+static bool priv_wait(pthread_cond_t  *cond,
+                      pthread_mutex_t *lock,
+                      bool           (*done)(void *),
+                      void            *context,
+                      TickType_t       ticks)
+{
+  TickType_t      deadline = xTaskGetTickCount() + ticks;
+  struct timespec until    = priv_tick_to_time(deadline);
+  while (!done(context)) {
+    if (ticks == 0) {
+      return false;
+    }
+    if (ticks == portMAX_DELAY) {
+      pthread_cond_wait(cond, lock);
+    } else if (pthread_cond_timedwait(cond, lock, &until) == ETIMEDOUT) {
+      return done(context);
+    }
+  }
+  return true;
+}
+
+static void priv_cond_init(pthread_cond_t *cond)
+{
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+static struct host_task *priv_task_new(const char *name)
+{
+  struct host_task *task = calloc(1, sizeof(*task));
+  if (task == NULL) {
+    return NULL;
+  }
+  strncpy(task->name, name, sizeof(task->name) - 1);
+  pthread_mutex_init(&task->lock, NULL);
+  priv_cond_init(&task->notified);
+  return task;
+}
+
+static void *priv_task_entry(void *arg)
+{
+  s_current = arg;
+  s_current->function(s_current->arg);
+  return NULL;
+}
+
+static bool priv_task_pending(void *context)
+{
+  return ((struct host_task *)context)->pending;
+}
+
+static bool priv_semaphore_available(void *context)
+{
+  return ((struct host_semaphore *)context)->count > 0;
+}
+
+static SemaphoreHandle_t priv_semaphore_new(UBaseType_t max_count, UBaseType_t initial_count)
+{
+  struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+  if (semaphore == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&semaphore->lock, NULL);
+  priv_cond_init(&semaphore->given);
+  semaphore->count     = initial_count;
+  semaphore->max_count = max_count;
+  return semaphore;
+}
+
+/* Public Functions ***********************************************************/
+
+void host_enter_critical(void)
+{
+  pthread_mutex_lock(&s_critical);
+}
+
+void host_exit_critical(void)
+{
+  pthread_mutex_unlock(&s_critical);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task,
+                       const char    *name,
+                       uint32_t       stack_depth,
+                       void          *arg,
+                       UBaseType_t    priority,
+                       TaskHandle_t  *handle)
+{
+  (void)stack_depth;
+  (void)priority;
+
+  struct host_task *created = priv_task_new(name);
+  if (created == NULL) {
+    return pdFAIL;
+  }
+  created->function = task;
+  created->arg      = arg;
+  if (handle != NULL) {
+    *handle = created; /* Before the thread starts, it may look itself up */
+  }
+  if (pthread_create(&created->thread, NULL, priv_task_entry, created) != 0) {
+    free(created);
+    return pdFAIL;
+  }
+  pthread_detach(created->thread);
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  if (task == NULL || task == s_current) {
+    pthread_exit(NULL);
+  }
+  pthread_cancel(task->thread);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+  pthread_once(&s_clock_once, priv_clock_init);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t elapsed_ns = (int64_t)(now.tv_sec - s_clock_start.tv_sec) * 1000000000 +
+                       (now.tv_nsec - s_clock_start.tv_nsec);
+  return (TickType_t)(elapsed_ns / (1000000000 / configTICK_RATE_HZ));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  struct timespec until = priv_tick_to_time(xTaskGetTickCount() + ticks);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+  }
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+  *previous_wake       += increment;
+  struct timespec until = priv_tick_to_time(*previous_wake);
+  if ((int32_t)(*previous_wake - xTaskGetTickCount()) <= 0) {
+    return pdFALSE; /* Already late, like FreeRTOS this does not sleep */
+  }
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+  }
+  return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+  xTaskDelayUntil(previous_wake, increment);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+  if (s_current == NULL) {
+    s_current = priv_task_new("main"); /* Threads not made by xTaskCreate */
+  }
+  return s_current;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+  if (task == NULL) {
+    task = xTaskGetCurrentTaskHandle();
+  }
+  return task->name;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+  BaseType_t result = pdPASS;
+  pthread_mutex_lock(&task->lock);
+  switch (action) {
+    case eSetBits:                  task->value |= value;  break;
+    case eIncrement:                task->value++;         break;
+    case eSetValueWithOverwrite:    task->value  = value;  break;
+    case eSetValueWithoutOverwrite:
+      if (task->pending) {
+        result = pdFAIL;
+      } else {
+        task->value = value;
+      }
+      break;
+    case eNoAction:
+    default:                                               break;
+  }
+  task->pending = true;
+  pthread_cond_broadcast(&task->notified);
+  pthread_mutex_unlock(&task->lock);
+  return result;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+  xTaskNotify(task, 0, eIncrement);
+  if (higher_priority_task_woken != NULL) {
+    *higher_priority_task_woken = pdFALSE;
+  }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+  struct host_task *task = xTaskGetCurrentTaskHandle();
+  pthread_mutex_lock(&task->lock);
+  priv_wait(&task->notified, &task->lock, priv_task_pending, task, ticks_to_wait);
+  uint32_t value = task->value;
+  if (value > 0) {
+    task->value = clear_on_exit ? 0 : value - 1;
+  }
+  task->pending = task->value > 0;
+  pthread_mutex_unlock(&task->lock);
+  return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t    clear_on_entry,
+                           uint32_t    clear_on_exit,
+                           uint32_t   *value,
+                           TickType_t  ticks_to_wait)
+{
+  struct host_task *task = xTaskGetCurrentTaskHandle();
+  pthread_mutex_lock(&task->lock);
+  if (!task->pending) {
+    task->value &= ~clear_on_entry;
+  }
+  bool notified = priv_wait(&task->notified, &task->lock, priv_task_pending, task, ticks_to_wait);
+  if (value != NULL) {
+    *value = task->value;
+  }
+  if (notified) {
+    task->value   &= ~clear_on_exit;
+    task->pending  = false;
+  }
+  pthread_mutex_unlock(&task->lock);
+  return notified ? pdTRUE : pdFALSE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+  return priv_semaphore_new(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+  return priv_semaphore_new(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+  return priv_semaphore_new(max_count, initial_count);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+  if (semaphore != NULL) {
+    pthread_cond_destroy(&semaphore->given);
+    pthread_mutex_destroy(&semaphore->lock);
+    free(semaphore);
+  }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+  pthread_mutex_lock(&semaphore->lock);
+  bool taken = priv_wait(&semaphore->given, &semaphore->lock, priv_semaphore_available, semaphore, ticks_to_wait);
+  if (taken) {
+    semaphore->count--;
+  }
+  pthread_mutex_unlock(&semaphore->lock);
+  return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  BaseType_t result = pdFAIL;
+  pthread_mutex_lock(&semaphore->lock);
+  if (semaphore->count < semaphore->max_count) {
+    semaphore->count++;
+    pthread_cond_signal(&semaphore->given);
+    result = pdPASS;
+  }
+  pthread_mutex_unlock(&semaphore->lock);
+  return result;
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken)
+{
+  if (higher_priority_task_woken != NULL) {
+    *higher_priority_task_woken = pdFALSE;
+  }
+  return xSemaphoreTake(semaphore, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken)
+{
+  if (higher_priority_task_woken != NULL) {
+    *higher_priority_task_woken = pdFALSE;
+  }
+  return xSemaphoreGive(semaphore);
+}
@@ -0,0 +1,40 @@
+# Host stand-ins for the ESP-IDF and FreeRTOS APIs the firmware sources use,
+# so host tools can build those sources unchanged. Include it after setting
+# PROJECT_STAR_ROOT, then link `host_shims`, and `host_log` unless the tool
+# links the real log_handler.c. `host_pca9685_sim` provides the I2C master
+# API against simulated PCA9685 boards.
+#
+# The firmware headers declare enums with a fixed underlying type
+# (`enum : uint8_t`), which needs GCC 13 or newer, or Clang.
+
+find_package(Threads REQUIRED)
+include(CheckSymbolExists)
+check_symbol_exists(strlcpy string.h HOST_HAVE_STRLCPY)
+
+add_library(host_shims STATIC
+  ${CMAKE_CURRENT_LIST_DIR}/freertos_host.c
+  ${CMAKE_CURRENT_LIST_DIR}/esp_host.c
+)
+target_include_directories(host_shims PUBLIC
+  ${CMAKE_CURRENT_LIST_DIR}/include
+)
+target_link_libraries(host_shims PUBLIC Threads::Threads)
+
+# newlib has strlcpy, glibc only from 2.38
+if(NOT HOST_HAVE_STRLCPY)
+  target_sources(host_shims PRIVATE ${CMAKE_CURRENT_LIST_DIR}/strlcpy_host.c)
+  target_compile_options(host_shims PUBLIC -include ${CMAKE_CURRENT_LIST_DIR}/include/strlcpy_host.h)
+endif()
+
+add_library(host_log STATIC
+  ${CMAKE_CURRENT_LIST_DIR}/log_host.c
+)
+target_include_directories(host_log PUBLIC
+  ${PROJECT_STAR_ROOT}/components/common/include
+)
+target_link_libraries(host_log PUBLIC host_shims)
+
+add_library(host_pca9685_sim STATIC
+  ${CMAKE_CURRENT_LIST_DIR}/pca9685_sim.c
+)
+target_link_libraries(host_pca9685_sim PUBLIC host_shims)
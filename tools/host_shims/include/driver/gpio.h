@@ -0,0 +1,35 @@
+/* tools/host_shims/include/driver/gpio.h */
+
+/* Host stand-in for the GPIO types in the firmware's structs. */
+
+#ifndef TOPOROBO_HOST_DRIVER_GPIO_H
+#define TOPOROBO_HOST_DRIVER_GPIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum {
+  GPIO_NUM_NC = -1,
+  GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5,
+  GPIO_NUM_6, GPIO_NUM_7, GPIO_NUM_8, GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11,
+  GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16, GPIO_NUM_17,
+  GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_20, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_23,
+  GPIO_NUM_25 = 25, GPIO_NUM_26, GPIO_NUM_27,
+  GPIO_NUM_32 = 32, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37,
+  GPIO_NUM_38, GPIO_NUM_39,
+} gpio_num_t;
+
+typedef enum {
+  GPIO_PULLUP_DISABLE,
+  GPIO_PULLUP_ENABLE,
+} gpio_pullup_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_DRIVER_GPIO_H */
@@ -0,0 +1,63 @@
+/* tools/host_shims/include/driver/i2c.h */
+
+/* Host stand-in for the legacy ESP-IDF I2C master API. The transfers are
+ * implemented by each tool, usually against a simulated device. */
+
+#ifndef TOPOROBO_HOST_DRIVER_I2C_H
+#define TOPOROBO_HOST_DRIVER_I2C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int i2c_port_t;
+
+#define I2C_NUM_0 (0)
+#define I2C_NUM_1 (1)
+
+typedef enum {
+  I2C_MODE_SLAVE,
+  I2C_MODE_MASTER,
+} i2c_mode_t;
+
+typedef struct {
+  i2c_mode_t    mode;
+  int           sda_io_num;
+  int           scl_io_num;
+  gpio_pullup_t sda_pullup_en;
+  gpio_pullup_t scl_pullup_en;
+  struct {
+    uint32_t clk_speed;
+  } master;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf);
+esp_err_t i2c_driver_install(i2c_port_t i2c_num,
+                             i2c_mode_t mode,
+                             size_t     slv_rx_buf_len,
+                             size_t     slv_tx_buf_len,
+                             int        intr_alloc_flags);
+esp_err_t i2c_master_write_to_device(i2c_port_t     i2c_num,
+                                     uint8_t        device_address,
+                                     const uint8_t *write_buffer,
+                                     size_t         write_size,
+                                     TickType_t     ticks_to_wait);
+esp_err_t i2c_master_write_read_device(i2c_port_t     i2c_num,
+                                       uint8_t        device_address,
+                                       const uint8_t *write_buffer,
+                                       size_t         write_size,
+                                       uint8_t       *read_buffer,
+                                       size_t         read_size,
+                                       TickType_t     ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_DRIVER_I2C_H */
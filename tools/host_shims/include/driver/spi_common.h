@@ -0,0 +1,14 @@
+/* tools/host_shims/include/driver/spi_common.h */
+
+/* Host stand-in for the SPI host type in the SD card declarations. */
+
+#ifndef TOPOROBO_HOST_DRIVER_SPI_COMMON_H
+#define TOPOROBO_HOST_DRIVER_SPI_COMMON_H
+
+typedef enum {
+  SPI1_HOST,
+  SPI2_HOST,
+  SPI3_HOST,
+} spi_host_device_t;
+
+#endif /* TOPOROBO_HOST_DRIVER_SPI_COMMON_H */
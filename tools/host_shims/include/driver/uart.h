@@ -0,0 +1,18 @@
+/* tools/host_shims/include/driver/uart.h */
+
+/* Host stand-in for the ESP-IDF UART types the firmware headers use. */
+
+#ifndef TOPOROBO_HOST_DRIVER_UART_H
+#define TOPOROBO_HOST_DRIVER_UART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int uart_port_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_DRIVER_UART_H */
@@ -0,0 +1,32 @@
+/* tools/host_shims/include/esp_err.h */
+
+/* Host stand-in for the ESP-IDF error codes used by the firmware sources. */
+
+#ifndef TOPOROBO_HOST_ESP_ERR_H
+#define TOPOROBO_HOST_ESP_ERR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK                     (0)
+#define ESP_FAIL                   (-1)
+#define ESP_ERR_NO_MEM             (0x101)
+#define ESP_ERR_INVALID_ARG        (0x102)
+#define ESP_ERR_INVALID_STATE      (0x103)
+#define ESP_ERR_INVALID_SIZE       (0x104)
+#define ESP_ERR_NOT_FOUND          (0x105)
+#define ESP_ERR_NOT_SUPPORTED      (0x106)
+#define ESP_ERR_TIMEOUT            (0x107)
+#define ESP_ERR_NVS_NOT_FOUND      (0x1102)
+#define ESP_ERR_NVS_INVALID_LENGTH (0x110c)
+
+const char *esp_err_to_name(esp_err_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_ESP_ERR_H */
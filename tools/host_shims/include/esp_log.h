@@ -0,0 +1,42 @@
+/* tools/host_shims/include/esp_log.h */
+
+/* Host stand-in for the ESP-IDF log levels and console macros. */
+
+#ifndef TOPOROBO_HOST_ESP_LOG_H
+#define TOPOROBO_HOST_ESP_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#define ESP_LOGE(tag, format, ...) esp_log_write(ESP_LOG_ERROR,   (tag), (format), ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_write(ESP_LOG_WARN,    (tag), (format), ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_write(ESP_LOG_INFO,    (tag), (format), ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_write(ESP_LOG_DEBUG,   (tag), (format), ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_write(ESP_LOG_VERBOSE, (tag), (format), ##__VA_ARGS__)
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Formats a console line, printing only warnings and errors
+ *
+ * Every level pays for the formatting, as on the target; the UART time is
+ * not modelled.
+ */
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+  __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_ESP_LOG_H */
@@ -0,0 +1,10 @@
+/* tools/host_shims/include/esp_system.h */
+
+/* Host stand-in, the firmware sources only need the include to resolve. */
+
+#ifndef TOPOROBO_HOST_ESP_SYSTEM_H
+#define TOPOROBO_HOST_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+#endif /* TOPOROBO_HOST_ESP_SYSTEM_H */
@@ -0,0 +1,20 @@
+/* tools/host_shims/include/esp_timer.h */
+
+/* Host stand-in for `esp_timer_get_time`, microseconds of CLOCK_MONOTONIC. */
+
+#ifndef TOPOROBO_HOST_ESP_TIMER_H
+#define TOPOROBO_HOST_ESP_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_ESP_TIMER_H */
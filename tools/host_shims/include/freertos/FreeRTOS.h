@@ -0,0 +1,52 @@
+/* tools/host_shims/include/freertos/FreeRTOS.h */
+
+/* Host stand-in for the FreeRTOS types and macros the firmware sources use.
+ * Ticks are 1 ms; tasks and semaphores are pthreads, see freertos_host.c. */
+
+#ifndef TOPOROBO_HOST_FREERTOS_H
+#define TOPOROBO_HOST_FREERTOS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t     TickType_t;
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef int          portMUX_TYPE;
+
+#define configTICK_RATE_HZ           (1000)
+#define portMAX_DELAY                ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS           (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)            ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTRUE                       (1)
+#define pdFALSE                      (0)
+#define pdPASS                       (pdTRUE)
+#define pdFAIL                       (pdFALSE)
+#define portMUX_INITIALIZER_UNLOCKED (0)
+
+/* Critical sections share one host lock, the mux argument is ignored */
+void host_enter_critical(void);
+void host_exit_critical(void);
+
+#define taskENTER_CRITICAL(mux)        host_enter_critical()
+#define taskEXIT_CRITICAL(mux)         host_exit_critical()
+#define taskENTER_CRITICAL_ISR(mux)    host_enter_critical()
+#define taskEXIT_CRITICAL_ISR(mux)     host_exit_critical()
+#define portENTER_CRITICAL(mux)        host_enter_critical()
+#define portEXIT_CRITICAL(mux)         host_exit_critical()
+#define portYIELD_FROM_ISR(...)        ((void)0)
+
+static inline BaseType_t xPortInIsrContext(void)
+{
+  return pdFALSE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_FREERTOS_H */
@@ -0,0 +1,30 @@
+/* tools/host_shims/include/freertos/semphr.h */
+
+/* Host stand-in for FreeRTOS semaphores. Mutexes are binary semaphores
+ * created given, without priority inheritance. */
+
+#ifndef TOPOROBO_HOST_FREERTOS_SEMPHR_H
+#define TOPOROBO_HOST_FREERTOS_SEMPHR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+void              vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t        xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken);
+BaseType_t        xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_FREERTOS_SEMPHR_H */
@@ -0,0 +1,52 @@
+/* tools/host_shims/include/freertos/task.h */
+
+/* Host stand-in for the FreeRTOS task API, each task is a pthread.
+ * Priorities and stack sizes are accepted and ignored. */
+
+#ifndef TOPOROBO_HOST_FREERTOS_TASK_H
+#define TOPOROBO_HOST_FREERTOS_TASK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+typedef enum {
+  eNoAction,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite,
+  eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+BaseType_t   xTaskCreate(TaskFunction_t task,
+                         const char    *name,
+                         uint32_t       stack_depth,
+                         void          *arg,
+                         UBaseType_t    priority,
+                         TaskHandle_t  *handle);
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+BaseType_t   xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char        *pcTaskGetName(TaskHandle_t task);
+BaseType_t   xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+BaseType_t   xTaskNotifyWait(uint32_t    clear_on_entry,
+                             uint32_t    clear_on_exit,
+                             uint32_t   *value,
+                             TickType_t  ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_FREERTOS_TASK_H */
@@ -0,0 +1,63 @@
+/* tools/host_shims/include/pca9685_sim.h */
+
+/* Simulated PCA9685 boards behind the host I2C master API. Every address
+ * written to becomes a board with its own 256-byte register file, written
+ * with auto-increment like the real part; ALL_LED writes reach every
+ * channel. Each transfer can be held for the time it would take on the
+ * wire at the configured bus clock. */
+
+#ifndef TOPOROBO_HOST_PCA9685_SIM_H
+#define TOPOROBO_HOST_PCA9685_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Bus traffic seen by the simulated boards
+ */
+typedef struct {
+  uint32_t transactions; /**< Transfers, each one START to STOP. */
+  uint32_t bytes;        /**< Bytes on the wire, address bytes included. */
+  uint64_t wire_us;      /**< Time the transfers take at the bus clock. */
+} pca9685_sim_stats_t;
+
+/**
+ * @brief Called after each write lands in a board's registers
+ *
+ * Runs on the writing task, with the register range that changed.
+ */
+typedef void (*pca9685_sim_write_hook_t)(uint8_t address, uint8_t first_reg, size_t count);
+
+/* Public Functions ***********************************************************/
+
+/**
+ * @brief Holds every transfer for its wire time at the bus clock.
+ *
+ * The clock comes from `i2c_param_config`, 100 kHz until it is called.
+ * Off by default, so tools that only count traffic run at full speed.
+ */
+void pca9685_sim_set_wire_delay(bool enabled);
+
+void pca9685_sim_set_write_hook(pca9685_sim_write_hook_t hook);
+
+void pca9685_sim_get_stats(pca9685_sim_stats_t *stats, bool reset);
+
+/**
+ * @brief Reads a channel's ON and OFF tick counts.
+ *
+ * @return false if no board was written at `address`.
+ */
+bool pca9685_sim_get_channel(uint8_t address, uint8_t channel, uint16_t *on_ticks, uint16_t *off_ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_PCA9685_SIM_H */
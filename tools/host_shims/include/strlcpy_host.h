@@ -0,0 +1,21 @@
+/* tools/host_shims/include/strlcpy_host.h */
+
+/* strlcpy for C libraries without it. newlib on the target has it, glibc
+ * only from 2.38; host_shims.cmake force-includes this header there. */
+
+#ifndef TOPOROBO_HOST_STRLCPY_H
+#define TOPOROBO_HOST_STRLCPY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPOROBO_HOST_STRLCPY_H */
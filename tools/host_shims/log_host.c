@@ -0,0 +1,45 @@
+/* tools/host_shims/log_host.c */
+
+/* Log handler stand-in for host tools that do not link log_handler.c.
+ * Warnings and errors go to stderr straight away, the rest is dropped. */
+
+#include "log_handler.h"
+#include <stdio.h>
+
+/* Constants ******************************************************************/
+
+static const char *s_level_names[] = { "", "E", "W", "I", "D", "V" };
+
+/* Public Functions ***********************************************************/
+
+bool log_level_enabled(const char *tag, esp_log_level_t level)
+{
+  (void)tag;
+  return level <= ESP_LOG_WARN;
+}
+
+void log_write_va(esp_log_level_t level,
+                  const char     *tag,
+                  const char     *short_msg,
+                  const char     *detailed_msg,
+                  va_list         args)
+{
+  if (!log_level_enabled(tag, level)) {
+    return;
+  }
+  fprintf(stderr, "%s %s: %s - ", s_level_names[level], tag, short_msg);
+  vfprintf(stderr, detailed_msg, args);
+  fputc('\n', stderr);
+}
+
+void log_write(esp_log_level_t level,
+               const char     *tag,
+               const char     *short_msg,
+               const char     *detailed_msg,
+               ...)
+{
+  va_list args;
+  va_start(args, detailed_msg);
+  log_write_va(level, tag, short_msg, detailed_msg, args);
+  va_end(args);
+}
@@ -0,0 +1,236 @@
+/* tools/host_shims/pca9685_sim.c */
+
+/* I2C master API against simulated PCA9685 boards, see pca9685_sim.h. */
+
+#include "pca9685_sim.h"
+#include "driver/i2c.h"
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define SIM_MAX_BOARDS     (8)
+#define SIM_REGISTER_COUNT (256)
+#define SIM_LED0_ON_L      (0x06)
+#define SIM_ALL_LED_ON_L   (0xFA)
+#define SIM_LED_REG_SIZE   (4)
+#define SIM_CHANNEL_COUNT  (16)
+#define SIM_BITS_PER_BYTE  (9) /* Eight data bits and the ACK */
+#define SIM_FRAMING_BITS   (2) /* START and STOP */
+
+/* Structs (Private) **********************************************************/
+
+typedef struct {
+  bool    present;
+  uint8_t address;
+  uint8_t registers[SIM_REGISTER_COUNT];
+} sim_board_t;
+
+/* Globals (Static) ***********************************************************/
+
+static pthread_mutex_t          s_lock                   = PTHREAD_MUTEX_INITIALIZER;
+static sim_board_t              s_boards[SIM_MAX_BOARDS] = {0};
+static pca9685_sim_stats_t      s_stats                  = {0};
+static pca9685_sim_write_hook_t s_hook                   = NULL;
+static uint32_t                 s_clock_hz               = 100000;
+static bool                     s_wire_delay             = false;
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Board at an address, added on first use when `create` is set
+ *
+ * The caller holds `s_lock`.
+ */
+static sim_board_t *priv_find_board(uint8_t address, bool create)
+{
+  for (size_t i = 0; i < SIM_MAX_BOARDS; i++) {
+    if (s_boards[i].present && s_boards[i].address == address) {
+      return &s_boards[i];
+    }
+  }
+  if (!create) {
+    return NULL;
+  }
+  for (size_t i = 0; i < SIM_MAX_BOARDS; i++) {
+    if (!s_boards[i].present) {
+      s_boards[i].present = true;
+      s_boards[i].address = address;
+      return &s_boards[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Counts a transfer and returns its wire time
+ *
+ * The caller holds `s_lock`.
+ */
+static uint32_t priv_account(size_t bytes)
+{
+  uint32_t bits    = SIM_FRAMING_BITS + (uint32_t)bytes * SIM_BITS_PER_BYTE;
+  uint32_t wire_us = (uint32_t)(((uint64_t)bits * 1000000 + s_clock_hz - 1) / s_clock_hz);
+  s_stats.transactions++;
+  s_stats.bytes   += (uint32_t)bytes;
+  s_stats.wire_us += wire_us;
+  return wire_us;
+}
+
+static void priv_hold(uint32_t wire_us)
+{
+  struct timespec until;
+  clock_gettime(CLOCK_MONOTONIC, &until);
+  until.tv_nsec += (long)wire_us * 1000;
+  until.tv_sec  += until.tv_nsec / 1000000000L;
+  until.tv_nsec %= 1000000000L;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+  }
+}
+
+/* Public Functions ***********************************************************/
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf)
+{
+  (void)i2c_num;
+  if (i2c_conf == NULL || i2c_conf->master.clk_speed == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  pthread_mutex_lock(&s_lock);
+  s_clock_hz = i2c_conf->master.clk_speed;
+  pthread_mutex_unlock(&s_lock);
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num,
+                             i2c_mode_t mode,
+                             size_t     slv_rx_buf_len,
+                             size_t     slv_tx_buf_len,
+                             int        intr_alloc_flags)
+{
+  (void)i2c_num;
+  (void)mode;
+  (void)slv_rx_buf_len;
+  (void)slv_tx_buf_len;
+  (void)intr_alloc_flags;
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_write_to_device(i2c_port_t     i2c_num,
+                                     uint8_t        device_address,
+                                     const uint8_t *write_buffer,
+                                     size_t         write_size,
+                                     TickType_t     ticks_to_wait)
+{
+  (void)i2c_num;
+  (void)ticks_to_wait;
+  if (write_buffer == NULL || write_size == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pthread_mutex_lock(&s_lock);
+  sim_board_t *board   = priv_find_board(device_address, true);
+  uint32_t     wire_us = priv_account(write_size + 1); /* Address byte */
+  bool         hold    = s_wire_delay;
+  pthread_mutex_unlock(&s_lock);
+  if (board == NULL) {
+    return ESP_FAIL; /* No ACK */
+  }
+
+  /* Registers change when the transfer ends, like OCH=0 outputs at STOP */
+  if (hold) {
+    priv_hold(wire_us);
+  }
+
+  pthread_mutex_lock(&s_lock);
+  uint8_t reg = write_buffer[0];
+  for (size_t i = 1; i < write_size; i++) {
+    uint8_t addr           = (uint8_t)(reg + i - 1);
+    board->registers[addr] = write_buffer[i];
+    /* ALL_LED drives every channel, mirror it so channel reads see it */
+    if (addr >= SIM_ALL_LED_ON_L && addr < SIM_ALL_LED_ON_L + SIM_LED_REG_SIZE) {
+      for (uint8_t channel = 0; channel < SIM_CHANNEL_COUNT; channel++) {
+        board->registers[SIM_LED0_ON_L + (channel * SIM_LED_REG_SIZE) + (addr - SIM_ALL_LED_ON_L)] = write_buffer[i];
+      }
+    }
+  }
+  pca9685_sim_write_hook_t hook = s_hook;
+  pthread_mutex_unlock(&s_lock);
+
+  if (hook != NULL && write_size > 1) {
+    hook(device_address, reg, write_size - 1);
+  }
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_write_read_device(i2c_port_t     i2c_num,
+                                       uint8_t        device_address,
+                                       const uint8_t *write_buffer,
+                                       size_t         write_size,
+                                       uint8_t       *read_buffer,
+                                       size_t         read_size,
+                                       TickType_t     ticks_to_wait)
+{
+  (void)i2c_num;
+  (void)ticks_to_wait;
+  if (write_buffer == NULL || write_size == 0 || read_buffer == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pthread_mutex_lock(&s_lock);
+  sim_board_t *board   = priv_find_board(device_address, false);
+  uint32_t     wire_us = priv_account(write_size + 1 + read_size + 1); /* Repeated START */
+  bool         hold    = s_wire_delay;
+  if (board != NULL) {
+    for (size_t i = 0; i < read_size; i++) {
+      read_buffer[i] = board->registers[(uint8_t)(write_buffer[0] + i)];
+    }
+  }
+  pthread_mutex_unlock(&s_lock);
+  if (board == NULL) {
+    return ESP_FAIL;
+  }
+  if (hold) {
+    priv_hold(wire_us);
+  }
+  return ESP_OK;
+}
+
+void pca9685_sim_set_wire_delay(bool enabled)
+{
+  pthread_mutex_lock(&s_lock);
+  s_wire_delay = enabled;
+  pthread_mutex_unlock(&s_lock);
+}
+
+void pca9685_sim_set_write_hook(pca9685_sim_write_hook_t hook)
+{
+  pthread_mutex_lock(&s_lock);
+  s_hook = hook;
+  pthread_mutex_unlock(&s_lock);
+}
+
+void pca9685_sim_get_stats(pca9685_sim_stats_t *stats, bool reset)
+{
+  pthread_mutex_lock(&s_lock);
+  *stats = s_stats;
+  if (reset) {
+    s_stats = (pca9685_sim_stats_t){0};
+  }
+  pthread_mutex_unlock(&s_lock);
+}
+
+bool pca9685_sim_get_channel(uint8_t address, uint8_t channel, uint16_t *on_ticks, uint16_t *off_ticks)
+{
+  pthread_mutex_lock(&s_lock);
+  sim_board_t *board = priv_find_board(address, false);
+  if (board != NULL) {
+    const uint8_t *led = &board->registers[SIM_LED0_ON_L + (SIM_LED_REG_SIZE * channel)];
+    *on_ticks  = (uint16_t)(led[0] | (led[1] << 8));
+    *off_ticks = (uint16_t)(led[2] | (led[3] << 8));
+  }
+  pthread_mutex_unlock(&s_lock);
+  return board != NULL;
+}
@@ -0,0 +1,19 @@
+/* tools/host_shims/strlcpy_host.c */
+
+/* See strlcpy_host.h. */
+
+#include "strlcpy_host.h"
+#include <string.h>
+
+/* Public Functions ***********************************************************/
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t copied = (length < size - 1) ? length : size - 1;
+    memcpy(dst, src, copied);
+    dst[copied] = '\0';
+  }
+  return length;
+}
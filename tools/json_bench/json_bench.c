@@ -0,0 +1,393 @@
+/* tools/json_bench/json_bench.c */
+
+/* Compares the sensor payload path through json_writer with the cJSON path
+ * the HALs used before, linking components/common/json_writer.c and the
+ * cJSON sources ESP-IDF ships in its json component.
+ *
+ *   json_bench [--payloads N]
+ *
+ * Two payloads, MPU6050 and GPS, each built from a pool of random samples:
+ *
+ *   json_writer  `json_writer_write_schema` into a stack buffer, what
+ *                `*_data_to_json_buf` does.
+ *   cJSON        `cJSON_CreateObject`, one `cJSON_Add*ToObject` per field,
+ *                `cJSON_PrintUnformatted`, `cJSON_Delete` and `free`, what
+ *                `*_data_to_json` did.
+ *
+ * malloc, calloc and realloc are wrapped at link time, so the allocations
+ * per payload are counted for both paths. Before timing, every sample is
+ * written both ways, parsed back with cJSON, and compared field by field:
+ * same keys, same strings and integers, and numbers that agree within the
+ * decimals the schema writes. Exits non-zero on a mismatch, or if the
+ * json_writer path allocates. Host figures show relative cost only. */
+
+#include "json_writer.h"
+#include "mpu6050_hal.h"
+#include "gy_neo6mv2_hal.h"
+#include "cJSON.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define SAMPLE_POOL_SIZE (256) /* Power of two, indexed with a mask */
+#define PAYLOAD_SIZE     (512)
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief A payload type, its samples and both ways of writing it
+ */
+typedef struct {
+  const char          *name;
+  const json_schema_t *schema;
+  const void          *samples;     /* SAMPLE_POOL_SIZE structs */
+  size_t               sample_size; /* Bytes of one struct */
+  cJSON             *(*to_cjson)(const void *sample);
+} payload_t;
+
+/**
+ * @brief Cost of one path
+ */
+typedef struct {
+  double ns_per_payload;
+  double allocations_per_payload;
+  double bytes_per_payload;
+} bench_result_t;
+
+/* Globals (Static) ***********************************************************/
+
+/* Same rows as s_mpu6050_json_fields in mpu6050_hal.c */
+static const json_field_t s_mpu6050_fields[] = {
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_x, "accel_x", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_y, "accel_y", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, accel_z, "accel_z", 4),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_x,  "gyro_x", 3),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_y,  "gyro_y", 3),
+  JSON_FIELD_FLOAT(mpu6050_data_t, gyro_z,  "gyro_z", 3),
+};
+
+/* Same rows as s_gy_neo6mv2_json_fields in gy_neo6mv2_hal.c */
+static const json_field_t s_gps_fields[] = {
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  latitude,        "latitude", 7),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  longitude,       "longitude", 7),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  speed,           "speed", 2),
+  JSON_FIELD_STRING(gy_neo6mv2_data_t, time,            "time"),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  fix_status,      "fix_status"),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  satellite_count, "satellite_count"),
+  JSON_FIELD_FLOAT(gy_neo6mv2_data_t,  hdop,            "hdop", 2),
+  JSON_FIELD_UINT8(gy_neo6mv2_data_t,  retry_count,     "retry_count"),
+  JSON_FIELD_UINT32(gy_neo6mv2_data_t, retry_interval,  "retry_interval"),
+};
+
+static const json_schema_t s_mpu6050_schema = JSON_SCHEMA("accelerometer_gyroscope", s_mpu6050_fields);
+static const json_schema_t s_gps_schema     = JSON_SCHEMA("gps", s_gps_fields);
+
+static mpu6050_data_t     s_mpu6050_samples[SAMPLE_POOL_SIZE];
+static gy_neo6mv2_data_t  s_gps_samples[SAMPLE_POOL_SIZE];
+static size_t             s_payloads    = 1000000;
+static uint64_t           s_allocations = 0;
+static uint64_t           s_rng         = 0x9E3779B97F4A7C15ull;
+static volatile uint32_t  s_sink        = 0; /* Keeps the compiler from dropping the loops */
+
+/* Allocation Counters ********************************************************/
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  s_allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  s_allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  s_allocations++;
+  return __real_realloc(ptr, size);
+}
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_now_s(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static double priv_random(double min, double max)
+{
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 7;
+  s_rng ^= s_rng << 17;
+  return min + (max - min) * ((s_rng >> 11) / 9007199254740992.0);
+}
+
+static void priv_fill_samples(void)
+{
+  for (size_t i = 0; i < SAMPLE_POOL_SIZE; i++) {
+    mpu6050_data_t *imu = &s_mpu6050_samples[i];
+    imu->accel_x = (float)priv_random(-4.0, 4.0);
+    imu->accel_y = (float)priv_random(-4.0, 4.0);
+    imu->accel_z = (float)priv_random(-4.0, 4.0);
+    imu->gyro_x  = (float)priv_random(-500.0, 500.0);
+    imu->gyro_y  = (float)priv_random(-500.0, 500.0);
+    imu->gyro_z  = (float)priv_random(-500.0, 500.0);
+
+    gy_neo6mv2_data_t *gps = &s_gps_samples[i];
+    gps->latitude        = (float)priv_random(-90.0, 90.0);
+    gps->longitude       = (float)priv_random(-180.0, 180.0);
+    gps->speed           = (float)priv_random(0.0, 30.0);
+    gps->fix_status      = (uint8_t)priv_random(0.0, 2.0);
+    gps->satellite_count = (uint8_t)priv_random(0.0, 13.0);
+    gps->hdop            = (float)priv_random(0.5, 5.0);
+    gps->retry_count     = (uint8_t)priv_random(0.0, 5.0);
+    gps->retry_interval  = (uint32_t)priv_random(0.0, 60000.0);
+    snprintf(gps->time, sizeof(gps->time), "%02u%02u%05.2f",
+             (unsigned)priv_random(0.0, 24.0),
+             (unsigned)priv_random(0.0, 60.0),
+             priv_random(0.0, 59.99));
+  }
+}
+
+/**
+ * @brief The body of mpu6050_data_to_json before json_writer
+ */
+static cJSON *priv_mpu6050_to_cjson(const void *sample)
+{
+  const mpu6050_data_t *data = sample;
+  cJSON                *json = cJSON_CreateObject();
+  if (json == NULL ||
+      !cJSON_AddStringToObject(json, "sensor_type", "accelerometer_gyroscope") ||
+      !cJSON_AddNumberToObject(json, "accel_x", data->accel_x) ||
+      !cJSON_AddNumberToObject(json, "accel_y", data->accel_y) ||
+      !cJSON_AddNumberToObject(json, "accel_z", data->accel_z) ||
+      !cJSON_AddNumberToObject(json, "gyro_x", data->gyro_x) ||
+      !cJSON_AddNumberToObject(json, "gyro_y", data->gyro_y) ||
+      !cJSON_AddNumberToObject(json, "gyro_z", data->gyro_z)) {
+    cJSON_Delete(json);
+    return NULL;
+  }
+  return json;
+}
+
+/**
+ * @brief The body of gy_neo6mv2_data_to_json before json_writer
+ */
+static cJSON *priv_gps_to_cjson(const void *sample)
+{
+  const gy_neo6mv2_data_t *data = sample;
+  cJSON                   *json = cJSON_CreateObject();
+  if (json == NULL ||
+      !cJSON_AddStringToObject(json, "sensor_type", "gps") ||
+      !cJSON_AddNumberToObject(json, "latitude", data->latitude) ||
+      !cJSON_AddNumberToObject(json, "longitude", data->longitude) ||
+      !cJSON_AddNumberToObject(json, "speed", data->speed) ||
+      !cJSON_AddStringToObject(json, "time", data->time) ||
+      !cJSON_AddNumberToObject(json, "fix_status", data->fix_status) ||
+      !cJSON_AddNumberToObject(json, "satellite_count", data->satellite_count) ||
+      !cJSON_AddNumberToObject(json, "hdop", data->hdop) ||
+      !cJSON_AddNumberToObject(json, "retry_count", data->retry_count) ||
+      !cJSON_AddNumberToObject(json, "retry_interval", data->retry_interval)) {
+    cJSON_Delete(json);
+    return NULL;
+  }
+  return json;
+}
+
+static const void *priv_sample(const payload_t *payload, size_t index)
+{
+  return (const uint8_t *)payload->samples + ((index & (SAMPLE_POOL_SIZE - 1)) * payload->sample_size);
+}
+
+static char *priv_print_cjson(const payload_t *payload, const void *sample)
+{
+  cJSON *json = payload->to_cjson(sample);
+  if (json == NULL) {
+    return NULL;
+  }
+  char *string = cJSON_PrintUnformatted(json);
+  cJSON_Delete(json);
+  return string;
+}
+
+/**
+ * @brief Compares one field of the two parsed payloads
+ */
+static bool priv_field_matches(const json_field_t *field, const cJSON *writer, const cJSON *reference)
+{
+  const cJSON *ours   = cJSON_GetObjectItemCaseSensitive(writer, field->key);
+  const cJSON *theirs = cJSON_GetObjectItemCaseSensitive(reference, field->key);
+  if (ours == NULL || theirs == NULL) {
+    return false;
+  }
+  switch (field->type) {
+    case k_json_field_string:
+      return cJSON_IsString(ours) && cJSON_IsString(theirs) &&
+             strcmp(ours->valuestring, theirs->valuestring) == 0;
+    case k_json_field_float:
+      /* cJSON prints the float exactly, json_writer rounds it to the decimals */
+      return cJSON_IsNumber(ours) && cJSON_IsNumber(theirs) &&
+             fabs(ours->valuedouble - theirs->valuedouble) <= 0.5 * pow(10.0, -field->arg) * (1.0 + 1e-9);
+    default:
+      return cJSON_IsNumber(ours) && cJSON_IsNumber(theirs) &&
+             ours->valuedouble == theirs->valuedouble;
+  }
+}
+
+/**
+ * @brief Writes every sample both ways and compares the parsed results
+ *
+ * @return Samples whose payloads differ
+ */
+static uint32_t priv_check(const payload_t *payload)
+{
+  uint32_t mismatches = 0;
+  for (size_t i = 0; i < SAMPLE_POOL_SIZE; i++) {
+    const void *sample = priv_sample(payload, i);
+    char        buffer[PAYLOAD_SIZE];
+    size_t      length = json_writer_write_schema(payload->schema, sample, buffer, sizeof(buffer));
+    char       *string = priv_print_cjson(payload, sample);
+    cJSON      *ours   = length < sizeof(buffer) ? cJSON_Parse(buffer) : NULL;
+    cJSON      *theirs = string != NULL ? cJSON_Parse(string) : NULL;
+
+    bool match = ours != NULL && theirs != NULL &&
+                 cJSON_GetArraySize(ours) == cJSON_GetArraySize(theirs) &&
+                 cJSON_GetArraySize(ours) == payload->schema->field_count + 1;
+    if (match) {
+      const cJSON *type = cJSON_GetObjectItemCaseSensitive(ours, "sensor_type");
+      match = cJSON_IsString(type) && strcmp(type->valuestring, payload->schema->object_type) == 0;
+    }
+    for (uint8_t f = 0; match && f < payload->schema->field_count; f++) {
+      match = priv_field_matches(&payload->schema->fields[f], ours, theirs);
+    }
+    if (!match) {
+      if (mismatches == 0) {
+        fprintf(stderr, "  json_writer: %s\n  cJSON:       %s\n", buffer, string != NULL ? string : "(null)");
+      }
+      mismatches++;
+    }
+
+    cJSON_Delete(ours);
+    cJSON_Delete(theirs);
+    free(string);
+  }
+  return mismatches;
+}
+
+static bench_result_t priv_bench_writer(const payload_t *payload)
+{
+  uint64_t bytes       = 0;
+  uint64_t allocations = s_allocations;
+  double   start       = priv_now_s();
+  for (size_t i = 0; i < s_payloads; i++) {
+    char   buffer[PAYLOAD_SIZE];
+    size_t length = json_writer_write_schema(payload->schema, priv_sample(payload, i), buffer, sizeof(buffer));
+    bytes  += length;
+    s_sink += (uint8_t)buffer[length / 2];
+  }
+  double elapsed = priv_now_s() - start;
+  return (bench_result_t){
+    .ns_per_payload          = elapsed * 1e9 / s_payloads,
+    .allocations_per_payload = (double)(s_allocations - allocations) / s_payloads,
+    .bytes_per_payload       = (double)bytes / s_payloads,
+  };
+}
+
+static bench_result_t priv_bench_cjson(const payload_t *payload)
+{
+  uint64_t bytes       = 0;
+  uint64_t allocations = s_allocations;
+  double   start       = priv_now_s();
+  for (size_t i = 0; i < s_payloads; i++) {
+    char *string = priv_print_cjson(payload, priv_sample(payload, i));
+    if (string != NULL) {
+      size_t length = strlen(string);
+      bytes  += length;
+      s_sink += (uint8_t)string[length / 2];
+      free(string);
+    }
+  }
+  double elapsed = priv_now_s() - start;
+  return (bench_result_t){
+    .ns_per_payload          = elapsed * 1e9 / s_payloads,
+    .allocations_per_payload = (double)(s_allocations - allocations) / s_payloads,
+    .bytes_per_payload       = (double)bytes / s_payloads,
+  };
+}
+
+static void priv_print(const char *name, bench_result_t result)
+{
+  printf("  %-12s %9.1f ns/payload  %5.1f allocations  %6.1f bytes\n",
+         name,
+         result.ns_per_payload,
+         result.allocations_per_payload,
+         result.bytes_per_payload);
+}
+
+static void priv_usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [--payloads N]\n", program);
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--payloads") == 0 && i + 1 < argc) {
+      s_payloads = strtoul(argv[++i], NULL, 10);
+    } else {
+      priv_usage(argv[0]);
+      return 2;
+    }
+  }
+  if (s_payloads == 0) {
+    priv_usage(argv[0]);
+    return 2;
+  }
+
+  const payload_t payloads[] = {
+    { "mpu6050", &s_mpu6050_schema, s_mpu6050_samples, sizeof(s_mpu6050_samples[0]), priv_mpu6050_to_cjson },
+    { "gps",     &s_gps_schema,     s_gps_samples,     sizeof(s_gps_samples[0]),     priv_gps_to_cjson     },
+  };
+
+  priv_fill_samples();
+  printf("cJSON %s, %zu payloads each\n", cJSON_Version(), s_payloads);
+
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+    const payload_t *payload    = &payloads[i];
+    uint32_t         mismatches = priv_check(payload);
+    printf("%s\n", payload->name);
+    if (mismatches > 0) {
+      fprintf(stderr, "  %u of %u samples differ from cJSON\n", mismatches, SAMPLE_POOL_SIZE);
+      failures++;
+    }
+
+    bench_result_t writer = priv_bench_writer(payload);
+    priv_print("json_writer", writer);
+    priv_print("cJSON", priv_bench_cjson(payload));
+    if (writer.allocations_per_payload != 0.0) {
+      fprintf(stderr, "  json_writer allocated\n");
+      failures++;
+    }
+  }
+
+  if (failures > 0) {
+    printf("\nFAIL: %d checks\n", failures);
+    return 1;
+  }
+  return 0;
+}
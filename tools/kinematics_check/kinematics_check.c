@@ -0,0 +1,415 @@
+/* tools/kinematics_check/kinematics_check.c */
+
+/* Checks the firmware's leg inverse kinematics, float and fixed point,
+ * across the workspace and measures their cost per solve.
+ *
+ *   kinematics_check [--seconds S] [--step DEG]
+ *
+ * Joint angles are swept over a grid of DEG cells (5 by default), one
+ * reproducible random pose per cell. Each pose goes through
+ * `kinematics_forward_legs`, back through `kinematics_solve_legs`, and
+ * forward again; the worst joint angle and foot position differences must
+ * stay within the bounds below. The same targets go through
+ * `kinematics_solve_legs_q16` and `kinematics_angles_to_servo_q16`, which
+ * must stay within bounds of the float angles and of the servo positions
+ * rounded from them. Targets beyond the leg's reach must be flagged in the
+ * unreachable mask and pulled back onto the workspace boundary by both
+ * paths. The benchmark solves precomputed reachable targets for all six
+ * legs per call with each path. Exits non-zero if a check fails. */
+
+#include "hexapod_kinematics.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define MAX_ANGLE_ERROR_DEG   (0.01)  /* Round trip through forward and inverse kinematics */
+#define MAX_POSITION_ERROR_CM (0.001)
+#define MAX_Q16_ERROR_DEG     (0.05)  /* Fixed-point against float, table interpolation dominates */
+#define MAX_SERVO_STEPS       (1)     /* 0.1° servo positions, fixed-point against float rounding */
+#define BENCHMARK_POSES       (1024)  /* Distinct targets cycled through by the benchmark */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Worst case over a sweep
+ */
+typedef struct {
+  double       angle_deg;
+  double       position_cm;
+  leg_angles_t worst_pose;     /* Leg 0 holds the pose with the largest angle error */
+  double       q16_angle_deg;  /* Fixed-point against float */
+  leg_angles_t q16_worst_pose; /* Leg 0 holds the pose with the largest fixed-point error */
+  uint32_t     servo_steps;    /* Largest servo position difference, 0.1° steps */
+  size_t       poses;
+  size_t       failures;       /* Reachable poses the solver flagged */
+  size_t       q16_failures;   /* Reachable poses the fixed-point solver flagged */
+} sweep_result_t;
+
+/* Globals (Static) ***********************************************************/
+
+static double            s_seconds  = 1.0;
+static double            s_step_deg = 5.0;
+static uint64_t          s_rng      = 0x9E3779B97F4A7C15ull;
+static volatile uint32_t s_sink     = 0; /* Keeps the compiler from dropping the loops */
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_now_s(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Uniform in [0, 1), reproducible between runs
+ */
+static float priv_random(void)
+{
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 7;
+  s_rng ^= s_rng << 17;
+  return (float)(s_rng >> 40) / (float)(1 << 24);
+}
+
+static void priv_positions_to_q16(const leg_positions_t *positions, leg_positions_q16_t *fixed)
+{
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+    fixed->x_cm[leg] = kinematics_float_to_q16(positions->x_cm[leg]);
+    fixed->y_cm[leg] = kinematics_float_to_q16(positions->y_cm[leg]);
+    fixed->z_cm[leg] = kinematics_float_to_q16(positions->z_cm[leg]);
+  }
+}
+
+/**
+ * @brief Servo position the float path would give, see `kinematics_angles_to_servo_q16`
+ */
+static uint16_t priv_float_to_servo(float angle_deg, float min_deg, float max_deg)
+{
+  return (uint16_t)lround(fmin(fmax(angle_deg, min_deg), max_deg) * 10.0 + 900.0);
+}
+
+/**
+ * @brief Whether a pose is one the solver can return
+ *
+ * The solver always picks the knee-up branch with the foot in front of the
+ * hip, and the float acos loses precision with the tibia folded flat onto
+ * the femur or stretched straight, so those poses are left out.
+ */
+static bool priv_pose_is_solvable(float hip_deg, float knee_deg, float tibia_deg)
+{
+  leg_angles_t    angles = {0};
+  leg_positions_t feet;
+  angles.hip_deg[0]   = hip_deg;
+  angles.knee_deg[0]  = knee_deg;
+  angles.tibia_deg[0] = tibia_deg;
+  kinematics_forward_legs(&angles, &feet);
+
+  float r = hypotf(feet.x_cm[0], feet.y_cm[0]);
+  return fabsf(tibia_deg) <= 85.0f && r > hip_length_cm + 0.5f;
+}
+
+/**
+ * @brief Forward, inverse and forward again over the joint angle grid
+ */
+static sweep_result_t priv_sweep(void)
+{
+  sweep_result_t  result = {0};
+  leg_angles_t    angles = {0};
+  leg_angles_t    solved;
+  leg_positions_t feet;
+  leg_positions_t check;
+  uint8_t         leg    = 0;
+
+  leg_positions_q16_t   fixed_feet;
+  leg_angles_q16_t      fixed;
+  leg_servo_positions_t servo;
+
+  for (double grid_hip = -60.0; grid_hip < 60.0; grid_hip += s_step_deg) {
+    for (double grid_knee = -60.0; grid_knee < 90.0; grid_knee += s_step_deg) {
+      for (double grid_tibia = -85.0; grid_tibia < 85.0; grid_tibia += s_step_deg) {
+        /* Anywhere in the cell, so servo positions land on rounding edges too */
+        float hip   = grid_hip + s_step_deg * priv_random();
+        float knee  = grid_knee + s_step_deg * priv_random();
+        float tibia = grid_tibia + s_step_deg * priv_random();
+        if (!priv_pose_is_solvable(hip, knee, tibia)) {
+          continue;
+        }
+        angles.hip_deg[leg]   = hip;
+        angles.knee_deg[leg]  = knee;
+        angles.tibia_deg[leg] = tibia;
+        if (++leg < NUMBER_OF_LEGS) {
+          continue;
+        }
+        leg = 0;
+
+        uint8_t mask = 0;
+        kinematics_forward_legs(&angles, &feet);
+        kinematics_solve_legs(&feet, &solved, &mask);
+        kinematics_forward_legs(&solved, &check);
+
+        uint8_t fixed_mask = 0;
+        priv_positions_to_q16(&feet, &fixed_feet);
+        kinematics_solve_legs_q16(&fixed_feet, &fixed, &fixed_mask);
+        kinematics_angles_to_servo_q16(&fixed, &servo);
+
+        for (uint8_t i = 0; i < NUMBER_OF_LEGS; i++) {
+          double angle = fmax(fabs(solved.hip_deg[i] - angles.hip_deg[i]),
+                              fmax(fabs(solved.knee_deg[i] - angles.knee_deg[i]),
+                                   fabs(solved.tibia_deg[i] - angles.tibia_deg[i])));
+          double position = sqrt(pow(check.x_cm[i] - feet.x_cm[i], 2) +
+                                 pow(check.y_cm[i] - feet.y_cm[i], 2) +
+                                 pow(check.z_cm[i] - feet.z_cm[i], 2));
+          if (angle > result.angle_deg) {
+            result.angle_deg               = angle;
+            result.worst_pose.hip_deg[0]   = angles.hip_deg[i];
+            result.worst_pose.knee_deg[0]  = angles.knee_deg[i];
+            result.worst_pose.tibia_deg[0] = angles.tibia_deg[i];
+          }
+          result.position_cm = fmax(result.position_cm, position);
+          result.failures   += (mask >> i) & 1;
+
+          double q16_angle = fmax(fabs(kinematics_angle_to_deg(fixed.hip[i]) - solved.hip_deg[i]),
+                                  fmax(fabs(kinematics_angle_to_deg(fixed.knee[i]) - solved.knee_deg[i]),
+                                       fabs(kinematics_angle_to_deg(fixed.tibia[i]) - solved.tibia_deg[i])));
+          if (q16_angle > result.q16_angle_deg) {
+            result.q16_angle_deg               = q16_angle;
+            result.q16_worst_pose.hip_deg[0]   = angles.hip_deg[i];
+            result.q16_worst_pose.knee_deg[0]  = angles.knee_deg[i];
+            result.q16_worst_pose.tibia_deg[0] = angles.tibia_deg[i];
+          }
+          result.q16_failures += (fixed_mask >> i) & 1;
+
+          int steps[3] = {
+            servo.hip[i] - priv_float_to_servo(solved.hip_deg[i], hip_angle_from_90_min, hip_angle_from_90_max),
+            servo.knee[i] - priv_float_to_servo(solved.knee_deg[i], knee_angle_from_90_min, knee_angle_from_90_max),
+            servo.tibia[i] - priv_float_to_servo(solved.tibia_deg[i], tibia_angle_from_90_min, tibia_angle_from_90_max),
+          };
+          for (int joint = 0; joint < 3; joint++) {
+            if ((uint32_t)abs(steps[joint]) > result.servo_steps) {
+              result.servo_steps = (uint32_t)abs(steps[joint]);
+            }
+          }
+        }
+        result.poses += NUMBER_OF_LEGS;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Targets past full extension and inside the femur joint
+ *
+ * @return Number of legs that were not flagged or not pulled back onto the
+ *         workspace boundary.
+ */
+static size_t priv_check_unreachable(void)
+{
+  const float     max_reach = femur_length_cm + tibia_length_cm;
+  const float     min_reach = fabsf(femur_length_cm - tibia_length_cm);
+  leg_positions_t feet;
+  leg_positions_t check;
+  leg_angles_t    solved;
+  uint8_t         mask   = 0;
+  size_t          errors = 0;
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+    /* Even legs reach too far, odd legs fold too tight, all along 30° down */
+    float reach = (leg % 2 == 0) ? max_reach + 2.0f + leg : min_reach * 0.25f;
+    float yaw   = (leg * 20.0f - 50.0f) * (float)M_PI / 180.0f;
+    float r     = hip_length_cm + reach * cosf((float)M_PI / 6.0f);
+    feet.x_cm[leg] = r * cosf(yaw);
+    feet.y_cm[leg] = r * sinf(yaw);
+    feet.z_cm[leg] = -reach * sinf((float)M_PI / 6.0f);
+  }
+
+  if (kinematics_solve_legs(&feet, &solved, &mask) != ESP_FAIL || mask != 0x3F) {
+    printf("  unreachable targets: expected ESP_FAIL with mask 0x3F, got mask 0x%02X\n", mask);
+    errors++;
+  }
+
+  leg_positions_q16_t fixed_feet;
+  leg_angles_q16_t    fixed;
+  uint8_t             fixed_mask = 0;
+  priv_positions_to_q16(&feet, &fixed_feet);
+  if (kinematics_solve_legs_q16(&fixed_feet, &fixed, &fixed_mask) != ESP_FAIL || fixed_mask != 0x3F) {
+    printf("  unreachable targets: expected ESP_FAIL with mask 0x3F from Q16, got mask 0x%02X\n",
+           fixed_mask);
+    errors++;
+  }
+
+  leg_angles_t fixed_deg;
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+    fixed_deg.hip_deg[leg]   = kinematics_angle_to_deg(fixed.hip[leg]);
+    fixed_deg.knee_deg[leg]  = kinematics_angle_to_deg(fixed.knee[leg]);
+    fixed_deg.tibia_deg[leg] = kinematics_angle_to_deg(fixed.tibia[leg]);
+  }
+
+  const leg_angles_t *paths[2]      = { &solved, &fixed_deg };
+  const char         *path_names[2] = { "float", "Q16" };
+  for (int path = 0; path < 2; path++) {
+    kinematics_forward_legs(paths[path], &check);
+    for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+      float r        = hypotf(check.x_cm[leg], check.y_cm[leg]) - hip_length_cm;
+      float distance = hypotf(r, check.z_cm[leg]);
+      float expected = (leg % 2 == 0) ? max_reach : min_reach;
+      if (fabsf(distance - expected) > 0.01f) {
+        printf("  leg %u %s: clamped to %.4f cm from the femur joint, expected %.4f\n",
+               leg,
+               path_names[path],
+               distance,
+               expected);
+        errors++;
+      }
+    }
+  }
+  return errors;
+}
+
+/**
+ * @brief Reachable targets for the benchmark, spread over the workspace
+ */
+static void priv_fill_targets(leg_positions_t *targets)
+{
+  leg_angles_t angles;
+  for (size_t pose = 0; pose < BENCHMARK_POSES; pose++) {
+    for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+      angles.hip_deg[leg]   = -45.0f + 90.0f * priv_random();
+      angles.knee_deg[leg]  = -30.0f + 90.0f * priv_random();
+      angles.tibia_deg[leg] = -60.0f + 90.0f * priv_random();
+    }
+    kinematics_forward_legs(&angles, &targets[pose]);
+  }
+}
+
+/**
+ * @brief Nanoseconds per `kinematics_solve_legs` call, all six legs
+ */
+static double priv_benchmark_float(const leg_positions_t *targets)
+{
+  leg_angles_t angles;
+  uint64_t     solves = 0;
+  double       start  = priv_now_s();
+  double       elapsed;
+  do {
+    for (size_t pose = 0; pose < BENCHMARK_POSES; pose++) {
+      kinematics_solve_legs(&targets[pose], &angles, NULL);
+      s_sink += (uint32_t)angles.knee_deg[pose % NUMBER_OF_LEGS];
+    }
+    solves += BENCHMARK_POSES;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < s_seconds);
+  return elapsed * 1e9 / solves;
+}
+
+/**
+ * @brief Nanoseconds per `kinematics_solve_legs_q16` and
+ *        `kinematics_angles_to_servo_q16` call pair, all six legs
+ */
+static double priv_benchmark_q16(const leg_positions_q16_t *targets)
+{
+  leg_angles_q16_t      angles;
+  leg_servo_positions_t servo;
+  uint64_t              solves = 0;
+  double                start  = priv_now_s();
+  double                elapsed;
+  do {
+    for (size_t pose = 0; pose < BENCHMARK_POSES; pose++) {
+      kinematics_solve_legs_q16(&targets[pose], &angles, NULL);
+      kinematics_angles_to_servo_q16(&angles, &servo);
+      s_sink += servo.knee[pose % NUMBER_OF_LEGS];
+    }
+    solves += BENCHMARK_POSES;
+    elapsed = priv_now_s() - start;
+  } while (elapsed < s_seconds);
+  return elapsed * 1e9 / solves;
+}
+
+static void priv_usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [--seconds S] [--step DEG]\n", program);
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      s_seconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+      s_step_deg = atof(argv[++i]);
+    } else {
+      priv_usage(argv[0]);
+      return 2;
+    }
+  }
+  if (s_step_deg <= 0.0) {
+    priv_usage(argv[0]);
+    return 2;
+  }
+
+  bool failed = false;
+  kinematics_init();
+
+  sweep_result_t sweep = priv_sweep();
+  printf("round trip over %zu poses\n", sweep.poses);
+  printf("  max angle error    %10.6f deg (limit %.3f) at hip %.2f, knee %.2f, tibia %.2f\n",
+         sweep.angle_deg,
+         MAX_ANGLE_ERROR_DEG,
+         sweep.worst_pose.hip_deg[0],
+         sweep.worst_pose.knee_deg[0],
+         sweep.worst_pose.tibia_deg[0]);
+  printf("  max position error %10.6f cm (limit %.3f)\n", sweep.position_cm, MAX_POSITION_ERROR_CM);
+  printf("  reachable poses flagged unreachable: %zu\n", sweep.failures);
+  failed |= sweep.angle_deg > MAX_ANGLE_ERROR_DEG;
+  failed |= sweep.position_cm > MAX_POSITION_ERROR_CM;
+  failed |= sweep.failures > 0;
+
+  printf("Q16 against float over the same poses\n");
+  printf("  max angle error    %10.6f deg (limit %.3f) at hip %.2f, knee %.2f, tibia %.2f\n",
+         sweep.q16_angle_deg,
+         MAX_Q16_ERROR_DEG,
+         sweep.q16_worst_pose.hip_deg[0],
+         sweep.q16_worst_pose.knee_deg[0],
+         sweep.q16_worst_pose.tibia_deg[0]);
+  printf("  max servo difference %u steps of 0.1 deg (limit %d)\n", sweep.servo_steps, MAX_SERVO_STEPS);
+  printf("  reachable poses flagged unreachable: %zu\n", sweep.q16_failures);
+  failed |= sweep.q16_angle_deg > MAX_Q16_ERROR_DEG;
+  failed |= sweep.servo_steps > MAX_SERVO_STEPS;
+  failed |= sweep.q16_failures > 0;
+
+  printf("unreachable targets\n");
+  size_t errors = priv_check_unreachable();
+  printf("  %s\n", errors == 0 ? "flagged and clamped onto the boundary" : "FAILED");
+  failed |= errors > 0;
+
+  leg_positions_t     *targets       = malloc(BENCHMARK_POSES * sizeof(*targets));
+  leg_positions_q16_t *fixed_targets = malloc(BENCHMARK_POSES * sizeof(*fixed_targets));
+  if (targets == NULL || fixed_targets == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  priv_fill_targets(targets);
+  for (size_t pose = 0; pose < BENCHMARK_POSES; pose++) {
+    priv_positions_to_q16(&targets[pose], &fixed_targets[pose]);
+  }
+  double float_ns = priv_benchmark_float(targets);
+  double q16_ns   = priv_benchmark_q16(fixed_targets);
+  printf("benchmark\n");
+  printf("  float %9.1f ns per call, %7.1f ns per leg\n", float_ns, float_ns / NUMBER_OF_LEGS);
+  printf("  Q16   %9.1f ns per call, %7.1f ns per leg (solve and servo conversion)\n",
+         q16_ns,
+         q16_ns / NUMBER_OF_LEGS);
+  free(fixed_targets);
+  free(targets);
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return failed ? 1 : 0;
+}
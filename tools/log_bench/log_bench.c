@@ -0,0 +1,208 @@
+/* tools/log_bench/log_bench.c */
+
+/* Measures what one log call in a hot path costs, running the firmware's
+ * log_handler.c and log_record.c with storage and the time manager stubbed.
+ *
+ *   log_bench [--batches N]
+ *
+ * The call is the one the MPU6050 driver makes per sample, three floats
+ * formatted into the detailed message. This file compiles with
+ * LOG_LOCAL_COMPILE_LEVEL at ESP_LOG_DEBUG and a runtime default of
+ * ESP_LOG_INFO, so:
+ *
+ *   compiled out     `log_verbose`, above the compile-time threshold; the
+ *                    call and its arguments are gone. What is left is the
+ *                    loop and the clock reads, the floor of every row.
+ *   runtime filter   `log_debug`, compiled in but rejected by
+ *                    `log_level_enabled`, with and without other tags
+ *                    holding runtime overrides.
+ *   written, sync    `log_info` before `log_init`: formatted, rendered with
+ *                    task name and timestamp, sent to the console and
+ *                    storage in the caller. This is what every hot-path
+ *                    `log_info` cost before the gate.
+ *   written, queued  `log_info` once the drain task runs: arguments copied
+ *                    into the ring, formatting left to the drain task.
+ *
+ * Each mode runs in batches smaller than the ring and reports the median
+ * per-call cost; queued batches are drained between timings. The console
+ * only formats on the host, UART time on the target comes on top of the
+ * synchronous figure. */
+
+#define LOG_LOCAL_COMPILE_LEVEL ESP_LOG_DEBUG
+
+#include "log_handler.h"
+#include "log_storage.h"
+#include "time_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Macros *********************************************************************/
+
+#define BATCH_CALLS   (LOG_RING_SIZE / 8) /* Below the drain task's wake-up count */
+#define OVERRIDE_TAGS (8)
+
+/* Globals (Static) ***********************************************************/
+
+static const char *s_other_tags[OVERRIDE_TAGS] = {
+  "GPS", "PCA9685", "EC11", "WIFI", "SD_CARD", "GAIT", "MOTION", "TELEMETRY",
+};
+
+static const char        *s_tag      = "MPU6050";
+static size_t             s_batches  = 2000;
+static volatile float     s_accel[3] = { 0.012f, -0.031f, 0.987f };
+static volatile uint32_t  s_sink     = 0; /* Keeps the compiler from dropping the loops */
+static uint32_t           s_stored   = 0;
+
+/* Storage and Time Stand-ins *************************************************/
+
+esp_err_t log_storage_init(void)
+{
+  return ESP_OK;
+}
+
+esp_err_t log_storage_write(const log_record_t *record)
+{
+  s_stored += record->level;
+  return ESP_OK;
+}
+
+esp_err_t log_storage_flush(void)
+{
+  return ESP_OK;
+}
+
+bool time_manager_is_initialized(void)
+{
+  return true;
+}
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_now_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static int priv_compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double priv_median(double *samples, size_t count)
+{
+  qsort(samples, count, sizeof(samples[0]), priv_compare_double);
+  return samples[count / 2];
+}
+
+static void priv_batch_verbose(void)
+{
+  for (uint32_t i = 0; i < BATCH_CALLS; i++) {
+    log_verbose(s_tag, "Data Updated", "Accel: [%f, %f, %f] g", s_accel[0], s_accel[1], s_accel[2]);
+    s_sink += i;
+  }
+}
+
+static void priv_batch_debug(void)
+{
+  for (uint32_t i = 0; i < BATCH_CALLS; i++) {
+    log_debug(s_tag, "Data Updated", "Accel: [%f, %f, %f] g", s_accel[0], s_accel[1], s_accel[2]);
+    s_sink += i;
+  }
+}
+
+static void priv_batch_info(void)
+{
+  for (uint32_t i = 0; i < BATCH_CALLS; i++) {
+    log_info(s_tag, "Data Updated", "Accel: [%f, %f, %f] g", s_accel[0], s_accel[1], s_accel[2]);
+    s_sink += i;
+  }
+}
+
+/**
+ * @brief Median per-call cost of a batch, optionally draining between batches
+ */
+static double priv_measure(void (*batch)(void), bool drain)
+{
+  double *samples = malloc(s_batches * sizeof(samples[0]));
+  if (samples == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < s_batches; i++) {
+    double start = priv_now_ns();
+    batch();
+    samples[i] = (priv_now_ns() - start) / BATCH_CALLS;
+    if (drain) {
+      log_flush();
+    }
+  }
+  double median = priv_median(samples, s_batches);
+  free(samples);
+  return median;
+}
+
+static void priv_print(const char *name, double ns_per_call)
+{
+  printf("  %-34s %9.1f ns/call\n", name, ns_per_call);
+}
+
+static void priv_usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [--batches N]\n", program);
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--batches") == 0 && i + 1 < argc) {
+      s_batches = strtoul(argv[++i], NULL, 10);
+    } else {
+      priv_usage(argv[0]);
+      return 2;
+    }
+  }
+  if (s_batches == 0) {
+    priv_usage(argv[0]);
+    return 2;
+  }
+
+  log_set_default_level(ESP_LOG_INFO);
+  log_set_sd_logging(true);
+
+  printf("%u calls per batch, median of %zu batches\n", BATCH_CALLS, s_batches);
+  priv_print("compiled out (log_verbose)", priv_measure(priv_batch_verbose, false));
+  priv_print("runtime filter (log_debug)", priv_measure(priv_batch_debug, false));
+  for (size_t i = 0; i < OVERRIDE_TAGS; i++) {
+    log_set_level(s_other_tags[i], ESP_LOG_INFO);
+  }
+  printf("  with %d other tags overridden:\n", OVERRIDE_TAGS);
+  priv_print("runtime filter (log_debug)", priv_measure(priv_batch_debug, false));
+
+  /* Before log_init every call is formatted and written in the caller */
+  priv_print("written, sync (log_info)", priv_measure(priv_batch_info, false));
+
+  if (log_init(false) != ESP_OK) {
+    fprintf(stderr, "log_init failed\n");
+    return 1;
+  }
+  log_set_sd_logging(true);
+  priv_print("written, queued (log_info)", priv_measure(priv_batch_info, true));
+
+  if (log_get_dropped_count() != 0) {
+    fprintf(stderr, "%u records dropped, the ring overflowed\n", log_get_dropped_count());
+    return 1;
+  }
+  if (s_stored == 0) {
+    fprintf(stderr, "no record reached storage\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,475 @@
+/* tools/log_decoder/log_decoder.c */
+
+/* Decodes binary log files (.tlog, .tlog.gz) written by log_storage back
+ * into text or JSON lines.
+ *
+ *   log_decoder [--json] FILE...
+ *
+ * Files that are still being written end without a gzip trailer; everything
+ * up to the last sync flush is decoded. */
+
+#include "log_record.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+/* Macros *********************************************************************/
+
+#define DECODER_READ_CHUNK     (64 * 1024) /* Bytes read from the file at a time */
+#define DECODER_MESSAGE_LENGTH (1024)      /* Longest rendered message */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Bounds-checked cursor over the decompressed file
+ */
+typedef struct {
+  const uint8_t *data; /* File contents */
+  size_t         len;  /* Bytes in data */
+  size_t         pos;  /* Next byte to read */
+  bool           ok;   /* Cleared on the first out-of-bounds read */
+} decoder_reader_t;
+
+/**
+ * @brief Per-file decoder state, mirrors log_record_encoder_t
+ */
+typedef struct {
+  char    *strings[LOG_RECORD_MAX_STRINGS + 1]; /* Interned strings by id */
+  char    *tasks[LOG_RECORD_MAX_TASKS + 1];     /* Interned task names by id */
+  uint64_t last_sequence;                       /* Sequence of the previous entry */
+  int64_t  last_timestamp_us;                   /* Timestamp of the previous entry */
+  int64_t  time_offset_us;                      /* Unix time minus esp_timer time */
+  bool     time_known;                          /* Whether a time sync block was seen */
+} decoder_state_t;
+
+/* Globals (Static) ***********************************************************/
+
+static bool s_json_output = false;
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Name of an esp_log_level_t value
+ */
+static const char *priv_level_name(uint8_t level)
+{
+  switch (level) {
+    case 1:  return "ERROR";
+    case 2:  return "WARN";
+    case 3:  return "INFO";
+    case 4:  return "DEBUG";
+    case 5:  return "VERBOSE";
+    default: return "UNKNOWN";
+  }
+}
+
+/**
+ * @brief Reads one byte
+ */
+static uint8_t priv_read_byte(decoder_reader_t *reader)
+{
+  if (reader->pos >= reader->len) {
+    reader->ok = false;
+    return 0;
+  }
+  return reader->data[reader->pos++];
+}
+
+/**
+ * @brief Reads an unsigned varint
+ */
+static uint64_t priv_read_varint(decoder_reader_t *reader)
+{
+  uint64_t value = 0;
+  size_t   used  = log_record_get_varint(&reader->data[reader->pos],
+                                         reader->len - reader->pos,
+                                         &value);
+  if (used == 0) {
+    reader->ok = false;
+    return 0;
+  }
+  reader->pos += used;
+  return value;
+}
+
+/**
+ * @brief Reads a zigzag encoded signed varint
+ */
+static int64_t priv_read_signed(decoder_reader_t *reader)
+{
+  uint64_t value = priv_read_varint(reader);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief Reads a length-prefixed string into a buffer
+ *
+ * @param reader Source
+ * @param buffer Destination, always NUL terminated
+ * @param size   Size of buffer
+ * @return Length of the string, 0 on a read error
+ */
+static size_t priv_read_string(decoder_reader_t *reader, char *buffer, size_t size)
+{
+  uint64_t len = priv_read_varint(reader);
+  if (!reader->ok || len > reader->len - reader->pos) {
+    reader->ok = false;
+    buffer[0]  = '\0';
+    return 0;
+  }
+
+  size_t copy = (len < size) ? (size_t)len : size - 1;
+  memcpy(buffer, &reader->data[reader->pos], copy);
+  buffer[copy]  = '\0';
+  reader->pos  += len;
+  return copy;
+}
+
+/**
+ * @brief Stores a string definition block in a table
+ *
+ * @param reader    Source, positioned after the block type
+ * @param table     Table to store into
+ * @param table_len Entries in table
+ */
+static void priv_read_definition(decoder_reader_t *reader, char **table, size_t table_len)
+{
+  char     buffer[LOG_RECORD_MAX_STRING_DEF + 1];
+  uint64_t id = priv_read_varint(reader);
+  priv_read_string(reader, buffer, sizeof(buffer));
+  if (!reader->ok || id == 0 || id >= table_len) {
+    reader->ok = false;
+    return;
+  }
+  free(table[id]);
+  table[id] = strdup(buffer);
+}
+
+/**
+ * @brief Resolves a string reference of an entry
+ *
+ * @param reader        Source
+ * @param table         Table the id refers to
+ * @param table_len     Entries in table
+ * @param inline_buffer Destination for inline strings
+ * @param size          Size of inline_buffer
+ * @return The string, "?" for an unknown id
+ */
+static const char *priv_read_ref(decoder_reader_t *reader,
+                                 char            **table,
+                                 size_t            table_len,
+                                 char             *inline_buffer,
+                                 size_t            size)
+{
+  uint64_t id = priv_read_varint(reader);
+  if (id == 0) {
+    priv_read_string(reader, inline_buffer, size);
+    return inline_buffer;
+  }
+  if (id >= table_len || table[id] == NULL) {
+    return "?";
+  }
+  return table[id];
+}
+
+/**
+ * @brief Writes a string as a JSON string literal
+ */
+static void priv_print_json_string(const char *str)
+{
+  putchar('"');
+  for (const unsigned char *p = (const unsigned char *)str; *p != '\0'; p++) {
+    switch (*p) {
+      case '"':  fputs("\\\"", stdout); break;
+      case '\\': fputs("\\\\", stdout); break;
+      case '\n': fputs("\\n", stdout);  break;
+      case '\r': fputs("\\r", stdout);  break;
+      case '\t': fputs("\\t", stdout);  break;
+      default:
+        if (*p < 0x20) {
+          printf("\\u%04x", *p);
+        } else {
+          putchar(*p);
+        }
+        break;
+    }
+  }
+  putchar('"');
+}
+
+/**
+ * @brief Formats an entry's time, wall clock when known, otherwise uptime
+ */
+static void priv_format_time(const decoder_state_t *state,
+                             int64_t                timestamp_us,
+                             char                  *buffer,
+                             size_t                 size)
+{
+  if (!state->time_known) {
+    snprintf(buffer,
+             size,
+             "+%" PRId64 ".%06" PRId64,
+             timestamp_us / 1000000,
+             timestamp_us % 1000000);
+    return;
+  }
+
+  int64_t   unix_us = timestamp_us + state->time_offset_us;
+  time_t    seconds = (time_t)(unix_us / 1000000);
+  struct tm timeinfo;
+  gmtime_r(&seconds, &timeinfo);
+  size_t len = strftime(buffer, size, "%Y-%m-%dT%H:%M:%S", &timeinfo);
+  snprintf(&buffer[len], size - len, ".%03dZ", (int)((unix_us % 1000000) / 1000));
+}
+
+/**
+ * @brief Decodes one entry block and prints it
+ *
+ * @param reader Source, positioned after the block type
+ * @param state  Decoder state of the file
+ * @param level  Log level from the block type
+ */
+static void priv_decode_entry(decoder_reader_t *reader, decoder_state_t *state, uint8_t level)
+{
+  char         tag_buffer[LOG_RECORD_MAX_STRING_DEF + 1];
+  char         short_buffer[LOG_RECORD_MAX_STRING_DEF + 1];
+  char         format_buffer[LOG_RECORD_MAX_STRING_DEF + 1];
+  log_record_t record = {0};
+
+  record.level          = level;
+  record.sequence       = state->last_sequence + (uint64_t)priv_read_signed(reader);
+  record.timestamp_us   = state->last_timestamp_us + priv_read_signed(reader);
+  record.tag            = priv_read_ref(reader, state->strings, LOG_RECORD_MAX_STRINGS + 1,
+                                        tag_buffer, sizeof(tag_buffer));
+  record.short_msg      = priv_read_ref(reader, state->strings, LOG_RECORD_MAX_STRINGS + 1,
+                                        short_buffer, sizeof(short_buffer));
+  record.format         = priv_read_ref(reader, state->strings, LOG_RECORD_MAX_STRINGS + 1,
+                                        format_buffer, sizeof(format_buffer));
+  const char *task_name = priv_read_ref(reader, state->tasks, LOG_RECORD_MAX_TASKS + 1,
+                                        record.task_name, sizeof(record.task_name));
+  uint64_t    arg_count = priv_read_varint(reader);
+  if (arg_count > LOG_RECORD_MAX_ARGS) {
+    reader->ok = false;
+  }
+
+  /* Argument kinds come from the format, exactly as the encoder walked it */
+  for (const char *p = strchr(record.format, '%');
+       reader->ok && p != NULL && record.arg_count < arg_count;
+       p = strchr(p, '%')) {
+    log_spec_t spec;
+    log_record_parse_spec(p, &spec);
+    p += spec.length;
+
+    if (spec.kind == k_log_arg_none) {
+      continue;
+    }
+    for (uint8_t i = 0; i < spec.stars && record.arg_count < arg_count; i++) {
+      record.args[record.arg_count++].i = priv_read_signed(reader);
+    }
+    if (record.arg_count >= arg_count) {
+      break;
+    }
+
+    log_arg_t *arg = &record.args[record.arg_count++];
+    switch (spec.kind) {
+      case k_log_arg_double: {
+        uint64_t bits = 0;
+        for (uint8_t i = 0; i < sizeof(bits); i++) {
+          bits |= (uint64_t)priv_read_byte(reader) << (8 * i);
+        }
+        memcpy(&arg->d, &bits, sizeof(bits));
+        break;
+      }
+      case k_log_arg_string: {
+        size_t avail = sizeof(record.strings) - record.string_bytes;
+        arg->i       = record.string_bytes;
+        if (avail == 0) {
+          arg->i = sizeof(record.strings) - 1;
+          priv_read_string(reader, (char[1]){0}, 1);
+          break;
+        }
+        record.string_bytes += priv_read_string(reader, &record.strings[record.string_bytes], avail) + 1;
+        break;
+      }
+      case k_log_arg_pointer:
+        arg->p = (const void *)(uintptr_t)priv_read_varint(reader);
+        break;
+      default:
+        arg->i = priv_read_signed(reader);
+        break;
+    }
+  }
+  if (!reader->ok) {
+    return;
+  }
+
+  state->last_sequence     = record.sequence;
+  state->last_timestamp_us = record.timestamp_us;
+
+  char message[DECODER_MESSAGE_LENGTH];
+  char time_text[64];
+  log_record_render(&record, message, sizeof(message));
+  priv_format_time(state, record.timestamp_us, time_text, sizeof(time_text));
+
+  if (s_json_output) {
+    printf("{\"seq\":%" PRIu64 ",\"uptime_us\":%" PRId64 ",", record.sequence, record.timestamp_us);
+    if (state->time_known) {
+      printf("\"time\":\"%s\",", time_text);
+    }
+    printf("\"level\":\"%s\",\"tag\":", priv_level_name(level));
+    priv_print_json_string(record.tag);
+    fputs(",\"task\":", stdout);
+    priv_print_json_string(task_name[0] != '\0' ? task_name : "ISR");
+    fputs(",\"short\":", stdout);
+    priv_print_json_string(record.short_msg);
+    fputs(",\"message\":", stdout);
+    priv_print_json_string(message);
+    fputs("}\n", stdout);
+  } else {
+    printf("%s [%s] [%" PRIu64 "][%s] %s: %s - %s\n",
+           time_text,
+           priv_level_name(level),
+           record.sequence,
+           task_name[0] != '\0' ? task_name : "ISR",
+           record.tag,
+           record.short_msg,
+           message);
+  }
+}
+
+/**
+ * @brief Reads a whole file, gzip or raw
+ *
+ * @param path      File to read
+ * @param len       Set to the bytes read
+ * @param truncated Set if a gzip stream ended without its trailer
+ * @return The contents, NULL on error
+ */
+static uint8_t *priv_read_file(const char *path, size_t *len, bool *truncated)
+{
+  gzFile file = gzopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  uint8_t *data     = NULL;
+  size_t   capacity = 0;
+  *len              = 0;
+  *truncated        = false;
+  while (true) {
+    if (capacity - *len < DECODER_READ_CHUNK) {
+      capacity     += 4 * DECODER_READ_CHUNK;
+      uint8_t *grow = realloc(data, capacity);
+      if (grow == NULL) {
+        free(data);
+        gzclose(file);
+        return NULL;
+      }
+      data = grow;
+    }
+    int read = gzread(file, &data[*len], DECODER_READ_CHUNK);
+    if (read <= 0) {
+      int err;
+      gzerror(file, &err);
+      *truncated = (read < 0 || err != Z_OK);
+      break;
+    }
+    *len += (size_t)read;
+  }
+  gzclose(file);
+  return data;
+}
+
+/**
+ * @brief Decodes and prints one log file
+ *
+ * @param path File to decode
+ * @return 0 on success, 1 if the file is unreadable or corrupt
+ */
+static int priv_decode_file(const char *path)
+{
+  size_t   len;
+  bool     truncated;
+  uint8_t *data = priv_read_file(path, &len, &truncated);
+  if (data == NULL) {
+    fprintf(stderr, "%s: cannot read file\n", path);
+    return 1;
+  }
+
+  const size_t header_len = sizeof(LOG_RECORD_FILE_MAGIC);
+  if (len < header_len || memcmp(data, LOG_RECORD_FILE_MAGIC, header_len - 1) != 0) {
+    fprintf(stderr, "%s: not a binary log file\n", path);
+    free(data);
+    return 1;
+  }
+  if (data[header_len - 1] != LOG_RECORD_FILE_VERSION) {
+    fprintf(stderr, "%s: unsupported format version %u\n", path, data[header_len - 1]);
+    free(data);
+    return 1;
+  }
+
+  decoder_state_t  state  = {0};
+  decoder_reader_t reader = { .data = data, .len = len, .pos = header_len, .ok = true };
+  while (reader.ok && reader.pos < reader.len) {
+    size_t  block_start = reader.pos;
+    uint8_t type        = priv_read_byte(&reader);
+    if (type == k_log_block_string) {
+      priv_read_definition(&reader, state.strings, LOG_RECORD_MAX_STRINGS + 1);
+    } else if (type == k_log_block_task) {
+      priv_read_definition(&reader, state.tasks, LOG_RECORD_MAX_TASKS + 1);
+    } else if (type == k_log_block_time_sync) {
+      state.time_offset_us = priv_read_signed(&reader);
+      state.time_known     = true;
+    } else if (type > k_log_block_entry && type <= k_log_block_entry + 5) {
+      priv_decode_entry(&reader, &state, type - k_log_block_entry);
+    } else {
+      fprintf(stderr, "%s: unknown block 0x%02x at offset %zu\n", path, type, block_start);
+      reader.ok = false;
+    }
+    if (!reader.ok) {
+      reader.pos = block_start;
+    }
+  }
+
+  /* An unfinished file may end inside a block written after its last flush */
+  int ret = 0;
+  if (truncated) {
+    fprintf(stderr, "%s: file not finished, decoded up to the last flush\n", path);
+  } else if (reader.pos < reader.len) {
+    fprintf(stderr, "%s: stopped at offset %zu of %zu\n", path, reader.pos, reader.len);
+    ret = 1;
+  }
+
+  for (size_t i = 0; i <= LOG_RECORD_MAX_STRINGS; i++) {
+    free(state.strings[i]);
+  }
+  for (size_t i = 0; i <= LOG_RECORD_MAX_TASKS; i++) {
+    free(state.tasks[i]);
+  }
+  free(data);
+  return ret;
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  int first_file = 1;
+  if (argc > 1 && strcmp(argv[1], "--json") == 0) {
+    s_json_output = true;
+    first_file    = 2;
+  }
+  if (first_file >= argc) {
+    fprintf(stderr, "usage: %s [--json] FILE...\n", argv[0]);
+    return 2;
+  }
+
+  int ret = 0;
+  for (int i = first_file; i < argc; i++) {
+    ret |= priv_decode_file(argv[i]);
+  }
+  return ret;
+}
@@ -0,0 +1,324 @@
+/* tools/motion_frame_latency/motion_frame_latency.c */
+
+/* Measures how long a pose handed to the motion frame scheduler takes to
+ * reach the servo registers, running motion_frame.c and pca9685_hal.c
+ * unchanged against two simulated PCA9685 boards.
+ *
+ *   motion_frame_latency [--poses N] [--i2c-hz HZ]
+ *
+ * Every bus transfer is held for its wire time at the bus clock, 100 kHz as
+ * in the firmware unless --i2c-hz overrides it. Three runs:
+ *
+ *   rest    Servos at rest, direct profile. Each pose is submitted at a
+ *           random time and must land on all 18 channels; the latency is
+ *           measured here from the register file and compared with
+ *           `motion_frame_get_stats`.
+ *   direct  Poses streamed at the gait control rate, direct profile.
+ *   stream  Poses streamed at the gait control rate, trapezoidal profile,
+ *           as the gait engine drives it.
+ *
+ * Streamed runs report `motion_frame_get_stats` after each submit. Exits
+ * non-zero if a pose never lands. Host scheduling adds jitter to every
+ * figure, so treat single outliers with care. */
+
+#include "motion_frame.h"
+#include "hexapod_geometry.h"
+#include "hexapod_kinematics.h"
+#include "pca9685_hal.h"
+#include "pca9685_sim.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Macros *********************************************************************/
+
+#define LAND_TIMEOUT_MS (200)
+#define STREAM_RATE_HZ  (50) /* gait_control_rate_hz, not linked in here */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Latency samples of one run, microseconds
+ */
+typedef struct {
+  uint32_t *samples;
+  size_t    count;
+} latency_set_t;
+
+/* Globals (Static) ***********************************************************/
+
+static pca9685_board_t *s_boards                   = NULL;
+static motor_t          s_motors[NUMBER_OF_JOINTS] = {0};
+static uint16_t         s_before[NUMBER_OF_JOINTS] = {0}; /* OFF ticks before the submit */
+static pthread_mutex_t  s_lock                     = PTHREAD_MUTEX_INITIALIZER;
+static bool             s_armed                    = false;
+static int64_t          s_landed_us                = 0;
+static uint64_t         s_rng                      = 0x9E3779B97F4A7C15ull;
+static size_t           s_poses                    = 200;
+static uint32_t         s_i2c_hz                   = 0; /* 0 keeps pca9685_i2c_freq_hz */
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_random(void)
+{
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 7;
+  s_rng ^= s_rng << 17;
+  return (s_rng >> 11) / 9007199254740992.0;
+}
+
+static uint16_t priv_channel_off(uint8_t joint)
+{
+  uint16_t on_ticks  = 0;
+  uint16_t off_ticks = 0;
+  pca9685_sim_get_channel(pca9685_i2c_address + s_motors[joint].board_id,
+                          s_motors[joint].motor_id,
+                          &on_ticks,
+                          &off_ticks);
+  return off_ticks;
+}
+
+/**
+ * @brief Stamps the time once every joint's OFF count has moved
+ */
+static void priv_write_hook(uint8_t address, uint8_t first_reg, size_t count)
+{
+  (void)address;
+  (void)first_reg;
+  (void)count;
+
+  pthread_mutex_lock(&s_lock);
+  if (s_armed) {
+    bool all_moved = true;
+    for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS && all_moved; joint++) {
+      all_moved = priv_channel_off(joint) != s_before[joint];
+    }
+    if (all_moved) {
+      s_landed_us = esp_timer_get_time();
+      s_armed     = false;
+    }
+  }
+  pthread_mutex_unlock(&s_lock);
+}
+
+/**
+ * @brief A pose within the joint limits, every joint at least 2° from `from`
+ */
+static void priv_random_pose(leg_angles_t *pose, const leg_angles_t *from)
+{
+  const float limits[JOINTS_PER_LEG][2] = {
+    { hip_angle_from_90_min,   hip_angle_from_90_max   },
+    { knee_angle_from_90_min,  knee_angle_from_90_max  },
+    { tibia_angle_from_90_min, tibia_angle_from_90_max },
+  };
+  float       *out[JOINTS_PER_LEG] = { pose->hip_deg, pose->knee_deg, pose->tibia_deg };
+  const float *old[JOINTS_PER_LEG] = { from->hip_deg, from->knee_deg, from->tibia_deg };
+
+  for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+    for (uint8_t joint = 0; joint < JOINTS_PER_LEG; joint++) {
+      float angle;
+      do {
+        angle = limits[joint][0] + (limits[joint][1] - limits[joint][0]) * (float)priv_random();
+      } while (fabsf(angle - old[joint][leg]) < 2.0f);
+      out[joint][leg] = angle;
+    }
+  }
+}
+
+static int priv_compare_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void priv_print(const char *name, latency_set_t *set)
+{
+  if (set->count == 0) {
+    printf("  %-28s no samples\n", name);
+    return;
+  }
+  qsort(set->samples, set->count, sizeof(set->samples[0]), priv_compare_u32);
+  double sum = 0.0;
+  for (size_t i = 0; i < set->count; i++) {
+    sum += set->samples[i];
+  }
+  printf("  %-28s mean %6.2f  p50 %6.2f  p99 %6.2f  max %6.2f ms  (%zu)\n",
+         name,
+         sum / set->count / 1000.0,
+         set->samples[set->count / 2] / 1000.0,
+         set->samples[(set->count * 99) / 100] / 1000.0,
+         set->samples[set->count - 1] / 1000.0,
+         set->count);
+}
+
+/**
+ * @brief Submits poses to resting servos at random times
+ *
+ * @return Poses that never landed.
+ */
+static size_t priv_run_rest(void)
+{
+  latency_set_t measured = { calloc(s_poses, sizeof(uint32_t)), 0 };
+  latency_set_t reported = { calloc(s_poses, sizeof(uint32_t)), 0 };
+  leg_angles_t  pose     = {0};
+  leg_angles_t  previous = {0};
+  size_t        lost     = 0;
+
+  motion_frame_set_profile(k_motion_profile_direct);
+  for (size_t i = 0; i < s_poses; i++) {
+    /* Let the last pose settle, then land anywhere in the frame period */
+    vTaskDelay(pdMS_TO_TICKS(pca9685_step_delay_ms * 2));
+    usleep((useconds_t)(priv_random() * pca9685_step_delay_ms * 1000.0));
+
+    priv_random_pose(&pose, &previous);
+    pthread_mutex_lock(&s_lock);
+    for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; joint++) {
+      s_before[joint] = priv_channel_off(joint);
+    }
+    s_armed     = true;
+    s_landed_us = 0;
+    pthread_mutex_unlock(&s_lock);
+
+    int64_t submit_us = esp_timer_get_time();
+    motion_frame_submit(&pose);
+    previous = pose;
+
+    int64_t landed_us = 0;
+    for (int waited = 0; waited < LAND_TIMEOUT_MS && landed_us == 0; waited++) {
+      vTaskDelay(1);
+      pthread_mutex_lock(&s_lock);
+      landed_us = s_landed_us;
+      pthread_mutex_unlock(&s_lock);
+    }
+    if (landed_us == 0) {
+      pthread_mutex_lock(&s_lock);
+      s_armed = false;
+      pthread_mutex_unlock(&s_lock);
+      lost++;
+      continue;
+    }
+
+    motion_frame_stats_t stats;
+    motion_frame_get_stats(&stats);
+    measured.samples[measured.count++] = (uint32_t)(landed_us - submit_us);
+    reported.samples[reported.count++] = stats.last_latency_us;
+  }
+
+  printf("rest: poses to resting servos, direct profile\n");
+  priv_print("registers (measured here)", &measured);
+  priv_print("motion_frame_get_stats", &reported);
+  if (lost > 0) {
+    printf("  %zu poses never landed\n", lost);
+  }
+  free(measured.samples);
+  free(reported.samples);
+  return lost;
+}
+
+/**
+ * @brief Submits poses at the gait control rate, as the gait loop does
+ */
+static void priv_run_stream(const char *name, motion_profile_t profile)
+{
+  latency_set_t reported = { calloc(s_poses, sizeof(uint32_t)), 0 };
+  leg_angles_t  pose     = {0};
+  uint32_t      frames   = 0;
+
+  motion_frame_set_profile(profile);
+  vTaskDelay(pdMS_TO_TICKS(200));
+  usleep((useconds_t)(priv_random() * pca9685_step_delay_ms * 1000.0));
+
+  motion_frame_stats_t stats;
+  motion_frame_get_stats(&stats);
+  frames = stats.frames;
+
+  TickType_t period    = pdMS_TO_TICKS(1000 / STREAM_RATE_HZ);
+  TickType_t last_wake = xTaskGetTickCount();
+  for (size_t i = 0; i < s_poses; i++) {
+    /* Small steps, like consecutive gait ticks */
+    for (uint8_t leg = 0; leg < NUMBER_OF_LEGS; leg++) {
+      float phase         = (float)i * 0.2f + leg;
+      pose.hip_deg[leg]   = 30.0f + 20.0f * sinf(phase);
+      pose.knee_deg[leg]  = 45.0f + 20.0f * cosf(phase);
+      pose.tibia_deg[leg] = 15.0f * sinf(phase);
+    }
+    motion_frame_submit(&pose);
+    vTaskDelayUntil(&last_wake, period);
+
+    motion_frame_get_stats(&stats);
+    if (stats.frames != frames) {
+      reported.samples[reported.count++] = stats.last_latency_us;
+      frames                             = stats.frames;
+    }
+  }
+
+  printf("%s\n", name);
+  priv_print("motion_frame_get_stats", &reported);
+  free(reported.samples);
+}
+
+static void priv_usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [--poses N] [--i2c-hz HZ]\n", program);
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--poses") == 0 && i + 1 < argc) {
+      s_poses = (size_t)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--i2c-hz") == 0 && i + 1 < argc) {
+      s_i2c_hz = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else {
+      priv_usage(argv[0]);
+      return 2;
+    }
+  }
+  if (s_poses == 0) {
+    priv_usage(argv[0]);
+    return 2;
+  }
+
+  if (pca9685_init(&s_boards, 2) != ESP_OK) {
+    fprintf(stderr, "pca9685_init failed\n");
+    return 1;
+  }
+  kinematics_init();
+  for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; joint++) {
+    s_motors[joint].joint_type = (joint_type_t)(joint % JOINTS_PER_LEG);
+    s_motors[joint].board_id   = joint_channels[joint].board_id;
+    s_motors[joint].motor_id   = joint_channels[joint].channel;
+  }
+  if (motion_frame_init(s_boards, s_motors) != ESP_OK) {
+    fprintf(stderr, "motion_frame_init failed\n");
+    return 1;
+  }
+
+  /* The firmware's clock went to i2c_param_config during pca9685_init */
+  if (s_i2c_hz != 0) {
+    i2c_config_t conf = { .mode = I2C_MODE_MASTER, .master.clk_speed = s_i2c_hz };
+    i2c_param_config(pca9685_i2c_bus, &conf);
+  }
+  printf("%u servos on 2 boards, I2C %lu Hz, frame period %lu ms\n",
+         NUMBER_OF_JOINTS,
+         (unsigned long)(s_i2c_hz != 0 ? s_i2c_hz : pca9685_i2c_freq_hz),
+         (unsigned long)pca9685_step_delay_ms);
+
+  pca9685_sim_set_write_hook(priv_write_hook);
+  pca9685_sim_set_wire_delay(true);
+
+  size_t lost = priv_run_rest();
+  priv_run_stream("direct: poses at 50 Hz, direct profile", k_motion_profile_direct);
+  priv_run_stream("stream: poses at 50 Hz, trapezoidal profile (gait)", k_motion_profile_trapezoidal);
+  return lost > 0 ? 1 : 0;
+}
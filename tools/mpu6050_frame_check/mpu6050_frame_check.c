@@ -0,0 +1,234 @@
+/* tools/mpu6050_frame_check/mpu6050_frame_check.c */
+
+/* Decodes MPU6050 frames from fixture files with the firmware's
+ * mpu6050_frame.c and checks them against expected values.
+ *
+ *   mpu6050_frame_check FILE...
+ *
+ * A fixture is a text file, one directive per line, `#` starts a comment:
+ *
+ *   scale <accel_lsb_per_g> <gyro_lsb_per_dps>
+ *       Sensitivities of the ranges the frames were read with. Required
+ *       before the first frame.
+ *   bias <temp> <x> <y> <z>
+ *       Adds a point to the gyro bias table with `mpu6050_gyro_bias_add`;
+ *       the table must stay valid. Each file starts with an empty table.
+ *   check_bias <temp> <x> <y> <z>
+ *       Expected `mpu6050_gyro_bias_at` at a temperature.
+ *   frame <hex> [<ax> <ay> <az> <gx> <gy> <gz> <temp>]
+ *       The 14 bytes from ACCEL_XOUT_H to GYRO_ZOUT_L, as 28 hex digits.
+ *       Decoded with the current table; the values after it are expected
+ *       in g, °/s and degrees C. Without them the decoded sample is
+ *       printed, so frames recorded from a sensor can be added as is.
+ *
+ * Values must match within FIXTURE_TOLERANCE. Exits non-zero on a mismatch
+ * or a malformed line. */
+
+#include "mpu6050_frame.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Macros *********************************************************************/
+
+#define FIXTURE_TOLERANCE   (1e-4) /* Fixtures are written with six decimals */
+#define FIXTURE_LINE_LENGTH (256)
+#define FRAME_VALUES        (7)    /* ax, ay, az, gx, gy, gz, temperature */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief State while reading one fixture file
+ */
+typedef struct {
+  const char               *path;
+  unsigned                  line;
+  bool                      have_scale;
+  mpu6050_frame_scale_t     scale;
+  mpu6050_gyro_bias_table_t bias;
+  unsigned                  frames;
+  unsigned                  checks;
+  unsigned                  failures;
+} fixture_t;
+
+/* Private Functions (Static) *************************************************/
+
+static void priv_fail(fixture_t *fixture, const char *message)
+{
+  fprintf(stderr, "%s:%u: %s\n", fixture->path, fixture->line, message);
+  fixture->failures++;
+}
+
+static bool priv_near(double actual, double expected)
+{
+  return fabs(actual - expected) <= FIXTURE_TOLERANCE;
+}
+
+static bool priv_parse_frame(const char *hex, uint8_t *frame)
+{
+  if (strlen(hex) != 2 * MPU6050_FRAME_SIZE) {
+    return false;
+  }
+  for (size_t i = 0; i < MPU6050_FRAME_SIZE; i++) {
+    unsigned byte;
+    if (!isxdigit((unsigned char)hex[2 * i]) || !isxdigit((unsigned char)hex[2 * i + 1]) ||
+        sscanf(&hex[2 * i], "%2x", &byte) != 1) {
+      return false;
+    }
+    frame[i] = (uint8_t)byte;
+  }
+  return true;
+}
+
+static void priv_do_bias(fixture_t *fixture, const char *args)
+{
+  mpu6050_gyro_bias_point_t point;
+  if (sscanf(args, "%f %f %f %f", &point.temperature, &point.bias_x, &point.bias_y, &point.bias_z) != 4) {
+    priv_fail(fixture, "bias needs <temp> <x> <y> <z>");
+    return;
+  }
+  if (!mpu6050_gyro_bias_add(&fixture->bias, &point)) {
+    priv_fail(fixture, "point rejected");
+  } else if (!mpu6050_gyro_bias_is_valid(&fixture->bias)) {
+    priv_fail(fixture, "table invalid after adding the point");
+  }
+}
+
+static void priv_do_check_bias(fixture_t *fixture, const char *args)
+{
+  float                     temperature;
+  float                     expected[3];
+  mpu6050_gyro_bias_point_t bias;
+  if (sscanf(args, "%f %f %f %f", &temperature, &expected[0], &expected[1], &expected[2]) != 4) {
+    priv_fail(fixture, "check_bias needs <temp> <x> <y> <z>");
+    return;
+  }
+
+  mpu6050_gyro_bias_at(&fixture->bias, temperature, &bias);
+  fixture->checks++;
+  if (!priv_near(bias.bias_x, expected[0]) || !priv_near(bias.bias_y, expected[1]) ||
+      !priv_near(bias.bias_z, expected[2])) {
+    char message[FIXTURE_LINE_LENGTH];
+    snprintf(message, sizeof(message), "bias at %.2f C is %.6f %.6f %.6f",
+             temperature, bias.bias_x, bias.bias_y, bias.bias_z);
+    priv_fail(fixture, message);
+  }
+}
+
+static void priv_do_frame(fixture_t *fixture, const char *args)
+{
+  char    hex[FIXTURE_LINE_LENGTH];
+  int     consumed = 0;
+  uint8_t frame[MPU6050_FRAME_SIZE];
+  if (!fixture->have_scale) {
+    priv_fail(fixture, "frame before scale");
+    return;
+  }
+  if (sscanf(args, "%255s%n", hex, &consumed) != 1 || !priv_parse_frame(hex, frame)) {
+    priv_fail(fixture, "frame needs 28 hex digits");
+    return;
+  }
+
+  mpu6050_sample_t sample = {0};
+  mpu6050_frame_decode(frame, &fixture->scale, fixture->bias.count > 0 ? &fixture->bias : NULL, &sample);
+  fixture->frames++;
+
+  const float actual[FRAME_VALUES] = {
+    sample.accel_x, sample.accel_y, sample.accel_z,
+    sample.gyro_x,  sample.gyro_y,  sample.gyro_z,
+    sample.temperature,
+  };
+  double expected[FRAME_VALUES];
+  int    count = sscanf(args + consumed, "%lf %lf %lf %lf %lf %lf %lf",
+                        &expected[0], &expected[1], &expected[2],
+                        &expected[3], &expected[4], &expected[5], &expected[6]);
+  if (count <= 0) {
+    printf("%s:%u: accel %.4f %.4f %.4f g  gyro %.3f %.3f %.3f dps  %.2f C\n",
+           fixture->path, fixture->line,
+           actual[0], actual[1], actual[2], actual[3], actual[4], actual[5], actual[6]);
+    return;
+  }
+  if (count != FRAME_VALUES) {
+    priv_fail(fixture, "frame needs all seven expected values or none");
+    return;
+  }
+
+  fixture->checks++;
+  for (int i = 0; i < FRAME_VALUES; i++) {
+    if (!priv_near(actual[i], expected[i])) {
+      char message[FIXTURE_LINE_LENGTH];
+      snprintf(message, sizeof(message), "value %d decoded as %.6f, expected %.6f", i + 1, actual[i], expected[i]);
+      priv_fail(fixture, message);
+    }
+  }
+}
+
+/**
+ * @brief Runs one fixture file
+ *
+ * @return Failures in the file
+ */
+static unsigned priv_run_fixture(const char *path)
+{
+  fixture_t fixture = { .path = path };
+  FILE     *file    = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return 1;
+  }
+
+  char line[FIXTURE_LINE_LENGTH];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    fixture.line++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+
+    char directive[16];
+    int  consumed = 0;
+    if (sscanf(line, "%15s%n", directive, &consumed) != 1) {
+      continue;
+    }
+    const char *args = line + consumed;
+    if (strcmp(directive, "scale") == 0) {
+      fixture.have_scale = sscanf(args, "%f %f",
+                                  &fixture.scale.accel_lsb_per_g,
+                                  &fixture.scale.gyro_lsb_per_dps) == 2 &&
+                           fixture.scale.accel_lsb_per_g > 0.0f &&
+                           fixture.scale.gyro_lsb_per_dps > 0.0f;
+      if (!fixture.have_scale) {
+        priv_fail(&fixture, "scale needs two positive sensitivities");
+      }
+    } else if (strcmp(directive, "bias") == 0) {
+      priv_do_bias(&fixture, args);
+    } else if (strcmp(directive, "check_bias") == 0) {
+      priv_do_check_bias(&fixture, args);
+    } else if (strcmp(directive, "frame") == 0) {
+      priv_do_frame(&fixture, args);
+    } else {
+      priv_fail(&fixture, "unknown directive");
+    }
+  }
+  fclose(file);
+
+  printf("%s: %u frames, %u checks, %u failures\n", path, fixture.frames, fixture.checks, fixture.failures);
+  return fixture.failures;
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE...\n", argv[0]);
+    return 2;
+  }
+
+  unsigned failures = 0;
+  for (int i = 1; i < argc; i++) {
+    failures += priv_run_fixture(argv[i]);
+  }
+  return failures > 0 ? 1 : 0;
+}
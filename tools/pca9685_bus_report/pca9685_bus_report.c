@@ -0,0 +1,275 @@
+/* tools/pca9685_bus_report/pca9685_bus_report.c */
+
+/* Reports the I2C traffic the PCA9685 driver puts on the bus for typical
+ * servo updates, running pca9685_hal.c unchanged against two simulated
+ * boards wired like the hexapod (`joint_channels`).
+ *
+ *   pca9685_bus_report
+ *
+ * Each scenario prints the driver's own counters (`pca9685_get_bus_stats`),
+ * what the simulated bus saw, and the traffic of the per-channel path the
+ * driver used before batching: four single-register writes per channel,
+ * each an address, register and value byte. Wire times are at
+ * `pca9685_i2c_freq_hz`. After every scenario the simulated registers are
+ * compared with the values written. Exits non-zero if a register is wrong,
+ * the two counters disagree, or a scenario takes more transactions than
+ * its budget. */
+
+#include "hexapod_geometry.h"
+#include "pca9685_hal.h"
+#include "pca9685_sim.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Macros *********************************************************************/
+
+#define NUM_BOARDS           (2)
+#define CHANNELS_PER_BOARD   (16)
+#define OLD_WRITES_PER_CHAN  (4) /* ON_L, ON_H, OFF_L, OFF_H */
+#define OLD_BYTES_PER_WRITE  (3) /* Address, register, value */
+#define I2C_BITS_PER_BYTE    (9) /* Eight data bits and the ACK */
+#define I2C_FRAMING_BITS     (2) /* START and STOP */
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief One servo update and what it may cost
+ */
+typedef struct {
+  const char *name;
+  uint32_t    channels;         /* Channels the caller writes */
+  uint32_t    max_transactions; /* Budget for the batched driver */
+  esp_err_t (*run)(void);
+} scenario_t;
+
+/**
+ * @brief Value a channel should hold after a scenario
+ */
+typedef struct {
+  bool     valid;
+  uint16_t on_ticks;
+  uint16_t off_ticks;
+} expected_channel_t;
+
+/* Globals (Static) ***********************************************************/
+
+static pca9685_board_t   *s_boards                                   = NULL;
+static expected_channel_t s_expected[NUM_BOARDS][CHANNELS_PER_BOARD] = {0};
+static uint16_t           s_on[NUMBER_OF_JOINTS]                     = {0};
+static uint16_t           s_width[NUMBER_OF_JOINTS]                  = {0};
+static uint64_t           s_rng                                      = 0x9E3779B97F4A7C15ull;
+
+/* Private Functions (Static) *************************************************/
+
+static double priv_random(void)
+{
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 7;
+  s_rng ^= s_rng << 17;
+  return (s_rng >> 11) / 9007199254740992.0;
+}
+
+static uint16_t priv_random_width(void)
+{
+  return pca9685_min_pulse_ticks +
+         (uint16_t)((pca9685_max_pulse_ticks - pca9685_min_pulse_ticks) * priv_random());
+}
+
+static uint32_t priv_wire_us(uint32_t transactions, uint32_t bytes)
+{
+  uint64_t bits = ((uint64_t)transactions * I2C_FRAMING_BITS) + ((uint64_t)bytes * I2C_BITS_PER_BYTE);
+  return (uint32_t)((bits * 1000000 + pca9685_i2c_freq_hz - 1) / pca9685_i2c_freq_hz);
+}
+
+static void priv_expect(uint8_t board_id, uint8_t channel, uint16_t on_ticks, uint16_t width_ticks)
+{
+  s_expected[board_id][channel] = (expected_channel_t){
+    .valid     = true,
+    .on_ticks  = on_ticks,
+    .off_ticks = (on_ticks + width_ticks) % pca9685_pwm_resolution,
+  };
+}
+
+/**
+ * @brief Gives every joint a new pulse width, staggered like motion frames
+ */
+static void priv_new_pose(void)
+{
+  const uint8_t slots = pca9685_pwm_resolution / pca9685_max_pulse_ticks;
+  for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; joint++) {
+    s_on[joint]    = (joint_channels[joint].channel % slots) * pca9685_max_pulse_ticks;
+    s_width[joint] = priv_random_width();
+  }
+}
+
+static esp_err_t priv_stage_pose(void)
+{
+  for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; joint++) {
+    const joint_channel_t *jc  = &joint_channels[joint];
+    esp_err_t              ret = pca9685_stage_pulse(s_boards, jc->board_id, jc->channel,
+                                                     s_on[joint], s_width[joint]);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+    priv_expect(jc->board_id, jc->channel, s_on[joint], s_width[joint]);
+  }
+  return pca9685_flush(s_boards);
+}
+
+/**
+ * @brief All 16 servos of board 0 to one position, as at start-up
+ */
+static esp_err_t priv_run_uniform(void)
+{
+  uint16_t width = priv_random_width();
+  for (uint8_t channel = 0; channel < CHANNELS_PER_BOARD; channel++) {
+    priv_expect(0, channel, 0, width);
+  }
+  return pca9685_set_ticks(s_boards, 0xFFFF, 0, width);
+}
+
+/**
+ * @brief A new pose for all 18 joints, staged and flushed
+ */
+static esp_err_t priv_run_pose(void)
+{
+  priv_new_pose();
+  return priv_stage_pose();
+}
+
+/**
+ * @brief The same pose submitted again
+ */
+static esp_err_t priv_run_repeat(void)
+{
+  return priv_stage_pose();
+}
+
+/**
+ * @brief A full pose in which only one joint moved
+ */
+static esp_err_t priv_run_one_joint(void)
+{
+  uint8_t  joint = NUMBER_OF_JOINTS / 2;
+  uint16_t width;
+  do {
+    width = priv_random_width();
+  } while (width == s_width[joint]);
+  s_width[joint] = width;
+  return priv_stage_pose();
+}
+
+/**
+ * @brief A new pose written joint by joint through `pca9685_set_pulse`
+ */
+static esp_err_t priv_run_per_call(void)
+{
+  priv_new_pose();
+  for (uint8_t joint = 0; joint < NUMBER_OF_JOINTS; joint++) {
+    const joint_channel_t *jc  = &joint_channels[joint];
+    esp_err_t              ret = pca9685_set_pulse(s_boards, jc->board_id, jc->channel,
+                                                   s_on[joint], s_width[joint]);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+    priv_expect(jc->board_id, jc->channel, s_on[joint], s_width[joint]);
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Counts channels whose simulated registers differ from the expected values
+ */
+static uint32_t priv_check_registers(void)
+{
+  uint32_t wrong = 0;
+  for (uint8_t board_id = 0; board_id < NUM_BOARDS; board_id++) {
+    for (uint8_t channel = 0; channel < CHANNELS_PER_BOARD; channel++) {
+      const expected_channel_t *exp       = &s_expected[board_id][channel];
+      uint16_t                  on_ticks  = 0;
+      uint16_t                  off_ticks = 0;
+      if (!exp->valid) {
+        continue;
+      }
+      if (!pca9685_sim_get_channel(pca9685_i2c_address + board_id, channel, &on_ticks, &off_ticks) ||
+          on_ticks != exp->on_ticks || off_ticks != exp->off_ticks) {
+        fprintf(stderr, "  board %u channel %2u: %u/%u, expected %u/%u\n",
+                board_id, channel, on_ticks, off_ticks, exp->on_ticks, exp->off_ticks);
+        wrong++;
+      }
+    }
+  }
+  return wrong;
+}
+
+/* Public Functions ***********************************************************/
+
+int main(void)
+{
+  static const scenario_t scenarios[] = {
+    { "uniform 16 (ALL_LED)",    CHANNELS_PER_BOARD, 1,                priv_run_uniform   },
+    { "pose 18 joints",          NUMBER_OF_JOINTS,   NUM_BOARDS,       priv_run_pose      },
+    { "same pose again",         NUMBER_OF_JOINTS,   0,                priv_run_repeat    },
+    { "pose, one joint moved",   NUMBER_OF_JOINTS,   1,                priv_run_one_joint },
+    { "pose via set_pulse",      NUMBER_OF_JOINTS,   NUMBER_OF_JOINTS, priv_run_per_call  },
+  };
+
+  if (pca9685_init(&s_boards, NUM_BOARDS) != ESP_OK) {
+    fprintf(stderr, "pca9685_init failed\n");
+    return 1;
+  }
+
+  pca9685_bus_stats_t hal;
+  pca9685_sim_stats_t sim;
+  pca9685_get_bus_stats(&hal, true);
+  pca9685_sim_get_stats(&sim, true);
+
+  printf("%u boards, %u joints, I2C at %u Hz; old path: %u writes of %u bytes per channel\n\n",
+         NUM_BOARDS,
+         NUMBER_OF_JOINTS,
+         pca9685_i2c_freq_hz,
+         OLD_WRITES_PER_CHAN,
+         OLD_BYTES_PER_WRITE);
+  printf("%-24s %4s | %12s | %12s %8s | %12s %8s\n",
+         "scenario", "chan", "driver tx/B", "bus tx/B", "wire us", "old tx/B", "wire us");
+
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const scenario_t *sc = &scenarios[i];
+    esp_err_t         ret = sc->run();
+    pca9685_get_bus_stats(&hal, true);
+    pca9685_sim_get_stats(&sim, true);
+
+    uint32_t old_tx    = sc->channels * OLD_WRITES_PER_CHAN;
+    uint32_t old_bytes = old_tx * OLD_BYTES_PER_WRITE;
+    printf("%-24s %4u | %5u / %4u | %5u / %4u %8llu | %5u / %4u %8u\n",
+           sc->name,
+           sc->channels,
+           hal.transactions, hal.bytes,
+           sim.transactions, sim.bytes, (unsigned long long)sim.wire_us,
+           old_tx, old_bytes, priv_wire_us(old_tx, old_bytes));
+
+    if (ret != ESP_OK) {
+      fprintf(stderr, "  %s failed: %s\n", sc->name, esp_err_to_name(ret));
+      failures++;
+    }
+    if (hal.transactions != sim.transactions || hal.bytes != sim.bytes) {
+      fprintf(stderr, "  driver and bus counters disagree\n");
+      failures++;
+    }
+    if (sim.transactions > sc->max_transactions) {
+      fprintf(stderr, "  %u transactions, budget %u\n", sim.transactions, sc->max_transactions);
+      failures++;
+    }
+    if (priv_check_registers() != 0) {
+      failures++;
+    }
+  }
+
+  if (failures > 0) {
+    printf("\nFAIL: %d checks\n", failures);
+    return 1;
+  }
+  printf("\nall registers match, all scenarios within budget\n");
+  return 0;
+}
@@ -0,0 +1,291 @@
+/* tools/sensor_decoder/sensor_decoder.c */
+
+/* Converts binary sensor logs (.tsns) written by sensor_log to CSV.
+ *
+ *   sensor_decoder [--index] [--from UNIX_S] [--to UNIX_S] FILE...
+ *
+ * --index prints one line per block from the block headers alone, --from
+ * and --to skip blocks outside a wall time range without decoding them.
+ * Blocks with a bad CRC, e.g. torn by a power loss, are reported and
+ * skipped; the fixed block size keeps the rest of the file readable. */
+
+#include "sensor_record.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Structs ********************************************************************/
+
+/**
+ * @brief Per-file decoder state, changes with every file header block
+ */
+typedef struct {
+  uint8_t         header[SENSOR_RECORD_MAX_BLOCK_SIZE]; /* Last file header block, the schema points into it */
+  sensor_schema_t schema;                               /* Columns of the following blocks */
+  uint8_t         type;                                 /* sensor_record_type_t of the following blocks */
+  uint16_t        block_size;                           /* Bytes per block, 0 before the first header */
+  uint8_t         decimals[SENSOR_RECORD_MAX_COLUMNS];  /* Digits printed per column, from the scale */
+  bool            have_sequence;                        /* Whether last_sequence is set */
+  uint32_t        last_sequence;                        /* Sequence of the previous block */
+} decoder_state_t;
+
+/**
+ * @brief Totals printed after each file
+ */
+typedef struct {
+  uint32_t blocks;  /* Data blocks decoded or indexed */
+  uint32_t skipped; /* Data blocks outside the time range */
+  uint32_t bad;     /* Data blocks with a bad header or CRC */
+  uint32_t gaps;    /* Sequence jumps, i.e. blocks lost before they were written */
+  uint64_t records; /* Rows printed */
+} decoder_totals_t;
+
+/* Globals (Static) ***********************************************************/
+
+static bool   s_index_only = false;
+static bool   s_has_range  = false;
+static double s_from_s     = -INFINITY;
+static double s_to_s       = INFINITY;
+
+/* Private Functions (Static) *************************************************/
+
+/**
+ * @brief Formats a time, wall clock when known, otherwise uptime
+ */
+static void priv_format_time(int64_t timestamp_us, int64_t unix_offset_us, char *buffer, size_t size)
+{
+  if (unix_offset_us == 0) {
+    snprintf(buffer,
+             size,
+             "+%" PRId64 ".%06" PRId64,
+             timestamp_us / 1000000,
+             timestamp_us % 1000000);
+    return;
+  }
+
+  int64_t   unix_us = timestamp_us + unix_offset_us;
+  time_t    seconds = (time_t)(unix_us / 1000000);
+  struct tm timeinfo;
+  gmtime_r(&seconds, &timeinfo);
+  size_t len = strftime(buffer, size, "%Y-%m-%dT%H:%M:%S", &timeinfo);
+  snprintf(&buffer[len], size - len, ".%06dZ", (int)(unix_us % 1000000));
+}
+
+/**
+ * @brief Takes a new file header block, printing the CSV header
+ *
+ * @return true if the block is a valid header
+ */
+static bool priv_read_header(decoder_state_t *state, const uint8_t *block, size_t len)
+{
+  memcpy(state->header, block, len);
+  if (!sensor_record_read_file_header(state->header, len, &state->type, &state->block_size, &state->schema)) {
+    return false;
+  }
+
+  for (uint8_t c = 0; c < state->schema.column_count; c++) {
+    state->decimals[c] = 0;
+    for (uint32_t scale = state->schema.columns[c].scale; scale >= 10; scale /= 10) {
+      state->decimals[c]++;
+    }
+  }
+  state->have_sequence = false; /* A new boot numbers its blocks from 0 again */
+
+  if (!s_index_only) {
+    fputs("uptime_us,time", stdout);
+    for (uint8_t c = 0; c < state->schema.column_count; c++) {
+      printf(",%s", state->schema.columns[c].name);
+    }
+    putchar('\n');
+  }
+  return true;
+}
+
+/**
+ * @brief Prints a data block as CSV rows, or its index line
+ */
+static void priv_print_block(decoder_state_t             *state,
+                             decoder_totals_t            *totals,
+                             const uint8_t               *block,
+                             const sensor_block_header_t *header,
+                             long                         offset)
+{
+  if (state->have_sequence && header->sequence != state->last_sequence + 1) {
+    totals->gaps++;
+  }
+  state->have_sequence = true;
+  state->last_sequence = header->sequence;
+
+  /* The headers are the time index, a block outside the range is never decoded */
+  if (s_has_range) {
+    double first_s = (header->first_us + header->unix_offset_us) / 1e6;
+    double last_s  = first_s + header->span_us / 1e6;
+    if (header->unix_offset_us == 0 || last_s < s_from_s || first_s > s_to_s) {
+      totals->skipped++;
+      return;
+    }
+  }
+  totals->blocks++;
+
+  if (s_index_only) {
+    char first[40];
+    char last[40];
+    priv_format_time(header->first_us, header->unix_offset_us, first, sizeof(first));
+    priv_format_time(header->first_us + header->span_us, header->unix_offset_us, last, sizeof(last));
+    printf("%ld,%s,%" PRIu32 ",%s,%s,%u,%s,%u/%u\n",
+           offset,
+           state->schema.name,
+           header->sequence,
+           first,
+           last,
+           header->record_count,
+           header->encoding == k_sensor_encoding_delta ? "delta" : "raw",
+           SENSOR_RECORD_BLOCK_HEADER_SIZE + header->payload_bytes,
+           state->block_size);
+    return;
+  }
+
+  int64_t timestamps[SENSOR_RECORD_MAX_ROWS];
+  int32_t values[SENSOR_RECORD_MAX_ROWS * SENSOR_RECORD_MAX_COLUMNS];
+  if (!sensor_record_decode_block(block, header, state->schema.column_count, timestamps, values)) {
+    totals->bad++;
+    return;
+  }
+
+  uint8_t cols = state->schema.column_count;
+  for (uint16_t r = 0; r < header->record_count; r++) {
+    char time_text[40] = "";
+    if (header->unix_offset_us != 0) {
+      priv_format_time(timestamps[r], header->unix_offset_us, time_text, sizeof(time_text));
+    }
+    printf("%" PRId64 ",%s", timestamps[r], time_text);
+    for (uint8_t c = 0; c < cols; c++) {
+      printf(",%.*f",
+             state->decimals[c],
+             (double)values[r * cols + c] / state->schema.columns[c].scale);
+    }
+    putchar('\n');
+  }
+  totals->records += header->record_count;
+}
+
+/**
+ * @brief Decodes and prints one sensor log file
+ *
+ * @param path File to decode
+ * @return 0 on success, 1 if the file is unreadable or has bad blocks
+ */
+static int priv_decode_file(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "%s: cannot read file\n", path);
+    return 1;
+  }
+
+  static decoder_state_t state;
+  memset(&state, 0, sizeof(state));
+  decoder_totals_t totals = {0};
+  uint8_t          block[SENSOR_RECORD_MAX_BLOCK_SIZE];
+  bool             partial = false;
+  int              ret     = 0;
+
+  /* Every block starts with its magic, a header block also gives the size of the next ones */
+  while (true) {
+    long   offset = ftell(file);
+    size_t got    = fread(block, 1, SENSOR_RECORD_MIN_BLOCK_SIZE, file);
+    if (got == 0) {
+      break;
+    }
+    if (got < SENSOR_RECORD_MIN_BLOCK_SIZE) {
+      partial = true;
+      break;
+    }
+
+    uint32_t magic = block[0] | (block[1] << 8) | (block[2] << 16) | ((uint32_t)block[3] << 24);
+    size_t   size  = state.block_size;
+    if (magic == SENSOR_RECORD_FILE_MAGIC) {
+      size = block[8] | (block[9] << 8);
+    }
+    if (size < SENSOR_RECORD_MIN_BLOCK_SIZE || size > SENSOR_RECORD_MAX_BLOCK_SIZE) {
+      fprintf(stderr, "%s: no file header before offset %ld\n", path, offset);
+      ret = 1;
+      break;
+    }
+    got += fread(&block[got], 1, size - got, file);
+    if (got < size) {
+      partial = true;
+      break;
+    }
+
+    sensor_block_header_t header;
+    if (magic == SENSOR_RECORD_FILE_MAGIC) {
+      if (!priv_read_header(&state, block, size)) {
+        fprintf(stderr, "%s: bad file header at offset %ld\n", path, offset);
+        ret = 1;
+        break;
+      }
+    } else if (sensor_record_read_block_header(block, size, &header) && header.type == state.type) {
+      priv_print_block(&state, &totals, block, &header, offset);
+    } else {
+      totals.bad++;
+    }
+  }
+  fclose(file);
+
+  if (partial) {
+    fprintf(stderr, "%s: ends inside a block, the last write was cut short\n", path);
+  }
+  if (totals.bad > 0) {
+    ret = 1;
+  }
+  fprintf(stderr,
+          "%s: %s, %" PRIu32 " blocks, %" PRIu64 " records, %" PRIu32 " skipped, %" PRIu32 " bad, %" PRIu32 " sequence gaps\n",
+          path,
+          state.block_size != 0 ? state.schema.name : "no header",
+          totals.blocks,
+          totals.records,
+          totals.skipped,
+          totals.bad,
+          totals.gaps);
+  return ret;
+}
+
+/* Public Functions ***********************************************************/
+
+int main(int argc, char **argv)
+{
+  int first_file = 1;
+  while (first_file < argc && strncmp(argv[first_file], "--", 2) == 0) {
+    if (strcmp(argv[first_file], "--index") == 0) {
+      s_index_only = true;
+      first_file++;
+    } else if (strcmp(argv[first_file], "--from") == 0 && first_file + 1 < argc) {
+      s_from_s     = strtod(argv[first_file + 1], NULL);
+      s_has_range  = true;
+      first_file  += 2;
+    } else if (strcmp(argv[first_file], "--to") == 0 && first_file + 1 < argc) {
+      s_to_s       = strtod(argv[first_file + 1], NULL);
+      s_has_range  = true;
+      first_file  += 2;
+    } else {
+      break;
+    }
+  }
+  if (first_file >= argc) {
+    fprintf(stderr, "usage: %s [--index] [--from UNIX_S] [--to UNIX_S] FILE...\n", argv[0]);
+    return 2;
+  }
+
+  if (s_index_only) {
+    puts("offset,sensor,sequence,first,last,records,encoding,bytes");
+  }
+  int ret = 0;
+  for (int i = first_file; i < argc; i++) {
+    ret |= priv_decode_file(argv[i]);
+  }
+  return ret;
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+# tools/telemetry_server/telemetry_server.py
+
+"""Local stand-in for the telemetry web server.
+
+Accepts the batched POSTs of the uploader task (a JSON array of sensor
+samples, optionally gzip encoded) over keep-alive HTTP/1.1 connections and
+prints one line per request, so a board or a host build can be pointed at
+it by setting `webserver_url` to http://<this host>:<port>/.
+
+    telemetry_server.py [--port 8080] [--samples FILE] [--fail-every N]
+                        [--close-every N]
+
+--samples appends every received sample as a JSON line to FILE.
+--fail-every answers every Nth request with 503, --close-every closes the
+connection after every Nth response, to exercise the uploader's error and
+reconnect paths. Totals are printed on Ctrl-C or SIGTERM.
+"""
+
+import argparse
+import gzip
+import json
+import signal
+import sys
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+class Totals:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.connections = 0
+        self.requests = 0
+        self.samples = 0
+        self.body_bytes = 0
+        self.json_bytes = 0
+        self.bad = 0
+
+    def summary(self):
+        return (f"{self.connections} connections, {self.requests} requests, "
+                f"{self.samples} samples, {self.body_bytes} body bytes "
+                f"({self.json_bytes} as JSON), {self.bad} bad")
+
+
+def make_handler(args, totals, samples_file):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # Keep-alive unless a side asks to close
+
+        def setup(self):
+            super().setup()
+            with totals.lock:
+                totals.connections += 1
+
+        def handle(self):
+            try:
+                super().handle()
+            except ConnectionResetError:
+                pass  # The board reset or dropped the link
+
+        def log_message(self, fmt, *fmt_args):
+            pass
+
+        def reply(self, status, close=False):
+            self.send_response(status)
+            self.send_header("Content-Length", "0")
+            if close:
+                self.send_header("Connection", "close")
+                self.close_connection = True
+            self.end_headers()
+
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            body = self.rfile.read(length)
+            with totals.lock:
+                totals.requests += 1
+                number = totals.requests
+
+            try:
+                text = body
+                if self.headers.get("Content-Encoding") == "gzip":
+                    text = gzip.decompress(body)
+                batch = json.loads(text)
+                if isinstance(batch, dict):
+                    batch = [batch]  # Unbatched sender
+            except (OSError, ValueError) as error:
+                with totals.lock:
+                    totals.bad += 1
+                print(f"#{number}: bad body ({error})", file=sys.stderr)
+                self.reply(400)
+                return
+
+            close = args.close_every and number % args.close_every == 0
+            if args.fail_every and number % args.fail_every == 0:
+                print(f"#{number}: {len(batch)} samples refused with 503")
+                self.reply(503, close)
+                return
+
+            with totals.lock:
+                totals.samples += len(batch)
+                totals.body_bytes += len(body)
+                totals.json_bytes += len(text)
+                if samples_file:
+                    for sample in batch:
+                        samples_file.write(json.dumps(sample, separators=(",", ":")) + "\n")
+                    samples_file.flush()
+            types = sorted({s.get("sensor_type", "?") for s in batch})
+            print(f"#{number}: {len(batch)} samples, {len(body)} bytes"
+                  f"{' gzip' if text is not body else ''}, {', '.join(types)}")
+            self.reply(200, close)
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--samples", help="append received samples as JSON lines")
+    parser.add_argument("--fail-every", type=int, default=0, metavar="N")
+    parser.add_argument("--close-every", type=int, default=0, metavar="N")
+    args = parser.parse_args()
+
+    totals = Totals()
+    samples_file = open(args.samples, "a") if args.samples else None
+    server = ThreadingHTTPServer(("", args.port), make_handler(args, totals, samples_file))
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+    print(f"Listening on port {args.port}", file=sys.stderr)
+    try:
+        server.serve_forever()
+    except (KeyboardInterrupt, SystemExit):
+        pass
+    print(totals.summary(), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()